@@ -0,0 +1,428 @@
+//  Copyright (C) 2020-2024  Jiří Maier
+
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "communication/datalogger.h"
+#include "communication/latencytrace.h"
+#include "metrics.h"
+#include "plots/capturefile.h"
+#include "traceevents.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <algorithm>
+
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+/// Jak často se vybírá fronta (ms)
+#define LOGGER_DRAIN_INTERVAL 20
+/// Po kolika řádcích se zapisuje CSV
+#define LOGGER_CSV_ROWS 4096
+
+/// Cíl zápisu, jeden otevřený soubor
+class LogSink {
+public:
+  explicit LogSink(const QString &fileName) : file(fileName) {}
+  virtual ~LogSink() {}
+
+  virtual bool begin() = 0;
+  /// frame = celý průběh ($$C, $$L) s vlastní časovou osou, jinak souvislé body
+  virtual bool writeAnalog(int ch, const QCPGraphData *data, int count, bool frame) = 0;
+  virtual bool writeLogic(int group, const double *times, const quint32 *words, int count, bool frame) = 0;
+  /// Dopíše zbytek (rejstřík), soubor se zavře se smazáním objektu
+  virtual bool finish() = 0;
+  virtual qint64 bytesWritten() const = 0;
+
+  /// Zapíše vyrovnávací paměti souboru až na disk
+  bool sync() {
+    if (!file.flush())
+      return false;
+#ifdef Q_OS_WIN
+    return _commit(file.handle()) == 0;
+#else
+    return fsync(file.handle()) == 0;
+#endif
+  }
+  QString errorString() const { return file.errorString(); }
+
+protected:
+  QFile file;
+};
+
+namespace {
+
+/// Binární záznam (stejný formát jako uložený záznam grafu), streamy se přidávají podle toho, co přijde
+/// Body a průběhy kanálu jsou v oddělených streamech, každý průběh začíná blokem s příznakem začátku průběhu,
+/// protože jeho časová osa začíná znovu. Soubor jde otevřít až po zapsání rejstříku při zavření (stop, rotace).
+class BinaryLogSink : public LogSink {
+public:
+  explicit BinaryLogSink(const QString &fileName) : LogSink(fileName) {
+    for (int frame = 0; frame < 2; frame++) {
+      std::fill(std::begin(analogStreams[frame]), std::end(analogStreams[frame]), -1);
+      std::fill(std::begin(logicStreams[frame]), std::end(logicStreams[frame]), -1);
+    }
+  }
+  ~BinaryLogSink() { delete writer; }
+
+  bool begin() override {
+    if (!file.open(QIODevice::WriteOnly))
+      return false;
+    writer = new CaptureWriter(file);
+    return writer->begin();
+  }
+
+  bool writeAnalog(int ch, const QCPGraphData *data, int count, bool frame) override {
+    int &stream = analogStreams[frame][ch];
+    if (stream < 0)
+      stream = writer->addStream(ch, false);
+    return writer->writeAnalog(stream, data, count, frame);
+  }
+
+  bool writeLogic(int group, const double *times, const quint32 *words, int count, bool frame) override {
+    int &stream = logicStreams[frame][group];
+    if (stream < 0)
+      stream = writer->addStream(group, true, 0, 1);
+    // Počet bitů skupiny není předem známý, stačí nejvyšší bit, který kdy byl v 1
+    quint32 ever = 0;
+    for (int i = 0; i < count; i++)
+      ever |= words[i];
+    while (ever >> logicBits[group])
+      logicBits[group]++;
+    writer->setBitCount(stream, qMax(logicBits[group], 1));
+    return writer->writeLogicWords(stream, times, words, count, frame);
+  }
+
+  bool finish() override { return writer->finish(); }
+  qint64 bytesWritten() const override { return writer->bytesWritten(); }
+
+private:
+  CaptureWriter *writer = nullptr;
+  /// [0] body, [1] průběhy
+  int analogStreams[2][ANALOG_COUNT];
+  int logicStreams[2][LOGIC_GROUPS];
+  int logicBits[LOGIC_GROUPS] = {};
+};
+
+/// CSV v dlouhém tvaru (čas, kanál, hodnota), logika jako celé slovo skupiny
+class CsvLogSink : public LogSink {
+public:
+  CsvLogSink(const QString &fileName, CsvFormat format) : LogSink(fileName), format(format) {
+    for (int ch = 0; ch < ANALOG_COUNT; ch++)
+      analogNames[ch] = getChName(ch).toUtf8();
+    for (int group = 0; group < LOGIC_GROUPS; group++)
+      logicNames[group] = QObject::tr("Logic %1").arg(group + 1).toUtf8();
+  }
+
+  bool begin() override {
+    if (!file.open(QIODevice::WriteOnly))
+      return false;
+    QByteArray header = QObject::tr("time").toUtf8() + format.separator + QObject::tr("channel").toUtf8() + format.separator + QObject::tr("value").toUtf8() + '\n';
+    return write(header.constData(), header.size());
+  }
+
+  bool writeAnalog(int ch, const QCPGraphData *data, int count, bool frame) override {
+    Q_UNUSED(frame); // Řádky jsou nezávislé, průběh se pozná podle návratu času
+    QByteArray text(qMin(count, LOGGER_CSV_ROWS) * (2 * CsvFormat::maxNumberLength + analogNames[ch].size() + 3), Qt::Uninitialized);
+    for (int offset = 0; offset < count; offset += LOGGER_CSV_ROWS) {
+      char *out = text.data();
+      for (int i = offset; i < qMin(count, offset + LOGGER_CSV_ROWS); i++) {
+        out = format.write(out, data[i].key);
+        *out++ = format.separator;
+        out = std::copy(analogNames[ch].constBegin(), analogNames[ch].constEnd(), out);
+        *out++ = format.separator;
+        out = format.write(out, data[i].value);
+        *out++ = '\n';
+      }
+      if (!write(text.constData(), out - text.constData()))
+        return false;
+    }
+    return true;
+  }
+
+  bool writeLogic(int group, const double *times, const quint32 *words, int count, bool frame) override {
+    Q_UNUSED(frame);
+    QByteArray text;
+    for (int offset = 0; offset < count; offset += LOGGER_CSV_ROWS) {
+      text.clear();
+      for (int i = offset; i < qMin(count, offset + LOGGER_CSV_ROWS); i++) {
+        char number[CsvFormat::maxNumberLength];
+        text.append(number, format.write(number, times[i]) - number);
+        text.append(format.separator);
+        text.append(logicNames[group]);
+        text.append(format.separator);
+        text.append(QByteArray::number(words[i]));
+        text.append('\n');
+      }
+      if (!write(text.constData(), text.size()))
+        return false;
+    }
+    return true;
+  }
+
+  bool finish() override { return file.flush(); }
+  qint64 bytesWritten() const override { return written; }
+
+private:
+  bool write(const char *text, qint64 size) {
+    if (file.write(text, size) != size)
+      return false;
+    written += size;
+    return true;
+  }
+
+  CsvFormat format;
+  QByteArray analogNames[ANALOG_COUNT];
+  QByteArray logicNames[LOGIC_GROUPS];
+  qint64 written = 0;
+};
+
+} // namespace
+
+DataLogger::DataLogger(QObject *parent) : QObject(parent), drainTimer(this) {
+  drainTimer.setInterval(LOGGER_DRAIN_INTERVAL);
+  connect(&drainTimer, &QTimer::timeout, this, &DataLogger::drain);
+}
+
+DataLogger::~DataLogger() { delete sink; }
+
+void DataLogger::logPoint(int ch, double time, double value) {
+  if (!running.loadRelaxed())
+    return;
+  Record record;
+  record.kind = Record::point;
+  record.channel = ch;
+  record.time = time;
+  record.value = value;
+  enqueue(std::move(record), 1);
+}
+
+void DataLogger::logVector(int ch, QSharedPointer<QCPGraphDataContainer> data) {
+  if (!running.loadRelaxed() || data->isEmpty())
+    return;
+  Record record;
+  record.kind = Record::vector;
+  record.channel = ch;
+  qint64 samples = data->size();
+  record.data = std::move(data);
+  enqueue(std::move(record), samples);
+}
+
+void DataLogger::logLogicWords(int group, QVector<double> times, QVector<quint32> words, bool continuous) {
+  Q_UNUSED(continuous); // Průběh se zapíše celý, body chodí přes logLogicWord
+  if (!running.loadRelaxed() || times.isEmpty())
+    return;
+  Record record;
+  record.kind = Record::logic;
+  record.channel = group;
+  qint64 samples = times.size();
+  record.times = std::move(times);
+  record.words = std::move(words);
+  enqueue(std::move(record), samples);
+}
+
+void DataLogger::logLogicWord(int group, double time, quint32 word) {
+  if (!running.loadRelaxed())
+    return;
+  Record record;
+  record.kind = Record::logicPoint;
+  record.channel = group;
+  record.time = time;
+  record.word = word;
+  enqueue(std::move(record), 1);
+}
+
+void DataLogger::enqueue(Record &&record, qint64 samples) {
+  record.enqueued = LatencyTrace::now();
+  if (!queue.push(std::move(record)))
+    Metrics::add(Metrics::loggerSamplesDropped, samples);
+}
+
+void DataLogger::start(LoggerSettings settings) {
+  if (sink)
+    stop();
+  this->settings = settings;
+  fileIndex = 0;
+  // Ve frontě mohou zůstat data vložená těsně po předchozím zastavení
+  Record record;
+  while (queue.pop(record))
+    ;
+  if (!openFile())
+    return;
+  running.storeRelaxed(1);
+  drainTimer.start();
+}
+
+void DataLogger::stop() {
+  if (!sink)
+    return;
+  running.storeRelaxed(0);
+  drainTimer.stop();
+  drain();
+  if (sink && (!flushAll() || !closeFile()))
+    fail(tr("Cannot write log file: %1").arg(sink->errorString()));
+  Metrics::set(Metrics::loggerQueueDepth, 0);
+  Metrics::set(Metrics::loggerLag, 0);
+}
+
+void DataLogger::drain() {
+  TRACE_SCOPE("logger", "DataLogger::drain");
+  quint32 count = queue.size();
+  Metrics::set(Metrics::loggerQueueDepth, count);
+  qint64 lag = 0;
+  Record record;
+  // Jen to, co ve frontě bylo na začátku, aby výběr při trvalém přísunu dat neběžel donekonečna
+  for (quint32 i = 0; i < count && queue.pop(record); i++) {
+    if (i == 0)
+      lag = LatencyTrace::now() - record.enqueued;
+    if (!process(record)) {
+      fail(tr("Cannot write log file: %1").arg(sink->errorString()));
+      return;
+    }
+  }
+  Metrics::set(Metrics::loggerLag, lag);
+
+  if (sinceFlush.elapsed() >= 1000) {
+    sinceFlush.restart();
+    if (!flushAll() || (settings.sync == LogSync::everySecond && !sink->sync())) {
+      fail(tr("Cannot write log file: %1").arg(sink->errorString()));
+      return;
+    }
+  }
+  Metrics::add(Metrics::loggerBytes, sink->bytesWritten() - reportedBytes);
+  reportedBytes = sink->bytesWritten();
+
+  // Při zastavení (running = 0) se už nový soubor neotevírá
+  bool rotate = (settings.rotateBytes > 0 && sink->bytesWritten() >= settings.rotateBytes) || (settings.rotateSeconds > 0 && fileAge.elapsed() >= settings.rotateSeconds * 1000LL);
+  if (!rotate || !running.loadRelaxed())
+    return;
+  if (!flushAll() || !closeFile()) {
+    fail(tr("Cannot write log file: %1").arg(sink->errorString()));
+    return;
+  }
+  openFile(); // Při chybě už logování zastavilo
+}
+
+bool DataLogger::process(Record &record) {
+  switch (record.kind) {
+  case Record::point:
+    if (record.channel < 0 || record.channel >= ANALOG_COUNT)
+      return true;
+    points[record.channel].append(QCPGraphData(record.time, record.value));
+    return points[record.channel].size() < CAPTURE_CHUNK_SAMPLES || flushPoints(record.channel);
+  case Record::vector:
+    if (record.channel < 0 || record.channel >= ANALOG_COUNT)
+      return true;
+    // Body kanálu přijaté před průběhem musí být v souboru dřív
+    if (!flushPoints(record.channel))
+      return false;
+    Metrics::add(Metrics::loggerSamples, record.data->size());
+    return sink->writeAnalog(record.channel, &*record.data->constBegin(), record.data->size(), true);
+  case Record::logicPoint:
+    if (record.channel < 0 || record.channel >= LOGIC_GROUPS)
+      return true;
+    logicTimes[record.channel].append(record.time);
+    logicWords[record.channel].append(record.word);
+    return logicTimes[record.channel].size() < CAPTURE_CHUNK_SAMPLES || flushLogic(record.channel);
+  case Record::logic: {
+    int group = record.channel;
+    if (group < 0 || group >= LOGIC_GROUPS)
+      return true;
+    int count = qMin(record.times.size(), record.words.size());
+    if (!flushLogic(group))
+      return false;
+    Metrics::add(Metrics::loggerSamples, count);
+    return sink->writeLogic(group, record.times.constData(), record.words.constData(), count, true);
+  }
+  }
+  return true;
+}
+
+bool DataLogger::flushPoints(int ch) {
+  if (points[ch].isEmpty())
+    return true;
+  Metrics::add(Metrics::loggerSamples, points[ch].size());
+  bool ok = sink->writeAnalog(ch, points[ch].constData(), points[ch].size(), false);
+  points[ch].clear();
+  return ok;
+}
+
+bool DataLogger::flushLogic(int group) {
+  if (logicTimes[group].isEmpty())
+    return true;
+  Metrics::add(Metrics::loggerSamples, logicTimes[group].size());
+  bool ok = sink->writeLogic(group, logicTimes[group].constData(), logicWords[group].constData(), logicTimes[group].size(), false);
+  logicTimes[group].clear();
+  logicWords[group].clear();
+  return ok;
+}
+
+bool DataLogger::flushAll() {
+  for (int ch = 0; ch < ANALOG_COUNT; ch++)
+    if (!flushPoints(ch))
+      return false;
+  for (int group = 0; group < LOGIC_GROUPS; group++)
+    if (!flushLogic(group))
+      return false;
+  return true;
+}
+
+bool DataLogger::openFile() {
+  QFileInfo info(settings.fileName);
+  QString fileName = info.dir().filePath(QString("%1_%2_%3.%4").arg(info.completeBaseName(), QDateTime::currentDateTime().toString("yyyyMMdd_HHmmss")).arg(++fileIndex, 3, 10, QChar('0')).arg(info.suffix()));
+  if (settings.format == LogFormat::csv)
+    sink = new CsvLogSink(fileName, settings.csv);
+  else
+    sink = new BinaryLogSink(fileName);
+  if (!sink->begin()) {
+    fail(tr("Cannot open log file %1: %2").arg(fileName, sink->errorString()));
+    return false;
+  }
+  reportedBytes = 0;
+  fileAge.start();
+  sinceFlush.start();
+  emit fileOpened(fileName);
+  return true;
+}
+
+bool DataLogger::closeFile() {
+  bool ok = sink->finish();
+  if (ok && settings.sync != LogSync::never)
+    ok = sink->sync();
+  Metrics::add(Metrics::loggerBytes, sink->bytesWritten() - reportedBytes);
+  reportedBytes = 0;
+  if (ok) {
+    delete sink;
+    sink = nullptr;
+  }
+  return ok;
+}
+
+void DataLogger::fail(QString message) {
+  running.storeRelaxed(0);
+  drainTimer.stop();
+  delete sink;
+  sink = nullptr;
+  for (auto &channel : points)
+    channel.clear();
+  for (int group = 0; group < LOGIC_GROUPS; group++) {
+    logicTimes[group].clear();
+    logicWords[group].clear();
+  }
+  emit error(message);
+}
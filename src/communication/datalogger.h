@@ -0,0 +1,102 @@
+//  Copyright (C) 2020-2024  Jiří Maier
+
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef DATALOGGER_H
+#define DATALOGGER_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QTimer>
+
+#include "communication/spscqueue.h"
+#include "global.h"
+#include "plots/csvexport.h"
+#include "utils.h"
+
+/// Nastavení průběžného logování
+struct LoggerSettings {
+  QString fileName; ///< Základ jména, ke každému souboru se přidá čas otevření a pořadí
+  LogFormat::enumLogFormat format = LogFormat::binary;
+  qint64 rotateBytes = 0; ///< Nový soubor po překročení velikosti (0 = bez omezení)
+  int rotateSeconds = 0;  ///< Nový soubor po uplynutí doby (0 = bez omezení)
+  LogSync::enumLogSync sync = LogSync::onClose;
+  CsvFormat csv;
+};
+
+class LogSink;
+
+/// Průběžné logování přijatých dat na disk během měření
+/// Vlákno parseru jen vloží sdílená data do fronty bez zámků (logPoint, logVector, logLogicWords se připojují přímo),
+/// zápis do souboru běží na vlastním vlákně. Když zápis nestíhá a fronta je plná, data se zahodí a započítají,
+/// příjem dat se nikdy nezdrží. Body se shromažďují a zapisují po blocích (nejvýše CAPTURE_CHUNK_SAMPLES a aspoň jednou za sekundu).
+class DataLogger : public QObject {
+  Q_OBJECT
+public:
+  explicit DataLogger(QObject *parent = nullptr);
+  ~DataLogger();
+
+  /// Producent (vlákno parseru)
+  void logPoint(int ch, double time, double value);
+  void logVector(int ch, QSharedPointer<QCPGraphDataContainer> data);
+  void logLogicWords(int group, QVector<double> times, QVector<quint32> words, bool continuous);
+  void logLogicWord(int group, double time, quint32 word);
+
+public slots:
+  void start(LoggerSettings settings);
+  void stop();
+
+signals:
+  void fileOpened(QString fileName);
+  /// Logování skončilo chybou
+  void error(QString message);
+
+private:
+  struct Record {
+    enum Kind { point, vector, logicPoint, logic } kind = point;
+    int channel = 0; ///< U logiky číslo skupiny
+    double time = 0, value = 0;
+    quint32 word = 0;
+    QSharedPointer<QCPGraphDataContainer> data;
+    QVector<double> times;
+    QVector<quint32> words;
+    qint64 enqueued = 0; ///< LatencyTrace::now() při vložení do fronty
+  };
+
+  void enqueue(Record &&record, qint64 samples);
+  void drain();
+  bool process(Record &record);
+  bool flushPoints(int ch);
+  bool flushLogic(int group);
+  bool flushAll();
+  bool openFile();
+  bool closeFile();
+  void fail(QString message);
+
+  SpscQueue<Record> queue{1 << 16};
+  QAtomicInt running{0};
+
+  LoggerSettings settings;
+  LogSink *sink = nullptr;
+  int fileIndex = 0;
+  QTimer drainTimer;
+  QElapsedTimer fileAge, sinceFlush;
+  qint64 reportedBytes = 0;
+  /// Body čekající na zápis (po kanálech a skupinách logiky)
+  QVector<QCPGraphData> points[ANALOG_COUNT];
+  QVector<double> logicTimes[LOGIC_GROUPS];
+  QVector<quint32> logicWords[LOGIC_GROUPS];
+};
+
+#endif // DATALOGGER_H
@@ -0,0 +1,156 @@
+//  Copyright (C) 2020-2024  Jiří Maier
+
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "latencytrace.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QtMath>
+
+namespace {
+// Koše histogramu jsou logaritmické, 4 na dvojnásobek, od 1 µs do cca 17 s (rozlišení ~19 %)
+const int bucketsPerOctave = 4;
+const int bucketCount = 24 * bucketsPerOctave + 1;
+
+struct Histogram {
+  quint64 buckets[bucketCount] = {};
+  quint64 count = 0;
+  qint64 max = 0;
+};
+
+QMutex histogramMutex;
+Histogram histograms[LatencyTrace::STAGE_COUNT];
+thread_local LatencyTrace::Stamp currentStamp;
+
+QElapsedTimer &clock() {
+  static QElapsedTimer timer = [] {
+    QElapsedTimer t;
+    t.start();
+    return t;
+  }();
+  return timer;
+}
+
+int bucketOf(qint64 nanoseconds) {
+  if (nanoseconds < 1000)
+    return 0;
+  int bucket = 1 + (int)(qLn(nanoseconds / 1000.0) / qLn(2.0) * bucketsPerOctave);
+  return qMin(bucket, bucketCount - 1);
+}
+
+/// Horní mez koše v ns
+double bucketLimit(int bucket) { return 1000.0 * qPow(2.0, (double)bucket / bucketsPerOctave); }
+
+double percentile(const Histogram &histogram, double fraction) {
+  quint64 target = qMax<quint64>(1, qCeil(histogram.count * fraction));
+  quint64 sum = 0;
+  for (int i = 0; i < bucketCount; i++) {
+    sum += histogram.buckets[i];
+    if (sum >= target)
+      return qMin(bucketLimit(i), (double)histogram.max) * 1e-9;
+  }
+  return histogram.max * 1e-9;
+}
+} // namespace
+
+qint64 LatencyTrace::now() { return clock().nsecsElapsed() + 1; }
+
+LatencyTrace::Scope::Scope(qint64 readTime) { currentStamp = {readTime, readTime}; }
+
+LatencyTrace::Scope::~Scope() { currentStamp = Stamp(); }
+
+LatencyTrace::Stamp LatencyTrace::current() { return currentStamp; }
+
+void LatencyTrace::markCurrent(Stage stage) { mark(stage, currentStamp); }
+
+void LatencyTrace::mark(Stage stage, Stamp &stamp) {
+  if (!stamp.isValid())
+    return;
+  qint64 time = now();
+  record(stage, time - stamp.last);
+  stamp.last = time;
+}
+
+void LatencyTrace::finish(Stamp &stamp) {
+  if (!stamp.isValid())
+    return;
+  mark(rendering, stamp);
+  record(total, stamp.last - stamp.read);
+}
+
+void LatencyTrace::record(Stage stage, qint64 nanoseconds) {
+  QMutexLocker locker(&histogramMutex);
+  Histogram &histogram = histograms[stage];
+  histogram.buckets[bucketOf(nanoseconds)]++;
+  histogram.count++;
+  histogram.max = qMax(histogram.max, nanoseconds);
+}
+
+LatencyTrace::Summary LatencyTrace::summary(Stage stage) {
+  QMutexLocker locker(&histogramMutex);
+  const Histogram &histogram = histograms[stage];
+  Summary result;
+  result.count = histogram.count;
+  if (histogram.count == 0)
+    return result;
+  result.p50 = percentile(histogram, 0.5);
+  result.p99 = percentile(histogram, 0.99);
+  result.max = histogram.max * 1e-9;
+  return result;
+}
+
+QString LatencyTrace::stageName(Stage stage) {
+  switch (stage) {
+  case readerQueue:
+    return QCoreApplication::translate("LatencyTrace", "Port to parser");
+  case parsing:
+    return QCoreApplication::translate("LatencyTrace", "Parsing");
+  case processing:
+    return QCoreApplication::translate("LatencyTrace", "Processing");
+  case guiQueue:
+    return QCoreApplication::translate("LatencyTrace", "Queue to GUI");
+  case rendering:
+    return QCoreApplication::translate("LatencyTrace", "Replot");
+  case total:
+    return QCoreApplication::translate("LatencyTrace", "Total");
+  default:
+    return QString();
+  }
+}
+
+QByteArray LatencyTrace::toCsv(char separator) {
+  QMutexLocker locker(&histogramMutex);
+  QByteArray output = "upper limit [us]";
+  for (int stage = 0; stage < STAGE_COUNT; stage++)
+    output.append(separator).append(stageName((Stage)stage).toUtf8());
+  output.append('\n');
+  for (int i = 0; i < bucketCount; i++) {
+    output.append(QByteArray::number(bucketLimit(i) / 1000.0, 'g', 4));
+    for (int stage = 0; stage < STAGE_COUNT; stage++)
+      output.append(separator).append(QByteArray::number(histograms[stage].buckets[i]));
+    output.append('\n');
+  }
+  output.append("max [us]");
+  for (int stage = 0; stage < STAGE_COUNT; stage++)
+    output.append(separator).append(QByteArray::number(histograms[stage].max / 1000.0, 'g', 6));
+  output.append('\n');
+  return output;
+}
+
+void LatencyTrace::reset() {
+  QMutexLocker locker(&histogramMutex);
+  for (auto &histogram : histograms)
+    histogram = Histogram();
+}
@@ -0,0 +1,73 @@
+//  Copyright (C) 2020-2024  Jiří Maier
+
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef LATENCYTRACE_H
+#define LATENCYTRACE_H
+
+#include <QByteArray>
+#include <QString>
+#include <QtGlobal>
+
+/// Měření zpoždění dat od přečtení z portu po vykreslení grafu
+/// Každý přečtený úsek dostane monotónní časovou značku (Stamp), ta putuje s daty přes parser, PlotData a schránku
+/// grafu až do překreslení. Na konci každého úseku cesty se zapíše doba od předchozí značky do histogramu daného úseku.
+/// Uvnitř vlákna parseru (parser, PlotData a vkládání do schránky se volají přímo) se značka předává jako aktuální
+/// značka vlákna (Scope), mezi vlákny se posílá spolu s daty.
+class LatencyTrace {
+public:
+  enum Stage { readerQueue = 0, parsing, processing, guiQueue, rendering, total, STAGE_COUNT };
+
+  /// Časová značka dat (ns od spuštění programu), nulová značka znamená, že se data nesledují (ruční vstup, výpočty)
+  struct Stamp {
+    qint64 read = 0; ///< Přečtení z portu
+    qint64 last = 0; ///< Konec posledního úseku
+    bool isValid() const { return read != 0; }
+  };
+
+  struct Summary {
+    quint64 count = 0;
+    double p50 = 0, p99 = 0, max = 0; ///< V sekundách
+  };
+
+  /// Monotónní čas v ns (vždy nenulový)
+  static qint64 now();
+
+  /// Nastaví aktuální značku vlákna po dobu zpracování jednoho přečteného úseku
+  class Scope {
+  public:
+    explicit Scope(qint64 readTime);
+    ~Scope();
+  };
+  /// Aktuální značka vlákna (neplatná mimo Scope)
+  static Stamp current();
+  /// Zapíše úsek aktuální značky vlákna
+  static void markCurrent(Stage stage);
+
+  /// Zapíše dobu od konce předchozího úseku a posune značku
+  static void mark(Stage stage, Stamp &stamp);
+  /// Data jsou vykreslena, zapíše poslední úsek a celkové zpoždění
+  static void finish(Stamp &stamp);
+
+  static Summary summary(Stage stage);
+  static QString stageName(Stage stage);
+  /// Histogramy všech úseků (horní mez koše v µs a počty) ve formátu CSV
+  static QByteArray toCsv(char separator = ',');
+  static void reset();
+
+private:
+  static void record(Stage stage, qint64 nanoseconds);
+};
+
+#endif // LATENCYTRACE_H
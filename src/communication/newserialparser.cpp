@@ -14,6 +14,9 @@
 //  along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include "newserialparser.h"
+#include "communication/latencytrace.h"
+#include "metrics.h"
+#include "traceevents.h"
 
 NewSerialParser::NewSerialParser(MessageTarget::enumMessageTarget target, QObject *parent) : QObject(parent) {
   this->target = target;
@@ -93,7 +96,11 @@ void NewSerialParser::clearBuffer() {
   resetChHeader();
 }
 
-void NewSerialParser::parse(QByteArray newData) {
+void NewSerialParser::parse(QByteArray newData, qint64 readTime) {
+  TRACE_SCOPE("parser", "NewSerialParser::parse");
+  // PlotData i schránka grafu se volají přímo z tohoto vlákna, značku si převezmou jako aktuální značku vlákna
+  LatencyTrace::Scope latencyScope(readTime);
+  LatencyTrace::markCurrent(LatencyTrace::readerQueue);
   buffer.push_back(newData);
   while (!buffer.isEmpty()) {
     try {
@@ -589,8 +596,10 @@ void NewSerialParser::parse(QByteArray newData) {
       }
 
     } catch (QString message) {
+      Metrics::add(Metrics::parseErrors);
       sendMessageIfAllowed(tr("Parsing error"), message, MessageLevel::error);
       if (!buffer.isEmpty()) {
+        Metrics::add(Metrics::resyncs);
         if (buffer.contains("$$"))
           buffer.remove(0, buffer.indexOf("$$"));
         else
@@ -603,9 +612,12 @@ void NewSerialParser::parse(QByteArray newData) {
       }
       changeMode(DataMode::unknown, currentMode, tr("Unknown").toUtf8());
     } catch (...) {
+      Metrics::add(Metrics::parseErrors);
       sendMessageIfAllowed(tr("Fatal error"), QString(""), MessageLevel::error);
     }
   }
+  if (target == MessageTarget::serial1)
+    Metrics::set(Metrics::parserBufferBytes, buffer.size());
 }
 
 NewSerialParser::readResult NewSerialParser::bufferReadPoint(QList<QPair<ValueType, QByteArray>> &result) {
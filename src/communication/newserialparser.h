@@ -102,8 +102,8 @@ private slots:
   void printUnknownToTerminalTimerSlot();
 
 public slots:
-  /// Zpracuje data
-  void parse(QByteArray newData);
+  /// Zpracuje data, readTime je časová značka přečtení pro měření zpoždění (0 = nesleduje se)
+  void parse(QByteArray newData, qint64 readTime = 0);
   /// Clear buffers
   void clearBuffer();
   /// Show content of buffers
@@ -14,6 +14,9 @@
 //  along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include "plotdata.h"
+#include "communication/latencytrace.h"
+#include "metrics.h"
+#include "traceevents.h"
 
 PlotData::PlotData(QObject *parent) : QObject(parent) {
   for (int i = 0; i < LOGIC_GROUPS - 1; i++) {
@@ -22,6 +25,7 @@ PlotData::PlotData(QObject *parent) : QObject(parent) {
   }
   for (int i = 0; i < MATH_COUNT; i++) {
     mathFirsts[i] = 0;
+    mathExpressionInputs[i] = 0;
     mathSeconds[i] = 0;
   }
   reset();
@@ -151,12 +155,15 @@ uint32_t PlotData::getBits(QPair<ValueType, QByteArray> value) {
 }
 
 void PlotData::addPoint(QList<QPair<ValueType, QByteArray>> data) {
+  TRACE_SCOPE("data", "PlotData::addPoint");
+  LatencyTrace::markCurrent(LatencyTrace::parsing);
   QString message;
   if (data.length() > ANALOG_COUNT) {
     QByteArray message = QString::number(data.length() - 1).toUtf8();
     sendMessageIfAllowed(tr("Too many channels in point (missing ';' ?)").toUtf8(), message, MessageLevel::error);
     return;
   }
+  Metrics::add(Metrics::pointFrames);
   bool isok;
   double time;
   if (data.at(0).second.isEmpty()) {
@@ -188,6 +195,8 @@ void PlotData::addPoint(QList<QPair<ValueType, QByteArray>> data) {
     if (debugLevel == OutputLevel::info)
       message.append(tr("Time: %1 s, ").arg(QString::number(time, 'g', 5)));
   }
+  double triggerValues[ANALOG_COUNT];
+  quint32 triggerPresent = 0;
   for (unsigned int ch = 1; (int)ch < data.length(); ch++) {
     if (data.at(ch).second.isEmpty())
       continue;
@@ -196,6 +205,9 @@ void PlotData::addPoint(QList<QPair<ValueType, QByteArray>> data) {
       sendMessageIfAllowed(tr("Can not parse points value").toUtf8(), data.at(ch).second, MessageLevel::error);
       return;
     }
+    if (filters[ch - 1].isEnabled())
+      value = filters[ch - 1].processPoint(time, value);
+    emit logPoint(ch - 1, time, value);
 
     bool isLogic = false;
     for (int i = 0; i < LOGIC_GROUPS - 1; i++)
@@ -216,6 +228,7 @@ void PlotData::addPoint(QList<QPair<ValueType, QByteArray>> data) {
           for (uint8_t bit = 0; bit < bits; bit++) {
             emit addPointToPlot(getLogicChannelID(logicGroup, bit), time, digitalChannels.at(bit), time >= lastTime);
           }
+          emit addLogicWord(logicGroup, time, digitalValue);
         }
       } else {
         sendMessageIfAllowed(tr("Can not show channel %1 as logic").arg(ch), tr("digital mode is only available for unsigned integer data type").toUtf8(), MessageLevel::warning);
@@ -223,17 +236,29 @@ void PlotData::addPoint(QList<QPair<ValueType, QByteArray>> data) {
     }
 
     updatesCounters[ch]++;
+    rates[ch - 1].addPoint(time);
+    Metrics::add(Metrics::samplesParsed);
 
     emit setExpectedRange(ch - 1, false, 0, 0);
 
-    if (averagerEnabled)
+    if (trigger.isEnabled()) {
+      triggerValues[ch - 1] = value;
+      triggerPresent |= 1u << (ch - 1);
+    } else if (averagerEnabled)
       emit addPointToAverager(ch - 1, time, value, time >= lastTime);
     else
       emit addPointToPlot(ch - 1, time, value, time >= lastTime);
 
+    if (spectrogramChannel == (int)ch - 1)
+      emit addPointToSpectrogram(ch - 1, time, value);
+
     if (debugLevel == OutputLevel::info)
       message.append(tr("Ch%1: %2, ").arg(ch).arg(QString::number(value, 'g', 5)));
 
+    // S triggerem jde do grafu a výpočtů až celý průběh
+    if (trigger.isEnabled())
+      continue;
+
     for (int math = 0; math < MATH_COUNT; math++) {
       if (mathFirsts[math] == ch) {
         auto point = QSharedPointer<QCPGraphDataContainer>(new QCPGraphDataContainer());
@@ -245,8 +270,15 @@ void PlotData::addPoint(QList<QPair<ValueType, QByteArray>> data) {
         point->add(QCPGraphData(time, value));
         emit addMathData(math, false, point);
       }
+      if (mathExpressionInputs[math] & (1u << (ch - 1))) {
+        auto point = QSharedPointer<QCPGraphDataContainer>(new QCPGraphDataContainer());
+        point->add(QCPGraphData(time, value));
+        emit addMathExpressionData(math, ch - 1, point);
+      }
     }
   }
+  if (trigger.isEnabled() && trigger.addPoint(time, triggerValues, triggerPresent))
+    sendTriggeredFrames();
   lastTime = time;
   if (debugLevel == OutputLevel::info) {
     message.remove(message.length() - 2, 2); // Odstraní ", " na konci
@@ -254,7 +286,27 @@ void PlotData::addPoint(QList<QPair<ValueType, QByteArray>> data) {
   }
 }
 
+void PlotData::sendTriggeredFrames() {
+  // Průběhy mají společnou časovou osu (0 = spuštění), do výpočtů jdou stejně jako kanály $$C
+  for (const auto& frame : trigger.takeFrames()) {
+    unsigned int ch = frame.first + 1;
+    for (int math = 0; math < MATH_COUNT; math++) {
+      if (mathFirsts[math] == ch)
+        emit addMathData(math, true, frame.second);
+      if (mathSeconds[math] == ch)
+        emit addMathData(math, false, frame.second);
+      if (mathExpressionInputs[math] & (1u << frame.first))
+        emit addMathExpressionData(math, frame.first, frame.second);
+    }
+    emit addVectorToPlot(frame.first, frame.second);
+    if (persistenceChannel == frame.first)
+      emit addDataToPersistence(frame.first, frame.second);
+  }
+}
+
 void PlotData::addLogicPoint(QPair<ValueType, QByteArray> timeArray, QPair<ValueType, QByteArray> valueArray, unsigned int bits) {
+  TRACE_SCOPE("data", "PlotData::addLogicPoint");
+  LatencyTrace::markCurrent(LatencyTrace::parsing);
   bool isok;
   double time;
   if (timeArray.second.isEmpty()) {
@@ -284,8 +336,12 @@ void PlotData::addLogicPoint(QPair<ValueType, QByteArray> timeArray, QPair<Value
       double value = ((bool)((digitalValue) & ((uint32_t)1 << (bit)))) + bit * 3;
       emit addPointToPlot(getLogicChannelID(2, bit), time, value, time >= lastTime);
     }
+    emit addLogicWord(LOGIC_GROUPS - 1, time, digitalValue);
 
     updatesCounters[-1]++;
+    rates[ANALOG_COUNT].addPoint(time);
+    Metrics::add(Metrics::logicPointFrames);
+    Metrics::add(Metrics::samplesParsed);
   }
 
   if (debugLevel == OutputLevel::info)
@@ -295,6 +351,8 @@ void PlotData::addLogicPoint(QPair<ValueType, QByteArray> timeArray, QPair<Value
 }
 
 void PlotData::addChannel(QPair<ValueType, QByteArray> data, unsigned int ch, QPair<ValueType, QByteArray> timeRaw, int zeroIndex, int bits, QPair<ValueType, QByteArray> min, QPair<ValueType, QByteArray> max) {
+  TRACE_SCOPE("data", "PlotData::addChannel");
+  LatencyTrace::markCurrent(LatencyTrace::parsing);
   // Zjistí datový typ vstupu
   // QByteArray typeID, numberBytes;
 
@@ -367,6 +425,9 @@ void PlotData::addChannel(QPair<ValueType, QByteArray> data, unsigned int ch, QP
       valuesDigital.append(getBits(QPair<ValueType, QByteArray>(data.first, data.second.mid(i, data.first.bytes))));
     analogData->add(point);
   }
+  if (filters[ch - 1].isEnabled() && !analogData->isEmpty())
+    filters[ch - 1].processFrame(timeStep, &*analogData->begin(), analogData->size());
+  emit logVector(ch - 1, analogData);
 
   // Pošle kanál do grafu a případně do výpočtů
   for (int math = 0; math < MATH_COUNT; math++) {
@@ -374,6 +435,8 @@ void PlotData::addChannel(QPair<ValueType, QByteArray> data, unsigned int ch, QP
       emit addMathData(math, true, analogData);
     if (mathSeconds[math] == ch)
       emit addMathData(math, false, analogData);
+    if (mathExpressionInputs[math] & (1u << (ch - 1)))
+      emit addMathExpressionData(math, ch - 1, analogData);
   }
 
   if (remap)
@@ -382,12 +445,24 @@ void PlotData::addChannel(QPair<ValueType, QByteArray> data, unsigned int ch, QP
     emit setExpectedRange(ch - 1, false, 0, 0);
 
   updatesCounters[ch]++;
+  rates[ch - 1].addFrame(analogData->size(), timeStep);
+  Metrics::add(Metrics::channelFrames);
+  Metrics::add(Metrics::samplesParsed, analogData->size());
 
   if (averagerEnabled)
     emit addDataToAverager(ch - 1, timeStep, analogData);
   else
     emit addVectorToPlot(ch - 1, analogData);
 
+  if (spectrogramChannel == (int)ch - 1)
+    emit addDataToSpectrogram(ch - 1, timeStep, analogData);
+
+  if (statisticsChannels & (1u << (ch - 1)))
+    emit addDataToStatistics(ch - 1, analogData);
+
+  if (persistenceChannel == (int)ch - 1)
+    emit addDataToPersistence(ch - 1, analogData);
+
   if (isLogic) {
     // Pošle do grafu logický kanál
     QVector<QSharedPointer<QCPGraphDataContainer>> digitalChannels;
@@ -405,11 +480,14 @@ void PlotData::addChannel(QPair<ValueType, QByteArray> data, unsigned int ch, QP
       for (uint8_t bit = 0; bit < bits; bit++) {
         emit addVectorToPlot(getLogicChannelID(logicGroup, bit), digitalChannels.at(bit));
       }
+      emit addLogicWords(logicGroup, times, valuesDigital, false);
     }
   }
 }
 
 void PlotData::addLogicChannel(QPair<ValueType, QByteArray> data, QPair<ValueType, QByteArray> timeRaw, int bits, int zeroIndex) {
+  TRACE_SCOPE("data", "PlotData::addLogicChannel");
+  LatencyTrace::markCurrent(LatencyTrace::parsing);
   // Převede časový interval na číslo
   bool isok;
   double timeStep = getValue(timeRaw, isok);
@@ -435,6 +513,9 @@ void PlotData::addLogicChannel(QPair<ValueType, QByteArray> data, QPair<ValueTyp
   }
 
   updatesCounters[-1]++;
+  rates[ANALOG_COUNT].addFrame(times.size(), timeStep);
+  Metrics::add(Metrics::logicChannelFrames);
+  Metrics::add(Metrics::samplesParsed, times.size());
 
   // Pošle do grafu logický kanál
   QVector<QSharedPointer<QCPGraphDataContainer>> digitalChannels;
@@ -447,11 +528,17 @@ void PlotData::addLogicChannel(QPair<ValueType, QByteArray> data, QPair<ValueTyp
   for (uint8_t bit = 0; bit < bits; bit++)
     emit addVectorToPlot(getLogicChannelID(LOGIC_GROUPS - 1, bit),
                          digitalChannels.at(bit)); // Posláno jako poslední logické skupina
+  emit addLogicWords(LOGIC_GROUPS - 1, times, valuesDigital, false);
 }
 
 void PlotData::reset() {
   lastTime = INFINITY;
   timerRunning = false;
+  for (auto &rate : rates)
+    rate = RateAccumulator();
+  for (int i = 0; i < ANALOG_COUNT; i++)
+    filters[i].reset();
+  trigger.reset();
 }
 
 void PlotData::setDigitalChannel(int logicGroup, int ch) {
@@ -475,9 +562,62 @@ void PlotData::updateCounterTimer() {
       max = it.value();
   updatesCounters.clear();
   emit dataRateUpdate(max);
+
+  QVector<ChannelRate> channelRates;
+  for (int i = 0; i <= ANALOG_COUNT; i++)
+    if (rates[i].samples > 0)
+      channelRates.append(rates[i].take(i < ANALOG_COUNT ? i + 1 : 0));
+  qint64 bytes = Metrics::value(Metrics::bytesReceived);
+  emit sampleRateUpdate(channelRates, bytes - lastBytesReceived);
+  lastBytesReceived = bytes;
+}
+
+void PlotData::RateAccumulator::addPoint(double time) {
+  samples++;
+  if (time > lastPointTime) { // Nepravda i pro NaN (první bod)
+    double interval = time - lastPointTime;
+    intervals++;
+    intervalSum += interval;
+    intervalSquares += interval * interval;
+    maxInterval = qMax(maxInterval, interval);
+    if (expectedInterval > 0 && interval > 1.5 * expectedInterval)
+      gaps++;
+  }
+  lastPointTime = time;
+}
+
+void PlotData::RateAccumulator::addFrame(int count, double timeStep) {
+  samples += count;
+  frames++;
+  frameIntervalSum += timeStep;
+  lastPointTime = qQNaN(); // Průběh navazuje na body jen náhodou
+}
+
+ChannelRate PlotData::RateAccumulator::take(int ch) {
+  ChannelRate rate;
+  rate.ch = ch;
+  rate.samples = samples;
+  if (intervals > 0) {
+    double mean = intervalSum / intervals;
+    rate.interval = mean;
+    rate.jitter = qSqrt(qMax(0.0, intervalSquares / intervals - mean * mean));
+    rate.maxInterval = maxInterval;
+    rate.gaps = gaps;
+    expectedInterval = mean;
+  } else if (frames > 0)
+    rate.interval = frameIntervalSum / frames;
+  samples = 0;
+  frames = 0;
+  frameIntervalSum = 0;
+  intervals = 0;
+  intervalSum = intervalSquares = maxInterval = 0;
+  gaps = 0;
+  return rate;
 }
 
 void PlotData::sendMessageIfAllowed(QString header, QByteArray message, MessageLevel::enumMessageLevel type) {
+  if (type == MessageLevel::error)
+    Metrics::add(Metrics::parseErrors); // Data se nepodařilo převést
   if ((int)debugLevel >= (int)type)
     emit sendMessage(header, message, type);
 }
@@ -26,8 +26,20 @@
 #include <QtMath>
 
 #include "global.h"
+#include "math/channelfilter.h"
+#include "math/triggerengine.h"
 #include "plots/qcustomplot.h"
 
+/// Příjem jednoho zdroje dat za poslední sekundu
+struct ChannelRate {
+  int ch = 0;              ///< Kanál od 1, 0 = logický kanál ($$L)
+  qint64 samples = 0;      ///< Vzorků za sekundu
+  double interval = 0;     ///< Odvozená vzorkovací perioda (z časů bodů nebo z periody kanálu)
+  double jitter = 0;       ///< Směrodatná odchylka intervalu mezi body
+  double maxInterval = 0;  ///< Nejdelší interval mezi body
+  int gaps = 0;            ///< Intervaly delší než 1,5× průměrného intervalu z předchozí sekundy
+};
+
 class PlotData : public QObject {
   Q_OBJECT
 public:
@@ -45,12 +57,37 @@ private:
   QTimer *updatesCounter;
   QMap<int, int> updatesCounters;
 
+  /// Průběžná statistika příjmu (sčítá se při dekódování, vyhodnotí se jednou za sekundu)
+  struct RateAccumulator {
+    qint64 samples = 0;
+    int frames = 0;
+    double frameIntervalSum = 0;
+    double lastPointTime = qQNaN();
+    int intervals = 0;
+    double intervalSum = 0, intervalSquares = 0, maxInterval = 0;
+    int gaps = 0;
+    double expectedInterval = 0;
+    void addPoint(double time);
+    void addFrame(int count, double timeStep);
+    ChannelRate take(int ch);
+  };
+  RateAccumulator rates[ANALOG_COUNT + 1]; ///< Poslední je logický kanál
+  qint64 lastBytesReceived = 0;
+
   unsigned int logicTargets[LOGIC_GROUPS - 1];
   unsigned int logicBits[LOGIC_GROUPS - 1];
   unsigned int mathFirsts[MATH_COUNT];
   unsigned int mathSeconds[MATH_COUNT];
+  quint32 mathExpressionInputs[MATH_COUNT]; ///< Kanály použité ve vzorci (bit 0 = kanál 1)
 
   bool averagerEnabled = false;
+  /// Filtruje se přímo ve vlákně parseru: trigger, výpočty, graf i logování potřebují filtrovaná data ve stejném pořadí, v jakém přišla
+  ChannelFilter filters[ANALOG_COUNT];
+  TriggerEngine trigger;
+  void sendTriggeredFrames();
+  int spectrogramChannel = -1;
+  int persistenceChannel = -1;
+  quint32 statisticsChannels = 0; ///< Kanály posílané do statistiky (bit 0 = kanál 1)
 
   // unsigned int xyFirst, xySecond;
   double getValue(QPair<ValueType, QByteArray> value, bool &isok);
@@ -78,9 +115,25 @@ public slots:
 
   void setMathFirst(int math, int ch);
   void setMathSecond(int math, int ch);
+  void setMathExpressionInputs(int math, quint32 channelMask) { mathExpressionInputs[math - 1] = channelMask; }
 
   void setAverager(bool enabled) { averagerEnabled = enabled; }
 
+  /// Nastaví filtr kanálu (chID od 0), filtruje se dřív, než data jdou do grafu, matematiky a průměrování
+  void setChannelFilter(int chID, FilterType::enumFilterType type, double frequency, double parameter) { filters[chID].configure(type, frequency, parameter); }
+
+  /// Nastaví trigger nad body ($$P), při zapnutém triggeru jdou do grafu jen celé průběhy zarovnané na okamžik spuštění
+  void setTrigger(TriggerMode::enumTriggerMode mode, int chID, double level, double width, double frameLength, double preTrigger) { trigger.configure(mode, chID, level, width, frameLength, preTrigger); }
+
+  /// Kanál, který se posílá do spektrogramu (-1 = žádný)
+  void setSpectrogramChannel(int chID) { spectrogramChannel = chID; }
+
+  /// Kanál, jehož průběhy ($$C i z triggeru) se posílají do zobrazení s dosvitem (-1 = žádný)
+  void setPersistenceChannel(int chID) { persistenceChannel = chID; }
+
+  /// Kanály, jejichž průběhy se posílají do statistiky měření (bit 0 = kanál 1)
+  void setStatisticsChannels(quint32 channelMask) { statisticsChannels = channelMask; }
+
 private slots:
   void updateCounterTimer();
 
@@ -95,10 +148,24 @@ signals:
   void addPointToPlot(int ch, double time, double value, bool append);
   void clearLogic(int group, int fromBit);
   void addMathData(int mathNumber, bool isFirst, QSharedPointer<QCPGraphDataContainer> in, bool shouldIgnorePause = false);
+  void addMathExpressionData(int mathNumber, int ch, QSharedPointer<QCPGraphDataContainer> in, bool shouldIgnorePause = false);
   void addDataToAverager(int chID, double samplingRate, QSharedPointer<QCPGraphDataContainer> data);
   void addPointToAverager(int ch, double time, double value, bool append);
+  void addDataToSpectrogram(int chID, double timeStep, QSharedPointer<QCPGraphDataContainer> data);
+  void addPointToSpectrogram(int chID, double time, double value);
+  void addDataToStatistics(int chID, QSharedPointer<QCPGraphDataContainer> data);
+  void addDataToPersistence(int chID, QSharedPointer<QCPGraphDataContainer> data);
+  /// Logická data ve tvaru slov (všechny bity vzorku v jednom čísle) pro dekodér a měření
+  void addLogicWords(int group, QVector<double> times, QVector<quint32> words, bool continuous);
+  /// Jeden logický bod (navazuje na předchozí data), bez alokace vektorů pro každý vzorek
+  void addLogicWord(int group, double time, quint32 word);
+  /// Přijatá data analogových kanálů (po filtru, před průměrováním a triggerem) pro průběžné logování, připojuje se přímo
+  void logPoint(int ch, double time, double value);
+  void logVector(int ch, QSharedPointer<QCPGraphDataContainer> data);
   void setExpectedRange(int chID, bool known, double min, double max);
   void dataRateUpdate(int perSec);
+  /// Vzorky za sekundu a časování jednotlivých kanálů, bytesPerSec je příjem z portu (i mimo data grafu)
+  void sampleRateUpdate(QVector<ChannelRate> rates, qint64 bytesPerSec);
 };
 
 #endif // PLOTTING_H
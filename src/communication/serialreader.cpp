@@ -14,6 +14,9 @@
 //  along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include "serialreader.h"
+#include "communication/latencytrace.h"
+#include "metrics.h"
+#include "traceevents.h"
 
 SerialReader::SerialReader(QObject *parent) : QObject(parent) {}
 
@@ -30,11 +33,15 @@ void SerialReader::setSimInputDialog(QSharedPointer<ManualInputDialog> simIn) {
 
 void SerialReader::startSimulatedInput() {
   connect(simulatedInputDialog.data(), &ManualInputDialog::sendManualInput, this, &SerialReader::newData);
+  connect(simulatedInputDialog->getRollingGenerator(), &SignalGenerator::sendData, this, &SerialReader::newData);
+  connect(simulatedInputDialog->getOscGenerator(), &SignalGenerator::sendData, this, &SerialReader::newData);
   simConnected = true;
 }
 
 void SerialReader::newData(QByteArray data) {
-  emit sendData(data);
+  TRACE_SCOPE("io", "SerialReader::newData");
+  Metrics::add(Metrics::bytesReceived, data.size());
+  emit sendData(data, LatencyTrace::now());
   if (serialMonitor)
     emit monitor(data);
 }
@@ -42,6 +49,8 @@ void SerialReader::newData(QByteArray data) {
 void SerialReader::endSim() {
   emit stopManualInputData();
   disconnect(simulatedInputDialog.data(), &ManualInputDialog::sendManualInput, this, &SerialReader::newData);
+  disconnect(simulatedInputDialog->getRollingGenerator(), &SignalGenerator::sendData, this, &SerialReader::newData);
+  disconnect(simulatedInputDialog->getOscGenerator(), &SignalGenerator::sendData, this, &SerialReader::newData);
   simConnected = false;
 }
 
@@ -49,8 +49,8 @@ signals:
   void connectionResult(bool connected, QString caption, QString details);
   /// Oznámý dokončení zápisu dat do portu
   void finishedWriting();
-  /// Počle přečtená data
-  void sendData(QByteArray data);
+  /// Počle přečtená data (readTime je časová značka LatencyTrace)
+  void sendData(QByteArray data, qint64 readTime);
   /// Oznámí připojení (očekává odpověď že parser je připravený)
   void started();
   /// Přeposílá data
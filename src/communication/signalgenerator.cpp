@@ -0,0 +1,188 @@
+//  Copyright (C) 2020-2024  Jiří Maier
+
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "signalgenerator.h"
+#include <QtMath>
+
+SignalGenerator::SignalGenerator(QObject *parent) : QObject(parent) {
+  timer = new QTimer(this);
+  timer->setTimerType(Qt::PreciseTimer);
+  connect(timer, &QTimer::timeout, this, &SignalGenerator::timerRoutine);
+}
+
+SignalGenerator::~SignalGenerator() { qDeleteAll(evaluators); }
+
+void SignalGenerator::setExpressions(QStringList expressions) {
+  qDeleteAll(evaluators);
+  evaluators.clear();
+  timeVariables.clear();
+  for (const QString &expression : expressions) {
+    auto *evaluator = new CompiledExpression();
+    timeVariables.append(evaluator->addVariable("time"));
+    // Kanály z grafu zde k dispozici nejsou
+    if (evaluator->setExpression(expression) && evaluator->getChannelMask() == 0) {
+      evaluators.append(evaluator);
+    } else {
+      delete evaluator;
+      evaluators.append(nullptr);
+    }
+  }
+  values.resize(evaluators.size());
+}
+
+void SignalGenerator::start() {
+  elapsed.start();
+  sentBytes = 0;
+  sentFrames = 0;
+  measuredBytes = 0;
+  measureStart = 0;
+  timer->start(10);
+}
+
+void SignalGenerator::startChannels(int length, double samplingFrequency, double megabytesPerSecond) {
+  channelMode = true;
+  channelLength = length;
+  this->samplingFrequency = samplingFrequency;
+  bytesPerSecond = megabytesPerSecond * 1e6;
+  timeAxis.resize(length);
+  for (int i = 0; i < length; i++)
+    timeAxis[i].key = i / samplingFrequency;
+  start();
+}
+
+void SignalGenerator::startPoints(double frequency, double timeScale, double megabytesPerSecond) {
+  channelMode = false;
+  pointFrequency = frequency;
+  pointPeriod = timeScale / frequency;
+  bytesPerSecond = megabytesPerSecond * 1e6;
+  start();
+}
+
+void SignalGenerator::stop() { timer->stop(); }
+
+int SignalGenerator::pointBytes() const {
+  int bytes = 5 + 8 + 1; // $$Pf8, čas, ;
+  for (auto *evaluator : evaluators)
+    bytes += evaluator ? 6 : 2;
+  return bytes;
+}
+
+void SignalGenerator::timerRoutine() {
+  double now = elapsed.nsecsElapsed() * 1e-9;
+  QByteArray output;
+
+  if (bytesPerSecond > 0) {
+    // Pokud generátor (nebo příjemce) nestíhá, dluh se zahodí, aby se zpoždění nehromadilo
+    double budget = now * bytesPerSecond - sentBytes;
+    if (budget > bytesPerSecond * 0.2) {
+      sentBytes = now * bytesPerSecond - bytesPerSecond * 0.05;
+      budget = bytesPerSecond * 0.05;
+    }
+    if (channelMode) {
+      while (output.size() < budget) {
+        int previousSize = output.size();
+        generateChannels(output, now);
+        if (output.size() == previousSize)
+          break;
+      }
+    } else if (budget > 0) {
+      generatePoints(qCeil(budget / pointBytes()), output, now);
+    }
+    sentBytes += output.size();
+  } else if (channelMode) {
+    // Rámec každých 100 ms
+    if (now >= sentFrames * 0.1) {
+      generateChannels(output, now);
+      sentFrames = qFloor(now / 0.1) + 1;
+    }
+  } else {
+    qint64 target = qFloor(now * pointFrequency);
+    if (target - sentFrames > qMax(1.0, pointFrequency * 0.2))
+      sentFrames = target - 1;
+    if (target > sentFrames)
+      generatePoints(target - sentFrames, output, now);
+    sentFrames = target;
+  }
+
+  if (!output.isEmpty())
+    emit sendData(output);
+
+  measuredBytes += output.size();
+  if (now - measureStart >= 1) {
+    emit rateMeasured(measuredBytes / (now - measureStart) / 1e6);
+    measuredBytes = 0;
+    measureStart = now;
+  }
+}
+
+void SignalGenerator::generateChannels(QByteArray &output, double time) {
+  const QVector<const QCPGraphData *> noChannels(ANALOG_COUNT, nullptr);
+  samples.resize(channelLength);
+  for (int ch = 0; ch < evaluators.size(); ch++) {
+    CompiledExpression *evaluator = evaluators.at(ch);
+    if (evaluator == nullptr)
+      continue;
+    evaluator->setVariable(timeVariables.at(ch), time);
+    values[ch].resize(channelLength);
+    evaluator->evaluate(noChannels, timeAxis.constData(), channelLength, values[ch].data());
+
+    const QCPGraphData *source = values.at(ch).constData();
+    for (int i = 0; i < channelLength; i++)
+      samples[i] = source[i].value;
+
+    output.append("$$C" + QByteArray::number(ch + 1) + "," + QByteArray::number(1.0 / samplingFrequency, 'g', 10) + "," + QByteArray::number(channelLength) + ";f4");
+    output.append(reinterpret_cast<const char *>(samples.constData()), channelLength * sizeof(float));
+    output.append(';');
+  }
+}
+
+void SignalGenerator::generatePoints(int count, QByteArray &output, double time) {
+  bool anyValid = false;
+  for (auto *evaluator : evaluators)
+    anyValid |= evaluator != nullptr;
+  if (!anyValid || count <= 0)
+    return;
+
+  timeAxis.resize(count);
+  for (int i = 0; i < count; i++)
+    timeAxis[i].key = pointTimestamp + (i + 1) * pointPeriod;
+
+  const QVector<const QCPGraphData *> noChannels(ANALOG_COUNT, nullptr);
+  for (int ch = 0; ch < evaluators.size(); ch++) {
+    if (evaluators.at(ch) == nullptr)
+      continue;
+    evaluators.at(ch)->setVariable(timeVariables.at(ch), time);
+    values[ch].resize(count);
+    evaluators.at(ch)->evaluate(noChannels, timeAxis.constData(), count, values[ch].data());
+  }
+
+  // Čas jako f8, hodnoty jako f4, neplatný vzorec jako vynechaná hodnota "-"
+  output.reserve(output.size() + count * pointBytes());
+  for (int i = 0; i < count; i++) {
+    double key = timeAxis.at(i).key;
+    output.append("$$Pf8", 5);
+    output.append(reinterpret_cast<const char *>(&key), sizeof(double));
+    for (int ch = 0; ch < evaluators.size(); ch++) {
+      if (evaluators.at(ch)) {
+        float value = values.at(ch).at(i).value;
+        output.append("f4", 2);
+        output.append(reinterpret_cast<const char *>(&value), sizeof(float));
+      } else
+        output.append(ch + 1 < evaluators.size() ? "-," : "-");
+    }
+    output.append(';');
+  }
+  pointTimestamp = timeAxis.last().key;
+}
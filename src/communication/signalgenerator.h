@@ -0,0 +1,75 @@
+//  Copyright (C) 2020-2024  Jiří Maier
+
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef SIGNALGENERATOR_H
+#define SIGNALGENERATOR_H
+
+#include "global.h"
+#include "math/compiledexpression.h"
+#include <QElapsedTimer>
+#include <QObject>
+#include <QTimer>
+
+/// Generuje binární rámce $$P nebo $$C ze vzorců pro simulovaný vstup.
+/// Běží ve vlastním vlákně, vzorce jsou přeložené (CompiledExpression) a počítají se po celých blocích.
+/// Při nenulové rychlosti posílá zadaný počet MB/s a slouží jako zátěžový generátor.
+class SignalGenerator : public QObject {
+  Q_OBJECT
+public:
+  explicit SignalGenerator(QObject *parent = nullptr);
+  ~SignalGenerator();
+
+private:
+  QTimer *timer;
+  QList<CompiledExpression *> evaluators;
+  QList<int> timeVariables; ///< Index proměnné "time" (sekundy od spuštění) v každém vzorci
+  bool channelMode = false;
+  int channelLength = 1024;
+  double samplingFrequency = 100e3;
+  double pointPeriod = 0.01; ///< Přírůstek t mezi body
+  double pointFrequency = 100;
+  double bytesPerSecond = 0; ///< 0 = v reálném čase
+  double pointTimestamp = 0;
+  double sentBytes = 0;
+  qint64 sentFrames = 0;
+  qint64 measuredBytes = 0;
+  double measureStart = 0;
+  QElapsedTimer elapsed;
+  QVector<QCPGraphData> timeAxis;
+  QVector<QVector<QCPGraphData>> values;
+  QVector<float> samples;
+
+  void start();
+  int pointBytes() const;
+  void generateChannels(QByteArray &output, double time);
+  void generatePoints(int count, QByteArray &output, double time);
+
+public slots:
+  void setExpressions(QStringList expressions);
+  void startChannels(int length, double samplingFrequency, double megabytesPerSecond);
+  void startPoints(double frequency, double timeScale, double megabytesPerSecond);
+  void stop();
+  void resetTime() { pointTimestamp = 0; }
+
+private slots:
+  void timerRoutine();
+
+signals:
+  void sendData(QByteArray data);
+  /// Skutečně dosažená rychlost, posílá se jednou za sekundu
+  void rateMeasured(double megabytesPerSecond);
+};
+
+#endif // SIGNALGENERATOR_H
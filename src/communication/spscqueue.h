@@ -0,0 +1,73 @@
+//  Copyright (C) 2020-2024  Jiří Maier
+
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <QAtomicInteger>
+#include <utility>
+#include <vector>
+
+/// Fronta bez zámků pro jednoho producenta a jednoho konzumenta s pevnou kapacitou
+/// Producent (vlákno parseru) nikdy nečeká: když je fronta plná, push vrátí false a záznam se zahodí.
+/// Indexy čtení a zápisu jsou každý na vlastním řádku cache, aby se vlákna navzájem nezpomalovala.
+template <typename T> class SpscQueue {
+public:
+  /// Kapacita se zaokrouhlí nahoru na mocninu dvou
+  explicit SpscQueue(quint32 capacity) {
+    quint32 size = 2;
+    while (size < capacity)
+      size <<= 1;
+    items.resize(size);
+    mask = size - 1;
+  }
+
+  /// Volá jen producent
+  bool push(T &&item) {
+    quint32 write = writeIndex.loadRelaxed();
+    if (write - readIndex.loadAcquire() > mask)
+      return false;
+    items[write & mask] = std::move(item);
+    writeIndex.storeRelease(write + 1);
+    return true;
+  }
+
+  /// Volá jen konzument, slot se uvolní (sdílená data se nedrží déle, než je potřeba)
+  bool pop(T &item) {
+    quint32 read = readIndex.loadRelaxed();
+    if (read == writeIndex.loadAcquire())
+      return false;
+    item = std::move(items[read & mask]);
+    items[read & mask] = T();
+    readIndex.storeRelease(read + 1);
+    return true;
+  }
+
+  /// Přibližný počet záznamů ve frontě (z libovolného vlákna)
+  /// Index čtení se načte první: čtení nikdy nepředběhne zápis, takže rozdíl nepřeteče, i když konzument mezitím vybírá
+  quint32 size() const {
+    quint32 read = readIndex.loadAcquire();
+    return writeIndex.loadAcquire() - read;
+  }
+  quint32 capacity() const { return mask + 1; }
+
+private:
+  std::vector<T> items;
+  quint32 mask;
+  alignas(64) QAtomicInteger<quint32> writeIndex{0};
+  alignas(64) QAtomicInteger<quint32> readIndex{0};
+};
+
+#endif // SPSCQUEUE_H
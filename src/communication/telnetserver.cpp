@@ -14,6 +14,7 @@
 //  along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include "telnetserver.h"
+#include "metrics.h"
 #include <QDebug>
 
 TelnetServer::TelnetServer(QObject *parent) : QObject(parent) {
@@ -47,6 +48,7 @@ void TelnetServer::disconnect() {
       socket->deleteLater();
     }
     m_clientSockets.clear();
+    m_pendingLines.clear();
   }
 }
 
@@ -62,6 +64,7 @@ void TelnetServer::onDisconnected() {
   QTcpSocket *socket = qobject_cast<QTcpSocket *>(sender());
   if (socket) {
     m_clientSockets.removeOne(socket);
+    m_pendingLines.remove(socket);
     emit clientDisconnected(socket);
     socket->deleteLater();
   }
@@ -70,8 +73,35 @@ void TelnetServer::onDisconnected() {
 void TelnetServer::onReadyRead() {
   QTcpSocket *socket = qobject_cast<QTcpSocket *>(sender());
   if (socket) {
-    QByteArray message = socket->readAll();
-    emit messageReceived(message);
+    const QByteArray query = "$$?metrics";
+    QByteArray message = m_pendingLines.take(socket) + socket->readAll();
+
+    // Dotaz na stav zpracování (celý řádek), odpoví se jen tazateli a do parseru se nepředá
+    if (message.contains(query)) {
+      QByteArray rest;
+      int lineStart = 0;
+      for (int lineEnd = message.indexOf('\n'); lineEnd >= 0; lineEnd = message.indexOf('\n', lineStart)) {
+        QByteArray line = message.mid(lineStart, lineEnd + 1 - lineStart);
+        if (line.trimmed() == query)
+          socket->write(Metrics::report());
+        else
+          rest.append(line);
+        lineStart = lineEnd + 1;
+      }
+      rest.append(message.mid(lineStart));
+      message = rest;
+      socket->flush();
+    }
+
+    // Dotaz může být rozdělen do více paketů, nedokončený řádek, který ho může začínat, počká na zbytek
+    int tailStart = message.lastIndexOf('\n') + 1;
+    QByteArray tail = message.mid(tailStart);
+    if (!tail.isEmpty() && tail.size() <= 2 * query.size() && query.startsWith(tail.trimmed())) {
+      m_pendingLines.insert(socket, tail);
+      message.truncate(tailStart);
+    }
+    if (!message.isEmpty())
+      emit messageReceived(message);
   }
 }
 
@@ -16,6 +16,7 @@
 #ifndef TELNETSERVER_H
 #define TELNETSERVER_H
 
+#include <QHash>
 #include <QObject>
 #include <QTcpServer>
 #include <QTcpSocket>
@@ -44,6 +45,8 @@ private slots:
 private:
   QTcpServer *m_tcpServer;
   QList<QTcpSocket *> m_clientSockets;
+  /// Nedokončený poslední řádek klienta, podrží se jen pokud může být začátkem dotazu $$?metrics
+  QHash<QTcpSocket *, QByteArray> m_pendingLines;
 };
 
 #endif // TELNETSERVER_H
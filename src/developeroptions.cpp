@@ -15,7 +15,9 @@
 
 #include "developeroptions.h"
 #include "communication/cobs.h"
+#include "communication/latencytrace.h"
 #include "defaultpathmanager.h"
+#include "metrics.h"
 #include "qcheckbox.h"
 #include "qclipboard.h"
 #include "qdebug.h"
@@ -23,7 +25,9 @@
 #include "qml/ansiterminalmodel.h"
 #include "qqmlerror.h"
 #include "qscrollbar.h"
+#include "traceevents.h"
 #include "ui_developeroptions.h"
+#include "utils.h"
 #include <QColorDialog>
 #include <QDesktopServices>
 #include <QFileDialog>
@@ -62,6 +66,36 @@ DeveloperOptions::DeveloperOptions(QWidget *parent, QQuickWidget *qQuickWidget)
     newItem->setData(Qt::UserRole, file.absoluteFilePath());
     ui->listWidgetQMLFiles->addItem(newItem);
   }
+
+  ui->tableWidgetLatency->setRowCount(LatencyTrace::STAGE_COUNT);
+  for (int stage = 0; stage < LatencyTrace::STAGE_COUNT; stage++) {
+    ui->tableWidgetLatency->setItem(stage, 0, new QTableWidgetItem(LatencyTrace::stageName((LatencyTrace::Stage)stage)));
+    for (int column = 1; column < ui->tableWidgetLatency->columnCount(); column++)
+      ui->tableWidgetLatency->setItem(stage, column, new QTableWidgetItem());
+  }
+  int metricsRows = Metrics::COUNTER_COUNT + Metrics::GAUGE_COUNT + Metrics::memoryChannelCount;
+  ui->tableWidgetMetrics->setRowCount(metricsRows);
+  for (int row = 0; row < metricsRows; row++) {
+    QString name;
+    if (row < Metrics::COUNTER_COUNT)
+      name = Metrics::name((Metrics::Counter)row);
+    else if (row < Metrics::COUNTER_COUNT + Metrics::GAUGE_COUNT)
+      name = Metrics::name((Metrics::Gauge)(row - Metrics::COUNTER_COUNT));
+    else
+      name = Metrics::channelMemoryName(row - Metrics::COUNTER_COUNT - Metrics::GAUGE_COUNT);
+    ui->tableWidgetMetrics->setItem(row, 0, new QTableWidgetItem(name));
+    ui->tableWidgetMetrics->setItem(row, 1, new QTableWidgetItem());
+  }
+
+  connect(&refreshTimer, &QTimer::timeout, this, &DeveloperOptions::updateLatencyTable);
+  connect(&refreshTimer, &QTimer::timeout, this, &DeveloperOptions::updateMetricsTable);
+  refreshTimer.start(500);
+
+#ifndef DATAPLOTTER_TRACING
+  // Události nejsou v tomto sestavení zakompilované
+  ui->checkBoxTraceEvents->hide();
+  ui->pushButtonTraceSave->hide();
+#endif
 }
 
 DeveloperOptions::~DeveloperOptions() { delete ui; }
@@ -383,3 +417,65 @@ void DeveloperOptions::on_pushButtonScrollDown_2_clicked() {
 }
 
 void DeveloperOptions::on_pushButtonOpenConfig_clicked() { emit requestConfigFolderOpen(); }
+
+void DeveloperOptions::updateLatencyTable() {
+  if (!isVisible() || ui->tabWidget->currentWidget() != ui->tab_6)
+    return;
+  for (int stage = 0; stage < LatencyTrace::STAGE_COUNT; stage++) {
+    auto summary = LatencyTrace::summary((LatencyTrace::Stage)stage);
+    ui->tableWidgetLatency->item(stage, 1)->setText(QString::number(summary.count));
+    ui->tableWidgetLatency->item(stage, 2)->setText(summary.count ? floatToNiceString(summary.p50, 3, false, false, false, UnitOfMeasure("s")) : "---");
+    ui->tableWidgetLatency->item(stage, 3)->setText(summary.count ? floatToNiceString(summary.p99, 3, false, false, false, UnitOfMeasure("s")) : "---");
+    ui->tableWidgetLatency->item(stage, 4)->setText(summary.count ? floatToNiceString(summary.max, 3, false, false, false, UnitOfMeasure("s")) : "---");
+  }
+}
+
+void DeveloperOptions::updateMetricsTable() {
+  if (!isVisible() || ui->tabWidget->currentWidget() != ui->tab_7)
+    return;
+  for (int row = 0; row < ui->tableWidgetMetrics->rowCount(); row++) {
+    qint64 value;
+    if (row < Metrics::COUNTER_COUNT)
+      value = Metrics::value((Metrics::Counter)row);
+    else if (row < Metrics::COUNTER_COUNT + Metrics::GAUGE_COUNT)
+      value = Metrics::value((Metrics::Gauge)(row - Metrics::COUNTER_COUNT));
+    else
+      value = Metrics::channelMemoryValue(row - Metrics::COUNTER_COUNT - Metrics::GAUGE_COUNT);
+    ui->tableWidgetMetrics->item(row, 1)->setText(QString::number(value));
+  }
+}
+
+void DeveloperOptions::on_pushButtonLatencyReset_clicked() {
+  LatencyTrace::reset();
+  updateLatencyTable();
+}
+
+void DeveloperOptions::on_pushButtonLatencyExport_clicked() {
+  QString fileName = DefaultPathManager::getInstance().requestSaveFile(this, tr("Export latency histograms"), "path_export", "latency.csv", tr("Comma separated values (*.csv)"));
+  if (fileName.isEmpty())
+    return;
+  QFile file(fileName);
+  if (file.open(QFile::WriteOnly | QFile::Truncate)) {
+    file.write(LatencyTrace::toCsv());
+    file.close();
+  } else
+    qCritical() << "Cannot write to file" << fileName;
+}
+
+void DeveloperOptions::on_checkBoxTraceEvents_toggled(bool checked) {
+  if (checked)
+    TraceEvents::clear();
+  TraceEvents::setEnabled(checked);
+}
+
+void DeveloperOptions::on_pushButtonTraceSave_clicked() {
+  QString fileName = DefaultPathManager::getInstance().requestSaveFile(this, tr("Save trace"), "path_export", "trace.json", tr("Trace event file (*.json)"));
+  if (fileName.isEmpty())
+    return;
+  QFile file(fileName);
+  if (file.open(QFile::WriteOnly | QFile::Truncate)) {
+    file.write(TraceEvents::toJson());
+    file.close();
+  } else
+    qCritical() << "Cannot write to file" << fileName;
+}
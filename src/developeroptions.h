@@ -19,6 +19,7 @@
 #include "qlistwidget.h"
 #include <QDialog>
 #include <QQuickWidget>
+#include <QTimer>
 #include <QUrl>
 
 namespace Ui {
@@ -69,6 +70,12 @@ private slots:
   void on_pushButtonViewBuffer_2_clicked() { emit requestManualBufferShow(); }
   void on_pushButtonScrollDown_2_clicked();
   void on_pushButtonOpenConfig_clicked();
+  void on_pushButtonLatencyReset_clicked();
+  void on_pushButtonLatencyExport_clicked();
+  void updateLatencyTable();
+  void updateMetricsTable();
+  void on_checkBoxTraceEvents_toggled(bool checked);
+  void on_pushButtonTraceSave_clicked();
 
 signals:
   void colorExceptionListChanged(QList<QColor> newlist, bool isBlacklist);
@@ -89,6 +96,7 @@ private:
   void qmlExport();
 
   const QQuickWidget *qQuickWidget;
+  QTimer refreshTimer;
   void quickWidget_statusChanged(const QQuickWidget::Status &arg1);
 };
 
@@ -33,6 +33,9 @@ const char MisrosoftStoreUrl[] = "https://apps.microsoft.com/detail/9NVBN2G853FP
 #define LOGIC_GROUPS 3
 #define INTERPOLATION_COUNT 2
 
+/// Nad tento počet vzorků (ve viditelném rozsahu) se interpolace neprovádí, vzorky jsou tak husté, že by nebyla vidět
+#define INTERPOLATION_MAX_SAMPLES 200000
+
 #define SHOW_OPENGL_RECOMMENDATION_WHEN_SWITCHED_TO_FILLED true
 
 #define TERMINAL_CLICK_BLINK_TIME 100
@@ -48,6 +48,7 @@
 #include <QTimer>
 #include <QTranslator>
 
+#include "communication/datalogger.h"
 #include "communication/newserialparser.h"
 #include "communication/plotdata.h"
 #include "communication/serialreader.h"
@@ -57,6 +58,11 @@
 #include "math/interpolator.h"
 #include "math/plotmath.h"
 #include "math/signalprocessing.h"
+#include "math/logicmeasurement.h"
+#include "math/protocoldecoder.h"
+#include "math/persistence.h"
+#include "math/spectrogram.h"
+#include "math/taskpool.h"
 #include "math/xymode.h"
 
 Q_DECLARE_METATYPE(ChannelSettings_t)
@@ -67,8 +73,20 @@ Q_DECLARE_METATYPE(PlotStatus::enumPlotStatus)
 Q_DECLARE_METATYPE(MessageTarget::enumMessageTarget)
 Q_DECLARE_METATYPE(QSharedPointer<QVector<double>>);
 Q_DECLARE_METATYPE(QSharedPointer<QCPGraphDataContainer>);
+Q_DECLARE_METATYPE(QVector<QSharedPointer<QCPGraphDataContainer>>);
+Q_DECLARE_METATYPE(ChannelSnapshot);
 Q_DECLARE_METATYPE(QSharedPointer<QCPCurveDataContainer>);
 Q_DECLARE_METATYPE(MathOperations::enumMathOperations);
+Q_DECLARE_METATYPE(AveragerMode::enumAveragerMode);
+Q_DECLARE_METATYPE(Resampling::enumResampling);
+Q_DECLARE_METATYPE(FilterType::enumFilterType);
+Q_DECLARE_METATYPE(TriggerMode::enumTriggerMode);
+Q_DECLARE_METATYPE(DecoderSettings);
+Q_DECLARE_METATYPE(LoggerSettings);
+Q_DECLARE_METATYPE(QVector<DecodedWord>);
+Q_DECLARE_METATYPE(QVector<LogicBitMeasurement>);
+Q_DECLARE_METATYPE(QVector<ChannelRate>);
+Q_DECLARE_METATYPE(MeasurementStatistics);
 Q_DECLARE_METATYPE(FFTWindow::enumFFTWindow);
 Q_DECLARE_METATYPE(FFTType::enumFFTType);
 Q_DECLARE_METATYPE(Cursors::enumCursors);
@@ -94,8 +112,21 @@ int main(int argc, char *argv[]) {
   qRegisterMetaType<MessageTarget::enumMessageTarget>();
   qRegisterMetaType<QSharedPointer<QVector<double>>>();
   qRegisterMetaType<QSharedPointer<QCPGraphDataContainer>>();
+  qRegisterMetaType<QVector<QSharedPointer<QCPGraphDataContainer>>>();
+  qRegisterMetaType<ChannelSnapshot>();
   qRegisterMetaType<QSharedPointer<QCPCurveDataContainer>>();
   qRegisterMetaType<MathOperations::enumMathOperations>();
+  qRegisterMetaType<AveragerMode::enumAveragerMode>();
+  qRegisterMetaType<Resampling::enumResampling>();
+  qRegisterMetaType<FilterType::enumFilterType>();
+  qRegisterMetaType<TriggerMode::enumTriggerMode>();
+  qRegisterMetaType<DecoderSettings>();
+  qRegisterMetaType<LoggerSettings>();
+  qRegisterMetaType<QVector<DecodedWord>>();
+  qRegisterMetaType<QVector<LogicBitMeasurement>>();
+  qRegisterMetaType<QVector<ChannelRate>>();
+  qRegisterMetaType<MeasurementStatistics>();
+  qRegisterMetaType<QVector<quint32>>();
   qRegisterMetaType<FFTWindow::enumFFTWindow>();
   qRegisterMetaType<FFTType::enumFFTType>();
   qRegisterMetaType<Cursors::enumCursors>();
@@ -121,18 +152,36 @@ int main(int argc, char *argv[]) {
   SignalProcessing *signalProcessing2 = new SignalProcessing();
   SignalProcessing *signalProcessingFFT1 = new SignalProcessing();
   SignalProcessing *signalProcessingFFT2 = new SignalProcessing();
+  SignalProcessing *signalProcessingCorrelation = new SignalProcessing();
   Interpolator *interpolator = new Interpolator();
   Averager *averager = new Averager();
+  Spectrogram *spectrogram = new Spectrogram();
+  Persistence *persistence = new Persistence();
+  ProtocolDecoder *protocolDecoder = new ProtocolDecoder();
+  LogicMeasurement *logicMeasurement = new LogicMeasurement();
+  DataLogger *dataLogger = new DataLogger();
 
   // Vytvoří vlákna
+  // Vlastní vlákno (event loop) má jen čtení portu a parser, výpočty běží na sdíleném fondu vláken (TaskPool)
   // QThread plotDataThread;
   QThread serialParserThread;
-  QThread plotMathThread;
   QThread serialReaderThread;
-  QThread signalProcessing1Thread, signalProcessing2Thread, signalProcessingFFT1Thread, signalProcessingFFT2Thread;
-  QThread interpolatorThread;
-  QThread averagerThread;
-  QThread xyThread;
+  QThread loggerThread; // Zápis na disk nesmí čekat za výpočty ve fondu
+
+  // Přiřadí výpočetní objekty do fondu, sloty se proto připojují přes TaskPool::connect
+  TaskPool::attach(plotMath, TaskPool::high);
+  TaskPool::attach(averager, TaskPool::high);
+  TaskPool::attach(interpolator, TaskPool::high);
+  TaskPool::attach(signalProcessing1, TaskPool::normal);
+  TaskPool::attach(signalProcessing2, TaskPool::normal);
+  TaskPool::attach(signalProcessingFFT1, TaskPool::normal);
+  TaskPool::attach(signalProcessingFFT2, TaskPool::normal);
+  TaskPool::attach(xyMode, TaskPool::normal);
+  TaskPool::attach(protocolDecoder, TaskPool::normal);
+  TaskPool::attach(logicMeasurement, TaskPool::normal);
+  TaskPool::attach(signalProcessingCorrelation, TaskPool::low);
+  TaskPool::attach(spectrogram, TaskPool::low);
+  TaskPool::attach(persistence, TaskPool::low);
 
   // Propojí signály
   QObject::connect(serial1, &SerialReader::sendData, serialParser, &NewSerialParser::parse);
@@ -182,39 +231,74 @@ int main(int argc, char *argv[]) {
   QObject::connect(&mainWindow, &MainWindow::disconnectSerial, serial1, &SerialReader::end);
   QObject::connect(&mainWindow, &MainWindow::resetChannels, plotData, &PlotData::reset);
   QObject::connect(&mainWindow, &MainWindow::writeToSerial, serial1, &SerialReader::write);
-  QObject::connect(&mainWindow, &MainWindow::sendManualInput, serialParserM, &NewSerialParser::parse);
+  QObject::connect(&mainWindow, &MainWindow::sendManualInput, serialParserM, [serialParserM](QByteArray data) { serialParserM->parse(data); });
   QObject::connect(plotData, &PlotData::sendMessage, &mainWindow, &MainWindow::printMessage);
   QObject::connect(plotData, &PlotData::dataRateUpdate, &mainWindow, &MainWindow::dataRateUpdate);
+  QObject::connect(plotData, &PlotData::sampleRateUpdate, &mainWindow, &MainWindow::sampleRateUpdate);
   QObject::connect(plotData, &PlotData::setExpectedRange, &mainWindow, &MainWindow::setExpectedRange);
   QObject::connect(plotMath, &PlotMath::sendMessage, &mainWindow, &MainWindow::printMessage);
   QObject::connect(&mainWindow, &MainWindow::setChDigital, plotData, &PlotData::setDigitalChannel);
   QObject::connect(&mainWindow, &MainWindow::setLogicBits, plotData, &PlotData::setLogicBits);
-  QObject::connect(&mainWindow, &MainWindow::resetMath, plotMath, &PlotMath::resetMath);
-  QObject::connect(&mainWindow, &MainWindow::requestXY, xyMode, &XYMode::calculateXY);
-  QObject::connect(plotData, &PlotData::addMathData, plotMath, &PlotMath::addMathData);
+  TaskPool::connect(&mainWindow, &MainWindow::resetMath, plotMath, &PlotMath::resetMath);
+  TaskPool::connect(&mainWindow, &MainWindow::resetMathExpression, plotMath, &PlotMath::resetMathExpression);
+  TaskPool::connectLatest(&mainWindow, &MainWindow::requestXY, xyMode, &XYMode::calculateXY);
+  // Celé průběhy platí jen poslední (pro každý vstup), jednotlivé body se slučují do omezené dávky
+  TaskPool::connectLatest(plotData, &PlotData::addMathData, plotMath, &PlotMath::addMathData, [](int math, bool isFirst, const QSharedPointer<QCPGraphDataContainer> &in, bool) { return in->size() > 1 ? math * 2 + isFirst : -1; });
+  TaskPool::connectLatest(plotData, &PlotData::addMathExpressionData, plotMath, &PlotMath::addMathExpressionData, [](int math, int ch, const QSharedPointer<QCPGraphDataContainer> &in, bool) { return in->size() > 1 ? math * ANALOG_COUNT + ch : -1; });
   QObject::connect(&mainWindow, &MainWindow::setMathFirst, plotData, &PlotData::setMathFirst);
   QObject::connect(&mainWindow, &MainWindow::setMathSecond, plotData, &PlotData::setMathSecond);
-  QObject::connect(&mainWindow, &MainWindow::clearMath, plotMath, &PlotMath::clearMath);
-  QObject::connect(&mainWindow, &MainWindow::requstMeasurements1, signalProcessing1, &SignalProcessing::process);
-  QObject::connect(&mainWindow, &MainWindow::requstMeasurements2, signalProcessing2, &SignalProcessing::process);
-  QObject::connect(&mainWindow, &MainWindow::requestFFT1, signalProcessingFFT1, &SignalProcessing::getFFTPlot);
-  QObject::connect(&mainWindow, &MainWindow::requestFFT2, signalProcessingFFT2, &SignalProcessing::getFFTPlot);
+  QObject::connect(&mainWindow, &MainWindow::setMathExpressionInputs, plotData, &PlotData::setMathExpressionInputs);
+  TaskPool::connect(&mainWindow, &MainWindow::clearMath, plotMath, &PlotMath::clearMath);
+  TaskPool::connectLatest(&mainWindow, &MainWindow::requstMeasurements1, signalProcessing1, &SignalProcessing::process);
+  TaskPool::connectLatest(&mainWindow, &MainWindow::requstMeasurements2, signalProcessing2, &SignalProcessing::process);
+  TaskPool::connectLatest(&mainWindow, &MainWindow::requestFFT1, signalProcessingFFT1, &SignalProcessing::getFFTPlot);
+  TaskPool::connectLatest(&mainWindow, &MainWindow::requestFFT2, signalProcessingFFT2, &SignalProcessing::getFFTPlot);
   QObject::connect(signalProcessing1, &SignalProcessing::result, &mainWindow, &MainWindow::signalMeasurementsResult1);
   QObject::connect(signalProcessing2, &SignalProcessing::result, &mainWindow, &MainWindow::signalMeasurementsResult2);
   QObject::connect(signalProcessingFFT1, &SignalProcessing::fftResult, &mainWindow, &MainWindow::fftResult1);
   QObject::connect(signalProcessingFFT2, &SignalProcessing::fftResult, &mainWindow, &MainWindow::fftResult2);
+  TaskPool::connectLatest(&mainWindow, &MainWindow::requestCorrelation, signalProcessingCorrelation, &SignalProcessing::correlate);
+  QObject::connect(signalProcessingCorrelation, &SignalProcessing::correlationResult, &mainWindow, &MainWindow::correlationResult);
   QObject::connect(xyMode, &XYMode::sendResultXY, &mainWindow, &MainWindow::xyResult);
-  QObject::connect(&mainWindow, &MainWindow::interpolate, interpolator, &Interpolator::interpolate);
+  TaskPool::connectLatest(&mainWindow, &MainWindow::interpolate, interpolator, &Interpolator::interpolate, [](int chID, const QSharedPointer<QCPGraphDataContainer> &, QCPRange, bool) { return chID; });
   QObject::connect(interpolator, &Interpolator::interpolationResult, &mainWindow, &MainWindow::interpolationResult);
   QObject::connect(&mainWindow, &MainWindow::setAverager, plotData, &PlotData::setAverager);
-  QObject::connect(&mainWindow, &MainWindow::resetAverager, averager, &Averager::reset);
-  QObject::connect(&mainWindow, &MainWindow::setAveragerCount, averager, &Averager::setCount);
-  QObject::connect(plotData, &PlotData::addDataToAverager, averager, &Averager::newDataVector);
-  QObject::connect(plotData, &PlotData::addPointToAverager, averager, &Averager::newDataPoint);
-  QObject::connect(&mainWindow, &MainWindow::setInterpolationFilter, interpolator, &Interpolator::loadFilterFromFile);
+  QObject::connect(&mainWindow, &MainWindow::setChannelFilter, plotData, &PlotData::setChannelFilter);
+  QObject::connect(&mainWindow, &MainWindow::setTrigger, plotData, &PlotData::setTrigger);
+  TaskPool::connect(&mainWindow, &MainWindow::resetAverager, averager, &Averager::reset);
+  TaskPool::connect(&mainWindow, &MainWindow::setAveragerCount, averager, &Averager::setCount);
+  TaskPool::connect(&mainWindow, &MainWindow::setAveragerMode, averager, &Averager::setMode);
+  // Data z parseru se zpracují všechna, dokud výpočet stíhá; fronty jsou ale omezené, při zahlcení se zahazují nejstarší
+  TaskPool::connectBatched(plotData, &PlotData::addDataToAverager, averager, &Averager::newDataVector, TaskPool::maxBatchedFrames);
+  TaskPool::connectBatched(plotData, &PlotData::addPointToAverager, averager, &Averager::newDataPoint, TaskPool::maxBatchedPoints);
+  TaskPool::connectBatched(plotData, &PlotData::addDataToSpectrogram, spectrogram, &Spectrogram::newDataVector, TaskPool::maxBatchedFrames);
+  TaskPool::connectBatched(plotData, &PlotData::addDataToStatistics, signalProcessing1, &SignalProcessing::accumulate, TaskPool::maxBatchedFrames);
+  TaskPool::connectBatched(plotData, &PlotData::addDataToStatistics, signalProcessing2, &SignalProcessing::accumulate, TaskPool::maxBatchedFrames);
+  QObject::connect(&mainWindow, &MainWindow::setStatisticsChannels, plotData, &PlotData::setStatisticsChannels);
+  TaskPool::connectBatched(plotData, &PlotData::addPointToSpectrogram, spectrogram, &Spectrogram::newDataPoint, TaskPool::maxBatchedPoints);
+  TaskPool::connectBatched(plotData, &PlotData::addDataToPersistence, persistence, &Persistence::newDataVector, TaskPool::maxBatchedFrames);
+  TaskPool::connectBatched(plotData, &PlotData::addLogicWords, protocolDecoder, &ProtocolDecoder::newLogicData, TaskPool::maxBatchedFrames);
+  TaskPool::connectBatched(plotData, &PlotData::addLogicWords, logicMeasurement, &LogicMeasurement::newLogicData, TaskPool::maxBatchedFrames);
+  TaskPool::connectBatched(plotData, &PlotData::addLogicWord, protocolDecoder, &ProtocolDecoder::newLogicWord, TaskPool::maxBatchedPoints);
+  TaskPool::connectBatched(plotData, &PlotData::addLogicWord, logicMeasurement, &LogicMeasurement::newLogicWord, TaskPool::maxBatchedPoints);
+  TaskPool::connect(plotData, &PlotData::clearLogic, logicMeasurement, &LogicMeasurement::clearGroup);
+  TaskPool::connect(&mainWindow, &MainWindow::resetChannels, logicMeasurement, &LogicMeasurement::reset);
+  TaskPool::connectLatest(&mainWindow, &MainWindow::requestLogicMeasurements, logicMeasurement, &LogicMeasurement::process, [](int group, double, double) { return group; });
+  QObject::connect(logicMeasurement, &LogicMeasurement::result, &mainWindow, &MainWindow::logicMeasurementsResult);
+  TaskPool::connect(&mainWindow, &MainWindow::setInterpolationFilter, interpolator, &Interpolator::loadFilterFromFile);
   QObject::connect(&mainWindow, &MainWindow::replyEcho, serialParser, &NewSerialParser::replyEcho);
   QObject::connect(&mainWindow, &MainWindow::changeSerialBaud, serial1, &SerialReader::changeBaud);
 
+  // Logování: producent se volá přímo ve vlákně parseru (jen vloží data do fronty), zápis běží ve vlákně loggeru
+  QObject::connect(plotData, &PlotData::logPoint, dataLogger, &DataLogger::logPoint, Qt::DirectConnection);
+  QObject::connect(plotData, &PlotData::logVector, dataLogger, &DataLogger::logVector, Qt::DirectConnection);
+  QObject::connect(plotData, &PlotData::addLogicWords, dataLogger, &DataLogger::logLogicWords, Qt::DirectConnection);
+  QObject::connect(plotData, &PlotData::addLogicWord, dataLogger, &DataLogger::logLogicWord, Qt::DirectConnection);
+  QObject::connect(&mainWindow, &MainWindow::startLogging, dataLogger, &DataLogger::start);
+  QObject::connect(&mainWindow, &MainWindow::stopLogging, dataLogger, &DataLogger::stop);
+  QObject::connect(dataLogger, &DataLogger::fileOpened, &mainWindow, &MainWindow::loggingFileOpened);
+  QObject::connect(dataLogger, &DataLogger::error, &mainWindow, &MainWindow::loggingError);
+
   // Funkce init je zavolána až z nového vlákna
   QObject::connect(&serialReaderThread, &QThread::started, serial1, &SerialReader::init);
 
@@ -223,30 +307,18 @@ int main(int argc, char *argv[]) {
   serialParser->moveToThread(&serialParserThread);
   serialParserM->moveToThread(&serialParserThread);
   plotData->moveToThread(&serialParserThread);
-  plotMath->moveToThread(&plotMathThread);
-
-  xyMode->moveToThread(&xyThread);
-  signalProcessing1->moveToThread(&signalProcessing1Thread);
-  signalProcessing2->moveToThread(&signalProcessing2Thread);
-  signalProcessingFFT1->moveToThread(&signalProcessingFFT1Thread);
-  signalProcessingFFT2->moveToThread(&signalProcessingFFT2Thread);
-  interpolator->moveToThread(&interpolatorThread);
-  averager->moveToThread(&averagerThread);
+  dataLogger->moveToThread(&loggerThread);
 
   // Zahájí vlákna
+  serialReaderThread.setObjectName("Serial reader");
+  serialParserThread.setObjectName("Serial parser");
+  loggerThread.setObjectName("Data logger");
   serialReaderThread.start();
   serialParserThread.start();
-  plotMathThread.start();
-  signalProcessing1Thread.start();
-  signalProcessing2Thread.start();
-  signalProcessingFFT1Thread.start();
-  signalProcessingFFT2Thread.start();
-  interpolatorThread.start();
-  averagerThread.start();
-  xyThread.start();
+  loggerThread.start();
 
   // Zobrazí okno a čeká na ukončení
-  mainWindow.init(&translator, plotData, plotMath, serial1, averager);
+  mainWindow.init(&translator, plotData, plotMath, serial1, averager, spectrogram, protocolDecoder, signalProcessing1, signalProcessing2, persistence);
   mainWindow.show();
   int returnValue = application.exec();
 
@@ -254,39 +326,37 @@ int main(int argc, char *argv[]) {
   serialParser->deleteLater();
   serialParserM->deleteLater();
   plotData->deleteLater();
-  plotMath->deleteLater();
   serial1->deleteLater();
-  signalProcessing1->deleteLater();
-  signalProcessing2->deleteLater();
-  signalProcessingFFT1->deleteLater();
-  signalProcessingFFT2->deleteLater();
-  interpolator->deleteLater();
-  averager->deleteLater();
-  xyMode->deleteLater();
 
   // Vyžádá ukončení event loopu
   serialParserThread.quit();
-  plotMathThread.quit();
   serialReaderThread.quit();
-  signalProcessing1Thread.quit();
-  signalProcessing2Thread.quit();
-  signalProcessingFFT1Thread.quit();
-  signalProcessingFFT2Thread.quit();
-  interpolatorThread.quit();
-  averagerThread.quit();
-  xyThread.quit();
 
   // Čeká na ukončení procesů
   serialParserThread.wait();
-  plotMathThread.wait();
   serialReaderThread.wait();
-  signalProcessing1Thread.wait();
-  signalProcessing2Thread.wait();
-  signalProcessingFFT1Thread.wait();
-  signalProcessingFFT2Thread.wait();
-  interpolatorThread.wait();
-  averagerThread.wait();
-  xyThread.wait();
+
+  // Data už nepřichází, logger zapíše zbytek fronty a uzavře soubor
+  QMetaObject::invokeMethod(dataLogger, &DataLogger::stop, Qt::BlockingQueuedConnection);
+  loggerThread.quit();
+  loggerThread.wait();
+  delete dataLogger;
+
+  // Parser už nic neposílá, dokončí se úlohy ve fondu a smažou se výpočetní objekty
+  TaskPool::shutdown();
+  delete plotMath;
+  delete signalProcessing1;
+  delete signalProcessing2;
+  delete signalProcessingFFT1;
+  delete signalProcessingFFT2;
+  delete signalProcessingCorrelation;
+  delete interpolator;
+  delete averager;
+  delete spectrogram;
+  delete persistence;
+  delete protocolDecoder;
+  delete logicMeasurement;
+  delete xyMode;
 
   return returnValue;
 }
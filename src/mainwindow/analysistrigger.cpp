@@ -0,0 +1,52 @@
+//  Copyright (C) 2020-2024  Jiří Maier
+
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "analysistrigger.h"
+
+void AnalysisTrigger::schedule() {
+  if (running) {
+    changedWhileRunning = true;
+    return;
+  }
+  if (timer.isActive())
+    return;
+  qint64 sinceStart = lastStart.isValid() ? lastStart.elapsed() : minInterval;
+  timer.start(qMax<qint64>(0, minInterval - sinceStart));
+}
+
+bool AnalysisTrigger::start(quint64 signature) {
+  if (hasSignature && signature == lastSignature)
+    return false;
+  lastSignature = signature;
+  hasSignature = true;
+  start();
+  return true;
+}
+
+void AnalysisTrigger::start() {
+  running = true;
+  changedWhileRunning = false;
+  lastStart.start();
+}
+
+void AnalysisTrigger::finished() {
+  running = false;
+  if (changedWhileRunning) {
+    changedWhileRunning = false;
+    schedule();
+  }
+}
+
+void AnalysisTrigger::invalidate() { hasSignature = false; }
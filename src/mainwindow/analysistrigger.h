@@ -0,0 +1,77 @@
+//  Copyright (C) 2020-2024  Jiří Maier
+
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef ANALYSISTRIGGER_H
+#define ANALYSISTRIGGER_H
+
+#include <QElapsedTimer>
+#include <QTimer>
+#include <cstring>
+
+#include "plots/qcustomplot.h"
+
+/// Řízení přepočtu jedné analýzy (měření, FFT, XY, interpolace) podle změny vstupů místo pevné periody
+/// Při možné změně vstupů (nová data v grafu, posun osy, změna nastavení) se zavolá schedule, časovač pak spustí funkci
+/// přepočtu. Ta z verzí dat kanálů, zobrazeného rozsahu a nastavení sestaví podpis a start() povolí výpočet, jen pokud se
+/// podpis od minula změnil. Výpočty se nepřekrývají (další až po finished) a začínají nejvýše jednou za minInterval.
+class AnalysisTrigger {
+public:
+  /// Podpis vstupů analýzy (hash přidávaných hodnot)
+  class Signature {
+  public:
+    Signature &operator<<(quint64 value) {
+      hash = (hash ^ value) * 1099511628211ULL;
+      return *this;
+    }
+    Signature &operator<<(int value) { return *this << (quint64)(qint64)value; }
+    Signature &operator<<(bool value) { return *this << (quint64)value; }
+    Signature &operator<<(double value) {
+      quint64 bits;
+      memcpy(&bits, &value, sizeof(bits));
+      return *this << bits;
+    }
+    Signature &operator<<(const QCPRange &range) { return *this << range.lower << range.upper; }
+    quint64 value() const { return hash; }
+
+  private:
+    quint64 hash = 14695981039346656037ULL;
+  };
+
+  explicit AnalysisTrigger(int minInterval) : minInterval(minInterval) { timer.setSingleShot(true); }
+
+  /// Časovač, jehož timeout se připojí na funkci přepočtu
+  QTimer timer;
+
+  /// Vstupy se mohly změnit, naplánuje kontrolu (s ohledem na minimální odstup výpočtů)
+  void schedule();
+  /// Volá funkce přepočtu těsně před odesláním požadavku. Vrátí false, pokud se podpis nezměnil (výpočet se vynechá).
+  bool start(quint64 signature);
+  /// Výpočet bez podpisu (funkce přepočtu si změny hlídá sama)
+  void start();
+  /// Výsledek došel, pokud se mezitím vstupy změnily, naplánuje další výpočet
+  void finished();
+  /// Zapomene podpis (výsledek byl smazán), příští kontrola výpočet provede vždy
+  void invalidate();
+
+private:
+  int minInterval;
+  QElapsedTimer lastStart;
+  quint64 lastSignature = 0;
+  bool hasSignature = false;
+  bool running = false;
+  bool changedWhileRunning = false;
+};
+
+#endif // ANALYSISTRIGGER_H
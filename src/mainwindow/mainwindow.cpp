@@ -14,11 +14,16 @@
 //  along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include "mainwindow.h"
+#include "math/taskpool.h"
 #include "defaultpathmanager.h"
 #include "ui_developeroptions.h"
 #include "ui_freqtimeplotdialog.h"
 #include "ui_manualinputdialog.h"
 #include "ui_serialsettingsdialog.h"
+#include "ui_persistencedialog.h"
+#include "ui_protocoldecoderdialog.h"
+#include "ui_statisticsdialog.h"
+#include "ui_spectrogramdialog.h"
 #include "version.h"
 
 MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent), ui(new Ui::MainWindow), serialSettingsDialog(new SerialSettingsDialog(this)) {
@@ -27,7 +32,13 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent), ui(new Ui::MainWi
   this->setAttribute(Qt::WA_NativeWindow);
 
   developerOptions = new DeveloperOptions(this, ui->quickWidget);
+  plotMailbox = new PlotMailbox(ui->plot, this);
   freqTimePlotDialog = new FreqTimePlotDialog(nullptr);
+  spectrogramDialog = new SpectrogramDialog(nullptr);
+  persistenceDialog = new PersistenceDialog(nullptr);
+  protocolDecoderDialog = new ProtocolDecoderDialog(nullptr);
+  statisticsDialog1 = new StatisticsDialog(nullptr);
+  statisticsDialog2 = new StatisticsDialog(nullptr);
   simulatedInputDialog.reset(new ManualInputDialog(nullptr));
 
   configFilePath = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/config.ini";
@@ -51,8 +62,18 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent), ui(new Ui::MainWi
   ui->doubleSpinBoxRangeHorizontal->trimDecimalZeroes = true;
   ui->doubleSpinBoxRangeHorizontal->emptyDefaultValue = 1;
 
-  for (int i = 0; i < ANALOG_COUNT; i++)
+  for (int i = 0; i < ANALOG_COUNT; i++) {
     averagerCounts[i] = 8;
+    filterTypes[i] = FilterType::none;
+    filterFrequencies[i] = 50;
+    filterParameters[i] = 2;
+  }
+  ui->doubleSpinBoxFilterFreq->setUnit(UnitOfMeasure("-Hz"));
+  ui->doubleSpinBoxFilterFreq->setAdaptiveStep(true);
+  ui->doubleSpinBoxTriggerWidth->setUnit(UnitOfMeasure("-s"));
+  ui->doubleSpinBoxTriggerWidth->setAdaptiveStep(true);
+  ui->doubleSpinBoxTriggerLength->setUnit(UnitOfMeasure("-s"));
+  ui->doubleSpinBoxTriggerLength->setAdaptiveStep(true);
 
   freqTimePlotDialog->getUi()->plotPeak->setUptimeTimer(&uptime);
   uptime.start();
@@ -108,6 +129,11 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent), ui(new Ui::MainWi
 
 void MainWindow::closeEvent(QCloseEvent *event) {
   freqTimePlotDialog->close();
+  spectrogramDialog->close();
+  persistenceDialog->close();
+  protocolDecoderDialog->close();
+  statisticsDialog1->close();
+  statisticsDialog2->close();
   simulatedInputDialog->close();
   developerOptions->close();
   ui->quickWidget->setSource(QUrl());
@@ -121,6 +147,11 @@ MainWindow::~MainWindow() {
   delete qmlTerminalInterface;
   delete developerOptions;
   delete freqTimePlotDialog;
+  delete spectrogramDialog;
+  delete persistenceDialog;
+  delete protocolDecoderDialog;
+  delete statisticsDialog1;
+  delete statisticsDialog2;
   delete ui;
 }
 
@@ -143,7 +174,7 @@ void MainWindow::setChStyleSelection(GraphType::enumGraphType type) {
   setComboboxItemVisible(*ui->comboBoxGraphStyle, GraphStyle::logicSquareFilled, type == GraphType::logic && false);
 }
 
-void MainWindow::init(QTranslator *translator, const PlotData *plotData, const PlotMath *plotMath, SerialReader *serialReader, const Averager *avg) {
+void MainWindow::init(QTranslator *translator, const PlotData *plotData, const PlotMath *plotMath, SerialReader *serialReader, const Averager *avg, const Spectrogram *spectrogram, const ProtocolDecoder *decoder, const SignalProcessing *measure1, const SignalProcessing *measure2, const Persistence *persistence) {
   // Načte ikony které se mění za běhu
   iconRun = QIcon(":/images/icons/run.png");
   iconPause = QIcon(":/images/icons/pause.png");
@@ -160,14 +191,39 @@ void MainWindow::init(QTranslator *translator, const PlotData *plotData, const P
 
   fillChannelSelect(); // Vytvoří seznam kanálů pro výběr
 
-  QObject::connect(plotMath, &PlotMath::sendResult, ui->plot, &MyMainPlot::newDataVector);
-  QObject::connect(plotData, &PlotData::addVectorToPlot, ui->plot, &MyMainPlot::newDataVector);
-  QObject::connect(plotData, &PlotData::addPointToPlot, ui->plot, &MyMainPlot::newDataPoint);
-  QObject::connect(plotData, &PlotData::clearLogic, ui->plot, &MyMainPlot::clearLogicGroup);
+  // Data do grafu jdou přes schránku (přímé spojení, schránka je vlákenně bezpečná a graf si data převezme najednou)
+  QObject::connect(plotMath, &PlotMath::sendResult, plotMailbox, &PlotMailbox::postVector, Qt::DirectConnection);
+  QObject::connect(plotData, &PlotData::addVectorToPlot, plotMailbox, &PlotMailbox::postVector, Qt::DirectConnection);
+  QObject::connect(plotData, &PlotData::addPointToPlot, plotMailbox, &PlotMailbox::postPoint, Qt::DirectConnection);
+  QObject::connect(plotData, &PlotData::clearLogic, plotMailbox, &PlotMailbox::postClearLogicGroup, Qt::DirectConnection);
   QObject::connect(&fileSender, &FileSender::transmit, serialReader, &SerialReader::write);
   QObject::connect(qmlTerminalInterface, &QmlTerminalInterface::dataTransmitted, serialReader, &SerialReader::write);
-  QObject::connect(avg, &Averager::addVectorToPlot, ui->plot, &MyMainPlot::newDataVector);
-  QObject::connect(avg, &Averager::addPointToPlot, ui->plot, &MyMainPlot::newDataPoint);
+  QObject::connect(avg, &Averager::addVectorToPlot, plotMailbox, &PlotMailbox::postVector, Qt::DirectConnection);
+  QObject::connect(avg, &Averager::addPointToPlot, plotMailbox, &PlotMailbox::postPoint, Qt::DirectConnection);
+  QObject::connect(spectrogramDialog, &SpectrogramDialog::sourceChanged, plotData, &PlotData::setSpectrogramChannel);
+  TaskPool::connect(spectrogramDialog, &SpectrogramDialog::sourceChanged, spectrogram, &Spectrogram::setSource);
+  TaskPool::connect(spectrogramDialog, &SpectrogramDialog::settingsChanged, spectrogram, &Spectrogram::setSettings);
+  TaskPool::connect(spectrogramDialog, &SpectrogramDialog::resetRequested, spectrogram, &Spectrogram::reset);
+  QObject::connect(spectrogram, &Spectrogram::newRows, spectrogramDialog->getUi()->plotSpectrogram, &MySpectrogramPlot::newRows);
+  QObject::connect(persistenceDialog, &PersistenceDialog::sourceChanged, plotData, &PlotData::setPersistenceChannel);
+  TaskPool::connect(persistenceDialog, &PersistenceDialog::sourceChanged, persistence, &Persistence::setSource);
+  TaskPool::connect(persistenceDialog, &PersistenceDialog::decayChanged, persistence, &Persistence::setDecay);
+  TaskPool::connect(persistenceDialog, &PersistenceDialog::resetRequested, persistence, &Persistence::reset);
+  QObject::connect(persistence, &Persistence::newDensity, persistenceDialog, &PersistenceDialog::newDensity);
+  TaskPool::connect(protocolDecoderDialog, &ProtocolDecoderDialog::settingsChanged, decoder, &ProtocolDecoder::setSettings);
+  TaskPool::connect(protocolDecoderDialog, &ProtocolDecoderDialog::resetRequested, decoder, &ProtocolDecoder::reset);
+  QObject::connect(decoder, &ProtocolDecoder::decoded, protocolDecoderDialog, &ProtocolDecoderDialog::addWords);
+  QObject::connect(decoder, &ProtocolDecoder::decoded, ui->plot, &MyMainPlot::newDecodedWords);
+  QObject::connect(statisticsDialog1, &StatisticsDialog::sourceChanged, this, &MainWindow::updateStatisticsChannels);
+  QObject::connect(statisticsDialog2, &StatisticsDialog::sourceChanged, this, &MainWindow::updateStatisticsChannels);
+  TaskPool::connect(statisticsDialog1, &StatisticsDialog::sourceChanged, measure1, &SignalProcessing::setStatisticsChannel);
+  TaskPool::connect(statisticsDialog2, &StatisticsDialog::sourceChanged, measure2, &SignalProcessing::setStatisticsChannel);
+  TaskPool::connect(statisticsDialog1, &StatisticsDialog::histogramSourceChanged, measure1, &SignalProcessing::setHistogramSource);
+  TaskPool::connect(statisticsDialog2, &StatisticsDialog::histogramSourceChanged, measure2, &SignalProcessing::setHistogramSource);
+  TaskPool::connect(statisticsDialog1, &StatisticsDialog::resetRequested, measure1, &SignalProcessing::resetStatistics);
+  TaskPool::connect(statisticsDialog2, &StatisticsDialog::resetRequested, measure2, &SignalProcessing::resetStatistics);
+  QObject::connect(measure1, &SignalProcessing::statisticsResult, statisticsDialog1, &StatisticsDialog::newStatistics);
+  QObject::connect(measure2, &SignalProcessing::statisticsResult, statisticsDialog2, &StatisticsDialog::newStatistics);
 
   // Odpojit port když se změní pokročilá nastavení
   QObject::connect(serialSettingsDialog, &SerialSettingsDialog::settingChanged, serialReader, &SerialReader::end);
@@ -196,6 +252,11 @@ void MainWindow::changeLanguage(QString code) {
   developerOptions->getUi()->retranslateUi(developerOptions);
   freqTimePlotDialog->getUi()->retranslateUi(freqTimePlotDialog);
   freqTimePlotDialog->getUi()->plotPeak->setInfoText();
+  spectrogramDialog->getUi()->retranslateUi(spectrogramDialog);
+  persistenceDialog->getUi()->retranslateUi(persistenceDialog);
+  protocolDecoderDialog->getUi()->retranslateUi(protocolDecoderDialog);
+  statisticsDialog1->getUi()->retranslateUi(statisticsDialog1);
+  statisticsDialog2->getUi()->retranslateUi(statisticsDialog2);
   simulatedInputDialog->getUi()->retranslateUi(simulatedInputDialog.data());
 }
 
@@ -317,11 +378,34 @@ void MainWindow::printDeviceMessage(QByteArray message, bool warning, bool ended
 }
 
 void MainWindow::updateMathNow(int number) {
-  emit setMathFirst(number, mathEn[number - 1]->isChecked() ? mathFirst[number - 1]->currentIndex() + 1 : 0);
-  emit setMathSecond(number, mathEn[number - 1]->isChecked() ? mathSecond[number - 1]->currentIndex() + 1 : 0);
+  bool isExpression = mathOp[number - 1]->currentIndex() == MathOperations::expression;
+  mathFirst[number - 1]->setVisible(!isExpression);
+  mathSecond[number - 1]->setVisible(!isExpression);
+  mathScalarFirst[number - 1]->setVisible(!isExpression);
+  mathScalarSecond[number - 1]->setVisible(!isExpression);
+  mathFormula[number - 1]->setVisible(isExpression);
+
+  // Vzorec se přeloží i zde, aby bylo vidět chybu a PlotData věděla, které kanály posílat
+  CompiledExpression expression;
+  bool expressionIsValid = isExpression && expression.setExpression(mathFormula[number - 1]->text()) && expression.getChannelMask() != 0;
+  mathFormula[number - 1]->setStyleSheet(isExpression && !expressionIsValid ? "color: rgb(255, 0, 0);" : "");
+
+  emit setMathFirst(number, mathEn[number - 1]->isChecked() && !isExpression ? mathFirst[number - 1]->currentIndex() + 1 : 0);
+  emit setMathSecond(number, mathEn[number - 1]->isChecked() && !isExpression ? mathSecond[number - 1]->currentIndex() + 1 : 0);
+  emit setMathExpressionInputs(number, mathEn[number - 1]->isChecked() && expressionIsValid ? expression.getChannelMask() : 0);
   emit clearMath(number);
   ui->plot->clearCh(getAnalogChId(number, ChannelType::math));
-  if (mathEn[number - 1]->isChecked()) {
+  if (mathEn[number - 1]->isChecked() && isExpression) {
+    if (expressionIsValid) {
+      QVector<QSharedPointer<QCPGraphDataContainer>> inputs(ANALOG_COUNT);
+      for (int i = 0; i < ANALOG_COUNT; i++)
+        if (expression.getChannelMask() & (1u << i))
+          inputs[i] = ui->plot->graph(getAnalogChId(i + 1, ChannelType::analog))->data();
+      emit resetMathExpression(number, mathFormula[number - 1]->text(), inputs);
+    } else if (!mathFormula[number - 1]->text().trimmed().isEmpty()) {
+      printMessage(tr("Math error"), (expression.getError().isEmpty() ? tr("Formula does not use any channel") : expression.getError()).toUtf8(), MessageLevel::error, MessageTarget::serial1);
+    }
+  } else if (mathEn[number - 1]->isChecked()) {
     MathOperations::enumMathOperations operation = (MathOperations::enumMathOperations)mathOp[number - 1]->currentIndex();
     QSharedPointer<QCPGraphDataContainer> in1, in2;
 
@@ -341,9 +425,11 @@ void MainWindow::updateMathNow(int number) {
 
 void MainWindow::interpolationResult(int chID, QSharedPointer<QCPGraphDataContainer> dataOriginal, QSharedPointer<QCPGraphDataContainer> dataInterpolated, bool dataIsFromInterpolationBuffer) {
   ui->plot->newInterpolatedVector(chID, dataOriginal, dataInterpolated, dataIsFromInterpolationBuffer);
+  if (dataIsFromInterpolationBuffer)
+    interpolatedVersions[chID] = ui->plot->getDataVersion(chID);
   interpolationsRunning--;
   if (interpolationsRunning == 0)
-    interpolationTimer.start();
+    interpolationTrigger.finished();
 }
 
 void MainWindow::deviceError(QByteArray message, MessageTarget::enumMessageTarget source) {
@@ -437,6 +523,8 @@ void MainWindow::on_pushButtonAvg_toggled(bool checked) {
   emit setAverager(checked);
 }
 
+void MainWindow::on_comboBoxAvgMode_currentIndexChanged(int index) { emit setAveragerMode((AveragerMode::enumAveragerMode)index); }
+
 void MainWindow::on_spinBoxAvg_valueChanged(int arg1) {
   if (ui->radioButtonAverageAll->isChecked()) {
     for (int i = 0; i < ANALOG_COUNT; i++) {
@@ -466,6 +554,62 @@ void MainWindow::on_comboBoxAvgIndividualCh_currentIndexChanged(int arg1) {
   ui->spinBoxAvg->blockSignals(false);
 }
 
+void MainWindow::on_comboBoxFilterCh_currentIndexChanged(int index) {
+  ui->comboBoxFilterType->blockSignals(true);
+  ui->doubleSpinBoxFilterFreq->blockSignals(true);
+  ui->doubleSpinBoxFilterParam->blockSignals(true);
+  ui->comboBoxFilterType->setCurrentIndex(filterTypes[index]);
+  ui->doubleSpinBoxFilterFreq->setValue(filterFrequencies[index]);
+  ui->doubleSpinBoxFilterParam->setValue(filterParameters[index]);
+  ui->doubleSpinBoxFilterFreq->setEnabled(filterTypes[index] != FilterType::none && filterTypes[index] != FilterType::median);
+  ui->doubleSpinBoxFilterParam->setEnabled(filterTypes[index] != FilterType::none);
+  ui->comboBoxFilterType->blockSignals(false);
+  ui->doubleSpinBoxFilterFreq->blockSignals(false);
+  ui->doubleSpinBoxFilterParam->blockSignals(false);
+}
+
+void MainWindow::on_comboBoxFilterType_currentIndexChanged(int index) {
+  // Parametr má u každého typu jiný význam, nastaví se rozumná výchozí hodnota
+  ui->doubleSpinBoxFilterParam->blockSignals(true);
+  switch ((FilterType::enumFilterType)index) {
+    case FilterType::lowPass:
+    case FilterType::highPass:
+    case FilterType::bandPass: ui->doubleSpinBoxFilterParam->setValue(2); break;
+    case FilterType::notch: ui->doubleSpinBoxFilterParam->setValue(10); break;
+    case FilterType::firLowPass: ui->doubleSpinBoxFilterParam->setValue(63); break;
+    case FilterType::median: ui->doubleSpinBoxFilterParam->setValue(5); break;
+    case FilterType::none: break;
+  }
+  ui->doubleSpinBoxFilterParam->blockSignals(false);
+  ui->doubleSpinBoxFilterFreq->setEnabled(index != FilterType::none && index != FilterType::median);
+  ui->doubleSpinBoxFilterParam->setEnabled(index != FilterType::none);
+  updateChannelFilter();
+}
+
+void MainWindow::updateChannelFilter() {
+  int chID = ui->comboBoxFilterCh->currentIndex();
+  filterTypes[chID] = (FilterType::enumFilterType)ui->comboBoxFilterType->currentIndex();
+  filterFrequencies[chID] = ui->doubleSpinBoxFilterFreq->value();
+  filterParameters[chID] = ui->doubleSpinBoxFilterParam->value();
+  emit setChannelFilter(chID, filterTypes[chID], filterFrequencies[chID], filterParameters[chID]);
+}
+
+void MainWindow::updateTrigger() {
+  auto mode = (TriggerMode::enumTriggerMode)ui->comboBoxTriggerMode->currentIndex();
+  int chID = ui->comboBoxTriggerCh->currentIndex();
+  double level = ui->doubleSpinBoxTriggerLevel->value();
+  ui->doubleSpinBoxTriggerWidth->setEnabled(mode == TriggerMode::pulseLonger || mode == TriggerMode::pulseShorter || mode == TriggerMode::timeout);
+  emit setTrigger(mode, chID, level, ui->doubleSpinBoxTriggerWidth->value(), ui->doubleSpinBoxTriggerLength->value(), ui->spinBoxTriggerPre->value() / 100.0);
+
+  // Čára triggeru ukazuje nastavenou úroveň
+  if (mode != TriggerMode::off) {
+    ui->plot->setTriggerLineChannel(chID);
+    ui->plot->setTriggerLineValue(level);
+  }
+  if (developerOptions->getUi()->checkBoxTriggerLineEn->checkState() == Qt::PartiallyChecked)
+    ui->plot->setTriggerLineVisible(mode != TriggerMode::off);
+}
+
 void MainWindow::checkBoxTriggerLineEn_stateChanged(int arg1) { ui->plot->setTriggerLineVisible(arg1 == Qt::Checked); }
 
 void MainWindow::pushButtonClearGraph_clicked() {
@@ -576,6 +720,11 @@ void MainWindow::on_radioButtonDark_toggled(bool checked) {
     auto list1 = this->findChildren<QPushButton *>();
     list1.append(simulatedInputDialog->findChildren<QPushButton *>());
     list1.append(freqTimePlotDialog->findChildren<QPushButton *>());
+    list1.append(spectrogramDialog->findChildren<QPushButton *>());
+    list1.append(persistenceDialog->findChildren<QPushButton *>());
+    list1.append(protocolDecoderDialog->findChildren<QPushButton *>());
+    list1.append(statisticsDialog1->findChildren<QPushButton *>());
+    list1.append(statisticsDialog2->findChildren<QPushButton *>());
     foreach (auto w, list1)
       w->setIcon(invertIconLightness(w->icon(), w->iconSize()));
 
@@ -626,6 +775,10 @@ void MainWindow::on_radioButtonDark_toggled(bool checked) {
 
     auto list4 = this->findChildren<MyPlot *>();
     list4.append(freqTimePlotDialog->findChildren<MyPlot *>());
+    list4.append(spectrogramDialog->findChildren<MyPlot *>());
+    list4.append(persistenceDialog->findChildren<MyPlot *>());
+    list4.append(statisticsDialog1->findChildren<MyPlot *>());
+    list4.append(statisticsDialog2->findChildren<MyPlot *>());
     foreach (auto plot, list4) {
       plot->setTheme(fnt, bck, checked ? 2 : 1);
     }
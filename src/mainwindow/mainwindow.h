@@ -21,6 +21,7 @@
 #include <QElapsedTimer>
 #include <QMainWindow>
 #include <QMessageBox>
+#include <QProgressDialog>
 #include <QQmlContext>
 #include <QQmlEngine>
 #include <QSerialPortInfo>
@@ -29,17 +30,29 @@
 #include <QTranslator>
 #include <QtCore>
 
+#include "communication/datalogger.h"
 #include "communication/filesender.h"
 #include "communication/serialreader.h"
 #include "communication/serialsettingsdialog.h"
 #include "developeroptions.h"
 #include "freqtimeplotdialog.h"
 #include "global.h"
+#include "mainwindow/analysistrigger.h"
 #include "mainwindow/appsettings.h"
 #include "mainwindow/updatechecker.h"
 #include "manualinputdialog.h"
+#include "protocoldecoderdialog.h"
+#include "persistencedialog.h"
+#include "plots/plotmailbox.h"
+#include "spectrogramdialog.h"
+#include "statisticsdialog.h"
 #include "math/averager.h"
+#include "math/logicmeasurement.h"
+#include "math/persistence.h"
 #include "math/plotmath.h"
+#include "math/protocoldecoder.h"
+#include "math/signalprocessing.h"
+#include "math/spectrogram.h"
 #include "qml/ansiterminalmodel.h"
 #include "qml/messagemodel.h"
 #include "qml/qmlterminalinterface.h"
@@ -58,7 +71,7 @@ class MainWindow : public QMainWindow {
 
 public:
   explicit MainWindow(QWidget *parent = nullptr);
-  void init(QTranslator *translator, const PlotData *plotData, const PlotMath *plotMath, SerialReader *serialReader, const Averager *avg);
+  void init(QTranslator *translator, const PlotData *plotData, const PlotMath *plotMath, SerialReader *serialReader, const Averager *avg, const Spectrogram *spectrogram, const ProtocolDecoder *decoder, const SignalProcessing *measure1, const SignalProcessing *measure2, const Persistence *persistence);
   ~MainWindow();
 
   void plotMaximizeButtonClicked(QString id);
@@ -70,9 +83,17 @@ private:
   SerialSettingsDialog *serialSettingsDialog;
   DeveloperOptions *developerOptions;
   FreqTimePlotDialog *freqTimePlotDialog;
+  SpectrogramDialog *spectrogramDialog;
+  PersistenceDialog *persistenceDialog;
+  ProtocolDecoderDialog *protocolDecoderDialog;
+  StatisticsDialog *statisticsDialog1, *statisticsDialog2;
+  PlotMailbox *plotMailbox;
   QSharedPointer<ManualInputDialog> simulatedInputDialog;
   QTranslator *translator;
-  QTimer portsRefreshTimer, activeChRefreshTimer, xyTimer, cursorRangeUpdateTimer, measureRefreshTimer1, measureRefreshTimer2, fftTimer1, fftTimer2, serialMonitorTimer, consoleTimer, interpolationTimer, triggerLineTimer;
+  QTimer portsRefreshTimer, activeChRefreshTimer, cursorRangeUpdateTimer, serialMonitorTimer, consoleTimer, triggerLineTimer;
+  /// Analýzy se přepočítávají při změně vstupů (verze dat, rozsah, nastavení), nejvýše s danou četností [ms]
+  AnalysisTrigger measureTrigger1{250}, measureTrigger2{250}, measureTriggerLogic{250}, measureTriggerCorrelation{250};
+  AnalysisTrigger fftTrigger1{50}, fftTrigger2{50}, xyTrigger{50}, interpolationTrigger{50};
   QList<QSerialPortInfo> portList;
   FileSender fileSender;
   QString configFilePath;
@@ -83,10 +104,16 @@ private:
   QComboBox *mathOp[3];
   QDoubleSpinBox *mathScalarFirst[3];
   QDoubleSpinBox *mathScalarSecond[3];
+  QLineEdit *mathFormula[3];
   QIcon iconRun, iconPause, iconHidden, iconVisible, iconConnected, iconNotConnected, iconCross, iconAbsoluteCursor, iconMaximize, iconUnMaximize;
   QString serialMonitor;
   QStringList consoleBuffer;
   int averagerCounts[ANALOG_COUNT];
+  FilterType::enumFilterType filterTypes[ANALOG_COUNT];
+  double filterFrequencies[ANALOG_COUNT];
+  double filterParameters[ANALOG_COUNT];
+  void updateChannelFilter();
+  void updateTrigger();
   QStringList autoConnectPortNames;
   QString attemptReconnectPort;
   ChannelExpectedRange channelExpectedRanges[ANALOG_COUNT + MATH_COUNT];
@@ -101,6 +128,8 @@ private:
   bool colorUpdateNeeded = true;
   bool currentThemeDark = false;
   int interpolationsRunning = 0;
+  QVector<quint64> interpolatedVersions = QVector<quint64>(ANALOG_COUNT + MATH_COUNT, ~0ULL); ///< Verze dat, ze které je spočítaná interpolace
+  QCPRange lastInterpolationRange;
   bool lastUpdateWasLogic = false;
   int lastSelectedChannel = 1;
   bool pendingDeviceMessage = false;
@@ -111,6 +140,9 @@ private:
 
   bool writeConfigInAppDirectory = false;
   QByteArray versionstring;
+  bool loggingActive = false;
+  QString loggingFileName;
+  qint64 loggingBytesAtStart = 0, loggingDroppedAtStart = 0; ///< Stav počítadel při spuštění logování
 
 private:
   void setComboboxItemVisible(QComboBox &comboBox, int index, bool visible);
@@ -124,11 +156,15 @@ private:
   void updateChScale();
   void changeLanguage(QString code);
   void exportCSV(int ch);
+  /// Dialog s průběhem exportu, ukáže se až když export trvá déle, smaže se po dokončení
+  QProgressDialog *createExportProgress(QString text, QWidget *parent);
   void fillChannelSelect();
   void updateChannelComboBox(QComboBox &combobox, int numberOfExcludedAtEnd);
   void updateSelectedChannel(int arg1);
   void updateMathNow(int number);
   void updateXY();
+  /// Doplní do Metrics ukazatele, které se počítají z GUI (paměť kanálů, fronty výpočtů)
+  void updateMetrics();
   void setCursorsVisibility(Cursors::enumCursors cursor, int graph, int timeCurState, int valueCurState);
   void updateXYCursorsCalculations();
   void updateCursorMeasurementsText();
@@ -158,9 +194,12 @@ private slots:
   void updateCursorRange();
   void updateMeasurements1();
   void updateMeasurements2();
+  void updateLogicMeasurements();
+  void updateCorrelation();
   void updateFFT1();
   void updateFFT2();
   void updateInterpolation();
+  void scheduleAnalyses();
   void updateSerialMonitor();
   void horizontalSliderTimeCur1_realValueChanged(int arg1) { horizontalSliderTimeCurXXX_realValueChanged(1, arg1); }
   void horizontalSliderTimeCur2_realValueChanged(int arg1) { horizontalSliderTimeCurXXX_realValueChanged(2, arg1); }
@@ -205,6 +244,10 @@ private slots: // Autoconnect slots
   void on_comboBoxLogic2_currentIndexChanged(int index) { emit setChDigital(2, ui->pushButtonLog2->isChecked() ? index + 1 : 0); }
   void on_pushButtonPlotImage_clicked();
   void on_pushButtonXYImage_clicked();
+  void on_pushButtonCaptureSave_clicked();
+  void on_pushButtonCaptureOpen_clicked();
+  void on_pushButtonWAV_clicked();
+  void on_pushButtonLogging_clicked();
   void on_checkBoxCur1XMode_stateChanged(int arg1) { on_checkBoxCurXXXVisible_stateChanged(1, arg1); }
   void on_checkBoxCur2XMode_stateChanged(int arg1) { on_checkBoxCurXXXVisible_stateChanged(2, arg1); }
   void on_pushButtonChangeChColor_clicked();
@@ -222,6 +265,9 @@ private slots: // Autoconnect slots
   void on_comboBoxMathSecond1_currentIndexChanged(int) { updateMathNow(1); }
   void on_comboBoxMathSecond2_currentIndexChanged(int) { updateMathNow(2); }
   void on_comboBoxMathSecond3_currentIndexChanged(int) { updateMathNow(3); }
+  void on_lineEditMathFormula1_editingFinished() { updateMathNow(1); }
+  void on_lineEditMathFormula2_editingFinished() { updateMathNow(2); }
+  void on_lineEditMathFormula3_editingFinished() { updateMathNow(3); }
   void on_doubleSpinBoxMathScalar1_1_valueChanged(double) { updateMathNow(1); }
   void on_doubleSpinBoxMathScalar1_2_valueChanged(double) { updateMathNow(2); }
   void on_doubleSpinBoxMathScalar1_3_valueChanged(double) { updateMathNow(3); }
@@ -264,9 +310,20 @@ private slots: // Autoconnect slots
   void on_pushButtonHideCur1_clicked();
   void on_pushButtonHideCur2_clicked();
   void on_pushButtonAvg_toggled(bool checked);
+  void on_comboBoxAvgMode_currentIndexChanged(int index);
   void on_spinBoxAvg_valueChanged(int arg1);
   void on_radioButtonAverageIndividual_toggled(bool checked);
   void on_comboBoxAvgIndividualCh_currentIndexChanged(int arg1);
+  void on_comboBoxFilterCh_currentIndexChanged(int index);
+  void on_comboBoxFilterType_currentIndexChanged(int index);
+  void on_doubleSpinBoxFilterFreq_valueChanged(double) { updateChannelFilter(); }
+  void on_doubleSpinBoxFilterParam_valueChanged(double) { updateChannelFilter(); }
+  void on_comboBoxTriggerMode_currentIndexChanged(int) { updateTrigger(); }
+  void on_comboBoxTriggerCh_currentIndexChanged(int) { updateTrigger(); }
+  void on_doubleSpinBoxTriggerLevel_valueChanged(double) { updateTrigger(); }
+  void on_doubleSpinBoxTriggerWidth_valueChanged(double) { updateTrigger(); }
+  void on_doubleSpinBoxTriggerLength_valueChanged(double) { updateTrigger(); }
+  void on_spinBoxTriggerPre_valueChanged(int) { updateTrigger(); }
   void on_lineEditHUnit_textChanged(const QString &arg1);
   void on_pushButtonProtocolGuideCZ_clicked();
   void on_pushButtonProtocolGuideEN_clicked();
@@ -285,6 +342,13 @@ private slots: // Autoconnect slots
   void on_pushButtonSetCenter_clicked();
   void on_pushButtonSetNegative_clicked();
   void on_pushButtonFvsT_clicked();
+
+  void on_pushButtonSpectrogram_clicked();
+  void on_pushButtonPersistence_clicked();
+  void on_pushButtonProtocolDecoder_clicked();
+  void on_pushButtonStatistics1_clicked();
+  void on_pushButtonStatistics2_clicked();
+  void updateStatisticsChannels();
   void on_pushButtonSerialMonitor_toggled(bool checked);
   void on_comboBoxXYStyle_currentIndexChanged(int index);
   void on_comboBoxFFTStyle1_currentIndexChanged(int index);
@@ -316,6 +380,8 @@ public slots:
   void printSerialMonitor(QByteArray data);
   void signalMeasurementsResult1(double period, double freq, double amp, double min, double max, double vrms, double dc, double fs, double rise, double fall, int samples);
   void signalMeasurementsResult2(double period, double freq, double amp, double min, double max, double vrms, double dc, double fs, double rise, double fall, int samples);
+  void logicMeasurementsResult(int group, QVector<LogicBitMeasurement> bits, int samples);
+  void correlationResult(double delay, double phase, double coefficient, double frequency, int samples);
   void fftResult1(QSharedPointer<QCPGraphDataContainer> data);
   void fftResult2(QSharedPointer<QCPGraphDataContainer> data);
   void xyResult(QSharedPointer<QCPCurveDataContainer> data);
@@ -335,12 +401,15 @@ public slots:
   void setQmlProperty(QByteArray data);
   void loadQmlFile(QUrl url);
   void dataRateUpdate(int dataUpdates);
+  void sampleRateUpdate(QVector<ChannelRate> rates, qint64 bytesPerSec);
   void mainPlotHRangeChanged(QCPRange range);
   void mainPlotHRangeMaxChanged(QCPRange range);
   void mainPlotVRangeChanged(QCPRange range);
   void mainPlotVRangeMaxChanged(QCPRange range);
   void lastDataTypeWasPointChanged(bool wasPoint);
   void checkedVersion(bool isNew, QString message);
+  void loggingFileOpened(QString fileName);
+  void loggingError(QString message);
 
 signals:
   void setChDigital(int chid, int target);
@@ -363,18 +432,28 @@ signals:
   void setMathSecond(int math, int ch);
   void clearMath(int math);
   void resetMath(int mathNumber, MathOperations::enumMathOperations mode, QSharedPointer<QCPGraphDataContainer> in1, QSharedPointer<QCPGraphDataContainer> in2, bool firstIsConst, bool secondIsConst, double scaleFirst, double scaleSecond);
-  void requestXY(QSharedPointer<QCPGraphDataContainer> in1, QSharedPointer<QCPGraphDataContainer> in2, bool removeDC);
-  void requstMeasurements1(QSharedPointer<QCPGraphDataContainer> data);
-  void requstMeasurements2(QSharedPointer<QCPGraphDataContainer> data);
-  void requestFFT1(QSharedPointer<QCPGraphDataContainer> data, FFTType::enumFFTType type, FFTWindow::enumFFTWindow window, bool removeDC, int pWelchtimeDivisions, bool twosided, bool zerocenter, int minNFFT);
-  void requestFFT2(QSharedPointer<QCPGraphDataContainer> data, FFTType::enumFFTType type, FFTWindow::enumFFTWindow window, bool removeDC, int pWelchtimeDivisions, bool twosided, bool zerocenter, int minNFFT);
+  void setMathExpressionInputs(int math, quint32 channelMask);
+  void resetMathExpression(int mathNumber, QString expression, QVector<QSharedPointer<QCPGraphDataContainer>> inputs);
+  void requestXY(ChannelSnapshot in1, ChannelSnapshot in2, bool removeDC, Resampling::enumResampling method);
+  void requstMeasurements1(ChannelSnapshot data);
+  void requstMeasurements2(ChannelSnapshot data);
+  void requestLogicMeasurements(int group, double from, double to);
+  void requestCorrelation(ChannelSnapshot first, ChannelSnapshot second);
+  void requestFFT1(ChannelSnapshot data, FFTType::enumFFTType type, FFTWindow::enumFFTWindow window, bool removeDC, int pWelchtimeDivisions, bool twosided, bool zerocenter, int minNFFT);
+  void requestFFT2(ChannelSnapshot data, FFTType::enumFFTType type, FFTWindow::enumFFTWindow window, bool removeDC, int pWelchtimeDivisions, bool twosided, bool zerocenter, int minNFFT);
   void setInterpolation(int chID, bool enabled);
   void interpolate(int chID, const QSharedPointer<QCPGraphDataContainer> data, QCPRange visibleRange, bool dataIsFromInterpolationBuffer);
   void resetAverager();
   void setAverager(bool enabled);
   void setAveragerCount(int chID, int count);
+  void setAveragerMode(AveragerMode::enumAveragerMode mode);
+  void setChannelFilter(int chID, FilterType::enumFilterType type, double frequency, double parameter);
+  void setTrigger(TriggerMode::enumTriggerMode mode, int chID, double level, double width, double frameLength, double preTrigger);
+  void setStatisticsChannels(quint32 channelMask);
   void setInterpolationFilter(QString filename, int upsampling);
   void replyEcho(bool enabled);
   void changeSerialBaud(qint32 baud);
+  void startLogging(LoggerSettings settings);
+  void stopLogging();
 };
 #endif // MAINWINDOW_H
@@ -15,6 +15,9 @@
 
 #include "defaultpathmanager.h"
 #include "mainwindow.h"
+#include "metrics.h"
+#include "plots/capturefile.h"
+#include "plots/csvexport.h"
 #include "ui_freqtimeplotdialog.h"
 
 void MainWindow::exportCSV(int ch) {
@@ -37,25 +40,24 @@ void MainWindow::exportCSV(int ch) {
     }
   }
 
-  QByteArray data;
-  char decimal = ui->radioButtonCSVDot->isChecked() ? '.' : ',';
-  char separator = ui->radioButtonCSVDot->isChecked() ? ',' : ';';
+  // Data se připraví hned (sdílená nebo zkopírovaná), formátování a zápis běží na pozadí
+  CsvTable table;
   if (ch == EXPORT_ALL)
-    data = (ui->plot->exportAllCSV(separator, decimal, ui->spinBoxCSVPrecision->value(), ui->checkBoxCSVVRO->isChecked(), ui->checkBoxCSVIncludeHidden->isChecked()));
+    table = ui->plot->exportAllTable(ui->checkBoxCSVVRO->isChecked(), ui->checkBoxCSVIncludeHidden->isChecked());
   else {
     if (ch >= ANALOG_COUNT + MATH_COUNT)
-      data = (ui->plot->exportLogicCSV(separator, decimal, ch - ANALOG_COUNT - MATH_COUNT, ui->spinBoxCSVPrecision->value(), ui->checkBoxCSVVRO->isChecked()));
+      table = ui->plot->exportLogicTable(ch - ANALOG_COUNT - MATH_COUNT, ui->checkBoxCSVVRO->isChecked());
     else if (ch == EXPORT_XY)
-      data = (ui->plotxy->exportCSV(separator, decimal, ui->spinBoxCSVPrecision->value()));
+      table = ui->plotxy->exportTable();
     else if (ch == EXPORT_FREQTIME)
-      data = (freqTimePlotDialog->getUi()->plotPeak->exportCSV(separator, decimal, ui->spinBoxCSVPrecision->value()));
+      table = freqTimePlotDialog->getUi()->plotPeak->exportTable();
     else if (ch == EXPORT_FFT)
-      data = (ui->plotFFT->exportCSV(separator, decimal, ui->spinBoxCSVPrecision->value()));
+      table = ui->plotFFT->exportTable();
     else
-      data = (ui->plot->exportChannelCSV(separator, decimal, ch, ui->spinBoxCSVPrecision->value(), ui->checkBoxCSVVRO->isChecked()));
+      table = ui->plot->exportChannelTable(ch, ui->checkBoxCSVVRO->isChecked());
   }
 
-  if (data.isEmpty()) {
+  if (table.isEmpty()) {
     QMessageBox msgBox(this);
     msgBox.setText(tr("No data to export"));
     msgBox.setIcon(QMessageBox::Warning);
@@ -76,23 +78,161 @@ void MainWindow::exportCSV(int ch) {
     return;
   bool toClipboard = (returnValue == QMessageBox::Yes);
 
+  CsvFormat format;
+  format.decimal = ui->radioButtonCSVDot->isChecked() ? '.' : ',';
+  format.separator = ui->radioButtonCSVDot->isChecked() ? ',' : ';';
+  format.precision = ui->spinBoxCSVPrecision->value();
+
+  QString fileName;
   if (toClipboard) {
-    data.replace(separator, '\t'); // V Excelovském formátu tabulky jsou hodnoty oddělené tabulátory
-    QClipboard *clipboard = QGuiApplication::clipboard();
-    clipboard->setText(data);
+    format.separator = '\t'; // V Excelovském formátu tabulky jsou hodnoty oddělené tabulátory
   } else {
     QString defaultName = QString("%1.csv").arg(name);
-    QString fileName = DefaultPathManager::getInstance().requestSaveFile(dialogParent, tr("Export %1").arg(name), "path_export", defaultName, tr("Comma separated values (*.csv)"));
+    fileName = DefaultPathManager::getInstance().requestSaveFile(dialogParent, tr("Export %1").arg(name), "path_export", defaultName, tr("Comma separated values (*.csv)"));
     if (fileName.isEmpty())
       return;
-    QFile file(fileName);
-    if (file.open(QFile::WriteOnly | QFile::Truncate)) {
-      file.write(data);
-      file.close();
-    } else {
-      qCritical() << "Cannot write to file" << fileName;
+  }
+
+  QProgressDialog *progressDialog = createExportProgress(tr("Exporting %1").arg(name), dialogParent);
+  CsvExport *csvExport = new CsvExport(table, format);
+  connect(csvExport, &CsvExport::progress, progressDialog, &QProgressDialog::setValue);
+  connect(progressDialog, &QProgressDialog::canceled, csvExport, &CsvExport::cancel);
+  connect(csvExport, &CsvExport::finished, progressDialog, [progressDialog, toClipboard](bool ok, QByteArray data) {
+    progressDialog->deleteLater();
+    if (ok && toClipboard)
+      QGuiApplication::clipboard()->setText(data);
+  });
+  csvExport->start(fileName);
+}
+
+QProgressDialog *MainWindow::createExportProgress(QString text, QWidget *parent) {
+  QProgressDialog *progressDialog = new QProgressDialog(text, tr("Cancel"), 0, 100, parent);
+  progressDialog->setWindowModality(Qt::WindowModal);
+  progressDialog->setMinimumDuration(500);
+  progressDialog->setValue(0);
+  return progressDialog;
+}
+
+void MainWindow::on_pushButtonCaptureSave_clicked() {
+  Capture capture = ui->plot->exportCapture();
+  if (capture.streams.isEmpty()) {
+    QMessageBox msgBox(this);
+    msgBox.setText(tr("No data to export"));
+    msgBox.setIcon(QMessageBox::Warning);
+    msgBox.exec();
+    return;
+  }
+  QString fileName = DefaultPathManager::getInstance().requestSaveFile(this, tr("Save capture"), "path_export", "capture.dpcap", tr("DataPlotter capture (*.dpcap)"));
+  if (fileName.isEmpty())
+    return;
+
+  QProgressDialog *progressDialog = createExportProgress(tr("Saving capture"), this);
+  CaptureFile *job = CaptureFile::save(capture, fileName);
+  connect(job, &CaptureFile::progress, progressDialog, &QProgressDialog::setValue);
+  connect(progressDialog, &QProgressDialog::canceled, job, &CaptureFile::cancel);
+  connect(job, &CaptureFile::finished, progressDialog, [progressDialog, job, fileName](bool ok) {
+    progressDialog->deleteLater();
+    if (!ok && !job->errorString().isEmpty())
+      qCritical() << "Cannot write to file" << fileName << job->errorString();
+  });
+  job->start();
+}
+
+void MainWindow::on_pushButtonCaptureOpen_clicked() {
+  QString fileName = DefaultPathManager::getInstance().requestOpenFile(this, tr("Open capture"), "path_export", tr("DataPlotter capture (*.dpcap)"));
+  if (fileName.isEmpty())
+    return;
+  CaptureFile *job = CaptureFile::open(fileName);
+  connect(job, &CaptureFile::finished, this, [this, job](bool ok) {
+    if (ok) {
+      ui->plot->showCapture(job->result());
+      return;
     }
+    QMessageBox msgBox(this);
+    msgBox.setText(tr("Cannot open capture: %1").arg(job->errorString()));
+    msgBox.setIcon(QMessageBox::Warning);
+    msgBox.exec();
+  });
+  job->start();
+}
+
+void MainWindow::on_pushButtonWAV_clicked() {
+  int ch = ui->comboBoxSelectedChannel->currentIndex();
+  if (ch >= ANALOG_COUNT + MATH_COUNT) {
+    QMessageBox msgBox(this);
+    msgBox.setText(tr("Only analog and math channels can be exported as WAV"));
+    msgBox.setIcon(QMessageBox::Warning);
+    msgBox.exec();
+    return;
+  }
+  if (ui->plot->graph(ch)->data()->isEmpty()) {
+    QMessageBox msgBox(this);
+    msgBox.setText(tr("No data to export"));
+    msgBox.setIcon(QMessageBox::Warning);
+    msgBox.exec();
+    return;
   }
+  QString fileName = DefaultPathManager::getInstance().requestSaveFile(this, tr("Export %1").arg(getChName(ch)), "path_export", QString("%1.wav").arg(getChName(ch)), tr("WAV audio (*.wav)"));
+  if (fileName.isEmpty())
+    return;
+
+  CaptureFile *job = CaptureFile::saveWav(ui->plot->shareChannelData(ch), fileName);
+  connect(job, &CaptureFile::finished, this, [this, job](bool ok) {
+    if (ok)
+      return;
+    QMessageBox msgBox(this);
+    msgBox.setText(tr("Cannot export WAV: %1").arg(job->errorString()));
+    msgBox.setIcon(QMessageBox::Warning);
+    msgBox.exec();
+  });
+  job->start();
+}
+
+void MainWindow::on_pushButtonLogging_clicked() {
+  if (loggingActive) {
+    emit stopLogging();
+    loggingActive = false;
+    ui->pushButtonLogging->setText(tr("Start logging"));
+    ui->labelLogStatus->setText(tr("Saved to %1").arg(QFileInfo(loggingFileName).fileName()));
+    return;
+  }
+
+  LoggerSettings settings;
+  settings.format = (LogFormat::enumLogFormat)ui->comboBoxLogFormat->currentIndex();
+  if (settings.format == LogFormat::csv)
+    settings.fileName = DefaultPathManager::getInstance().requestSaveFile(this, tr("Log to file"), "path_export", "log.csv", tr("Comma separated values (*.csv)"));
+  else
+    settings.fileName = DefaultPathManager::getInstance().requestSaveFile(this, tr("Log to file"), "path_export", "log.dpcap", tr("DataPlotter capture (*.dpcap)"));
+  if (settings.fileName.isEmpty())
+    return;
+  settings.rotateBytes = ui->spinBoxLogRotateMB->value() * 1024LL * 1024LL;
+  settings.rotateSeconds = ui->spinBoxLogRotateMin->value() * 60;
+  settings.sync = (LogSync::enumLogSync)ui->comboBoxLogSync->currentIndex();
+  settings.csv.decimal = ui->radioButtonCSVDot->isChecked() ? '.' : ',';
+  settings.csv.separator = ui->radioButtonCSVDot->isChecked() ? ',' : ';';
+  settings.csv.precision = ui->spinBoxCSVPrecision->value();
+
+  loggingActive = true;
+  loggingFileName.clear();
+  loggingBytesAtStart = Metrics::value(Metrics::loggerBytes);
+  loggingDroppedAtStart = Metrics::value(Metrics::loggerSamplesDropped);
+  ui->pushButtonLogging->setText(tr("Stop logging"));
+  emit startLogging(settings);
+}
+
+void MainWindow::loggingFileOpened(QString fileName) {
+  loggingFileName = fileName;
+  ui->labelLogStatus->setText(QFileInfo(fileName).fileName());
+}
+
+void MainWindow::loggingError(QString message) {
+  loggingActive = false;
+  ui->pushButtonLogging->setText(tr("Start logging"));
+  ui->labelLogStatus->setText(tr("Logging stopped"));
+  QMessageBox msgBox(this);
+  msgBox.setText(message);
+  msgBox.setIcon(QMessageBox::Critical);
+  msgBox.exec();
 }
 
 void MainWindow::on_pushButtonPlotImage_clicked() {
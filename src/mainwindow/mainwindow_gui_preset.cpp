@@ -50,14 +50,32 @@ void MainWindow::connectSignals() {
   connect(&portsRefreshTimer, &QTimer::timeout, this, &MainWindow::comRefresh);
   connect(&activeChRefreshTimer, &QTimer::timeout, this, &MainWindow::updateUsedChannels);
   connect(&cursorRangeUpdateTimer, &QTimer::timeout, this, &MainWindow::updateCursorRange);
-  connect(&measureRefreshTimer1, &QTimer::timeout, this, &MainWindow::updateMeasurements1);
-  connect(&measureRefreshTimer2, &QTimer::timeout, this, &MainWindow::updateMeasurements2);
-  connect(&fftTimer1, &QTimer::timeout, this, &::MainWindow::updateFFT1);
-  connect(&fftTimer2, &QTimer::timeout, this, &::MainWindow::updateFFT2);
-  connect(&xyTimer, &QTimer::timeout, this, &::MainWindow::updateXY);
+  connect(&measureTrigger1.timer, &QTimer::timeout, this, &MainWindow::updateMeasurements1);
+  connect(&measureTrigger2.timer, &QTimer::timeout, this, &MainWindow::updateMeasurements2);
+  connect(&measureTriggerLogic.timer, &QTimer::timeout, this, &MainWindow::updateLogicMeasurements);
+  connect(&measureTriggerCorrelation.timer, &QTimer::timeout, this, &MainWindow::updateCorrelation);
+  connect(&fftTrigger1.timer, &QTimer::timeout, this, &::MainWindow::updateFFT1);
+  connect(&fftTrigger2.timer, &QTimer::timeout, this, &::MainWindow::updateFFT2);
+  connect(&xyTrigger.timer, &QTimer::timeout, this, &::MainWindow::updateXY);
   connect(&serialMonitorTimer, &QTimer::timeout, this, &MainWindow::updateSerialMonitor);
   connect(&serialMonitorTimer, &QTimer::timeout, this, &MainWindow::updateConsole);
-  connect(&interpolationTimer, &QTimer::timeout, this, &MainWindow::updateInterpolation);
+  connect(&interpolationTrigger.timer, &QTimer::timeout, this, &MainWindow::updateInterpolation);
+
+  // Analýzy se přepočítají při změně dat v grafu, posunu osy nebo změně kteréhokoli nastavení na jejich stránkách
+  // (zda se vstupy opravdu změnily, rozhodne funkce přepočtu podle podpisu)
+  connect(ui->plot, &MyMainPlot::dataUpdated, this, &MainWindow::scheduleAnalyses);
+  connect(ui->plot->xAxis, SIGNAL(rangeChanged(QCPRange)), this, SLOT(scheduleAnalyses()));
+  connect(ui->tabsControll, &QTabWidget::currentChanged, this, &MainWindow::scheduleAnalyses);
+  for (QWidget *page : {ui->Measure, ui->FFT, ui->XY}) {
+    for (auto comboBox : page->findChildren<QComboBox *>())
+      connect(comboBox, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &MainWindow::scheduleAnalyses);
+    for (auto spinBox : page->findChildren<QSpinBox *>())
+      connect(spinBox, QOverload<int>::of(&QSpinBox::valueChanged), this, &MainWindow::scheduleAnalyses);
+    for (auto button : page->findChildren<QAbstractButton *>())
+      connect(button, &QAbstractButton::toggled, this, &MainWindow::scheduleAnalyses);
+  }
+  connect(developerOptions->getUi()->checkBoxFFTTwoSided, &QCheckBox::toggled, this, &MainWindow::scheduleAnalyses);
+  connect(developerOptions->getUi()->checkBoxFFTZeroCenter, &QCheckBox::toggled, this, &MainWindow::scheduleAnalyses);
   connect(&triggerLineTimer, &QTimer::timeout, this, &MainWindow::turnOffTriggerLine);
 
   connect(ui->horizontalSliderTimeCur1, &myCursorSlider::realValueChanged, this, &MainWindow::horizontalSliderTimeCur1_realValueChanged);
@@ -104,14 +122,9 @@ void MainWindow::startTimers() {
   portsRefreshTimer.start(500);
   activeChRefreshTimer.start(500);
   cursorRangeUpdateTimer.start(100);
-  measureRefreshTimer1.start(250);
-  measureRefreshTimer2.start(250);
-  fftTimer1.start(50);
-  fftTimer2.start(50);
-  xyTimer.start(50);
   serialMonitorTimer.start(500);
-  interpolationTimer.start(50);
   consoleTimer.start(250);
+  scheduleAnalyses();
 }
 
 void MainWindow::setGuiDefaults() {
@@ -153,6 +166,9 @@ void MainWindow::setGuiDefaults() {
   ui->comboBoxMathSecond2->setCurrentIndex(1);
   ui->comboBoxMathFirst3->setCurrentIndex(0);
   ui->comboBoxMathSecond3->setCurrentIndex(1);
+  ui->lineEditMathFormula1->setVisible(false);
+  ui->lineEditMathFormula2->setVisible(false);
+  ui->lineEditMathFormula3->setVisible(false);
 
   ui->comboBoxLogic1->setCurrentIndex(0);
   ui->comboBoxLogic2->setCurrentIndex(1);
@@ -217,6 +233,10 @@ void MainWindow::setGuiArrays() {
   mathScalarSecond[0] = ui->doubleSpinBoxMathScalar2_1;
   mathScalarSecond[1] = ui->doubleSpinBoxMathScalar2_2;
   mathScalarSecond[2] = ui->doubleSpinBoxMathScalar2_3;
+
+  mathFormula[0] = ui->lineEditMathFormula1;
+  mathFormula[1] = ui->lineEditMathFormula2;
+  mathFormula[2] = ui->lineEditMathFormula3;
 }
 
 void MainWindow::fillChannelSelect() {
@@ -238,6 +258,8 @@ void MainWindow::fillChannelSelect() {
   ui->comboBoxLogic1->blockSignals(true);
   ui->comboBoxLogic2->blockSignals(true);
   ui->comboBoxAvgIndividualCh->blockSignals(true);
+  ui->comboBoxFilterCh->blockSignals(true);
+  ui->comboBoxTriggerCh->blockSignals(true);
   developerOptions->getUi()->comboBoxChClear->blockSignals(true);
 
   for (int i = 0; i < ANALOG_COUNT; i++) {
@@ -250,6 +272,8 @@ void MainWindow::fillChannelSelect() {
     ui->comboBoxLogic1->addItem(getChName(i));
     ui->comboBoxLogic2->addItem(getChName(i));
     ui->comboBoxAvgIndividualCh->addItem(getChName(i));
+    ui->comboBoxFilterCh->addItem(getChName(i));
+    ui->comboBoxTriggerCh->addItem(getChName(i));
   }
 
   for (int i = 0; i < ANALOG_COUNT + MATH_COUNT; i++) {
@@ -323,5 +347,7 @@ void MainWindow::fillChannelSelect() {
   ui->comboBoxLogic1->blockSignals(false);
   ui->comboBoxLogic2->blockSignals(false);
   ui->comboBoxAvgIndividualCh->blockSignals(false);
+  ui->comboBoxFilterCh->blockSignals(false);
+  ui->comboBoxTriggerCh->blockSignals(false);
   developerOptions->getUi()->comboBoxChClear->blockSignals(false);
 }
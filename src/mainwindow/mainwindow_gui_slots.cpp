@@ -305,7 +305,7 @@ void MainWindow::signalMeasurementsResult1(double period, double freq, double am
   ui->labelSig1fs->setText(floatToNiceString(fs, 4, false, false, false, ui->plotFFT->getXUnit()));
 
   ui->labelSig1samples->setText(QString::number(samples));
-  measureRefreshTimer1.start(250);
+  measureTrigger1.finished();
 }
 void MainWindow::signalMeasurementsResult2(double period, double freq, double amp, double min, double max, double vrms, double dc, double fs, double rise, double fall, int samples) {
   if (recordingOfMeasurements2.isOpen()) {
@@ -354,7 +354,49 @@ void MainWindow::signalMeasurementsResult2(double period, double freq, double am
   ui->labelSig2fs->setText(floatToNiceString(fs, 4, false, false, false, ui->plotFFT->getXUnit()));
 
   ui->labelSig2samples->setText(QString::number(samples));
-  measureRefreshTimer2.start(250);
+  measureTrigger2.finished();
+}
+
+void MainWindow::correlationResult(double delay, double phase, double coefficient, double frequency, int samples) {
+  measureTriggerCorrelation.finished();
+  if (samples == 0) {
+    ui->labelCorrDelay->setText("---");
+    ui->labelCorrPhase->setText("---");
+    ui->labelCorrCoef->setText("---");
+    return;
+  }
+  ui->labelCorrDelay->setText(floatToNiceString(delay, 4, false, false, false, ui->plot->getXUnit()));
+  ui->labelCorrPhase->setText(QString::number(phase, 'f', 1) + "° @ " + floatToNiceString(frequency, 4, false, false, false, ui->plotFFT->getXUnit()));
+  ui->labelCorrCoef->setText(QString::number(coefficient, 'f', 3));
+}
+
+void MainWindow::logicMeasurementsResult(int group, QVector<LogicBitMeasurement> bits, int samples) {
+  measureTriggerLogic.finished();
+  if (group != ui->comboBoxMeasureLogic->currentIndex())
+    return;
+
+  auto table = ui->tableWidgetLogicMeasure;
+  int bitCount = samples < 2 ? 0 : qMin(ui->plot->getLogicBitsUsed(group), bits.size());
+  table->setRowCount(bitCount);
+  for (int bit = 0; bit < bitCount; bit++) {
+    const LogicBitMeasurement &m = bits.at(bit);
+    QStringList cells;
+    cells << QString::number(bit);
+    cells << (m.frequency > 0 ? floatToNiceString(m.frequency, 4, false, false, false, ui->plotFFT->getXUnit()) : "---");
+    cells << QString::number(m.duty * 100, 'f', 1) + " %";
+    cells << (m.highWidth > 0 ? floatToNiceString(m.highWidth, 4, false, false, false, ui->plot->getXUnit()) : "---");
+    cells << (m.lowWidth > 0 ? floatToNiceString(m.lowWidth, 4, false, false, false, ui->plot->getXUnit()) : "---");
+    cells << QString("%1 / %2").arg(m.rising).arg(m.falling);
+    for (int column = 0; column < cells.size(); column++) {
+      // Položky se používají znovu, tabulka se obnovuje 4× za sekundu
+      auto item = table->item(bit, column);
+      if (!item) {
+        item = new QTableWidgetItem();
+        table->setItem(bit, column, item);
+      }
+      item->setText(cells.at(column));
+    }
+  }
 }
 
 void MainWindow::fftResult1(QSharedPointer<QCPGraphDataContainer> data) {
@@ -367,7 +409,7 @@ void MainWindow::fftResult1(QSharedPointer<QCPGraphDataContainer> data) {
   // zdvojnásobí na správnou hodnotu.
   // ui->spinBoxFFTSamples1->setValue(data->size());
 
-  fftTimer1.start();
+  fftTrigger1.finished();
 }
 
 void MainWindow::fftResult2(QSharedPointer<QCPGraphDataContainer> data) {
@@ -380,13 +422,13 @@ void MainWindow::fftResult2(QSharedPointer<QCPGraphDataContainer> data) {
   // zdvojnásobí na správnou hodnotu.
   // ui->spinBoxFFTSamples2->setValue(data->size());
 
-  fftTimer2.start();
+  fftTrigger2.finished();
 }
 
 void MainWindow::xyResult(QSharedPointer<QCPCurveDataContainer> data) {
   if (ui->pushButtonXY->isChecked())
     ui->plotxy->newData(data);
-  xyTimer.start();
+  xyTrigger.finished();
 }
 
 void MainWindow::on_pushButtonFFT_toggled(bool checked) {
@@ -525,6 +567,7 @@ void MainWindow::on_pushButtonInterpolate_toggled(bool checked) {
       ui->comboBoxGraphStyle->setCurrentIndex(GraphStyle::point); // Radši přepne na styl point, aby nebyl zmatek,
                                                                   // že v linepoint se pořád spojují body
     ui->plot->setChInterpolate(chid, checked);
+    interpolatedVersions[chid] = ~0ULL; // Po zapnutí se interpolace spočítá znovu
     emit setInterpolation(chid, checked);
   }
 }
@@ -575,6 +618,48 @@ void MainWindow::on_pushButtonFvsT_clicked() {
   ui->plotFFT->setOutputPeakValue(true);
 }
 
+void MainWindow::on_pushButtonSpectrogram_clicked() {
+  spectrogramDialog->setSourceChannel(ui->comboBoxFFTCh1->currentIndex());
+  spectrogramDialog->show();
+  spectrogramDialog->raise();
+}
+
+void MainWindow::on_pushButtonPersistence_clicked() {
+  persistenceDialog->setSourceChannel(ui->comboBoxFFTCh1->currentIndex());
+  persistenceDialog->setUnits(ui->plot->getXUnit(), ui->plot->getYUnit());
+  persistenceDialog->show();
+  persistenceDialog->raise();
+}
+
+void MainWindow::on_pushButtonProtocolDecoder_clicked() {
+  protocolDecoderDialog->show();
+  protocolDecoderDialog->raise();
+}
+
+void MainWindow::on_pushButtonStatistics1_clicked() {
+  statisticsDialog1->setSourceChannel(ui->comboBoxMeasure1->currentIndex());
+  statisticsDialog1->setUnits(ui->plot->getXUnit(), ui->plot->getYUnit());
+  statisticsDialog1->show();
+  statisticsDialog1->raise();
+}
+
+void MainWindow::on_pushButtonStatistics2_clicked() {
+  statisticsDialog2->setSourceChannel(ui->comboBoxMeasure2->currentIndex());
+  statisticsDialog2->setUnits(ui->plot->getXUnit(), ui->plot->getYUnit());
+  statisticsDialog2->show();
+  statisticsDialog2->raise();
+}
+
+void MainWindow::updateStatisticsChannels() {
+  quint32 channelMask = 0;
+  for (auto dialog : {statisticsDialog1, statisticsDialog2}) {
+    int chID = dialog->getSourceChannel();
+    if (chID >= 0 && chID < ANALOG_COUNT)
+      channelMask |= 1u << chID;
+  }
+  emit setStatisticsChannels(channelMask);
+}
+
 void MainWindow::on_pushButtonSerialMonitor_toggled(bool checked) {
   ui->frameSerialMonitor->setEnabled(checked);
   emit enableSerialMonitor(checked);
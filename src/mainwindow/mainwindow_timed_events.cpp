@@ -14,6 +14,8 @@
 //  along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include "mainwindow.h"
+#include "math/taskpool.h"
+#include "metrics.h"
 #include "ui_developeroptions.h"
 #include "ui_freqtimeplotdialog.h"
 
@@ -81,6 +83,8 @@ void MainWindow::updateUsedChannels() {
   updateChannelComboBox(*ui->comboBoxLogic1, 0);
   updateChannelComboBox(*ui->comboBoxLogic2, 0);
   updateChannelComboBox(*ui->comboBoxAvgIndividualCh, 0);
+  updateChannelComboBox(*ui->comboBoxFilterCh, 0);
+  updateChannelComboBox(*ui->comboBoxTriggerCh, 0);
   colorUpdateNeeded = false;
 }
 
@@ -139,16 +143,19 @@ void MainWindow::updateMeasurements1() {
     int chid = ui->comboBoxMeasure1->currentIndex();
     if (ui->plot->graph(chid)->data()->isEmpty())
       goto empty;
-    auto data = QSharedPointer<QCPGraphDataContainer>(
-        new QCPGraphDataContainer(*ui->plot->graph(chid)->data()));
-    if (ui->radioButtonSigPart->isChecked()) {
-      data->removeBefore(ui->plot->xAxis->range().lower);
-      data->removeAfter(ui->plot->xAxis->range().upper);
-    }
-    measureRefreshTimer1.stop();
+    AnalysisTrigger::Signature signature;
+    signature << chid << ui->plot->getDataVersion(chid) << ui->radioButtonSigPart->isChecked();
+    if (ui->radioButtonSigPart->isChecked())
+      signature << ui->plot->xAxis->range();
+    if (!measureTrigger1.start(signature.value()))
+      return; // Beze změny, výsledek platí
+    auto data = ui->plot->getSnapshot(chid);
+    if (ui->radioButtonSigPart->isChecked())
+      data = data.slice(ui->plot->xAxis->range().lower, ui->plot->xAxis->range().upper);
     emit requstMeasurements1(data);
   } else {
   empty:
+    measureTrigger1.invalidate();
     ui->labelSig1Period->setText("---");
     ui->labelSig1Freq->setText("---");
     ui->labelSig1Amp->setText("---");
@@ -171,16 +178,19 @@ void MainWindow::updateMeasurements2() {
     int chid = ui->comboBoxMeasure2->currentIndex();
     if (ui->plot->graph(chid)->data()->isEmpty())
       goto empty;
-    auto data = QSharedPointer<QCPGraphDataContainer>(
-        new QCPGraphDataContainer(*ui->plot->graph(chid)->data()));
-    if (ui->radioButtonSigPart->isChecked()) {
-      data->removeBefore(ui->plot->xAxis->range().lower);
-      data->removeAfter(ui->plot->xAxis->range().upper);
-    }
-    measureRefreshTimer2.stop();
+    AnalysisTrigger::Signature signature;
+    signature << chid << ui->plot->getDataVersion(chid) << ui->radioButtonSigPart->isChecked();
+    if (ui->radioButtonSigPart->isChecked())
+      signature << ui->plot->xAxis->range();
+    if (!measureTrigger2.start(signature.value()))
+      return; // Beze změny, výsledek platí
+    auto data = ui->plot->getSnapshot(chid);
+    if (ui->radioButtonSigPart->isChecked())
+      data = data.slice(ui->plot->xAxis->range().lower, ui->plot->xAxis->range().upper);
     emit requstMeasurements2(data);
   } else {
   empty:
+    measureTrigger2.invalidate();
     ui->labelSig2Period->setText("---");
     ui->labelSig2Freq->setText("---");
     ui->labelSig2Amp->setText("---");
@@ -195,29 +205,79 @@ void MainWindow::updateMeasurements2() {
   }
 }
 
+void MainWindow::updateLogicMeasurements() {
+  if (ui->tabsControll->currentIndex() != 2)
+    return;  // Stránky s měřením není zobrazena, je zbytečné počítat
+  int group = ui->comboBoxMeasureLogic->currentIndex();
+  if (group >= LOGIC_GROUPS || !ui->plot->isChUsed(getLogicChannelID(group, 0))) {
+    ui->tableWidgetLogicMeasure->setRowCount(0);
+    measureTriggerLogic.invalidate();
+    return;
+  }
+  // Počítá se ze slov uložených v LogicMeasurement, ne z grafů jednotlivých bitů (slova přibývají spolu s grafem bitu 0)
+  AnalysisTrigger::Signature signature;
+  signature << group << ui->plot->getDataVersion(getLogicChannelID(group, 0)) << ui->radioButtonSigPart->isChecked();
+  if (ui->radioButtonSigPart->isChecked())
+    signature << ui->plot->xAxis->range();
+  if (!measureTriggerLogic.start(signature.value()))
+    return;
+  if (ui->radioButtonSigPart->isChecked())
+    emit requestLogicMeasurements(group, ui->plot->xAxis->range().lower, ui->plot->xAxis->range().upper);
+  else
+    emit requestLogicMeasurements(group, 1, -1);
+}
+
+void MainWindow::updateCorrelation() {
+  if (ui->tabsControll->currentIndex() != 2)
+    return;  // Stránky s měřením není zobrazena, je zbytečné počítat
+  int chid1 = ui->comboBoxMeasure1->currentIndex();
+  int chid2 = ui->comboBoxMeasure2->currentIndex();
+  if (!ui->checkBoxMeasureCorrelation->isChecked() || chid1 == ui->comboBoxMeasure1->count() - 1 || chid2 == ui->comboBoxMeasure2->count() - 1 || ui->plot->graph(chid1)->data()->isEmpty() || ui->plot->graph(chid2)->data()->isEmpty()) {
+    ui->labelCorrDelay->setText("---");
+    ui->labelCorrPhase->setText("---");
+    ui->labelCorrCoef->setText("---");
+    measureTriggerCorrelation.invalidate();
+    return;
+  }
+  AnalysisTrigger::Signature signature;
+  signature << chid1 << chid2 << ui->plot->getDataVersion(chid1) << ui->plot->getDataVersion(chid2) << ui->radioButtonSigPart->isChecked();
+  if (ui->radioButtonSigPart->isChecked())
+    signature << ui->plot->xAxis->range();
+  if (!measureTriggerCorrelation.start(signature.value()))
+    return;
+  auto data1 = ui->plot->getSnapshot(chid1);
+  auto data2 = ui->plot->getSnapshot(chid2);
+  if (ui->radioButtonSigPart->isChecked()) {
+    data1 = data1.slice(ui->plot->xAxis->range().lower, ui->plot->xAxis->range().upper);
+    data2 = data2.slice(ui->plot->xAxis->range().lower, ui->plot->xAxis->range().upper);
+  }
+  emit requestCorrelation(data1, data2);
+}
+
 void MainWindow::updateFFT1() {
-  if (!ui->pushButtonFFT->isChecked())
+  if (!ui->pushButtonFFT->isChecked()) {
+    fftTrigger1.invalidate(); // Spektrum se při vypnutí smaže
     return;
+  }
 
   if (ui->checkBoxFFTCh1->isChecked()) {
     int chid = ui->comboBoxFFTCh1->currentIndex();
 
-    auto data = QSharedPointer<QCPGraphDataContainer>(
-        new QCPGraphDataContainer(*ui->plot->graph(chid)->data()));
-    if (ui->radioButtonFFTPart->isChecked()) {
-      data->removeBefore(ui->plot->xAxis->range().lower);
-      data->removeAfter(ui->plot->xAxis->range().upper);
-    }
+    auto data = ui->plot->getSnapshot(chid);
+    if (ui->radioButtonFFTPart->isChecked())
+      data = data.slice(ui->plot->xAxis->range().lower, ui->plot->xAxis->range().upper);
 
-    if (data->isEmpty()) {
+    if (data.isEmpty()) {
       ui->plotFFT->clear(0);
+      fftTrigger1.invalidate();
       return;
     }
 
     if (ui->comboBoxFFTType->currentIndex() == FFTType::pwelch) {
-      if (ui->spinBoxFFTSegments1->value() * 2 > data->size()) {
+      if (ui->spinBoxFFTSegments1->value() * 2 > data.size()) {
         // Není dostatek vzorků na tento počet segmentů (alespoň 2 na segment)
         ui->plotFFT->clear(0);
+        fftTrigger1.invalidate();
         return;
       }
     }
@@ -238,7 +298,13 @@ void MainWindow::updateFFT1() {
       item->setIcon(QIcon(color));
     }
 
-    fftTimer1.stop();
+    AnalysisTrigger::Signature signature;
+    signature << chid << ui->plot->getDataVersion(chid) << ui->radioButtonFFTPart->isChecked() << ui->comboBoxFFTType->currentIndex() << ui->comboBoxFFTWindow1->currentIndex() << ui->checkBoxFFTNoDC1->isChecked() << ui->spinBoxFFTSegments1->value() << ui->spinBoxFFTSamples1->value();
+    signature << developerOptions->getUi()->checkBoxFFTTwoSided->isChecked() << developerOptions->getUi()->checkBoxFFTZeroCenter->isChecked();
+    if (ui->radioButtonFFTPart->isChecked())
+      signature << ui->plot->xAxis->range();
+    if (!fftTrigger1.start(signature.value()))
+      return;
     emit requestFFT1(
         data, (FFTType::enumFFTType)ui->comboBoxFFTType->currentIndex(),
         (FFTWindow::enumFFTWindow)ui->comboBoxFFTWindow1->currentIndex(),
@@ -246,33 +312,36 @@ void MainWindow::updateFFT1() {
         developerOptions->getUi()->checkBoxFFTTwoSided->isChecked(),
         developerOptions->getUi()->checkBoxFFTZeroCenter->isChecked(),
         ui->spinBoxFFTSamples1->value());
-  } else
+  } else {
     ui->plotFFT->clear(0);
+    fftTrigger1.invalidate();
+  }
 }
 
 void MainWindow::updateFFT2() {
-  if (!ui->pushButtonFFT->isChecked())
+  if (!ui->pushButtonFFT->isChecked()) {
+    fftTrigger2.invalidate(); // Spektrum se při vypnutí smaže
     return;
+  }
 
   if (ui->checkBoxFFTCh2->isChecked()) {
     int chid = ui->comboBoxFFTCh2->currentIndex();
 
-    auto data = QSharedPointer<QCPGraphDataContainer>(
-        new QCPGraphDataContainer(*ui->plot->graph(chid)->data()));
-    if (ui->radioButtonFFTPart->isChecked()) {
-      data->removeBefore(ui->plot->xAxis->range().lower);
-      data->removeAfter(ui->plot->xAxis->range().upper);
-    }
+    auto data = ui->plot->getSnapshot(chid);
+    if (ui->radioButtonFFTPart->isChecked())
+      data = data.slice(ui->plot->xAxis->range().lower, ui->plot->xAxis->range().upper);
 
-    if (data->isEmpty()) {
+    if (data.isEmpty()) {
       ui->plotFFT->clear(1);
+      fftTrigger2.invalidate();
       return;
     }
 
     if (ui->comboBoxFFTType->currentIndex() == FFTType::pwelch) {
-      if (ui->spinBoxFFTSegments2->value() * 2 > data->size()) {
+      if (ui->spinBoxFFTSegments2->value() * 2 > data.size()) {
         // Není dostatek vzorků na tento počet segmentů (alespoň 2 na segment)
         ui->plotFFT->clear(1);
+        fftTrigger2.invalidate();
         return;
       }
     }
@@ -292,7 +361,13 @@ void MainWindow::updateFFT2() {
       item = model->item(FFT_INDEX(1));
       item->setIcon(QIcon(color));
     }
-    fftTimer2.stop();
+    AnalysisTrigger::Signature signature;
+    signature << chid << ui->plot->getDataVersion(chid) << ui->radioButtonFFTPart->isChecked() << ui->comboBoxFFTType->currentIndex() << ui->comboBoxFFTWindow2->currentIndex() << ui->checkBoxFFTNoDC2->isChecked() << ui->spinBoxFFTSegments2->value() << ui->spinBoxFFTSamples2->value();
+    signature << developerOptions->getUi()->checkBoxFFTTwoSided->isChecked() << developerOptions->getUi()->checkBoxFFTZeroCenter->isChecked();
+    if (ui->radioButtonFFTPart->isChecked())
+      signature << ui->plot->xAxis->range();
+    if (!fftTrigger2.start(signature.value()))
+      return;
     emit requestFFT2(
         data, (FFTType::enumFFTType)ui->comboBoxFFTType->currentIndex(),
         (FFTWindow::enumFFTWindow)ui->comboBoxFFTWindow2->currentIndex(),
@@ -300,33 +375,52 @@ void MainWindow::updateFFT2() {
         developerOptions->getUi()->checkBoxFFTTwoSided->isChecked(),
         developerOptions->getUi()->checkBoxFFTZeroCenter->isChecked(),
         ui->spinBoxFFTSamples2->value());
-  } else
+  } else {
     ui->plotFFT->clear(1);
+    fftTrigger2.invalidate();
+  }
 }
 
 void MainWindow::updateInterpolation() {
-  for (int chid = 0; chid < ANALOG_COUNT + MATH_COUNT; chid++) {
-    if (ui->plot->isChInterpolated(chid)) {
-      bool dataIsFromInterpolationBuffer;
-      QSharedPointer<QCPGraphDataContainer> data;
-      if (ui->plot->dataToBeInterpolated.at(chid).isNull()) {
-        data = QSharedPointer<QCPGraphDataContainer>(
-            new QCPGraphDataContainer(*ui->plot->graph(chid)->data()));
-        dataIsFromInterpolationBuffer = false;
-      } else {
-        data = ui->plot->dataToBeInterpolated.at(chid);
-        ui->plot->dataToBeInterpolated[chid]
-            .clear();  // Vymaže pointer ze seznamu, pozor, ne jeho obsah;
-        dataIsFromInterpolationBuffer = true;
-      }
-      interpolationsRunning++;
-      emit interpolate(chid, data, ui->plot->xAxis->range(),
-                       dataIsFromInterpolationBuffer);
+  // Interpolují se jen kanály s novými daty (v bufferu nebo změněný graf), po posunu osy všechny (počítá se jen okolí zobrazené části)
+  bool rangeChanged = ui->plot->xAxis->range() != lastInterpolationRange;
+  QVector<int> channels;
+  for (int chid = 0; chid < ANALOG_COUNT + MATH_COUNT; chid++)
+    if (ui->plot->isChInterpolated(chid) && (rangeChanged || !ui->plot->dataToBeInterpolated.at(chid).isNull() || ui->plot->getDataVersion(chid) != interpolatedVersions.at(chid)))
+      channels.append(chid);
+  if (channels.isEmpty())
+    return;
+  interpolationTrigger.start();
+  lastInterpolationRange = ui->plot->xAxis->range();
+
+  for (int chid : channels) {
+    bool dataIsFromInterpolationBuffer;
+    QSharedPointer<QCPGraphDataContainer> data;
+    if (ui->plot->dataToBeInterpolated.at(chid).isNull()) {
+      data = ui->plot->shareChannelData(chid);
+      interpolatedVersions[chid] = ui->plot->getDataVersion(chid);
+      dataIsFromInterpolationBuffer = false;
+    } else {
+      data = ui->plot->dataToBeInterpolated.at(chid);
+      ui->plot->dataToBeInterpolated[chid]
+          .clear();  // Vymaže pointer ze seznamu, pozor, ne jeho obsah;
+      dataIsFromInterpolationBuffer = true;
     }
+    interpolationsRunning++;
+    emit interpolate(chid, data, ui->plot->xAxis->range(),
+                     dataIsFromInterpolationBuffer);
   }
+}
 
-  if (interpolationsRunning > 0)
-    interpolationTimer.stop();
+void MainWindow::scheduleAnalyses() {
+  measureTrigger1.schedule();
+  measureTrigger2.schedule();
+  measureTriggerLogic.schedule();
+  measureTriggerCorrelation.schedule();
+  fftTrigger1.schedule();
+  fftTrigger2.schedule();
+  xyTrigger.schedule();
+  interpolationTrigger.schedule();
 }
 
 void MainWindow::updateSerialMonitor() {
@@ -399,32 +493,87 @@ void MainWindow::updateConsole() {
 }
 
 void MainWindow::dataRateUpdate(int dataUpdates) {
+  updateMetrics();
+  int dropped = plotMailbox->takeDropped();
   if (dataUpdates > 0) {
     ui->labelUpdateRate->setText(
         tr("Data rate: ") + QString::number(dataUpdates) + tr(" updates / s"));
+    if (dropped > 0)
+      ui->labelUpdateRate->setText(ui->labelUpdateRate->text() + tr(", %1 skipped (display overloaded)").arg(dropped));
   } else
     ui->labelUpdateRate->clear();
   this->dataUpdates = dataUpdates;
 }
 
+void MainWindow::sampleRateUpdate(QVector<ChannelRate> rates, qint64 bytesPerSec) {
+  // Volá se hned po dataRateUpdate, text popisku už je nastavený
+  if (!ui->labelUpdateRate->text().isEmpty() && bytesPerSec > 0)
+    ui->labelUpdateRate->setText(ui->labelUpdateRate->text() + ", " + floatToNiceString(bytesPerSec, 3, false, false, true, UnitOfMeasure("B/s")));
+
+  QString details;
+  for (const ChannelRate &rate : rates) {
+    QString line = (rate.ch == 0 ? tr("Logic") : getChName(rate.ch - 1)) + ": " + tr("%1 samples / s").arg(rate.samples);
+    if (rate.interval > 0)
+      line.append(", " + tr("interval %1").arg(floatToNiceString(rate.interval, 3, false, false, false, UnitOfMeasure("s"))));
+    if (rate.maxInterval > 0) {
+      line.append(", " + tr("jitter %1").arg(floatToNiceString(rate.jitter, 3, false, false, false, UnitOfMeasure("s"))));
+      line.append(", " + tr("longest %1").arg(floatToNiceString(rate.maxInterval, 3, false, false, false, UnitOfMeasure("s"))));
+    }
+    if (rate.gaps > 0)
+      line.append(", " + tr("%n gap(s)", "", rate.gaps));
+    details.append(line + "\n");
+  }
+  if (bytesPerSec > 0)
+    details.append(tr("Received %1").arg(floatToNiceString(bytesPerSec, 3, false, false, true, UnitOfMeasure("B/s"))));
+  ui->labelUpdateRate->setToolTip(details.trimmed());
+}
+
+void MainWindow::updateMetrics() {
+  qint64 total = 0;
+  for (int i = 0; i < Metrics::memoryChannelCount; i++) {
+    qint64 bytes = 0;
+    if (i < ANALOG_COUNT + MATH_COUNT)
+      bytes = ui->plot->graph(i)->data()->size() * (qint64)sizeof(QCPGraphData);
+    else
+      for (int bit = 0; bit < LOGIC_BITS; bit++)
+        bytes += ui->plot->graph(getLogicChannelID(i - ANALOG_COUNT - MATH_COUNT, bit))->data()->size() * (qint64)sizeof(QCPGraphData);
+    Metrics::setChannelMemory(i, bytes);
+    total += bytes;
+  }
+  Metrics::set(Metrics::plotMemoryBytes, total);
+  Metrics::set(Metrics::workerQueueDepth, TaskPool::pendingTasks());
+
+  if (loggingActive && !loggingFileName.isEmpty()) {
+    QString status = tr("%1: %2 written, lag %3").arg(QFileInfo(loggingFileName).fileName(), floatToNiceString(Metrics::value(Metrics::loggerBytes) - loggingBytesAtStart, 3, false, false, true, UnitOfMeasure("B")), floatToNiceString(Metrics::value(Metrics::loggerLag) * 1e-9, 2, false, false, false, UnitOfMeasure("s")));
+    qint64 dropped = Metrics::value(Metrics::loggerSamplesDropped) - loggingDroppedAtStart;
+    if (dropped > 0)
+      status.append(", " + tr("%1 samples dropped").arg(dropped));
+    ui->labelLogStatus->setText(status);
+  }
+}
+
 void MainWindow::updateXY() {
   if (ui->pushButtonXY->isChecked()) {
-    auto in1 = QSharedPointer<QCPGraphDataContainer>(new QCPGraphDataContainer(
-        *ui->plot->graph(ui->comboBoxXYx->currentIndex())->data()));
-    auto in2 = QSharedPointer<QCPGraphDataContainer>(new QCPGraphDataContainer(
-        *ui->plot->graph(ui->comboBoxXYy->currentIndex())->data()));
+    auto in1 = ui->plot->getSnapshot(ui->comboBoxXYx->currentIndex());
+    auto in2 = ui->plot->getSnapshot(ui->comboBoxXYy->currentIndex());
     if (ui->radioButtonXYPart->isChecked()) {
-      in1->removeBefore(ui->plot->xAxis->range().lower);
-      in1->removeAfter(ui->plot->xAxis->range().upper);
-      in2->removeBefore(ui->plot->xAxis->range().lower);
-      in2->removeAfter(ui->plot->xAxis->range().upper);
+      in1 = in1.slice(ui->plot->xAxis->range().lower, ui->plot->xAxis->range().upper);
+      in2 = in2.slice(ui->plot->xAxis->range().lower, ui->plot->xAxis->range().upper);
     }
-    if (in2->isEmpty() || in1->isEmpty()) {
+    if (in2.isEmpty() || in1.isEmpty()) {
       ui->plotxy->clear();
+      xyTrigger.invalidate();
       return;
     }
 
-    xyTimer.stop();
-    emit requestXY(in1, in2, ui->checkBoxXYNoDC->isChecked());
-  }
+    AnalysisTrigger::Signature signature;
+    signature << ui->comboBoxXYx->currentIndex() << ui->comboBoxXYy->currentIndex() << ui->plot->getDataVersion(ui->comboBoxXYx->currentIndex()) << ui->plot->getDataVersion(ui->comboBoxXYy->currentIndex());
+    signature << ui->radioButtonXYPart->isChecked() << ui->checkBoxXYNoDC->isChecked() << ui->comboBoxXYResampling->currentIndex();
+    if (ui->radioButtonXYPart->isChecked())
+      signature << ui->plot->xAxis->range();
+    if (!xyTrigger.start(signature.value()))
+      return;
+    emit requestXY(in1, in2, ui->checkBoxXYNoDC->isChecked(), (Resampling::enumResampling)ui->comboBoxXYResampling->currentIndex());
+  } else
+    xyTrigger.invalidate();
 }
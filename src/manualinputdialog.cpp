@@ -38,13 +38,25 @@ ManualInputDialog::ManualInputDialog(QWidget *parent) : QDialog(parent), ui(new
   iconRun = QIcon(":/images/icons/run.png");
   iconPause = QIcon(":/images/icons/pause.png");
   ui->pushButtonRolling->setIcon(iconPause);
-  connect(&rollingTimer, &QTimer::timeout, this, &ManualInputDialog::rollingDataTimerRoutine);
   ui->pushButtonOsc->setIcon(iconPause);
-  connect(&oscTimer, &QTimer::timeout, this, &ManualInputDialog::oscDataTimerRoutine);
 
-  rollingEngine.globalObject().setProperty("t", 0);
-  oscEngine.globalObject().setProperty("t", 0);
-  oscEngine.globalObject().setProperty("time", 0);
+  // Generátory běží ve vlastním vlákně, data posílají rovnou do SerialReader
+  rollingGenerator = new SignalGenerator();
+  oscGenerator = new SignalGenerator();
+  connect(this, &ManualInputDialog::setRollingExpressions, rollingGenerator, &SignalGenerator::setExpressions);
+  connect(this, &ManualInputDialog::startRolling, rollingGenerator, &SignalGenerator::startPoints);
+  connect(this, &ManualInputDialog::stopRolling, rollingGenerator, &SignalGenerator::stop);
+  connect(this, &ManualInputDialog::resetRollingTime, rollingGenerator, &SignalGenerator::resetTime);
+  connect(rollingGenerator, &SignalGenerator::rateMeasured, this, &ManualInputDialog::rollingRateMeasured);
+  connect(this, &ManualInputDialog::setOscExpressions, oscGenerator, &SignalGenerator::setExpressions);
+  connect(this, &ManualInputDialog::startOsc, oscGenerator, &SignalGenerator::startChannels);
+  connect(this, &ManualInputDialog::stopOsc, oscGenerator, &SignalGenerator::stop);
+  connect(oscGenerator, &SignalGenerator::rateMeasured, this, &ManualInputDialog::oscRateMeasured);
+  connect(&generatorThread, &QThread::finished, rollingGenerator, &QObject::deleteLater);
+  connect(&generatorThread, &QThread::finished, oscGenerator, &QObject::deleteLater);
+  rollingGenerator->moveToThread(&generatorThread);
+  oscGenerator->moveToThread(&generatorThread);
+  generatorThread.start();
 
 #if QT_VERSION > QT_VERSION_CHECK(5, 10, 0)
   ui->doubleSpinBoxRollingFreq->setStepType(QAbstractSpinBox::AdaptiveDecimalStepType);
@@ -54,104 +66,103 @@ ManualInputDialog::ManualInputDialog(QWidget *parent) : QDialog(parent), ui(new
 }
 
 ManualInputDialog::~ManualInputDialog() {
-  rollingTimer.deleteLater();
+  generatorThread.quit();
+  generatorThread.wait();
   delete ui;
 }
 
 void ManualInputDialog::stopAll() {
-  rollingTimer.stop();
-  oscTimer.stop();
+  rollingRunning = false;
+  oscRunning = false;
+  emit stopRolling();
+  emit stopOsc();
   ui->pushButtonRolling->setIcon(iconPause);
   ui->pushButtonOsc->setIcon(iconPause);
+  ui->labelRollingRate->clear();
+  ui->labelOscRate->clear();
 }
 
 Ui::ManualInputDialog *ManualInputDialog::getUi() const { return ui; }
 
-void ManualInputDialog::on_doubleSpinBoxRollingFreq_valueChanged(double arg1) { rollingTimer.setInterval(1000 / arg1); }
+void ManualInputDialog::restartRunning() {
+  if (rollingRunning)
+    emit startRolling(ui->doubleSpinBoxRollingFreq->value(), ui->doubleSpinBoxTimeScale->value(), ui->doubleSpinBoxRollingRate->value());
+  if (oscRunning)
+    emit startOsc(ui->spinBoxOscLen->value(), ui->doubleSpinBoxOscFs->value() * 1000, ui->doubleSpinBoxOscRate->value());
+}
 
 void ManualInputDialog::on_pushButtonRolling_clicked() {
-  if (rollingTimer.isActive())
-    rollingTimer.stop();
-  else
-    rollingTimer.start(1000 / ui->doubleSpinBoxRollingFreq->value());
-  ui->pushButtonRolling->setIcon(rollingTimer.isActive() ? iconRun : iconPause);
+  rollingRunning = !rollingRunning;
+  if (rollingRunning)
+    restartRunning();
+  else {
+    emit stopRolling();
+    ui->labelRollingRate->clear();
+  }
+  ui->pushButtonRolling->setIcon(rollingRunning ? iconRun : iconPause);
 }
 
 void ManualInputDialog::on_pushButtonOsc_clicked() {
-  if (oscTimer.isActive())
-    oscTimer.stop();
-  else
-    oscTimer.start(100);
-  ui->pushButtonOsc->setIcon(oscTimer.isActive() ? iconRun : iconPause);
-  oscTimestamp = 0;
-}
-
-void ManualInputDialog::rollingDataTimerRoutine() {
-  rollingTimestamp += static_cast<double>(rollingTimer.interval()) / 1000.0 * ui->doubleSpinBoxTimeScale->value();
-  QString data = "$$P" + QString::number(rollingTimestamp, 'g', 10);
-  rollingEngine.globalObject().setProperty("t", rollingTimestamp);
-  for (auto &ch : rollingChannelEvaluators) {
-    bool isOk;
-    double val = ch->evaluate(rollingEngine, &isOk);
-    if (isOk)
-      data.append("," + QString::number(val));
-    else
-      data.append(",-");
+  oscRunning = !oscRunning;
+  if (oscRunning)
+    restartRunning();
+  else {
+    emit stopOsc();
+    ui->labelOscRate->clear();
   }
-  data.append(";");
-  emit sendManualInput(data.toLocal8Bit());
+  ui->pushButtonOsc->setIcon(oscRunning ? iconRun : iconPause);
 }
 
-void ManualInputDialog::oscDataTimerRoutine() {
-  oscTimestamp += static_cast<double>(oscTimer.interval()) / 1000.0;
-  int len = ui->spinBoxOscLen->value();
-  double fs = ui->doubleSpinBoxOscFs->value() * 1000;
-  oscEngine.globalObject().setProperty("time", oscTimestamp);
-  int chnum = 1;
-  for (auto &ch : oscChannelEvaluators) {
-    bool isOk;
-    QByteArray data = "$$C";
-    data.append(QString::number(chnum++).toLocal8Bit() + ",");
-    data.append(QString::number(1.0 / fs).toLocal8Bit() + ",");
-    data.append(QString::number(len).toLocal8Bit() + ";f4");
-
-    for (int i = 0; i < len; i++) {
-      oscEngine.globalObject().setProperty("t", static_cast<double>(i) / fs);
-      float value = ch->evaluate(oscEngine, &isOk);
-      data.append(reinterpret_cast<char *>(&value), 4);
-    }
+void ManualInputDialog::rollingRateMeasured(double megabytesPerSecond) {
+  if (rollingRunning)
+    ui->labelRollingRate->setText(tr("%1 MB/s").arg(megabytesPerSecond, 0, 'f', 2));
+}
 
-    data.append(";");
-    if (isOk)
-      emit sendManualInput(data);
-  }
+void ManualInputDialog::oscRateMeasured(double megabytesPerSecond) {
+  if (oscRunning)
+    ui->labelOscRate->setText(tr("%1 MB/s").arg(megabytesPerSecond, 0, 'f', 2));
 }
 
 void ManualInputDialog::on_tableWidgetRollingSetup_cellChanged(int row, int column) {
   if (column == 0) {
     auto txt = ui->tableWidgetRollingSetup->item(row, column)->text();
-    bool ok = rollingChannelEvaluators.at(row)->setExpression(rollingEngine, txt);
+    CompiledExpression parser;
+    parser.addVariable("time");
+    bool ok = parser.setExpression(txt) && parser.getChannelMask() == 0;
     QTableWidgetItem *item = new QTableWidgetItem(ok ? "OK" : txt.isEmpty() ? "Empty" : "Error");
     item->setFlags(Qt::NoItemFlags | Qt::ItemIsEnabled);
+    item->setToolTip(parser.getError());
     ui->tableWidgetRollingSetup->setItem(row, 1, item);
+    updateExpressions(ui->tableWidgetRollingSetup);
   }
 }
 
 void ManualInputDialog::on_tableWidgetOscSetup_cellChanged(int row, int column) {
   if (column == 0) {
     auto txt = ui->tableWidgetOscSetup->item(row, column)->text();
-    bool ok = oscChannelEvaluators.at(row)->setExpression(oscEngine, txt);
+    CompiledExpression parser;
+    parser.addVariable("time");
+    bool ok = parser.setExpression(txt) && parser.getChannelMask() == 0;
     QTableWidgetItem *item = new QTableWidgetItem(ok ? "OK" : txt.isEmpty() ? "Empty" : "Error");
     item->setFlags(Qt::NoItemFlags | Qt::ItemIsEnabled);
+    item->setToolTip(parser.getError());
     ui->tableWidgetOscSetup->setItem(row, 1, item);
+    updateExpressions(ui->tableWidgetOscSetup);
   }
 }
 
-void ManualInputDialog::setExprRows(QTableWidget *table, int rows) {
-  auto *evaluators = &rollingChannelEvaluators;
+void ManualInputDialog::updateExpressions(QTableWidget *table) {
+  // Poslední řádek jsou tlačítka
+  QStringList expressions;
+  for (int row = 0; row < table->rowCount() - 1; row++)
+    expressions.append(table->item(row, 0) ? table->item(row, 0)->text() : "");
   if (table == ui->tableWidgetOscSetup)
-    evaluators = &oscChannelEvaluators;
+    emit setOscExpressions(expressions);
+  else
+    emit setRollingExpressions(expressions);
+}
 
+void ManualInputDialog::setExprRows(QTableWidget *table, int rows) {
   while (table->rowCount() != rows) {
     int count = table->rowCount();
     if (rows > count) {
@@ -159,13 +170,11 @@ void ManualInputDialog::setExprRows(QTableWidget *table, int rows) {
       QTableWidgetItem *item = new QTableWidgetItem("Empty");
       item->setFlags(Qt::NoItemFlags | Qt::ItemIsEnabled);
       table->setItem(count - 1, 1, item);
-      evaluators->append(new VariableExpressionParser());
     } else {
       table->removeRow(count - 2);
-      delete evaluators->last();
-      evaluators->removeLast();
     }
   }
+  updateExpressions(table);
 
   QStringList names;
   for (int i = 1; i < table->rowCount(); i++)
@@ -174,7 +183,7 @@ void ManualInputDialog::setExprRows(QTableWidget *table, int rows) {
   table->setVerticalHeaderLabels(names);
 }
 
-void ManualInputDialog::on_pushButtonRollingResetTime_clicked() { rollingTimestamp = 0; }
+void ManualInputDialog::on_pushButtonRollingResetTime_clicked() { emit resetRollingTime(); }
 
 void ManualInputDialog::initTable(QTableWidget &table) {
   table.setRowCount(1);
@@ -16,12 +16,12 @@
 #ifndef MANUALINPUTDIALOG_H
 #define MANUALINPUTDIALOG_H
 
+#include "communication/signalgenerator.h"
 #include "global.h"
-#include "math/variableexpressionparser.h"
 #include "qicon.h"
 #include "qtablewidget.h"
-#include "qtimer.h"
 #include <QDialog>
+#include <QThread>
 
 namespace Ui {
 class ManualInputDialog;
@@ -35,16 +35,23 @@ public:
   ~ManualInputDialog();
 
   Ui::ManualInputDialog *getUi() const;
+  const SignalGenerator *getRollingGenerator() const { return rollingGenerator; }
+  const SignalGenerator *getOscGenerator() const { return oscGenerator; }
 
 public slots:
   void stopAll();
 
 private slots:
-  void on_doubleSpinBoxRollingFreq_valueChanged(double arg1);
+  void on_doubleSpinBoxRollingFreq_valueChanged(double) { restartRunning(); }
+  void on_doubleSpinBoxTimeScale_valueChanged(double) { restartRunning(); }
+  void on_doubleSpinBoxRollingRate_valueChanged(double) { restartRunning(); }
+  void on_doubleSpinBoxOscFs_valueChanged(double) { restartRunning(); }
+  void on_spinBoxOscLen_valueChanged(int) { restartRunning(); }
+  void on_doubleSpinBoxOscRate_valueChanged(double) { restartRunning(); }
   void on_pushButtonRolling_clicked();
   void on_pushButtonOsc_clicked();
-  void rollingDataTimerRoutine();
-  void oscDataTimerRoutine();
+  void rollingRateMeasured(double megabytesPerSecond);
+  void oscRateMeasured(double megabytesPerSecond);
   void on_tableWidgetRollingSetup_cellChanged(int row, int column);
   void on_tableWidgetOscSetup_cellChanged(int row, int column);
   void on_pushButtonRollingResetTime_clicked();
@@ -56,20 +63,26 @@ private slots:
 
 signals:
   void sendManualInput(QByteArray bytes);
+  void setRollingExpressions(QStringList expressions);
+  void setOscExpressions(QStringList expressions);
+  void startRolling(double frequency, double timeScale, double megabytesPerSecond);
+  void startOsc(int length, double samplingFrequency, double megabytesPerSecond);
+  void stopRolling();
+  void stopOsc();
+  void resetRollingTime();
 
 private:
   Ui::ManualInputDialog *ui;
-  QTimer rollingTimer;
-  QTimer oscTimer;
   QIcon iconRun;
   QIcon iconPause;
-  QList<VariableExpressionParser *> rollingChannelEvaluators;
-  QList<VariableExpressionParser *> oscChannelEvaluators;
-  double rollingTimestamp = 0;
-  double oscTimestamp = 0;
-  QJSEngine rollingEngine;
-  QJSEngine oscEngine;
-
+  bool rollingRunning = false;
+  bool oscRunning = false;
+  QThread generatorThread;
+  SignalGenerator *rollingGenerator;
+  SignalGenerator *oscGenerator;
+
+  void restartRunning();
+  void updateExpressions(QTableWidget *table);
   void setExprRows(QTableWidget *table, int rows);
   void initRollingTable();
   void initOscTable();
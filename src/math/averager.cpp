@@ -14,96 +14,240 @@
 //  along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include "averager.h"
+#include "traceevents.h"
 
 Averager::Averager(QObject* parent) : QObject(parent) {
-  for (int i = 0; i < ANALOG_COUNT; i++)
+  for (int i = 0; i < ANALOG_COUNT; i++) {
     averageCount[i] = 8;
-  listsChannels.resize(ANALOG_COUNT);
-  channelsResults.resize(ANALOG_COUNT);
+    lastChannelSamplingPeriod[i] = 0;
+  }
+  frames.resize(ANALOG_COUNT);
   points.resize(ANALOG_COUNT);
 }
 
+void Averager::resetFrames(int chID) {
+  FrameState& state = frames[chID];
+  state.ring.clear();
+  state.result.clear();
+  state.frame.clear();
+  state.frameLength = 0;
+  state.writeFrame = 0;
+  state.filledFrames = 0;
+}
+
 void Averager::reset() {
   for (int i = 0; i < ANALOG_COUNT; i++) {
-    listsChannels[i].clear();
-    channelsResults[i].clear();
-    points[i].clear();
-    pointResults[i] = 0;
+    resetFrames(i);
+    points[i] = PointState();
   }
 }
 
+void Averager::setMode(AveragerMode::enumAveragerMode mode) {
+  this->mode = mode;
+  reset();
+}
+
 void Averager::setCount(int chID, int count) {
+  if (count < 1)
+    count = 1;
   this->averageCount[chID] = count;
 
-  while (listsChannels.at(chID).length() > count) {
-    for (int i = 0; i < channelsResults[chID].size(); i++) {
-      channelsResults[chID][i] -= listsChannels[chID].first().at(i);
+  // Z kruhového zásobníku se zachová nejnovějších min(filled, count) průběhů
+  FrameState& state = frames[chID];
+  if (mode == AveragerMode::mean && state.filledFrames > 0) {
+    int length = state.frameLength;
+    int oldCount = state.ring.size() / length;
+    int keep = qMin(state.filledFrames, count);
+    QVector<double> ring(count * length);
+    state.result.fill(0);
+    for (int k = 0; k < keep; k++) {
+      int oldIndex = (state.writeFrame - keep + k + oldCount) % oldCount;
+      const double* from = state.ring.constData() + oldIndex * length;
+      double* to = ring.data() + k * length;
+      double* sum = state.result.data();
+      for (int i = 0; i < length; i++) {
+        to[i] = from[i];
+        sum[i] += from[i];
+      }
     }
-    listsChannels[chID].removeFirst();
+    state.ring = ring;
+    state.filledFrames = keep;
+    state.writeFrame = keep % count;
+  } else if (mode == AveragerMode::exponential) {
+    state.filledFrames = qMin(state.filledFrames, count);
   }
 
-  while (points.at(chID).length() > count) {
-    pointResults[chID] -= points.at(chID).first().second;
-    points[chID].removeFirst();
-  }
+  // Body se jen vymažou, jde o jednotky až stovky hodnot
+  points[chID] = PointState();
 }
 
-void Averager::newDataVector(int chID, double timeStep, QSharedPointer<QCPGraphDataContainer> data) {
-  if (data->size() != channelsResults.at(chID).size() || timeStep != lastChannelSamplingPeriod[chID]) {
-    channelsResults[chID].clear();
-    listsChannels[chID].clear();
+void Averager::averageFrame(FrameState& state, int count) {
+  const int length = state.frameLength;
+  const double* in = state.frame.constData();
+  double* result = state.result.data();
+
+  // Všechny smyčky jsou jednoduché operace nad souvislými poli, kompilátor je vektorizuje
+  if (mode == AveragerMode::mean) {
+    if (state.ring.size() != count * length)
+      state.ring.resize(count * length);
+    double* slot = state.ring.data() + state.writeFrame * length;
+    if (state.filledFrames == count) {
+      // Nejstarší průběh se odečte a na jeho místo se zapíše nový
+      for (int i = 0; i < length; i++) {
+        result[i] += in[i] - slot[i];
+        slot[i] = in[i];
+      }
+    } else {
+      for (int i = 0; i < length; i++) {
+        result[i] += in[i];
+        slot[i] = in[i];
+      }
+      state.filledFrames++;
+    }
+    state.writeFrame = (state.writeFrame + 1) % count;
+    return;
   }
 
-  lastChannelSamplingPeriod[chID] = timeStep;
-
-  if (channelsResults.at(chID).isEmpty()) {
-    channelsResults[chID].resize(data->size());
+  if (state.filledFrames == 0) {
+    std::copy(in, in + length, result);
+    state.filledFrames = 1;
+    return;
   }
 
-  listsChannels[chID].append(QVector<double>());
-
-  for (auto it = data->begin(); it != data->end(); it++) {
-    listsChannels[chID].last().append(it->value);
+  if (mode == AveragerMode::exponential) {
+    // Dokud není načteno count průběhů, je to obyčejný průměr, pak exponenciální s alfa = 1/count
+    if (state.filledFrames < count)
+      state.filledFrames++;
+    const double alpha = 1.0 / state.filledFrames;
+    for (int i = 0; i < length; i++)
+      result[i] += (in[i] - result[i]) * alpha;
+  } else if (mode == AveragerMode::peakMax) {
+    for (int i = 0; i < length; i++)
+      result[i] = in[i] > result[i] ? in[i] : result[i];
+  } else if (mode == AveragerMode::peakMin) {
+    for (int i = 0; i < length; i++)
+      result[i] = in[i] < result[i] ? in[i] : result[i];
   }
+}
 
-  if (listsChannels[chID].size() == averageCount[chID] + 1) {
-    for (int i = 0; i < data->size(); i++) {
-      channelsResults[chID][i] -= listsChannels[chID].first().at(i);
+QSharedPointer<QCPGraphDataContainer> Averager::highResolutionFrame(const QSharedPointer<QCPGraphDataContainer>& data, int count) {
+  // Průměr count sousedních vzorků jednoho průběhu - menší šum za cenu nižší vzorkovací frekvence
+  int outputLength = data->size() / count;
+  if (count <= 1 || outputLength == 0)
+    return data;
+
+  QVector<QCPGraphData> output(outputLength);
+  auto it = data->constBegin();
+  for (int i = 0; i < outputLength; i++) {
+    double keySum = 0, valueSum = 0;
+    for (int k = 0; k < count; k++, it++) {
+      keySum += it->key;
+      valueSum += it->value;
     }
-    listsChannels[chID].removeFirst();
+    output[i] = QCPGraphData(keySum / count, valueSum / count);
   }
 
-  Q_ASSERT(listsChannels[chID].size() <= averageCount[chID]);
+  auto result = QSharedPointer<QCPGraphDataContainer>(new QCPGraphDataContainer);
+  result->set(output, true);
+  return result;
+}
+
+void Averager::newDataVector(int chID, double timeStep, QSharedPointer<QCPGraphDataContainer> data) {
+  TRACE_SCOPE("math", "Averager::newDataVector");
+  const int count = averageCount[chID];
 
-  for (int i = 0; i < data->size(); i++) {
-    channelsResults[chID][i] += data->at(i)->value;
+  if (mode == AveragerMode::highResolution) {
+    emit addVectorToPlot(chID, highResolutionFrame(data, count));
+    return;
   }
 
-  for (auto it = data->begin(); it != data->end(); it++) {
-    it->value = channelsResults[chID][it - data->begin()];
-    it->value /= listsChannels[chID].size();
+  FrameState& state = frames[chID];
+  if (data->size() != state.frameLength || timeStep != lastChannelSamplingPeriod[chID]) {
+    resetFrames(chID);
+    state.frameLength = data->size();
+    state.frame.resize(state.frameLength);
+    state.result.fill(0, state.frameLength);
   }
 
+  lastChannelSamplingPeriod[chID] = timeStep;
+
+  double* frame = state.frame.data();
+  for (auto it = data->constBegin(); it != data->constEnd(); it++)
+    *frame++ = it->value;
+
+  averageFrame(state, count);
+
+  const double* result = state.result.constData();
+  const double scale = (mode == AveragerMode::mean) ? 1.0 / state.filledFrames : 1.0;
+  for (auto it = data->begin(); it != data->end(); it++)
+    it->value = *result++ * scale;
+
   emit addVectorToPlot(chID, data);
 }
 
 void Averager::newDataPoint(int chID, double time, double value, bool append) {
-  if (!append) {
-    points[chID].clear();
-    pointResults[chID] = 0;
+  PointState& p = points[chID];
+  const int count = averageCount[chID];
+
+  if (!append || p.values.size() != count) {
+    bool clearPlot = !append || p.clearPlot;
+    p = PointState();
+    p.values.resize(count);
+    p.times.resize(count);
+    p.clearPlot = clearPlot;
   }
 
-  points[chID].append(QPair<double, double>(time, value));
-
-  if (points[chID].size() == averageCount[chID] + 1) {
-    pointResults[chID] -= points[chID].first().second;
-    points[chID].removeFirst();
+  if (mode == AveragerMode::highResolution) {
+    // Výstupem je jeden bod za každých count vstupních
+    p.blockSum += value;
+    p.blockTime += time;
+    p.blockCount++;
+    if (p.blockCount >= count) {
+      emit addPointToPlot(chID, p.blockTime / p.blockCount, p.blockSum / p.blockCount, !p.clearPlot);
+      p.clearPlot = false;
+      p.blockSum = 0;
+      p.blockTime = 0;
+      p.blockCount = 0;
+    }
+    return;
   }
 
-  Q_ASSERT(listsChannels[chID].size() <= averageCount[chID]);
-
-  pointResults[chID] += value;
+  // Kruhový zásobník posledních count bodů
+  double evicted = 0;
+  bool full = p.filled == count;
+  if (full)
+    evicted = p.values.at(p.write);
+  else
+    p.filled++;
+  p.values[p.write] = value;
+  p.times[p.write] = time;
+  int oldest = full ? (p.write + 1) % count : 0;
+  p.write = (p.write + 1) % count;
+
+  double midTime = (p.times.at(oldest) + time) / 2.0;
+  double output;
+
+  if (mode == AveragerMode::mean) {
+    p.sum += value - evicted;
+    output = p.sum / p.filled;
+  } else if (mode == AveragerMode::exponential) {
+    p.result = (p.filled == 1) ? value : p.result + (value - p.result) / p.filled;
+    output = p.result;
+    midTime = time;
+  } else {
+    bool isMax = mode == AveragerMode::peakMax;
+    if (p.filled == 1)
+      p.result = value;
+    else if (full && evicted == p.result) {
+      // Vypadl extrém, je třeba ho najít znovu
+      p.result = value;
+      for (int i = 0; i < count; i++)
+        p.result = isMax ? qMax(p.result, p.values.at(i)) : qMin(p.result, p.values.at(i));
+    } else
+      p.result = isMax ? qMax(p.result, value) : qMin(p.result, value);
+    output = p.result;
+  }
 
-  double midTime = (points.at(chID).first().first + points.at(chID).last().first) / 2.0;
-  emit addPointToPlot(chID, midTime, pointResults[chID] / points.at(chID).size(), append);
+  emit addPointToPlot(chID, midTime, output, !p.clearPlot);
+  p.clearPlot = false;
 }
@@ -26,16 +26,47 @@ class Averager : public QObject {
   explicit Averager(QObject* parent = nullptr);
 
  private:
-  QVector<QList<QVector<double>>> listsChannels;
-  QVector<QVector<double>> channelsResults;
+  /// Stav průměrování kanálů (režim $$C)
+  struct FrameState {
+    /// Kruhový zásobník posledních averageCount průběhů, alokovaný najednou (jen režim mean)
+    QVector<double> ring;
+    /// Průběžný součet (mean), nebo aktuální výsledek (exponential, peak)
+    QVector<double> result;
+    /// Hodnoty právě přijatého průběhu
+    QVector<double> frame;
+    int frameLength = 0;
+    int writeFrame = 0;
+    int filledFrames = 0;
+  };
+
+  /// Stav průměrování bodů (režim $$P)
+  struct PointState {
+    QVector<double> values, times;
+    int write = 0;
+    int filled = 0;
+    double sum = 0;
+    double result = 0;
+    /// Pro highResolution - součet a počet bodů v aktuálním bloku
+    double blockSum = 0, blockTime = 0;
+    int blockCount = 0;
+    /// Další odeslaný bod má v grafu nahradit stávající data (append = false)
+    bool clearPlot = false;
+  };
+
+  AveragerMode::enumAveragerMode mode = AveragerMode::mean;
   int averageCount[ANALOG_COUNT];
   double lastChannelSamplingPeriod[ANALOG_COUNT];
-  QVector<QList<QPair<double, double>>> points;
-  double pointResults[ANALOG_COUNT];
+  QVector<FrameState> frames;
+  QVector<PointState> points;
+
+  void resetFrames(int chID);
+  void averageFrame(FrameState& state, int count);
+  QSharedPointer<QCPGraphDataContainer> highResolutionFrame(const QSharedPointer<QCPGraphDataContainer>& data, int count);
 
  public slots:
   void reset();
   void setCount(int chID, int count);
+  void setMode(AveragerMode::enumAveragerMode mode);
   void newDataVector(int chID, double timeStep, QSharedPointer<QCPGraphDataContainer> data);
   void newDataPoint(int chID, double time, double value, bool append);
 
@@ -0,0 +1,251 @@
+//  Copyright (C) 2020-2024  Jiří Maier
+
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "channelfilter.h"
+#include <QtMath>
+#include <algorithm>
+#include <cmath>
+
+double ChannelFilter::Biquad::settle(double x) {
+  double y = x * (b0 + b1 + b2) / (1 + a1 + a2);
+  z2 = b2 * x - a2 * y;
+  z1 = b1 * x - a1 * y + z2;
+  return y;
+}
+
+void ChannelFilter::configure(FilterType::enumFilterType type, double frequency, double parameter) {
+  this->type = type;
+  this->frequency = frequency;
+  this->parameter = parameter;
+  designedPeriod = 0;
+  sections.clear();
+  taps.clear();
+  reset();
+}
+
+void ChannelFilter::reset() {
+  hasLastTime = false;
+  settled = false;
+  smoothedPeriod = 0;
+  history.fill(0);
+  historyWrite = 0;
+  window.clear();
+  sorted.clear();
+  windowWrite = 0;
+}
+
+void ChannelFilter::design(double samplingPeriod) {
+  switch (type) {
+    case FilterType::lowPass: designButterworth(samplingPeriod, false); break;
+    case FilterType::highPass: designButterworth(samplingPeriod, true); break;
+    case FilterType::bandPass: designResonator(samplingPeriod, false); break;
+    case FilterType::notch: designResonator(samplingPeriod, true); break;
+    case FilterType::firLowPass: designFir(samplingPeriod); break;
+    case FilterType::median:
+    case FilterType::none: break;
+  }
+  designedPeriod = samplingPeriod;
+  settled = false;
+}
+
+void ChannelFilter::designButterworth(double samplingPeriod, bool highPass) {
+  // Kaskáda biquadů (RBJ), řád se zaokrouhlí nahoru na sudý
+  int count = qBound(1, (qRound(parameter) + 1) / 2, 4);
+  double f = qBound(1e-6 / samplingPeriod, frequency, 0.49 / samplingPeriod);
+  double w0 = 2 * M_PI * f * samplingPeriod;
+  double cosW = qCos(w0);
+  sections.resize(count);
+  for (int k = 0; k < count; k++) {
+    double q = 1.0 / (2.0 * qCos(M_PI * (2 * k + 1) / (4.0 * count)));
+    double alpha = qSin(w0) / (2 * q);
+    double a0 = 1 + alpha;
+    Biquad& s = sections[k];
+    if (highPass) {
+      s.b0 = (1 + cosW) / 2 / a0;
+      s.b1 = -(1 + cosW) / a0;
+    } else {
+      s.b0 = (1 - cosW) / 2 / a0;
+      s.b1 = (1 - cosW) / a0;
+    }
+    s.b2 = s.b0;
+    s.a1 = -2 * cosW / a0;
+    s.a2 = (1 - alpha) / a0;
+  }
+}
+
+void ChannelFilter::designResonator(double samplingPeriod, bool notch) {
+  double q = qMax(parameter, 0.1);
+  double f = qBound(1e-6 / samplingPeriod, frequency, 0.49 / samplingPeriod);
+  double w0 = 2 * M_PI * f * samplingPeriod;
+  double cosW = qCos(w0);
+  double alpha = qSin(w0) / (2 * q);
+  double a0 = 1 + alpha;
+  sections.resize(1);
+  Biquad& s = sections[0];
+  if (notch) {
+    s.b0 = 1 / a0;
+    s.b1 = -2 * cosW / a0;
+    s.b2 = 1 / a0;
+  } else {
+    s.b0 = alpha / a0;
+    s.b1 = 0;
+    s.b2 = -alpha / a0;
+  }
+  s.a1 = -2 * cosW / a0;
+  s.a2 = (1 - alpha) / a0;
+}
+
+void ChannelFilter::designFir(double samplingPeriod) {
+  // Okénkovaný sinc (Blackman), lichý počet koeficientů, zesílení 1 pro DC
+  int n = qBound(3, qRound(parameter), 1023) | 1;
+  double fc = qBound(1e-6, frequency * samplingPeriod, 0.49);
+  taps.resize(n);
+  double sum = 0;
+  for (int k = 0; k < n; k++) {
+    double m = k - (n - 1) / 2;
+    double sinc = (m == 0) ? 2 * fc : qSin(2 * M_PI * fc * m) / (M_PI * m);
+    double blackman = 0.42 - 0.5 * qCos(2 * M_PI * k / (n - 1)) + 0.08 * qCos(4 * M_PI * k / (n - 1));
+    taps[k] = sinc * blackman;
+    sum += taps[k];
+  }
+  for (int k = 0; k < n; k++)
+    taps[k] /= sum;
+  history.resize(2 * n);
+  history.fill(0);
+  historyWrite = 0;
+}
+
+int ChannelFilter::medianLength() const { return qBound(1, qRound(parameter), 1001) | 1; }
+
+namespace {
+/// Úplné uspořádání s NaN na konci, jinak by se NaN v okně nedal najít a odebrat
+inline bool medianLess(double a, double b) { return a < b || (std::isnan(b) && !std::isnan(a)); }
+} // namespace
+
+double ChannelFilter::medianPush(double value, int length) {
+  if (window.size() >= length) {
+    double oldest = window.at(windowWrite);
+    sorted.erase(std::lower_bound(sorted.begin(), sorted.end(), oldest, medianLess));
+    window[windowWrite] = value;
+    windowWrite = (windowWrite + 1) % length;
+  } else {
+    window.append(value);
+  }
+  sorted.insert(std::upper_bound(sorted.begin(), sorted.end(), value, medianLess), value);
+  return sorted.at(sorted.size() / 2);
+}
+
+void ChannelFilter::processFrame(double samplingPeriod, QCPGraphData* data, int count) {
+  if (type == FilterType::none || count == 0 || !(samplingPeriod > 0))
+    return;
+  if (type != FilterType::median && samplingPeriod != designedPeriod)
+    design(samplingPeriod);
+  reset();
+
+  values.resize(count);
+  for (int i = 0; i < count; i++)
+    values[i] = data[i].value;
+  double* v = values.data();
+
+  if (type == FilterType::firLowPass || type == FilterType::median) {
+    // Okraje se doplní krajní hodnotou, aby byl výstup centrovaný a stejně dlouhý
+    int n = (type == FilterType::median) ? medianLength() : taps.size();
+    int half = n / 2;
+    padded.resize(count + n - 1);
+    double* p = padded.data();
+    for (int i = 0; i < count + n - 1; i++)
+      p[i] = v[qBound(0, i - half, count - 1)];
+
+    if (type == FilterType::firLowPass) {
+      // Po koeficientech přes celý průběh - vnitřní smyčka je souvislá a bez závislostí, překladač ji vektorizuje
+      std::fill(v, v + count, 0.0);
+      for (int k = 0; k < n; k++) {
+        const double h = taps.at(k);
+        const double* src = p + k;
+        for (int i = 0; i < count; i++)
+          v[i] += h * src[i];
+      }
+    } else {
+      for (int i = 0; i < n - 1; i++)
+        medianPush(p[i], n);
+      for (int i = 0; i < count; i++)
+        v[i] = medianPush(p[i + n - 1], n);
+      reset();
+    }
+  } else {
+    // IIR po sekcích, každá projde celý průběh
+    for (int k = 0; k < sections.size(); k++) {
+      Biquad s = sections.at(k);
+      s.settle(v[0]);
+      for (int i = 0; i < count; i++)
+        v[i] = s.process(v[i]);
+    }
+  }
+
+  for (int i = 0; i < count; i++)
+    data[i].value = v[i];
+}
+
+double ChannelFilter::processPoint(double time, double value) {
+  if (type == FilterType::none)
+    return value;
+
+  if (hasLastTime) {
+    double delta = time - lastTime;
+    if (delta <= 0)
+      reset(); // Čas se vrátil, jde o nové měření
+    else
+      smoothedPeriod = (smoothedPeriod == 0) ? delta : (0.9 * smoothedPeriod + 0.1 * delta);
+  }
+  hasLastTime = true;
+  lastTime = time;
+
+  if (type == FilterType::median)
+    return medianPush(value, medianLength());
+
+  // Dokud není známa perioda, nelze navrhnout filtr
+  if (smoothedPeriod == 0)
+    return value;
+  if (designedPeriod == 0 || qAbs(smoothedPeriod - designedPeriod) > 0.1 * designedPeriod)
+    design(smoothedPeriod);
+
+  if (type == FilterType::firLowPass) {
+    int n = taps.size();
+    if (!settled) {
+      history.fill(value);
+      settled = true;
+    }
+    history[historyWrite] = value;
+    history[historyWrite + n] = value;
+    historyWrite = (historyWrite + 1) % n;
+    const double* h = taps.constData();
+    const double* x = history.constData() + historyWrite;
+    double sum = 0;
+    for (int k = 0; k < n; k++)
+      sum += h[k] * x[k];
+    return sum;
+  }
+
+  if (!settled) {
+    double x = value;
+    for (int k = 0; k < sections.size(); k++)
+      x = sections[k].settle(x);
+    settled = true;
+  }
+  double y = value;
+  for (int k = 0; k < sections.size(); k++)
+    y = sections[k].process(y);
+  return y;
+}
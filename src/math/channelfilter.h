@@ -0,0 +1,89 @@
+//  Copyright (C) 2020-2024  Jiří Maier
+
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef CHANNELFILTER_H
+#define CHANNELFILTER_H
+
+#include <QVector>
+#include "plots/qcustomplot.h"
+#include "utils.h"
+
+/// Filtr jednoho analogového kanálu, používá ho PlotData ještě před odesláním dat dál (graf, math, průměrování...)
+/// Body ($$P) se filtrují průběžně se zachováním stavu mezi body, kanály ($$C) se filtrují celé najednou.
+class ChannelFilter {
+public:
+  /// Typ filtru, mezní / střední frekvence v Hz a parametr:
+  /// řád (dolní a horní propust), jakost Q (pásmová propust a zádrž), počet koeficientů (FIR), délka okna (medián)
+  void configure(FilterType::enumFilterType type, double frequency, double parameter);
+  bool isEnabled() const { return type != FilterType::none; }
+
+  /// Smaže stav filtru (další bod začne bez historie)
+  void reset();
+
+  /// Vyfiltruje celý průběh na místě, stav se nepřenáší z předchozího průběhu.
+  /// IIR začne v ustáleném stavu z prvního vzorku, FIR a medián jsou centrované (bez zpoždění).
+  void processFrame(double samplingPeriod, QCPGraphData *data, int count);
+
+  /// Vyfiltruje jeden bod, perioda vzorkování se odhaduje z časů bodů
+  double processPoint(double time, double value);
+
+private:
+  /// Jedna sekce IIR (biquad), transponovaná přímá forma II
+  struct Biquad {
+    double b0 = 1, b1 = 0, b2 = 0, a1 = 0, a2 = 0;
+    double z1 = 0, z2 = 0;
+    inline double process(double x) {
+      double y = b0 * x + z1;
+      z1 = b1 * x - a1 * y + z2;
+      z2 = b2 * x - a2 * y;
+      return y;
+    }
+    /// Nastaví stav, jako by na vstupu byla dlouho konstanta x, vrací výstup
+    double settle(double x);
+  };
+
+  FilterType::enumFilterType type = FilterType::none;
+  double frequency = 0;
+  double parameter = 0;
+
+  /// Perioda, pro kterou jsou spočítané koeficienty (0 = zatím nespočítané)
+  double designedPeriod = 0;
+  QVector<Biquad> sections;
+  QVector<double> taps;
+
+  /// Stav pro body
+  double lastTime = 0;
+  double smoothedPeriod = 0;
+  bool hasLastTime = false;
+  bool settled = false;
+  /// Historie FIR, uložená dvakrát za sebou, aby bylo okno vždy souvislé
+  QVector<double> history;
+  int historyWrite = 0;
+  /// Okno mediánu (v pořadí příchodu) a totéž seřazené
+  QVector<double> window, sorted;
+  int windowWrite = 0;
+
+  /// Pracovní buffery pro průběhy (nepřealokovávají se)
+  QVector<double> values, padded;
+
+  void design(double samplingPeriod);
+  void designButterworth(double samplingPeriod, bool highPass);
+  void designResonator(double samplingPeriod, bool notch);
+  void designFir(double samplingPeriod);
+  int medianLength() const;
+  double medianPush(double value, int length);
+};
+
+#endif // CHANNELFILTER_H
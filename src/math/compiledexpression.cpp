@@ -0,0 +1,452 @@
+//  Copyright (C) 2020-2024  Jiří Maier
+
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "compiledexpression.h"
+#include "math/expressionparser.h"
+
+namespace {
+inline double fnNeg(double a) { return -a; }
+inline double fnAbs(double a) { return std::fabs(a); }
+inline double fnSqrt(double a) { return std::sqrt(a); }
+inline double fnCbrt(double a) { return std::cbrt(a); }
+inline double fnExp(double a) { return std::exp(a); }
+inline double fnLog(double a) { return std::log(a); }
+inline double fnLog2(double a) { return std::log2(a); }
+inline double fnLog10(double a) { return std::log10(a); }
+inline double fnSin(double a) { return std::sin(a); }
+inline double fnCos(double a) { return std::cos(a); }
+inline double fnTan(double a) { return std::tan(a); }
+inline double fnAsin(double a) { return std::asin(a); }
+inline double fnAcos(double a) { return std::acos(a); }
+inline double fnAtan(double a) { return std::atan(a); }
+inline double fnSinh(double a) { return std::sinh(a); }
+inline double fnCosh(double a) { return std::cosh(a); }
+inline double fnTanh(double a) { return std::tanh(a); }
+inline double fnCeil(double a) { return std::ceil(a); }
+inline double fnFloor(double a) { return std::floor(a); }
+inline double fnRound(double a) { return std::floor(a + 0.5); } // Jako Math.round
+inline double fnAdd(double a, double b) { return a + b; }
+inline double fnSubtract(double a, double b) { return a - b; }
+inline double fnMultiply(double a, double b) { return a * b; }
+inline double fnDivide(double a, double b) { return a / b; }
+inline double fnPower(double a, double b) { return std::pow(a, b); }
+inline double fnAtan2(double a, double b) { return std::atan2(a, b); }
+inline double fnMinimum(double a, double b) { return b < a ? b : a; }
+inline double fnMaximum(double a, double b) { return b > a ? b : a; }
+
+template <double (*F)(double)> void unaryLoop(double *a, int count) {
+  for (int i = 0; i < count; i++)
+    a[i] = F(a[i]);
+}
+
+template <double (*F)(double, double)> void binaryLoop(double *a, const double *b, double constant, bool constOperand, int count) {
+  if (constOperand) {
+    for (int i = 0; i < count; i++)
+      a[i] = F(a[i], constant);
+  } else {
+    for (int i = 0; i < count; i++)
+      a[i] = F(a[i], b[i]);
+  }
+}
+} // namespace
+
+CompiledExpression::CompiledExpression() {
+  functions = {{"abs", {opAbs, 1}},   {"acos", {opAcos, 1}}, {"asin", {opAsin, 1}},   {"atan", {opAtan, 1}},   {"atan2", {opAtan2, 2}}, {"cbrt", {opCbrt, 1}},
+               {"ceil", {opCeil, 1}}, {"cos", {opCos, 1}},   {"cosh", {opCosh, 1}},   {"exp", {opExp, 1}},     {"floor", {opFloor, 1}}, {"log", {opLog, 1}},
+               {"log2", {opLog2, 1}}, {"log10", {opLog10, 1}}, {"max", {opMaximum, 2}}, {"min", {opMinimum, 2}}, {"pow", {opPower, 2}},  {"random", {opRandom, 0}}, {"round", {opRound, 1}},
+               {"sin", {opSin, 1}},   {"sinh", {opSinh, 1}}, {"sqrt", {opSqrt, 1}},   {"tan", {opTan, 1}},     {"tanh", {opTanh, 1}}};
+}
+
+int CompiledExpression::arity(OpCode op) {
+  switch (op) {
+    case opPushConst:
+    case opPushChannel:
+    case opPushTime:
+    case opPushVariable:
+    case opRandom:
+      return 0;
+    case opAdd:
+    case opSubtract:
+    case opMultiply:
+    case opDivide:
+    case opPower:
+    case opAtan2:
+    case opMinimum:
+    case opMaximum:
+      return 2;
+    default:
+      return 1;
+  }
+}
+
+void CompiledExpression::execute(const Instruction &instruction, double *a, const double *b, int count) {
+  double c = instruction.value;
+  bool k = instruction.constOperand;
+  switch (instruction.op) {
+    case opNeg: unaryLoop<fnNeg>(a, count); break;
+    case opAbs: unaryLoop<fnAbs>(a, count); break;
+    case opSqrt: unaryLoop<fnSqrt>(a, count); break;
+    case opCbrt: unaryLoop<fnCbrt>(a, count); break;
+    case opExp: unaryLoop<fnExp>(a, count); break;
+    case opLog: unaryLoop<fnLog>(a, count); break;
+    case opLog2: unaryLoop<fnLog2>(a, count); break;
+    case opLog10: unaryLoop<fnLog10>(a, count); break;
+    case opSin: unaryLoop<fnSin>(a, count); break;
+    case opCos: unaryLoop<fnCos>(a, count); break;
+    case opTan: unaryLoop<fnTan>(a, count); break;
+    case opAsin: unaryLoop<fnAsin>(a, count); break;
+    case opAcos: unaryLoop<fnAcos>(a, count); break;
+    case opAtan: unaryLoop<fnAtan>(a, count); break;
+    case opSinh: unaryLoop<fnSinh>(a, count); break;
+    case opCosh: unaryLoop<fnCosh>(a, count); break;
+    case opTanh: unaryLoop<fnTanh>(a, count); break;
+    case opCeil: unaryLoop<fnCeil>(a, count); break;
+    case opFloor: unaryLoop<fnFloor>(a, count); break;
+    case opRound: unaryLoop<fnRound>(a, count); break;
+    case opAdd: binaryLoop<fnAdd>(a, b, c, k, count); break;
+    case opSubtract: binaryLoop<fnSubtract>(a, b, c, k, count); break;
+    case opMultiply: binaryLoop<fnMultiply>(a, b, c, k, count); break;
+    case opDivide: binaryLoop<fnDivide>(a, b, c, k, count); break;
+    case opPower: binaryLoop<fnPower>(a, b, c, k, count); break;
+    case opAtan2: binaryLoop<fnAtan2>(a, b, c, k, count); break;
+    case opMinimum: binaryLoop<fnMinimum>(a, b, c, k, count); break;
+    case opMaximum: binaryLoop<fnMaximum>(a, b, c, k, count); break;
+    default: break;
+  }
+}
+
+void CompiledExpression::evaluate(const QVector<const QCPGraphData *> &channels, const QCPGraphData *keys, int count, QCPGraphData *out) {
+  if (code.isEmpty())
+    return;
+  stack.resize(maxDepth * blockSize);
+
+  // Po blocích, aby mezivýsledky zůstaly v cache
+  for (int start = 0; start < count; start += blockSize) {
+    int length = qMin(blockSize, count - start);
+    int sp = 0;
+    for (const Instruction &instruction : code) {
+      double *top = stack.data() + sp * blockSize;
+      if (instruction.op == opPushConst) {
+        std::fill(top, top + length, instruction.value);
+        sp++;
+      } else if (instruction.op == opPushChannel) {
+        const QCPGraphData *source = channels.at(instruction.channel) + start;
+        for (int i = 0; i < length; i++)
+          top[i] = source[i].value;
+        sp++;
+      } else if (instruction.op == opPushTime) {
+        const QCPGraphData *source = keys + start;
+        for (int i = 0; i < length; i++)
+          top[i] = source[i].key;
+        sp++;
+      } else if (instruction.op == opPushVariable) {
+        std::fill(top, top + length, variableValues.at(instruction.channel));
+        sp++;
+      } else if (instruction.op == opRandom) {
+        // xorshift64*, rovnoměrně v <0, 1) jako Math.random
+        for (int i = 0; i < length; i++) {
+          randomState ^= randomState >> 12;
+          randomState ^= randomState << 25;
+          randomState ^= randomState >> 27;
+          top[i] = ((randomState * 0x2545F4914F6CDD1Dull) >> 11) * (1.0 / 9007199254740992.0);
+        }
+        sp++;
+      } else if (arity(instruction.op) == 2 && !instruction.constOperand) {
+        execute(instruction, top - 2 * blockSize, top - blockSize, length);
+        sp--;
+      } else {
+        execute(instruction, top - blockSize, nullptr, length);
+      }
+    }
+    const double *result = stack.constData();
+    for (int i = 0; i < length; i++) {
+      out[start + i].key = keys[start + i].key;
+      out[start + i].value = result[i];
+    }
+  }
+}
+
+int CompiledExpression::addVariable(const QString &name) {
+  variableNames.append(name);
+  variableValues.append(0);
+  return variableNames.size() - 1;
+}
+
+bool CompiledExpression::setExpression(QString expr) {
+  // Komentář jako v JavaScriptu
+  int comment = expr.indexOf("//");
+  if (comment >= 0)
+    expr.truncate(comment);
+
+  code.clear();
+  channelMask = 0;
+  maxDepth = 0;
+  depth = 0;
+  argumentDepth = 0;
+  error.clear();
+  source = expr.replace(QString::fromUtf8("\xc2\xb5"), "u"); // mu
+  pos = 0;
+
+  skipSpaces();
+  if (pos >= source.length())
+    return fail(tr("Empty expression"));
+  if (!parseSum())
+    return false;
+  skipSpaces();
+  if (pos < source.length())
+    return fail(tr("Unexpected \"%1\"").arg(source.at(pos)));
+  return true;
+}
+
+void CompiledExpression::emitConst(double value) {
+  Instruction instruction;
+  instruction.op = opPushConst;
+  instruction.value = value;
+  code.append(instruction);
+  depth++;
+  maxDepth = qMax(maxDepth, depth);
+}
+
+void CompiledExpression::emitLoad(OpCode op, int channel) {
+  Instruction instruction;
+  instruction.op = op;
+  instruction.channel = channel;
+  code.append(instruction);
+  depth++;
+  maxDepth = qMax(maxDepth, depth);
+}
+
+void CompiledExpression::emitOp(OpCode op) {
+  Instruction instruction;
+  instruction.op = op;
+  int size = code.size();
+  if (arity(op) == 1) {
+    // Konstanta se spočítá hned
+    if (code.last().op == opPushConst)
+      execute(instruction, &code.last().value, nullptr, 1);
+    else
+      code.append(instruction);
+    return;
+  }
+
+  depth--;
+  if (code.at(size - 1).op == opPushConst && size >= 2 && code.at(size - 2).op == opPushConst) {
+    execute(instruction, &code[size - 2].value, &code[size - 1].value, 1);
+    code.removeLast();
+    return;
+  }
+  // Konstantní pravý operand se nedává na zásobník
+  if (code.at(size - 1).op == opPushConst) {
+    instruction.constOperand = true;
+    instruction.value = code.last().value;
+    code.removeLast();
+  }
+  code.append(instruction);
+}
+
+void CompiledExpression::skipSpaces() {
+  while (pos < source.length() && source.at(pos).isSpace())
+    pos++;
+}
+
+bool CompiledExpression::accept(QChar c) {
+  skipSpaces();
+  if (pos < source.length() && source.at(pos) == c) {
+    pos++;
+    return true;
+  }
+  return false;
+}
+
+bool CompiledExpression::fail(const QString &message) {
+  error = tr("%1 (position %2)").arg(message).arg(pos + 1);
+  code.clear();
+  channelMask = 0;
+  return false;
+}
+
+bool CompiledExpression::parseSum() {
+  if (!parseProduct())
+    return false;
+  forever {
+    if (accept('+')) {
+      if (!parseProduct())
+        return false;
+      emitOp(opAdd);
+    } else if (accept('-')) {
+      if (!parseProduct())
+        return false;
+      emitOp(opSubtract);
+    } else
+      return true;
+  }
+}
+
+bool CompiledExpression::parseProduct() {
+  if (!parseUnary())
+    return false;
+  forever {
+    if (accept('*')) {
+      if (!parseUnary())
+        return false;
+      emitOp(opMultiply);
+    } else if (accept('/')) {
+      if (!parseUnary())
+        return false;
+      emitOp(opDivide);
+    } else
+      return true;
+  }
+}
+
+bool CompiledExpression::parseUnary() {
+  if (accept('-')) {
+    if (!parseUnary())
+      return false;
+    emitOp(opNeg);
+    return true;
+  }
+  if (accept('+'))
+    return parseUnary();
+  return parsePower();
+}
+
+bool CompiledExpression::parsePower() {
+  if (!parsePrimary())
+    return false;
+  skipSpaces();
+  // Mocnina jako ^ i jako ** (JavaScript), pravě asociativní
+  bool isPower = accept('^');
+  if (!isPower && source.mid(pos, 2) == "**") {
+    pos += 2;
+    isPower = true;
+  }
+  if (!isPower)
+    return true;
+  if (!parseUnary())
+    return false;
+  emitOp(opPower);
+  return true;
+}
+
+bool CompiledExpression::parsePrimary() {
+  skipSpaces();
+  if (pos >= source.length())
+    return fail(tr("Unexpected end of expression"));
+  QChar c = source.at(pos);
+  if (accept('(')) {
+    if (!parseSum())
+      return false;
+    if (!accept(')'))
+      return fail(tr("Missing \")\""));
+    return true;
+  }
+  if (c.isDigit() || c == '.')
+    return parseNumber();
+  if (c.isLetter() || c == '_')
+    return parseIdentifier();
+  return fail(tr("Unexpected \"%1\"").arg(c));
+}
+
+bool CompiledExpression::parseNumber() {
+  int start = pos;
+  while (pos < source.length() && (source.at(pos).isDigit() || source.at(pos) == '.'))
+    pos++;
+  // Desetinná čárka stejně jako v ExpressionParser, v argumentech funkce ale čárka argumenty odděluje
+  if (argumentDepth == 0 && ExpressionParser::decimalSeparatorRegex.match(source, pos).capturedStart() == pos) {
+    pos++;
+    while (pos < source.length() && source.at(pos).isDigit())
+      pos++;
+  }
+  // Exponent, samotné E za číslem je předpona exa
+  if (pos + 1 < source.length() && (source.at(pos) == 'e' || source.at(pos) == 'E')) {
+    int exponent = pos + 1;
+    if (source.at(exponent) == '+' || source.at(exponent) == '-')
+      exponent++;
+    if (exponent < source.length() && source.at(exponent).isDigit()) {
+      pos = exponent;
+      while (pos < source.length() && source.at(pos).isDigit())
+        pos++;
+    }
+  }
+  bool isok;
+  double value = source.mid(start, pos - start).replace(',', '.').toDouble(&isok);
+  if (!isok)
+    return fail(tr("Invalid number \"%1\"").arg(source.mid(start, pos - start)));
+
+  // SI předpona (1k, 10 m), nesmí být začátkem dalšího názvu
+  int afterNumber = pos;
+  skipSpaces();
+  if (pos < source.length() && ExpressionParser::prefixes.contains(QString(source.at(pos))) && (pos + 1 >= source.length() || !(source.at(pos + 1).isLetterOrNumber() || source.at(pos + 1) == '_'))) {
+    value *= ExpressionParser::prefixes.value(QString(source.at(pos))).toDouble();
+    pos++;
+  } else
+    pos = afterNumber;
+
+  emitConst(value);
+  return true;
+}
+
+bool CompiledExpression::parseIdentifier() {
+  int start = pos;
+  while (pos < source.length() && (source.at(pos).isLetterOrNumber() || source.at(pos) == '_'))
+    pos++;
+  QString name = source.mid(start, pos - start);
+
+  if (name == "t") {
+    emitLoad(opPushTime);
+    return true;
+  }
+  if (name.toLower() == "pi") {
+    emitConst(M_PI);
+    return true;
+  }
+  if (variableNames.contains(name)) {
+    emitLoad(opPushVariable, variableNames.indexOf(name));
+    return true;
+  }
+  if (name.startsWith("ch") && name.length() > 2) {
+    bool isok;
+    int ch = name.mid(2).toInt(&isok);
+    if (isok) {
+      if (ch < 1 || ch > ANALOG_COUNT)
+        return fail(tr("Channel %1 does not exist").arg(ch));
+      emitLoad(opPushChannel, ch - 1);
+      channelMask |= 1u << (ch - 1);
+      return true;
+    }
+  }
+  if (!functions.contains(name))
+    return fail(tr("Unknown name \"%1\"").arg(name));
+
+  QPair<OpCode, int> function = functions.value(name);
+  if (!accept('('))
+    return fail(tr("Expected \"(\" after %1").arg(name));
+  argumentDepth++;
+  for (int argument = 0; argument < function.second; argument++) {
+    if (argument > 0 && !accept(','))
+      return fail(tr("%1 expects %2 arguments").arg(name).arg(function.second));
+    if (!parseSum())
+      return false;
+  }
+  argumentDepth--;
+  if (!accept(')'))
+    return fail(tr("Missing \")\" after arguments of %1").arg(name));
+  if (function.second == 0)
+    emitLoad(function.first);
+  else
+    emitOp(function.first);
+  return true;
+}
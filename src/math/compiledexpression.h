@@ -0,0 +1,92 @@
+//  Copyright (C) 2020-2024  Jiří Maier
+
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef COMPILEDEXPRESSION_H
+#define COMPILEDEXPRESSION_H
+
+#include "global.h"
+#include "plots/qcustomplot.h"
+#include <QCoreApplication>
+
+/// Vzorec nad kanály (např. "sqrt(ch1^2+ch2^2)*1k") přeložený do zásobníkového bytekódu.
+/// Syntaxe odpovídá ExpressionParser (SI předpony, názvy funkcí z Math), ale výpočet
+/// neběží přes QJSEngine - každá instrukce se provede nad celým blokem vzorků.
+/// Není to QObject, takže se dá držet hodnotou (pole v PlotMath) a levně vytvářet.
+class CompiledExpression {
+  Q_DECLARE_TR_FUNCTIONS(CompiledExpression)
+public:
+  CompiledExpression();
+
+  /// Přeloží vzorec, při chybě vrátí false a popis je v getError()
+  bool setExpression(QString expr);
+  QString getError() const { return error; }
+  bool isValid() const { return !code.isEmpty(); }
+
+  /// Bit n je nastaven, pokud vzorec používá kanál n+1
+  quint32 getChannelMask() const { return channelMask; }
+
+  /// Další pojmenovaná proměnná (musí být přidána před setExpression), vrací její index
+  int addVariable(const QString &name);
+  void setVariable(int index, double value) { variableValues[index] = value; }
+
+  /// Spočítá vzorec pro count vzorků, channels je indexováno číslem analogového kanálu (od 0),
+  /// časová osa výsledku i proměnná t se berou z keys
+  void evaluate(const QVector<const QCPGraphData *> &channels, const QCPGraphData *keys, int count, QCPGraphData *out);
+
+private:
+  enum OpCode { opPushConst, opPushChannel, opPushTime, opPushVariable, opRandom, opNeg, opAdd, opSubtract, opMultiply, opDivide, opPower, opAtan2, opMinimum, opMaximum, opAbs, opSqrt, opCbrt, opExp, opLog, opLog2, opLog10, opSin, opCos, opTan, opAsin, opAcos, opAtan, opSinh, opCosh, opTanh, opCeil, opFloor, opRound };
+  struct Instruction {
+    OpCode op;
+    int channel = 0;
+    double value = 0;
+    bool constOperand = false; ///< Pravý operand není na zásobníku, ale ve value
+  };
+  static const int blockSize = 256;
+
+  QVector<Instruction> code;
+  QVector<double> stack;
+  int maxDepth = 0;
+  quint32 channelMask = 0;
+  QString error;
+  QStringList variableNames;
+  QVector<double> variableValues;
+  quint64 randomState = 0x9E3779B97F4A7C15ull;
+
+  // Stav překladu
+  QString source;
+  int pos = 0;
+  int depth = 0;
+  int argumentDepth = 0; ///< Uvnitř argumentů funkce je čárka oddělovač, ne desetinná čárka
+  QMap<QString, QPair<OpCode, int>> functions;
+
+  static int arity(OpCode op);
+  static void execute(const Instruction &instruction, double *a, const double *b, int count);
+  void emitConst(double value);
+  void emitLoad(OpCode op, int channel = 0);
+  void emitOp(OpCode op);
+
+  void skipSpaces();
+  bool accept(QChar c);
+  bool fail(const QString &message);
+  bool parseSum();
+  bool parseProduct();
+  bool parseUnary();
+  bool parsePower();
+  bool parsePrimary();
+  bool parseNumber();
+  bool parseIdentifier();
+};
+
+#endif // COMPILEDEXPRESSION_H
@@ -16,6 +16,10 @@
 #include "expressionparser.h"
 #include "qdebug.h"
 
+const QMap<QString, QString> ExpressionParser::prefixes{{"E", "1e18"}, {"P", "1e15"}, {"T", "1e12"}, {"G", "1e9"}, {"M", "1e6"}, {"k", "1e3"}, {"m", "1e-3"}, {"u", "1e-6"}, {"n", "1e-9"}, {"p", "1e-12"}, {"f", "1e-15"}, {"a", "1e-18"}};
+
+const QRegularExpression ExpressionParser::decimalSeparatorRegex("(?<=\\d),(?=\\d)");
+
 ExpressionParser::ExpressionParser(QObject *parent) : QObject{parent} {
   siPrefixes.setPattern("(\\d+\\.?\\d*)\\s*([TMkmGun]?)");
   jsFunctions.setPattern("(\\b(acos|asin|atan2|atan|cbrt|ceil|cos|cosh|exp|floor|log10|log2|log|max|min|pow|random|round|sin|sinh|sqrt|tan|tanh|PI)\\b)");
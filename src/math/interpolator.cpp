@@ -14,19 +14,20 @@
 //  along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include "interpolator.h"
+#include "math/taskpool.h"
+#include "traceevents.h"
 
 Interpolator::Interpolator(QObject* parent) : QObject(parent) {
 
 }
 
 void Interpolator::interpolate(int chID, const QSharedPointer<QCPGraphDataContainer> data, QCPRange visibleRange, bool dataIsFromInterpolationBuffer) {
+  TRACE_SCOPE("analysis", "Interpolator::interpolate");
   int M = lowPassFIR.size() - 1;
 
   double fs = (data->size() - 1) / (data->at(data->size() - 1)->key - data->at(0)->key);
   double resultSamplingPeriod = 1.0 / upsampling / fs;
 
-  QVector<float> values;
-
   auto dataBegin = data->constBegin(); // Při volání této funkce se změní adresy v data!!!
   auto dataEnd = data->constEnd();
 
@@ -41,31 +42,67 @@ void Interpolator::interpolate(int chID, const QSharedPointer<QCPGraphDataContai
   if (end > dataEnd)
     end = dataEnd;
 
-  for (auto it = begin; it != end; it++) {
-    values.append(it->value);
-    for (int i = 1; i < upsampling; i++)
-      values.append(0);
-  }
+  int inputLength = end - begin;
 
-  if (values.length() < lowPassFIR.size()) {
+  if (inputLength * upsampling < lowPassFIR.size() || tapsPerPhase == 0) {
     // Moc málo vzorků, nemá to cenu
     auto result = QSharedPointer<QCPGraphDataContainer>(new QCPGraphDataContainer(*data));
     emit interpolationResult(chID, data, result, dataIsFromInterpolationBuffer);
     return;
   }
 
-  if (values.length() > 2000 * upsampling) {
+  if (inputLength > INTERPOLATION_MAX_SAMPLES) {
     // Hodně vzorků, nemá cenu interpolovat
     auto result = QSharedPointer<QCPGraphDataContainer>(new QCPGraphDataContainer(*data));
     emit interpolationResult(chID, data, result, dataIsFromInterpolationBuffer);
     return;
   }
 
-  values = filter(values, lowPassFIR);
+  // Polyfázová interpolace: místo filtrování signálu proloženého nulami se pro každý vstupní vzorek q spočítá všech
+  // upsampling výstupů najednou, y[q*U + r] = sum_i x[q - i] * h[i*U + r]. Násobení nulami se tak vůbec neprovádí.
+  // Vnitřní smyčka přes fáze r pracuje s nezávislými akumulátory a sousedními koeficienty, kompilátor ji vektorizuje.
+  const int U = upsampling;
+  const int P = tapsPerPhase;
+  const int taps = lowPassFIR.size();
+
+  // Vstup s P-1 nulami na začátku, aby x[q - i] nebylo mimo rozsah
+  QVector<float> x(P - 1 + inputLength, 0);
+  for (int i = 0; i < inputLength; i++)
+    x[P - 1 + i] = (begin + i)->value;
+
+  // Stejně jako při přímé konvoluci je vynecháno prvních a posledních M/2 výstupů (přechodné jevy)
+  const int firstN = taps - 1;
+  const int outputLength = inputLength * U - firstN;
+  QVector<QCPGraphData> output(outputLength);
+  QCPGraphData* out = output.data();
+  const float* h = polyphaseTaps.constData();
+
+  // Výstupy pro různé vstupní vzorky jsou nezávislé, dlouhý průběh se rozdělí na bloky a počítá na všech jádrech
+  const int firstQ = firstN / U;
+  TaskPool::parallelFor(inputLength - firstQ, qMax(256, 65536 / (P * U)), [&](int from, int to) {
+    QVector<float> accumulators(U);
+    float* acc = accumulators.data();
+    for (int q = firstQ + from; q < firstQ + to; q++) {
+      std::fill(acc, acc + U, 0.0f);
+      const float* xq = x.constData() + q + P - 1; // xq[-i] = x[q - i]
+      for (int i = 0; i < P; i++) {
+        const float xv = xq[-i];
+        const float* hi = h + i * U;
+        for (int r = 0; r < U; r++)
+          acc[r] += xv * hi[r];
+      }
+      for (int r = 0; r < U; r++) {
+        int j = q * U + r - firstN;
+        if (j < 0)
+          continue;
+        out[j].key = (begin + (j + M / 2) / U)->key + ((j + M / 2) % U) * resultSamplingPeriod;
+        out[j].value = acc[r] * U;
+      }
+    }
+  });
 
   auto result = QSharedPointer<QCPGraphDataContainer>(new QCPGraphDataContainer);
-  for (int i = 0; i < values.size(); i++)
-    result->add(QCPGraphData((begin + (i + M / 2) / upsampling)->key + ((i + M / 2) % upsampling)*resultSamplingPeriod, values.at(i)*upsampling));
+  result->set(output, true);
 
   emit interpolationResult(chID, data, result, dataIsFromInterpolationBuffer);
   emit finished(chID);
@@ -90,23 +127,11 @@ void Interpolator::loadFilterFromFile(QString filename, int upsampling) {
   } else {
     qDebug() << "Failed to load " << filename;
   }
-}
-
-/// Provede konvoluci s odezvou (koeficienty) FIR filtru prvních M/2 a posledních M/2 vzorků je vynecháno (přechodné jevy).
-/// Výstup se tedy předbíhá o M/2 oproti vstupu (filtrovaný signál by se o M/2 zpožďoval, ale na začátku je vynecháno M vzorků)
-QVector<float> Interpolator::filter(QVector<float> x, QVector<float> h) {
-  QVector<float> y;
-
-  int N = x.length();     // Délka signálu
-  int M = h.length();     // Délka odezvy filtru
-
-  y.resize(N - M + 1);
-
-  for (int n = M - 1; n < N; n++) {
-    for (int k = 0; k < M; k++) {
-      y[n - M + 1] += x[n - k] * h[k];
-    }
-  }
 
-  return y;
+  // Doplnění na celý počet fází
+  tapsPerPhase = (lowPassFIR.size() + upsampling - 1) / upsampling;
+  polyphaseTaps = lowPassFIR;
+  polyphaseTaps.resize(tapsPerPhase * upsampling);
+  for (int i = lowPassFIR.size(); i < polyphaseTaps.size(); i++)
+    polyphaseTaps[i] = 0;
 }
@@ -30,8 +30,10 @@ class Interpolator : public QObject {
   /// Filtr pro filterování při interpolaci
   QVector<float> lowPassFIR;
 
-  /// Konvoluce signálu x s odezvou filtru h
-  QVector<float> filter(QVector<float> x, QVector<float> h);
+  /// Koeficienty filtru doplněné nulami na násobek upsampling. Uspořádání [tap][fáze] odpovídá polyfázovému rozkladu,
+  /// takže pro jeden vstupní vzorek se všechny fáze (výstupní vzorky) počítají jednou smyčkou přes sousední koeficienty.
+  QVector<float> polyphaseTaps;
+  int tapsPerPhase = 0;
 
   int upsampling = 8;
 
@@ -39,6 +41,7 @@ class Interpolator : public QObject {
   /// Interpoluje signál a výsledek odešle signálem interpolationResult, pokud data pochází z bufferu (přidávání po celých kanálech, jsou
   /// v grafu prepsány i původní vzorky, aby odpovídali průběhu z kterého je vypočtena interpolace. Pokud byla data vzata přímo z grafu,
   /// původní vzorky už v něm jsou a není potřeba je přepisovat.
+  /// Každé volání zpracuje jeden kanál, výpočet se dělí na bloky vstupních vzorků počítané paralelně na sdíleném fondu vláken.
   void interpolate(int chID, const QSharedPointer<QCPGraphDataContainer> data, QCPRange visibleRange, bool dataIsFromInterpolationBuffer);
 
   void loadFilterFromFile(QString filename, int upsampling);
@@ -0,0 +1,150 @@
+//  Copyright (C) 2020-2024  Jiří Maier
+
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "logicmeasurement.h"
+#include <algorithm>
+
+/// Body se připojují, při překročení se zahodí nejstarší čtvrtina
+#define LOGIC_MEASUREMENT_MAX_SAMPLES (1 << 22)
+
+LogicMeasurement::LogicMeasurement(QObject *parent) : QObject(parent) {}
+
+void LogicMeasurement::newLogicData(int group, QVector<double> times, QVector<quint32> words, bool continuous) {
+  Buffer &buffer = buffers[group];
+  if (!continuous || (!buffer.times.isEmpty() && !times.isEmpty() && times.first() < buffer.times.last())) {
+    buffer.times = times;
+    buffer.words = words;
+    return;
+  }
+  if (buffer.times.size() + times.size() > LOGIC_MEASUREMENT_MAX_SAMPLES) {
+    int drop = qMin(buffer.times.size(), LOGIC_MEASUREMENT_MAX_SAMPLES / 4);
+    buffer.times.remove(0, drop);
+    buffer.words.remove(0, drop);
+  }
+  buffer.times.append(times);
+  buffer.words.append(words);
+}
+
+void LogicMeasurement::newLogicWord(int group, double time, quint32 word) {
+  Buffer &buffer = buffers[group];
+  if (!buffer.times.isEmpty() && time < buffer.times.last()) {
+    buffer.times.clear();
+    buffer.words.clear();
+  } else if (buffer.times.size() >= LOGIC_MEASUREMENT_MAX_SAMPLES) {
+    buffer.times.remove(0, LOGIC_MEASUREMENT_MAX_SAMPLES / 4);
+    buffer.words.remove(0, LOGIC_MEASUREMENT_MAX_SAMPLES / 4);
+  }
+  buffer.times.append(time);
+  buffer.words.append(word);
+}
+
+void LogicMeasurement::clearGroup(int group, int fromBit) {
+  if (fromBit != 0)
+    return; // Jen se skryly vyšší bity, data zůstávají
+  buffers[group].times.clear();
+  buffers[group].words.clear();
+}
+
+void LogicMeasurement::reset() {
+  for (int i = 0; i < LOGIC_GROUPS; i++)
+    clearGroup(i, 0);
+}
+
+void LogicMeasurement::process(int group, double from, double to) {
+  const Buffer &buffer = buffers[group];
+  int begin = 0, end = qMin(buffer.times.size(), buffer.words.size());
+  if (from <= to) {
+    begin = std::lower_bound(buffer.times.cbegin(), buffer.times.cbegin() + end, from) - buffer.times.cbegin();
+    end = std::upper_bound(buffer.times.cbegin() + begin, buffer.times.cbegin() + end, to) - buffer.times.cbegin();
+  }
+  const int count = end - begin;
+  QVector<LogicBitMeasurement> bits(32);
+  if (count < 2) {
+    emit result(group, bits, qMax(count, 0));
+    return;
+  }
+  const quint32 *w = buffer.words.constData() + begin;
+  const double *t = buffer.times.constData() + begin;
+
+  // Bitové pole změn: bit i je nastaven, pokud se vzorek i liší od předchozího
+  const int blocks = (count + 63) / 64;
+  changesBuffer.fill(0, blocks);
+  quint64 *changes = changesBuffer.data();
+  for (int i = 1; i < count; i++)
+    changes[i >> 6] |= (quint64)(w[i] != w[i - 1]) << (i & 63);
+
+  // Čas poslední hrany každého bitu (začátek úseku, dokud žádná nebyla)
+  double lastEdge[32], firstRise[32], lastRise[32], highTime[32] = {0};
+  bool hasEdge[32] = {false};
+  double highSum[32] = {0}, lowSum[32] = {0};
+  int highCount[32] = {0}, lowCount[32] = {0};
+  for (int bit = 0; bit < 32; bit++)
+    lastEdge[bit] = t[0];
+
+  for (int block = 0; block < blocks; block++) {
+    quint64 samples = changes[block];
+    while (samples) {
+      const int i = block * 64 + qCountTrailingZeroBits(samples);
+      samples &= samples - 1;
+      const double time = t[i];
+      quint32 diff = w[i] ^ w[i - 1];
+      const quint32 rising = diff & w[i];
+      while (diff) {
+        const int bit = qCountTrailingZeroBits(diff);
+        diff &= diff - 1;
+        LogicBitMeasurement &m = bits[bit];
+        const double width = time - lastEdge[bit];
+        if ((rising >> bit) & 1u) {
+          // Konec pulzu v 0
+          if (hasEdge[bit]) {
+            lowSum[bit] += width;
+            lowCount[bit]++;
+          }
+          if (m.rising == 0)
+            firstRise[bit] = time;
+          lastRise[bit] = time;
+          m.rising++;
+        } else {
+          // Konec pulzu v 1
+          highTime[bit] += width;
+          if (hasEdge[bit]) {
+            highSum[bit] += width;
+            highCount[bit]++;
+          }
+          m.falling++;
+        }
+        hasEdge[bit] = true;
+        lastEdge[bit] = time;
+      }
+    }
+  }
+
+  const double span = t[count - 1] - t[0];
+  const quint32 last = w[count - 1];
+  for (int bit = 0; bit < 32; bit++) {
+    LogicBitMeasurement &m = bits[bit];
+    m.level = (last >> bit) & 1u;
+    if (m.level)
+      highTime[bit] += t[count - 1] - lastEdge[bit];
+    m.duty = span > 0 ? highTime[bit] / span : (double)m.level;
+    m.highWidth = highCount[bit] ? highSum[bit] / highCount[bit] : 0;
+    m.lowWidth = lowCount[bit] ? lowSum[bit] / lowCount[bit] : 0;
+    if (m.rising >= 2 && lastRise[bit] > firstRise[bit])
+      m.frequency = (m.rising - 1) / (lastRise[bit] - firstRise[bit]);
+    else if (m.highWidth > 0 && m.lowWidth > 0)
+      m.frequency = 1.0 / (m.highWidth + m.lowWidth);
+  }
+  emit result(group, bits, count);
+}
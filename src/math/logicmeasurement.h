@@ -0,0 +1,62 @@
+//  Copyright (C) 2020-2024  Jiří Maier
+
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef LOGICMEASUREMENT_H
+#define LOGICMEASUREMENT_H
+
+#include <QObject>
+#include <QVector>
+#include "global.h"
+
+struct LogicBitMeasurement {
+  double frequency = 0;
+  double duty = 0;
+  /// Průměrná délka celých pulzů v 1 a v 0
+  double highWidth = 0, lowWidth = 0;
+  int rising = 0, falling = 0;
+  /// Úroveň na konci úseku
+  bool level = false;
+};
+
+/// Měření na logických kanálech (frekvence, střída, šířka pulzů, počty hran) pro všechny bity najednou.
+/// Pracuje přímo se slovy (všechny bity vzorku v jednom čísle): vzorky beze změny se přeskočí po 64
+/// přes bitové pole změn a změněné bity se projdou přes počítání nul (ctz), takže cena je dána počtem hran.
+class LogicMeasurement : public QObject {
+  Q_OBJECT
+public:
+  explicit LogicMeasurement(QObject *parent = nullptr);
+
+private:
+  struct Buffer {
+    QVector<double> times;
+    QVector<quint32> words;
+  } buffers[LOGIC_GROUPS];
+  QVector<quint64> changesBuffer;
+
+public slots:
+  /// Uloží data skupiny, continuous = body (připojí se), jinak nahradí předchozí průběh
+  void newLogicData(int group, QVector<double> times, QVector<quint32> words, bool continuous);
+  /// Připojí jeden bod
+  void newLogicWord(int group, double time, quint32 word);
+  void clearGroup(int group, int fromBit);
+  void reset();
+  /// Změří úsek od from do to (from > to = celý průběh)
+  void process(int group, double from, double to);
+
+signals:
+  void result(int group, QVector<LogicBitMeasurement> bits, int samples);
+};
+
+#endif // LOGICMEASUREMENT_H
@@ -0,0 +1,128 @@
+//  Copyright (C) 2020-2024  Jiří Maier
+
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "measurementstatistics.h"
+
+void RunningStatistic::add(double value) {
+  if (!qIsFinite(value))
+    return;
+  count++;
+  double delta = value - mean;
+  mean += delta / count;
+  m2 += delta * (value - mean);
+  if (count == 1 || value < min)
+    min = value;
+  if (count == 1 || value > max)
+    max = value;
+}
+
+FixedBinHistogram::FixedBinHistogram(int binCount) : bins(binCount, 0) {}
+
+void FixedBinHistogram::clear() {
+  bins.fill(0);
+  lower = 0;
+  width = 0;
+  count = 0;
+}
+
+void FixedBinHistogram::start(double min, double max) {
+  double span = max - min;
+  if (span <= 0)
+    span = qMax(qAbs(min) * 1e-6, 1e-12);
+  width = span / bins.size();
+  lower = min;
+  // Hodnota rovná max padne do posledního koše
+  if (lower + width * bins.size() <= max)
+    width *= 1.0 + 1e-9;
+}
+
+void FixedBinHistogram::grow(bool down) {
+  const int n = bins.size();
+  QVector<quint64> merged(n, 0);
+  // Při rozšíření dolů se původní rozsah přesune do horní poloviny
+  const int offset = down ? n / 2 : 0;
+  for (int i = 0; i < n; i++)
+    merged[offset + i / 2] += bins.at(i);
+  if (down)
+    lower -= n * width;
+  width *= 2;
+  bins.swap(merged);
+}
+
+void FixedBinHistogram::addChecked(double value) {
+  const int n = bins.size();
+  while (value < lower)
+    grow(true);
+  while (value >= lower + n * width)
+    grow(false);
+  int index = (int)((value - lower) / width);
+  bins[qBound(0, index, n - 1)]++;
+  count++;
+}
+
+void FixedBinHistogram::add(double value) {
+  if (!qIsFinite(value))
+    return;
+  if (width == 0)
+    start(value, value);
+  addChecked(value);
+}
+
+void FixedBinHistogram::add(const QCPGraphDataContainer &data) {
+  if (data.isEmpty())
+    return;
+  if (width == 0) {
+    bool found = false;
+    QCPRange range = data.valueRange(found);
+    if (!found)
+      return;
+    start(range.lower, range.upper);
+  }
+  // Rozsah se kontroluje jen pro hodnoty mimo něj, běžná cesta je jen výpočet indexu
+  const int n = bins.size();
+  quint64 *b = bins.data();
+  for (auto it = data.constBegin(); it != data.constEnd(); it++) {
+    double position = (it->value - lower) / width;
+    if (position >= 0 && position < n) {
+      b[(int)position]++;
+      count++;
+    } else if (qIsFinite(it->value)) {
+      addChecked(it->value);
+      b = bins.data();
+    }
+  }
+}
+
+void MeasurementStatistics::reset() {
+  for (int i = 0; i < measurementCount; i++)
+    statistics[i] = RunningStatistic();
+  histogram.clear();
+  acquisitions = 0;
+}
+
+void MeasurementStatistics::setHistogramSource(int source) {
+  histogramSource = source;
+  histogram.clear();
+}
+
+void MeasurementStatistics::addAcquisition(const double values[measurementCount], const QCPGraphDataContainer &data) {
+  for (int i = 0; i < measurementCount; i++)
+    statistics[i].add(values[i]);
+  if (histogramSource == 0)
+    histogram.add(data);
+  else if (histogramSource <= measurementCount)
+    histogram.add(values[histogramSource - 1]);
+  acquisitions++;
+}
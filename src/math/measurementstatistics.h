@@ -0,0 +1,88 @@
+//  Copyright (C) 2020-2024  Jiří Maier
+
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef MEASUREMENTSTATISTICS_H
+#define MEASUREMENTSTATISTICS_H
+
+#include <QVector>
+#include <QtMath>
+
+#include "plots/qcustomplot.h"
+
+/// Průběžný průměr a rozptyl (Welfordův algoritmus), minimum a maximum
+struct RunningStatistic {
+  quint64 count = 0;
+  double mean = 0;
+  double m2 = 0;
+  double min = 0, max = 0;
+
+  void add(double value);
+  double stdDev() const { return count > 1 ? qSqrt(m2 / (count - 1)) : 0; }
+};
+
+/// Histogram s pevným počtem košů
+/// Rozsah se určí z prvních hodnot, hodnota mimo rozsah ho zdvojnásobí sloučením sousedních košů,
+/// takže se nic neukládá a přidání hodnoty je O(1).
+class FixedBinHistogram {
+public:
+  explicit FixedBinHistogram(int binCount = 256);
+
+  void clear();
+  void add(double value);
+  void add(const QCPGraphDataContainer &data);
+
+  const QVector<quint64> &getBins() const { return bins; }
+  double getLower() const { return lower; }
+  double getBinWidth() const { return width; }
+  quint64 getCount() const { return count; }
+
+private:
+  QVector<quint64> bins;
+  double lower = 0;
+  double width = 0;
+  quint64 count = 0;
+  void start(double min, double max);
+  void grow(bool down);
+  inline void addChecked(double value);
+};
+
+/// Statistika měření přes mnoho průběhů ($$C)
+class MeasurementStatistics {
+public:
+  /// Pořadí odpovídá SignalProcessing::result
+  enum Measurement { period, frequency, amplitude, minimum, maximum, rms, dc, samplingRate, rise, fall };
+  static const int measurementCount = 10;
+
+  void reset();
+
+  /// Zdroj histogramu: 0 = hodnoty vzorků, jinak měření (Measurement + 1)
+  void setHistogramSource(int source);
+  int getHistogramSource() const { return histogramSource; }
+
+  /// Přidá výsledky měření jednoho průběhu a jeho vzorky
+  void addAcquisition(const double values[measurementCount], const QCPGraphDataContainer &data);
+
+  const RunningStatistic &getStatistic(int measurement) const { return statistics[measurement]; }
+  const FixedBinHistogram &getHistogram() const { return histogram; }
+  quint64 getAcquisitions() const { return acquisitions; }
+
+private:
+  RunningStatistic statistics[measurementCount];
+  FixedBinHistogram histogram;
+  int histogramSource = 0;
+  quint64 acquisitions = 0;
+};
+
+#endif // MEASUREMENTSTATISTICS_H
@@ -0,0 +1,183 @@
+//  Copyright (C) 2020-2024  Jiří Maier
+
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "persistence.h"
+#include "math/taskpool.h"
+
+/// Nejkratší interval posílání pole (ms)
+#define PERSISTENCE_UPDATE_INTERVAL 50
+
+Persistence::Persistence(QObject *parent) : QObject(parent), flushTimer(this), fadeTimer(this) {
+  density.resize(columns * rows);
+  spanLow.resize(columns);
+  spanHigh.resize(columns);
+  clearDensity();
+  decayTimer.start();
+  sendTimer.start();
+
+  flushTimer.setSingleShot(true);
+  flushTimer.setInterval(PERSISTENCE_UPDATE_INTERVAL);
+  connect(&flushTimer, &QTimer::timeout, this, [this]() { postToStrand(&Persistence::flush); });
+  fadeTimer.setInterval(PERSISTENCE_UPDATE_INTERVAL);
+  connect(&fadeTimer, &QTimer::timeout, this, [this]() { postToStrand(&Persistence::fade); });
+  if (halfLife > 0)
+    fadeTimer.start();
+}
+
+void Persistence::postToStrand(void (Persistence::*function)()) {
+  if (TaskStrand *strand = TaskPool::strandOf(this))
+    strand->post([this, function]() { (this->*function)(); });
+  else
+    (this->*function)();
+}
+
+void Persistence::clearDensity() {
+  density.fill(0);
+  frames = 0;
+}
+
+void Persistence::setSource(int chID) {
+  if (chID == sourceChID)
+    return;
+  sourceChID = chID;
+  reset();
+}
+
+void Persistence::setDecay(double halfLife) {
+  this->halfLife = qMax(0.0, halfLife);
+  QMetaObject::invokeMethod(&fadeTimer, this->halfLife > 0 ? "start" : "stop", Qt::QueuedConnection);
+}
+
+void Persistence::reset() {
+  clearDensity();
+  rangeValid = false;
+  decayTimer.start();
+  sendPending = false;
+  sentMaxValue = 0;
+  emit newDensity(density, columns, rows, keyRange, valueRange, 0, 0);
+}
+
+bool Persistence::updateRange(const QCPGraphDataContainer &data) {
+  QCPRange frameKeys(data.constBegin()->key, (data.constEnd() - 1)->key);
+  if (frameKeys.size() <= 0)
+    return false;
+
+  // Rozsahy se určí z prvního průběhu, výrazně jiná časová osa (změna vzorkování) začne znovu
+  if (rangeValid && qAbs(frameKeys.size() - keyRange.size()) < 0.5 * keyRange.size())
+    return true;
+
+  bool found = false;
+  QCPRange frameValues = data.valueRange(found);
+  if (!found)
+    return false;
+  if (frameValues.size() == 0)
+    frameValues = QCPRange(frameValues.lower - 1, frameValues.upper + 1);
+  double margin = 0.1 * frameValues.size();
+  valueRange = QCPRange(frameValues.lower - margin, frameValues.upper + margin);
+  keyRange = frameKeys;
+  rangeValid = true;
+  clearDensity();
+  return true;
+}
+
+void Persistence::rasterize(const QCPGraphDataContainer &data) {
+  const double xScale = columns / keyRange.size();
+  const double yScale = rows / valueRange.size();
+  std::fill(spanLow.begin(), spanLow.end(), rows);
+  std::fill(spanHigh.begin(), spanHigh.end(), -1);
+  int *low = spanLow.data();
+  int *high = spanHigh.data();
+
+  // Hodnoty mimo rozsah se zobrazí na okraji (jako ořezaný průběh)
+  auto row = [yScale, this](double y) { return (int)qBound(0.0, (y - valueRange.lower) * yScale, rows - 1.0); };
+
+  auto it = data.constBegin();
+  double x0 = (it->key - keyRange.lower) * xScale;
+  double y0 = it->value;
+  for (++it; it != data.constEnd(); ++it) {
+    double x1 = (it->key - keyRange.lower) * xScale;
+    double y1 = it->value;
+    if (x1 >= x0 && x1 >= 0 && x0 < columns && !qIsNaN(y0) && !qIsNaN(y1)) {
+      // Úsek mezi vzorky se rozdělí na sloupce, v každém sloupci pokrývá rozsah mezi hodnotami na jeho okrajích
+      int firstColumn = (int)qMax(0.0, x0);
+      int lastColumn = (int)qMin(columns - 1.0, x1);
+      double slope = x1 > x0 ? (y1 - y0) / (x1 - x0) : 0;
+      for (int column = firstColumn; column <= lastColumn; column++) {
+        int rowA = row(x1 > x0 ? y0 + slope * (qMax<double>(x0, column) - x0) : y0);
+        int rowB = row(x1 > x0 ? y0 + slope * (qMin<double>(x1, column + 1) - x0) : y1);
+        low[column] = qMin(low[column], qMin(rowA, rowB));
+        high[column] = qMax(high[column], qMax(rowA, rowB));
+      }
+    }
+    x0 = x1;
+    y0 = y1;
+  }
+
+  // Každý pixel průběhu se započítá jednou, přičítá se souvislý úsek sloupce
+  float *cells = density.data();
+  for (int column = 0; column < columns; column++) {
+    float *cell = cells + column * rows;
+    for (int r = low[column]; r <= high[column]; r++)
+      cell[r] += 1;
+  }
+  frames++;
+}
+
+void Persistence::decay() {
+  double elapsed = decayTimer.nsecsElapsed() * 1e-9;
+  decayTimer.start();
+  if (halfLife <= 0)
+    return;
+  float factor = qPow(0.5, elapsed / halfLife);
+  for (float &cell : density)
+    cell *= factor;
+}
+
+void Persistence::newDataVector(int chID, QSharedPointer<QCPGraphDataContainer> data) {
+  if (chID != sourceChID || data->size() < 2)
+    return;
+  if (!updateRange(*data))
+    return;
+  rasterize(*data);
+
+  // Průběhů mohou být tisíce za sekundu, pole se posílá nejvýše 20x za sekundu a poslední průběhy dávky dorazí s odloženým posláním
+  if (sendTimer.elapsed() >= PERSISTENCE_UPDATE_INTERVAL) {
+    send();
+  } else if (!sendPending) {
+    sendPending = true;
+    QMetaObject::invokeMethod(&flushTimer, "start", Qt::QueuedConnection);
+  }
+}
+
+void Persistence::send() {
+  sendTimer.start();
+  sendPending = false;
+  decay();
+  sentMaxValue = *std::max_element(density.cbegin(), density.cend());
+  emit newDensity(density, columns, rows, keyRange, valueRange, sentMaxValue, frames);
+}
+
+void Persistence::flush() {
+  if (sendPending)
+    send();
+}
+
+void Persistence::fade() {
+  // Pole se posílá, dokud z něj něco zbývá (úplně vyhaslé pole už se nemění)
+  if (halfLife <= 0 || !rangeValid || sentMaxValue < 1e-3f)
+    return;
+  if (sendTimer.elapsed() >= PERSISTENCE_UPDATE_INTERVAL / 2)
+    send();
+}
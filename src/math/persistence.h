@@ -0,0 +1,81 @@
+//  Copyright (C) 2020-2024  Jiří Maier
+
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef PERSISTENCE_H
+#define PERSISTENCE_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QTimer>
+#include <QVector>
+
+#include "global.h"
+#include "plots/qcustomplot.h"
+
+/// Zobrazení s dosvitem (jako digitální fosfor osciloskopu)
+/// Každý průběh se rasterizuje do 2D pole počtů zásahů o pevné velikosti, pole postupně vyhasíná.
+/// Rasterizace jde po sloupcích: pro každý sloupec se nejdřív najde rozsah řádků, který průběh v sloupci protíná,
+/// pak se přičte souvislý úsek sloupce (pole je uloženo po sloupcích).
+class Persistence : public QObject {
+  Q_OBJECT
+public:
+  explicit Persistence(QObject *parent = nullptr);
+
+  static const int columns = 512; ///< Rozlišení v čase
+  static const int rows = 256;    ///< Rozlišení v hodnotě
+
+private:
+  int sourceChID = -1;
+  double halfLife = 1; ///< Poločas vyhasínání v sekundách, 0 = nevyhasíná
+
+  QVector<float> density; ///< columns * rows, po sloupcích
+  QVector<int> spanLow, spanHigh;
+  QCPRange keyRange, valueRange;
+  bool rangeValid = false;
+  int frames = 0;
+
+  QElapsedTimer decayTimer, sendTimer;
+  /// Odložené odeslání posledních průběhů dávky, které při omezení četnosti neprošly
+  QTimer flushTimer;
+  bool sendPending = false;
+  /// Pravidelné odesílání při vyhasínání, aby pole dohasínalo i bez nových průběhů
+  QTimer fadeTimer;
+  float sentMaxValue = 0;
+
+  void clearDensity();
+  bool updateRange(const QCPGraphDataContainer &data);
+  void rasterize(const QCPGraphDataContainer &data);
+  void decay();
+  void send();
+  void flush();
+  void fade();
+  /// Zařadí funkci do řady úloh objektu (časovače běží v hlavním vlákně, pole se mění jen v řadě)
+  void postToStrand(void (Persistence::*function)());
+
+public slots:
+  /// Nastaví zdrojový kanál, -1 vypne výpočet
+  void setSource(int chID);
+  /// Poločas vyhasínání v sekundách, 0 = nekonečný dosvit
+  void setDecay(double halfLife);
+  /// Vymaže pole a rozsahy os se znovu určí z dalšího průběhu
+  void reset();
+  void newDataVector(int chID, QSharedPointer<QCPGraphDataContainer> data);
+
+signals:
+  /// Pole zásahů (columns * rows, po sloupcích), maxValue je nejvyšší hodnota v poli
+  void newDensity(QVector<float> density, int columns, int rows, QCPRange keyRange, QCPRange valueRange, float maxValue, int frames);
+};
+
+#endif // PERSISTENCE_H
@@ -14,17 +14,149 @@
 //  along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include "plotmath.h"
+#include "traceevents.h"
 
 PlotMath::PlotMath(QObject* parent) : QObject(parent) {
   firsts.resize(MATH_COUNT);
   seconds.resize(MATH_COUNT);
-  for (int i = 0; i < MATH_COUNT; i++)
+  for (int i = 0; i < MATH_COUNT; i++) {
     operations[i] = MathOperations::add;
+    expressionInputs[i].resize(ANALOG_COUNT);
+  }
 }
 
 PlotMath::~PlotMath() {}
 
+namespace {
+/// Vstupy jednoho výpočtu, konstantní operand má hodnotu rovnou svému násobku
+struct MathOperands {
+  const QCPGraphData *first, *second, *keys;
+  double scaleFirst, scaleSecond;
+  int count;
+  bool constFirst, constSecond;
+  MathRunningState *state;
+};
+
+/// Na předchozí výpočet se navazuje jen u jednoho bodu za posledním vzorkem (stejně jako ho připojí graf), jinak se začíná znovu
+inline bool resumes(const MathOperands &in) { return in.state->valid && in.count == 1 && in.keys[0].key > in.state->lastKey; }
+
+struct OpAdd {
+  static inline double apply(double a, double b) { return a + b; }
+};
+struct OpSubtract {
+  static inline double apply(double a, double b) { return a - b; }
+};
+struct OpMultiply {
+  static inline double apply(double a, double b) { return a * b; }
+};
+struct OpDivide {
+  static inline double apply(double a, double b) { return a / b; }
+};
+struct OpMinimum {
+  static inline double apply(double a, double b) { return b < a ? b : a; }
+};
+struct OpMaximum {
+  static inline double apply(double a, double b) { return b > a ? b : a; }
+};
+
+template <bool isConst> inline double operand(const QCPGraphData *data, int i, double scale) { return isConst ? scale : data[i].value * scale; }
+
+/// Prvek po prvku, operace i konstantnost vstupů jsou známé při překladu
+template <typename Op> struct BinaryKernel {
+  template <bool constFirst, bool constSecond> static void run(const MathOperands &in, QCPGraphData *out) {
+    for (int i = 0; i < in.count; i++) {
+      out[i].key = in.keys[i].key;
+      out[i].value = Op::apply(operand<constFirst>(in.first, i, in.scaleFirst), operand<constSecond>(in.second, i, in.scaleSecond));
+    }
+  }
+};
+
+/// |první| + druhý
+struct AbsoluteKernel {
+  template <bool constFirst, bool constSecond> static void run(const MathOperands &in, QCPGraphData *out) {
+    for (int i = 0; i < in.count; i++) {
+      double a = operand<constFirst>(in.first, i, in.scaleFirst);
+      out[i].key = in.keys[i].key;
+      out[i].value = (a < 0 ? -a : a) + operand<constSecond>(in.second, i, in.scaleSecond);
+    }
+  }
+};
+
+/// Integrál prvního (lichoběžníky, od nuly v prvním vzorku) + druhý
+struct IntegralKernel {
+  template <bool constFirst, bool constSecond> static void run(const MathOperands &in, QCPGraphData *out) {
+    if (in.count == 0)
+      return;
+    MathRunningState &state = *in.state;
+    bool resume = resumes(in);
+    double sum = resume ? state.sum : 0;
+    double lastValue = resume ? state.lastValue : operand<constFirst>(in.first, 0, in.scaleFirst);
+    double lastKey = resume ? state.lastKey : in.keys[0].key;
+    for (int i = 0; i < in.count; i++) {
+      double a = operand<constFirst>(in.first, i, in.scaleFirst);
+      double key = in.keys[i].key;
+      sum += 0.5 * (a + lastValue) * (key - lastKey);
+      lastValue = a;
+      lastKey = key;
+      out[i].key = key;
+      out[i].value = sum + operand<constSecond>(in.second, i, in.scaleSecond);
+    }
+    state = MathRunningState{true, sum, lastKey, lastValue, 0};
+  }
+};
+
+/// Derivace prvního (zpětná diference, první vzorek bloku má dopřednou) + druhý
+struct DerivativeKernel {
+  template <bool constFirst, bool constSecond> static void run(const MathOperands &in, QCPGraphData *out) {
+    if (in.count == 0)
+      return;
+    MathRunningState &state = *in.state;
+    bool resume = resumes(in);
+    double derivative = resume ? state.derivative : 0;
+    double lastValue = resume ? state.lastValue : operand<constFirst>(in.first, 0, in.scaleFirst);
+    double lastKey = resume ? state.lastKey : in.keys[0].key;
+    if (!resume && !constFirst && in.count > 1 && in.keys[1].key != in.keys[0].key)
+      derivative = (in.first[1].value - in.first[0].value) * in.scaleFirst / (in.keys[1].key - in.keys[0].key);
+    for (int i = 0; i < in.count; i++) {
+      double a = operand<constFirst>(in.first, i, in.scaleFirst);
+      double dt = in.keys[i].key - lastKey;
+      if (!constFirst && dt != 0)
+        derivative = (a - lastValue) / dt;
+      lastValue = a;
+      lastKey = in.keys[i].key;
+      out[i].key = in.keys[i].key;
+      out[i].value = derivative + operand<constSecond>(in.second, i, in.scaleSecond);
+    }
+    state = MathRunningState{true, 0, lastKey, lastValue, derivative};
+  }
+};
+
+/// Vybere specializaci podle konstantnosti vstupů jednou pro celý blok
+template <typename Kernel> void runKernel(const MathOperands &in, QCPGraphData *out) {
+  if (in.constFirst) {
+    if (in.constSecond)
+      Kernel::template run<true, true>(in, out);
+    else
+      Kernel::template run<true, false>(in, out);
+  } else {
+    if (in.constSecond)
+      Kernel::template run<false, true>(in, out);
+    else
+      Kernel::template run<false, false>(in, out);
+  }
+}
+} // namespace
+
+bool PlotMath::sameTimeBase(const QCPGraphDataContainer& first, const QCPGraphDataContainer& second) {
+  if (first.size() != second.size())
+    return false;
+  if (first.isEmpty())
+    return true;
+  return (first.constBegin()->key == second.constBegin()->key && (first.constEnd() - 1)->key == (second.constEnd() - 1)->key);
+}
+
 void PlotMath::addMathData(int mathNumber, bool isFirst, QSharedPointer<QCPGraphDataContainer> in, bool shouldIgnorePause) {
+  TRACE_SCOPE("math", "PlotMath::addMathData");
   QSharedPointer<QCPGraphDataContainer>& first = firsts[mathNumber];
   QSharedPointer<QCPGraphDataContainer>& second = seconds[mathNumber];
   if (isFirst)
@@ -37,41 +169,139 @@ void PlotMath::addMathData(int mathNumber, bool isFirst, QSharedPointer<QCPGraph
   if (second.isNull() && !isconstSeconds[mathNumber])
     return;
 
-  if (!isconstFirst[mathNumber] && !isconstSeconds[mathNumber]) {
-    if (first->size() != second->size()) {
-      emit sendMessage(tr("Math error"), tr("Channels have different length, can not use math").toUtf8());
-      first.clear();
-      second.clear();
-      return;
+  // Časová osa se bere z nekonstantního vstupu
+  const QSharedPointer<QCPGraphDataContainer>& keySource = (isconstFirst[mathNumber] && !isconstSeconds[mathNumber]) ? second : first;
+  if (keySource.isNull()) {
+    first.clear();
+    second.clear();
+    return;
+  }
+
+  // Prázdný vstup dává prázdný výsledek, ukazatele na data se z něj brát nesmí
+  if (keySource->isEmpty() || (!isconstFirst[mathNumber] && first->isEmpty()) || (!isconstSeconds[mathNumber] && second->isEmpty())) {
+    auto result = QSharedPointer<QCPGraphDataContainer>(new QCPGraphDataContainer());
+    emit sendResult(getAnalogChId(mathNumber + 1, ChannelType::math), result, shouldIgnorePause);
+    first.clear();
+    second.clear();
+    return;
+  }
+
+  MathOperands operands;
+  operands.count = keySource->size();
+  operands.keys = &*keySource->constBegin();
+  operands.first = isconstFirst[mathNumber] ? operands.keys : &*first->constBegin();
+  operands.second = isconstSeconds[mathNumber] ? operands.keys : &*second->constBegin();
+
+  if (!isconstFirst[mathNumber] && !isconstSeconds[mathNumber] && !sameTimeBase(*first, *second)) {
+    // Různé časové osy, kanály se zarovnají na společnou (buffery se mezi voláními nepřealokovávají)
+    int maxCount = Resampler::maxOutputCount(first->size(), second->size());
+    alignedFirst.resize(maxCount);
+    alignedSecond.resize(maxCount);
+    QCPGraphData* outFirst = alignedFirst.data();
+    QCPGraphData* outSecond = alignedSecond.data();
+    operands.count = Resampler::merge(operands.first, first->size(), operands.second, second->size(), Resampling::linear, [&](double time, double valueFirst, double valueSecond) {
+      *outFirst++ = QCPGraphData(time, valueFirst);
+      *outSecond++ = QCPGraphData(time, valueSecond);
+    });
+    operands.keys = alignedFirst.constData();
+    operands.first = alignedFirst.constData();
+    operands.second = alignedSecond.constData();
+  }
+  operands.scaleFirst = scalarsFirst[mathNumber];
+  operands.scaleSecond = scalarsSeconds[mathNumber];
+  operands.constFirst = isconstFirst[mathNumber];
+  operands.constSecond = isconstSeconds[mathNumber];
+  operands.state = &runningStates[mathNumber];
+
+  QVector<QCPGraphData> output(operands.count);
+  if (operands.count) {
+    QCPGraphData* out = output.data();
+    switch (operations[mathNumber]) {
+      case MathOperations::add: runKernel<BinaryKernel<OpAdd>>(operands, out); break;
+      case MathOperations::subtract: runKernel<BinaryKernel<OpSubtract>>(operands, out); break;
+      case MathOperations::multiply: runKernel<BinaryKernel<OpMultiply>>(operands, out); break;
+      case MathOperations::divide: runKernel<BinaryKernel<OpDivide>>(operands, out); break;
+      case MathOperations::minimum: runKernel<BinaryKernel<OpMinimum>>(operands, out); break;
+      case MathOperations::maximum: runKernel<BinaryKernel<OpMaximum>>(operands, out); break;
+      case MathOperations::integral: runKernel<IntegralKernel>(operands, out); break;
+      case MathOperations::derivative: runKernel<DerivativeKernel>(operands, out); break;
+      case MathOperations::absolute: runKernel<AbsoluteKernel>(operands, out); break;
+      case MathOperations::expression: break; // Počítá se v calculateExpression
     }
   }
 
   auto result = QSharedPointer<QCPGraphDataContainer>(new QCPGraphDataContainer());
-  for (int i = 0; i < first->size(); i++) {
-    double resultSample = (isconstFirst[mathNumber] ? 1.0 : first->at(i)->value) * scalarsFirst[mathNumber];
-    if (operations[mathNumber] == MathOperations::add)
-      resultSample += (isconstSeconds[mathNumber] ? 1.0 : second->at(i)->value) * scalarsSeconds[mathNumber];
-    else if (operations[mathNumber] == MathOperations::subtract)
-      resultSample -= (isconstSeconds[mathNumber] ? 1.0 : second->at(i)->value) * scalarsSeconds[mathNumber];
-    else if (operations[mathNumber] == MathOperations::multiply)
-      resultSample *= (isconstSeconds[mathNumber] ? 1.0 : second->at(i)->value) * scalarsSeconds[mathNumber];
-    else if (operations[mathNumber] == MathOperations::divide)
-      resultSample /= (isconstSeconds[mathNumber] ? 1.0 : second->at(i)->value) * scalarsSeconds[mathNumber];
-    result->add(QCPGraphData(first->at(i)->key, resultSample));
-  }
+  result->set(output, true);
   emit sendResult(getAnalogChId(mathNumber + 1, ChannelType::math), result, shouldIgnorePause);
   first.clear();
   second.clear();
 }
 
+void PlotMath::addMathExpressionData(int mathNumber, int ch, QSharedPointer<QCPGraphDataContainer> in, bool shouldIgnorePause) {
+  TRACE_SCOPE("math", "PlotMath::addMathExpressionData");
+  if (operations[mathNumber] != MathOperations::expression || !expressions[mathNumber].isValid())
+    return;
+  expressionInputs[mathNumber][ch] = in;
+
+  // Počítá se až když jsou k dispozici všechny použité kanály
+  quint32 mask = expressions[mathNumber].getChannelMask();
+  for (int i = 0; i < ANALOG_COUNT; i++)
+    if ((mask & (1u << i)) && expressionInputs[mathNumber].at(i).isNull())
+      return;
+  calculateExpression(mathNumber, shouldIgnorePause);
+}
+
+void PlotMath::calculateExpression(int mathNumber, bool shouldIgnorePause) {
+  QVector<QSharedPointer<QCPGraphDataContainer>>& inputs = expressionInputs[mathNumber];
+  quint32 mask = expressions[mathNumber].getChannelMask();
+
+  // Časová osa je z prvního použitého kanálu, ostatní kanály se na ni případně převzorkují
+  int count = -1;
+  int keyChannel = -1;
+  const QCPGraphData* keys = nullptr;
+  QVector<const QCPGraphData*> channels(ANALOG_COUNT, nullptr);
+  for (int i = 0; i < ANALOG_COUNT; i++) {
+    if (!(mask & (1u << i)))
+      continue;
+    const QCPGraphDataContainer& input = *inputs.at(i);
+    if (count < 0) {
+      count = input.size();
+      keyChannel = i;
+    }
+    if (count == 0)
+      break;
+    if (i == keyChannel || sameTimeBase(*inputs.at(keyChannel), input)) {
+      channels[i] = &*input.constBegin();
+    } else {
+      QVector<QCPGraphData>& aligned = alignedExpressionInputs[i];
+      aligned.resize(count);
+      Resampler::resampleOnto(input.isEmpty() ? nullptr : &*input.constBegin(), input.size(), keys, count, Resampling::linear, aligned.data());
+      channels[i] = aligned.constData();
+    }
+    if (keys == nullptr)
+      keys = channels.at(i);
+  }
+
+  QVector<QCPGraphData> output(qMax(count, 0));
+  if (count > 0)
+    expressions[mathNumber].evaluate(channels, keys, count, output.data());
+  auto result = QSharedPointer<QCPGraphDataContainer>(new QCPGraphDataContainer());
+  result->set(output, true);
+  emit sendResult(getAnalogChId(mathNumber + 1, ChannelType::math), result, shouldIgnorePause);
+  inputs.fill(QSharedPointer<QCPGraphDataContainer>());
+}
+
 void PlotMath::clearMath(int math) {
   firsts[math - 1].clear();
   seconds[math - 1].clear();
+  expressionInputs[math - 1].fill(QSharedPointer<QCPGraphDataContainer>());
+  runningStates[math - 1] = MathRunningState();
 }
 
 void PlotMath::resetMath(int mathNumber, MathOperations::enumMathOperations mode, QSharedPointer<QCPGraphDataContainer> in1, QSharedPointer<QCPGraphDataContainer> in2, bool firstIsConst, bool secondIsConst, double scaleFirst, double scaleSecond) {
   operations[mathNumber - 1] = mode;
   seconds[mathNumber - 1].clear();// Vymaže druhá data
+  runningStates[mathNumber - 1] = MathRunningState();
 
   isconstFirst[mathNumber - 1] = firstIsConst;
   isconstSeconds[mathNumber - 1] = secondIsConst;
@@ -82,4 +312,25 @@ void PlotMath::resetMath(int mathNumber, MathOperations::enumMathOperations mode
   addMathData(mathNumber - 1, false, in2, true); // Vloží druhá data, spočítá a pošle do grafu
 }
 
+void PlotMath::resetMathExpression(int mathNumber, QString expression, QVector<QSharedPointer<QCPGraphDataContainer>> inputs) {
+  operations[mathNumber - 1] = MathOperations::expression;
+  expressionInputs[mathNumber - 1].fill(QSharedPointer<QCPGraphDataContainer>());
+  if (!expressions[mathNumber - 1].setExpression(expression)) {
+    emit sendMessage(tr("Math error"), expressions[mathNumber - 1].getError().toUtf8());
+    return;
+  }
+  quint32 mask = expressions[mathNumber - 1].getChannelMask();
+  if (mask == 0) {
+    emit sendMessage(tr("Math error"), tr("Formula does not use any channel").toUtf8());
+    return;
+  }
 
+  // Spočítá z dat, která už jsou v grafu
+  for (int i = 0; i < ANALOG_COUNT && i < inputs.size(); i++)
+    if (mask & (1u << i))
+      expressionInputs[mathNumber - 1][i] = inputs.at(i);
+  for (int i = 0; i < ANALOG_COUNT; i++)
+    if ((mask & (1u << i)) && expressionInputs[mathNumber - 1].at(i).isNull())
+      return;
+  calculateExpression(mathNumber - 1, true);
+}
@@ -21,8 +21,16 @@
 #include <QThread>
 
 #include "global.h"
+#include "math/compiledexpression.h"
+#include "math/resampler.h"
 #include "plots/qcustomplot.h"
 
+/// Stav integrálu a derivace mezi voláními, v režimu bodů ($$P) přichází každý vzorek zvlášť
+struct MathRunningState {
+  bool valid = false;
+  double sum = 0, lastKey = 0, lastValue = 0, derivative = 0;
+};
+
 class PlotMath : public QObject {
   Q_OBJECT
  public:
@@ -36,10 +44,19 @@ class PlotMath : public QObject {
   bool isconstSeconds[MATH_COUNT];
   double scalarsFirst[MATH_COUNT];
   double scalarsSeconds[MATH_COUNT];
+  CompiledExpression expressions[MATH_COUNT];
+  MathRunningState runningStates[MATH_COUNT];
+  QVector<QSharedPointer<QCPGraphDataContainer>> expressionInputs[MATH_COUNT];
+  QVector<QCPGraphData> alignedFirst, alignedSecond;
+  QVector<QCPGraphData> alignedExpressionInputs[ANALOG_COUNT];
+  static bool sameTimeBase(const QCPGraphDataContainer& first, const QCPGraphDataContainer& second);
+  void calculateExpression(int mathNumber, bool shouldIgnorePause);
  public slots:
   void addMathData(int mathNumber, bool isFirst, QSharedPointer<QCPGraphDataContainer> in, bool shouldIgnorePause);
+  void addMathExpressionData(int mathNumber, int ch, QSharedPointer<QCPGraphDataContainer> in, bool shouldIgnorePause);
   void clearMath(int math);
   void resetMath(int mathNumber, MathOperations::enumMathOperations mode, QSharedPointer<QCPGraphDataContainer> in1, QSharedPointer<QCPGraphDataContainer> in2, bool firstIsConst, bool secondIsConst, double scaleFirst, double scaleSecond);
+  void resetMathExpression(int mathNumber, QString expression, QVector<QSharedPointer<QCPGraphDataContainer>> inputs);
 
  signals:
   void sendResult(int chNumber, QSharedPointer<QCPGraphDataContainer> result, bool ignorePause);
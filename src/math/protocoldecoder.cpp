@@ -0,0 +1,335 @@
+//  Copyright (C) 2020-2024  Jiří Maier
+
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "protocoldecoder.h"
+#include <QtAlgorithms>
+
+QString DecodedWord::text() const {
+  if (flags & startCondition)
+    return "S";
+  if (flags & stopCondition)
+    return "P";
+  if (flags & address)
+    return QString("A:0x%1%2").arg(value >> 1, 2, 16, QChar('0')).arg((flags & read) ? "R" : "W");
+  QString result = QString("0x%1").arg(value, 2, 16, QChar('0'));
+  if (hasSecondValue)
+    result.append(QString("/0x%1").arg(secondValue, 2, 16, QChar('0')));
+  return result;
+}
+
+QString DecodedWord::info() const {
+  QStringList list;
+  if (flags & startCondition)
+    list.append(QObject::tr("Start"));
+  if (flags & stopCondition)
+    list.append(QObject::tr("Stop"));
+  if (flags & address)
+    list.append((flags & read) ? QObject::tr("Address, read") : QObject::tr("Address, write"));
+  if (flags & nack)
+    list.append(QObject::tr("NACK"));
+  if (flags & parityError)
+    list.append(QObject::tr("Parity error"));
+  if (flags & framingError)
+    list.append(QObject::tr("Framing error"));
+  return list.join(", ");
+}
+
+bool ProtocolDecoder::Line::levelAt(double time, int &cursor) const {
+  while (cursor < edges.size() && edges.at(cursor).time <= time)
+    cursor++;
+  return cursor == 0 ? levelBefore : edges.at(cursor - 1).level;
+}
+
+void ProtocolDecoder::Line::dropConsumed() {
+  if (consumed == 0)
+    return;
+  levelBefore = edges.at(consumed - 1).level;
+  edges.remove(0, consumed);
+  consumed = 0;
+}
+
+ProtocolDecoder::ProtocolDecoder(QObject *parent) : QObject(parent) {}
+
+void ProtocolDecoder::setSettings(DecoderSettings settings) {
+  this->settings = settings;
+  for (int i = 0; i < 4; i++)
+    lines[i].bit = -1;
+  switch (settings.protocol) {
+    case DecoderProtocol::uart: lines[0].bit = settings.uartBit; break;
+    case DecoderProtocol::spi:
+      lines[0].bit = settings.clkBit;
+      lines[1].bit = settings.mosiBit;
+      lines[2].bit = settings.misoBit;
+      lines[3].bit = settings.csBit;
+      break;
+    case DecoderProtocol::i2c:
+      lines[0].bit = settings.sclBit;
+      lines[1].bit = settings.sdaBit;
+      break;
+    case DecoderProtocol::off: break;
+  }
+  reset();
+  emit decoded(settings.group, QVector<DecodedWord>(), true);
+}
+
+void ProtocolDecoder::reset() {
+  for (int i = 0; i < 4; i++) {
+    lines[i].edges.clear();
+    lines[i].consumed = 0;
+    lines[i].levelBefore = true;
+  }
+  hasLastWord = false;
+  lastTime = 0;
+  spi.bitCount = 0;
+  i2c.active = false;
+  i2c.bitCount = 0;
+  output.clear();
+}
+
+void ProtocolDecoder::process(int group, const double *times, const quint32 *words, int count, bool continuous) {
+  if (settings.protocol == DecoderProtocol::off || group != settings.group || count <= 0)
+    return;
+
+  // Nový průběh nebo čas šel zpět (nové měření)
+  bool clear = !continuous || (hasLastWord && times[0] < lastTime);
+  if (clear)
+    reset();
+
+  const quint32 *w = words;
+  quint32 mask = 0;
+  for (int i = 0; i < 4; i++)
+    if (lines[i].bit >= 0)
+      mask |= 1u << lines[i].bit;
+  if (!hasLastWord) {
+    for (int i = 0; i < 4; i++)
+      if (lines[i].bit >= 0)
+        lines[i].levelBefore = (w[0] >> lines[i].bit) & 1u;
+    lastWord = w[0];
+    hasLastWord = true;
+  }
+
+  // Bitové pole změn: bit i je nastaven, pokud se ve vzorku i změnila některá sledovaná linka
+  int blocks = (count + 63) / 64;
+  bitsBuffer.fill(0, blocks);
+  quint64 *changes = bitsBuffer.data();
+  changes[0] = ((w[0] ^ lastWord) & mask) != 0;
+  for (int i = 1; i < count; i++)
+    changes[i >> 6] |= (quint64)(((w[i] ^ w[i - 1]) & mask) != 0) << (i & 63);
+
+  // Projdou se jen vzorky se změnou
+  for (int block = 0; block < blocks; block++) {
+    quint64 bits = changes[block];
+    while (bits) {
+      int i = block * 64 + qCountTrailingZeroBits(bits);
+      bits &= bits - 1;
+      quint32 diff = w[i] ^ (i ? w[i - 1] : lastWord);
+      for (int l = 0; l < 4; l++) {
+        int bit = lines[l].bit;
+        if (bit >= 0 && ((diff >> bit) & 1u))
+          lines[l].edges.append(Edge{times[i], (bool)((w[i] >> bit) & 1u)});
+      }
+    }
+  }
+  lastWord = w[count - 1];
+  lastTime = times[count - 1];
+
+  switch (settings.protocol) {
+    case DecoderProtocol::uart: decodeUart(); break;
+    case DecoderProtocol::spi: decodeSpi(); break;
+    case DecoderProtocol::i2c: decodeI2c(); break;
+    case DecoderProtocol::off: break;
+  }
+
+  if (!output.isEmpty() || clear)
+    emit decoded(group, output, clear);
+  output.clear();
+}
+
+void ProtocolDecoder::decodeUart() {
+  Line &rx = lines[0];
+  const double bitTime = 1.0 / settings.baud;
+  const int frameBits = 1 + settings.dataBits + (settings.parity ? 1 : 0) + 1;
+  const bool idle = !settings.uartInverted;
+  int i = rx.consumed;
+  forever {
+    // Start bit je první hrana z klidové úrovně
+    while (i < rx.edges.size() && rx.edges.at(i).level == idle)
+      i++;
+    if (i >= rx.edges.size())
+      break;
+    double start = rx.edges.at(i).time;
+    double end = start + frameBits * bitTime;
+    if (end > lastTime)
+      break; // Rámec ještě není celý, počká se na další data
+
+    // Bity se vzorkují uprostřed
+    int cursor = i;
+    auto sample = [&](int bitIndex) { return rx.levelAt(start + (bitIndex + 0.5) * bitTime, cursor) != settings.uartInverted; };
+    if (sample(0)) {
+      i++; // Zákmit, ne start bit
+      continue;
+    }
+    DecodedWord word;
+    word.start = start;
+    word.end = end;
+    int ones = 0;
+    for (int bit = 0; bit < settings.dataBits; bit++) {
+      if (sample(1 + bit)) {
+        word.value |= 1u << bit;
+        ones++;
+      }
+    }
+    if (settings.parity) {
+      ones += sample(1 + settings.dataBits);
+      if ((ones % 2 == 1) != (settings.parity == 1))
+        word.flags |= DecodedWord::parityError;
+    }
+    if (!sample(frameBits - 1))
+      word.flags |= DecodedWord::framingError;
+    output.append(word);
+
+    // Další start bit se hledá až od poloviny stop bitu
+    double resume = start + (frameBits - 0.5) * bitTime;
+    while (i < rx.edges.size() && rx.edges.at(i).time <= resume)
+      i++;
+  }
+  rx.consumed = i;
+  rx.dropConsumed();
+}
+
+void ProtocolDecoder::decodeSpi() {
+  Line &clk = lines[0];
+  Line &mosi = lines[1];
+  Line &miso = lines[2];
+  Line &cs = lines[3];
+  const bool sampleOnRising = (settings.spiMode == 0 || settings.spiMode == 3);
+  int mosiCursor = mosi.consumed, misoCursor = miso.consumed, csCursor = cs.consumed;
+
+  for (int i = clk.consumed; i < clk.edges.size(); i++) {
+    const Edge &edge = clk.edges.at(i);
+    // Neaktivní CS (i krátce mezi hranami hodin) ukončí rozpracované slovo
+    if (cs.bit >= 0) {
+      bool deasserted = false;
+      while (csCursor < cs.edges.size() && cs.edges.at(csCursor).time <= edge.time)
+        deasserted |= cs.edges.at(csCursor++).level;
+      if (deasserted)
+        spi.bitCount = 0;
+      if (csCursor == 0 ? cs.levelBefore : cs.edges.at(csCursor - 1).level)
+        continue;
+    }
+    if (edge.level != sampleOnRising)
+      continue;
+
+    bool mosiBit = mosi.bit >= 0 && mosi.levelAt(edge.time, mosiCursor);
+    bool misoBit = miso.bit >= 0 && miso.levelAt(edge.time, misoCursor);
+    if (spi.bitCount == 0) {
+      spi.wordStart = edge.time;
+      spi.mosi = 0;
+      spi.miso = 0;
+    }
+    if (settings.lsbFirst) {
+      spi.mosi |= (quint32)mosiBit << spi.bitCount;
+      spi.miso |= (quint32)misoBit << spi.bitCount;
+    } else {
+      spi.mosi = (spi.mosi << 1) | mosiBit;
+      spi.miso = (spi.miso << 1) | misoBit;
+    }
+    if (++spi.bitCount == 8) {
+      DecodedWord word;
+      word.start = spi.wordStart;
+      word.end = edge.time;
+      word.value = spi.mosi;
+      word.secondValue = spi.miso;
+      word.hasSecondValue = miso.bit >= 0;
+      output.append(word);
+      spi.bitCount = 0;
+    }
+  }
+
+  // Všechny hrany hodin jsou zpracované, z ostatních linek se zahodí vše do poslední z nich
+  if (!clk.edges.isEmpty()) {
+    double processed = clk.edges.last().time;
+    mosi.levelAt(processed, mosiCursor);
+    miso.levelAt(processed, misoCursor);
+    cs.levelAt(processed, csCursor);
+  }
+  clk.consumed = clk.edges.size();
+  mosi.consumed = mosiCursor;
+  miso.consumed = misoCursor;
+  cs.consumed = csCursor;
+  for (int l = 0; l < 4; l++)
+    lines[l].dropConsumed();
+}
+
+void ProtocolDecoder::decodeI2c() {
+  Line &scl = lines[0];
+  Line &sda = lines[1];
+  int a = scl.consumed, b = sda.consumed;
+  bool sclLevel = (a == 0) ? scl.levelBefore : scl.edges.at(a - 1).level;
+  bool sdaLevel = (b == 0) ? sda.levelBefore : sda.edges.at(b - 1).level;
+
+  // Hrany obou linek se zpracují v časovém pořadí (při shodě nejdřív SCL)
+  while (a < scl.edges.size() || b < sda.edges.size()) {
+    bool takeScl = b >= sda.edges.size() || (a < scl.edges.size() && scl.edges.at(a).time <= sda.edges.at(b).time);
+    if (!takeScl) {
+      const Edge &edge = sda.edges.at(b++);
+      sdaLevel = edge.level;
+      if (!sclLevel)
+        continue;
+      // Změna SDA při SCL v 1 je start (sestupná) nebo stop (vzestupná)
+      DecodedWord marker;
+      marker.start = marker.end = edge.time;
+      marker.flags = edge.level ? DecodedWord::stopCondition : DecodedWord::startCondition;
+      output.append(marker);
+      i2c.active = !edge.level;
+      i2c.expectAddress = true;
+      i2c.bitCount = 0;
+      i2c.value = 0;
+      continue;
+    }
+
+    const Edge &edge = scl.edges.at(a++);
+    sclLevel = edge.level;
+    if (!edge.level || !i2c.active)
+      continue;
+    if (i2c.bitCount < 8) {
+      if (i2c.bitCount == 0)
+        i2c.wordStart = edge.time;
+      i2c.value = (i2c.value << 1) | sdaLevel;
+      i2c.bitCount++;
+    } else {
+      // Devátý bit je ACK (0) / NACK (1)
+      DecodedWord word;
+      word.start = i2c.wordStart;
+      word.end = edge.time;
+      word.value = i2c.value;
+      if (sdaLevel)
+        word.flags |= DecodedWord::nack;
+      if (i2c.expectAddress) {
+        word.flags |= DecodedWord::address;
+        if (i2c.value & 1u)
+          word.flags |= DecodedWord::read;
+      }
+      output.append(word);
+      i2c.expectAddress = false;
+      i2c.bitCount = 0;
+      i2c.value = 0;
+    }
+  }
+  scl.consumed = a;
+  sda.consumed = b;
+  scl.dropConsumed();
+  sda.dropConsumed();
+}
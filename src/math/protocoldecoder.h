@@ -0,0 +1,118 @@
+//  Copyright (C) 2020-2024  Jiří Maier
+
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef PROTOCOLDECODER_H
+#define PROTOCOLDECODER_H
+
+#include <QObject>
+#include <QVector>
+#include "global.h"
+
+struct DecoderSettings {
+  DecoderProtocol::enumDecoderProtocol protocol = DecoderProtocol::off;
+  /// Logická skupina (0 až LOGIC_GROUPS - 1)
+  int group = LOGIC_GROUPS - 1;
+  // UART
+  int uartBit = 0;
+  double baud = 115200;
+  int dataBits = 8;
+  int parity = 0; ///< 0 žádná, 1 lichá, 2 sudá
+  bool uartInverted = false;
+  // SPI (-1 = nepoužito)
+  int clkBit = 0, mosiBit = 1, misoBit = -1, csBit = -1;
+  int spiMode = 0;
+  bool lsbFirst = false;
+  // I2C
+  int sclBit = 0, sdaBit = 1;
+};
+
+struct DecodedWord {
+  enum Flag { parityError = 1, framingError = 2, address = 4, read = 8, nack = 16, startCondition = 32, stopCondition = 64 };
+  double start = 0, end = 0;
+  quint32 value = 0;
+  /// MISO u SPI
+  quint32 secondValue = 0;
+  bool hasSecondValue = false;
+  int flags = 0;
+  /// Text pro popisek v grafu a tabulku
+  QString text() const;
+  QString info() const;
+};
+
+/// Dekodér sériových sběrnic z logických kanálů.
+/// Data (časy a slova se všemi bity) se zpracovávají průběžně, jak přichází. Z každého bloku se pro použité bity
+/// složí bitové pole po 64 vzorcích a hrany se najdou přes xor s posunutým polem a počítání nul (ctz),
+/// samotné dekodéry pak pracují jen se seznamem hran.
+class ProtocolDecoder : public QObject {
+  Q_OBJECT
+public:
+  explicit ProtocolDecoder(QObject *parent = nullptr);
+
+private:
+  struct Edge {
+    double time;
+    bool level;
+  };
+  /// Hrany jedné linky, které ještě nebyly zpracovány, a úroveň před první z nich
+  struct Line {
+    int bit = -1;
+    QVector<Edge> edges;
+    bool levelBefore = true;
+    int consumed = 0;
+    bool levelAt(double time, int &cursor) const;
+    void dropConsumed();
+  };
+
+  DecoderSettings settings;
+  Line lines[4];
+  double lastTime = 0;
+  bool hasLastWord = false;
+  quint32 lastWord = 0;
+  QVector<quint64> bitsBuffer;
+
+  /// Rozpracovaný stav dekodérů mezi bloky
+  struct {
+    int bitCount = 0;
+    quint32 mosi = 0, miso = 0;
+    double wordStart = 0;
+  } spi;
+  struct {
+    bool active = false;
+    int bitCount = 0;
+    quint32 value = 0;
+    bool expectAddress = false;
+    double wordStart = 0;
+  } i2c;
+
+  QVector<DecodedWord> output;
+
+  void decodeUart();
+  void decodeSpi();
+  void decodeI2c();
+  void process(int group, const double *times, const quint32 *words, int count, bool continuous);
+
+public slots:
+  void setSettings(DecoderSettings settings);
+  void reset();
+  /// continuous = body (navazují na předchozí data), jinak jde o celý nový průběh
+  void newLogicData(int group, QVector<double> times, QVector<quint32> words, bool continuous) { process(group, times.constData(), words.constData(), qMin(times.size(), words.size()), continuous); }
+  void newLogicWord(int group, double time, quint32 word) { process(group, &time, &word, 1, true); }
+
+signals:
+  /// Dekódovaná slova, clear = předchozí slova patří ke starému průběhu
+  void decoded(int group, QVector<DecodedWord> words, bool clear);
+};
+
+#endif // PROTOCOLDECODER_H
@@ -0,0 +1,33 @@
+//  Copyright (C) 2020-2024  Jiří Maier
+
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "resampler.h"
+#include <QtMath>
+
+double Resampler::bandLimitedAt(const QCPGraphData *data, int count, int index, double time) {
+  // Lanczos a = 4, vzdálenost v násobcích periody v místě interpolace
+  const int lobes = 4;
+  double period = data[index + 1].key - data[index].key;
+  double x = (time - data[index].key) / period;
+  double sum = 0, weights = 0;
+  for (int k = 1 - lobes; k <= lobes; k++) {
+    int sample = qBound(0, index + k, count - 1);
+    double u = (x - k) * M_PI;
+    double weight = (qAbs(u) < 1e-9) ? 1.0 : lobes * qSin(u) * qSin(u / lobes) / (u * u);
+    sum += data[sample].value * weight;
+    weights += weight;
+  }
+  return sum / weights;
+}
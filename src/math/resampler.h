@@ -0,0 +1,118 @@
+//  Copyright (C) 2020-2024  Jiří Maier
+
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef RESAMPLER_H
+#define RESAMPLER_H
+
+#include "plots/qcustomplot.h"
+#include "utils.h"
+
+/// Zarovnání dvou kanálů na společnou časovou osu.
+/// Obě časové osy se projdou jedním sloučením (jako merge sort), výsledkem je každý čas z obou kanálů
+/// v jejich společném rozsahu, hodnota druhého kanálu se v tom čase dopočítá interpolací.
+/// Výstup se předává rovnou volajícímu, nic se mezi tím nekopíruje.
+class Resampler {
+public:
+  /// Projde kanály a pro každý společný čas zavolá output(time, valueA, valueB), vrací počet výstupních vzorků
+  template <typename Output> static int merge(const QCPGraphData *a, int countA, const QCPGraphData *b, int countB, Resampling::enumResampling method, Output output) {
+    if (method == Resampling::bandLimited)
+      return mergeWith<Resampling::bandLimited>(a, countA, b, countB, output);
+    return mergeWith<Resampling::linear>(a, countA, b, countB, output);
+  }
+
+  /// Převzorkuje data na časy z keys (jeden průchod), mimo rozsah dat drží krajní hodnotu
+  static void resampleOnto(const QCPGraphData *data, int count, const QCPGraphData *keys, int keyCount, Resampling::enumResampling method, QCPGraphData *output) {
+    if (method == Resampling::bandLimited)
+      resampleOntoWith<Resampling::bandLimited>(data, count, keys, keyCount, output);
+    else
+      resampleOntoWith<Resampling::linear>(data, count, keys, keyCount, output);
+  }
+
+  /// Horní odhad počtu výstupních vzorků
+  static int maxOutputCount(int countA, int countB) { return countA + countB; }
+
+  /// Hodnota v čase time, data[index].key <= time < data[index + 1].key
+  static inline double linearAt(const QCPGraphData *data, int index, double time) {
+    const QCPGraphData &left = data[index];
+    const QCPGraphData &right = data[index + 1];
+    return left.value + (right.value - left.value) * (time - left.key) / (right.key - left.key);
+  }
+
+  /// Hodnota v čase time pomocí Lanczosova jádra (předpokládá přibližně rovnoměrné vzorkování)
+  static double bandLimitedAt(const QCPGraphData *data, int count, int index, double time);
+
+private:
+  template <Resampling::enumResampling method> static inline double valueAt(const QCPGraphData *data, int count, int index, double time) {
+    if (method == Resampling::bandLimited)
+      return bandLimitedAt(data, count, index, time);
+    return linearAt(data, index, time);
+  }
+
+  template <Resampling::enumResampling method> static void resampleOntoWith(const QCPGraphData *data, int count, const QCPGraphData *keys, int keyCount, QCPGraphData *output) {
+    int j = 0;
+    for (int i = 0; i < keyCount; i++) {
+      double time = keys[i].key;
+      while (j < count && data[j].key < time)
+        j++;
+      double value;
+      if (count == 0)
+        value = qQNaN();
+      else if (j == count)
+        value = data[count - 1].value;
+      else if (j == 0 || data[j].key == time)
+        value = data[j].value;
+      else
+        value = valueAt<method>(data, count, j - 1, time);
+      output[i] = QCPGraphData(time, value);
+    }
+  }
+
+  template <Resampling::enumResampling method, typename Output> static int mergeWith(const QCPGraphData *a, int countA, const QCPGraphData *b, int countB, Output &output) {
+    if (countA == 0 || countB == 0)
+      return 0;
+    double start = qMax(a[0].key, b[0].key);
+    double end = qMin(a[countA - 1].key, b[countB - 1].key);
+    if (start > end)
+      return 0;
+
+    int i = 0, j = 0, written = 0;
+    while (i < countA && a[i].key < start)
+      i++;
+    while (j < countB && b[j].key < start)
+      j++;
+    // Vzorek před aktuálním indexem má vždy menší čas, takže interpolace má levý bod
+    while (i < countA && j < countB) {
+      double timeA = a[i].key;
+      double timeB = b[j].key;
+      if (timeA > end && timeB > end)
+        break;
+      if (timeA == timeB) {
+        output(timeA, a[i].value, b[j].value);
+        i++;
+        j++;
+      } else if (timeA < timeB) {
+        output(timeA, a[i].value, valueAt<method>(b, countB, j - 1, timeA));
+        i++;
+      } else {
+        output(timeB, valueAt<method>(a, countA, i - 1, timeB), b[j].value);
+        j++;
+      }
+      written++;
+    }
+    return written;
+  }
+};
+
+#endif // RESAMPLER_H
@@ -14,8 +14,24 @@
 //  along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include "signalprocessing.h"
-
-SignalProcessing::SignalProcessing(QObject *parent) : QObject(parent) {}
+#include "math/resampler.h"
+#include "math/taskpool.h"
+#include "traceevents.h"
+
+/// Nejkratší interval posílání statistiky (ms)
+#define STATISTICS_UPDATE_INTERVAL 200
+
+SignalProcessing::SignalProcessing(QObject *parent) : QObject(parent), statisticsFlushTimer(this) {
+  statisticsFlushTimer.setSingleShot(true);
+  statisticsFlushTimer.setInterval(STATISTICS_UPDATE_INTERVAL);
+  // Statistika se mění jen v řadě úloh objektu, odeslání se proto zařadí tam
+  connect(&statisticsFlushTimer, &QTimer::timeout, this, [this]() {
+    if (TaskStrand *strand = TaskPool::strandOf(this))
+      strand->post([this]() { flushStatistics(); });
+    else
+      flushStatistics();
+  });
+}
 
 void SignalProcessing::resizeHamming(int length) {
   if (hamming.size() != length) {
@@ -43,53 +59,60 @@ void SignalProcessing::resizeBlackman(int length) {
 
 QVector<std::complex<double>> SignalProcessing::fft(QVector<std::complex<double>> x) {
   int N = x.size(); // Velikost x musí být mocnina 2.
-
-  if (N == 1)
-    return x; // Konec rekurze
-
-  QVector<std::complex<double>> Pe, Po; // Sudé a liché koeficienty
-  for (int n = 1; n < N; n += 2) {
-    Pe.append(x.at(n - 1)); // Sudé
-    Po.append(x.at(n));     // Liché
+  if (N <= 1)
+    return x;
+
+  // Iterativní radix-2 (stejný výsledek jako rekurzivní dělení na sudé a liché), vstup se přeuspořádá bitovou reverzí
+  std::complex<double> *X = x.data();
+  for (int i = 1, j = 0; i < N; i++) {
+    int bit = N >> 1;
+    for (; j & bit; bit >>= 1)
+      j ^= bit;
+    j ^= bit;
+    if (i < j)
+      std::swap(X[i], X[j]);
   }
 
-  QVector<std::complex<double>> Xe = fft(Pe), Xo = fft(Po); // Rekurze
-
-  QVector<std::complex<double>> X;
-  X.resize(N);
-  for (int k = 0; k < N / 2; k++) {
-
-    // exp(i*2*Pi*k/N)
-    double arg = M_PI * 2 * k / N;
-    std::complex<double> WNk(cos(arg), sin(arg));
+  // exp(i*2*Pi*k/N), tabulka se počítá jen při změně délky
+  if (twiddles.size() != N / 2) {
+    twiddles.resize(N / 2);
+    for (int k = 0; k < N / 2; k++)
+      twiddles[k] = std::complex<double>(cos(M_PI * 2 * k / N), sin(M_PI * 2 * k / N));
+  }
 
-    X[k] = Xe[k] + WNk * Xo[k];
-    X[k + N / 2] = Xe[k] - WNk * Xo[k];
+  for (int length = 2; length <= N; length <<= 1) {
+    int half = length / 2;
+    int stride = N / length;
+    for (int start = 0; start < N; start += length) {
+      for (int k = 0; k < half; k++) {
+        std::complex<double> odd = twiddles.at(k * stride) * X[start + k + half];
+        X[start + k + half] = X[start + k] - odd;
+        X[start + k] += odd;
+      }
+    }
   }
-  return X;
+  return x;
 }
 
-void SignalProcessing::getFFTPlot(QSharedPointer<QCPGraphDataContainer> data, FFTType::enumFFTType type, FFTWindow::enumFFTWindow window, bool removeDC, int segmentCount, bool twosided, bool zerocenter, int minNFFT) {
+void SignalProcessing::getFFTPlot(ChannelSnapshot data, FFTType::enumFFTType type, FFTWindow::enumFFTWindow window, bool removeDC, int segmentCount, bool twosided, bool zerocenter, int minNFFT) {
+  TRACE_SCOPE("analysis", "SignalProcessing::getFFTPlot");
+  // Stejnosměrná složka (data jsou sdílená s grafem, odečítá se až při převodu na komplexní hodnoty)
+  double dc = 0;
   if (removeDC) {
-    // Stejnosměrná složka
-    double dc = 0;
-    for (QCPGraphDataContainer::iterator it = data->begin(); it != data->end(); it++)
+    for (const QCPGraphData *it = data.constBegin(); it != data.constEnd(); it++)
       dc += it->value;
-    dc /= data->size();
-
-    // Odstranění stejnosměrné složky
-    for (QCPGraphDataContainer::iterator it = data->begin(); it != data->end(); it++)
-      it->value -= dc;
+    dc /= data.size();
   }
 
-  double fs = data->size() / (data->at(data->size() - 1)->key - data->at(0)->key);
+  double fs = data.size() / (data.back().key - data.front().key);
 
   if (type == FFTType::spectrum || type == FFTType::periodogram) {
     QVector<std::complex<double>> values;
-    for (int i = 0; i < data->size(); i++)
-      values.append(std::complex<double>(data->at(i)->value, 0));
+    values.reserve(data.size());
+    for (int i = 0; i < data.size(); i++)
+      values.append(std::complex<double>(data.at(i).value - dc, 0));
 
-    double normalization = data->size();
+    double normalization = data.size();
     if (window == FFTWindow::hamming)
       normalization *= 0.54;
     else if (window == FFTWindow::hann)
@@ -123,7 +146,7 @@ void SignalProcessing::getFFTPlot(QSharedPointer<QCPGraphDataContainer> data, FF
 
     // Rozdělení na segmenty s 50% překryvem
     //  Kolik půl-segmentů se vejde?
-    int halfSegmentLength = data->size() / segmentCount;
+    int halfSegmentLength = data.size() / segmentCount;
     // Pokud je počet půlsegmentů sudý, poslední překryvný se nevejde, bude o jeden méně, než se chtělo
     // |___ ___ ___ ___ ___ _|
     // |  ___ ___ ___ ___ ___|
@@ -132,7 +155,7 @@ void SignalProcessing::getFFTPlot(QSharedPointer<QCPGraphDataContainer> data, FF
     // |___ ___ ___ ___ ___|
     // |  ___ ___ ___ ___   |
     // V horní řadě je 5 celých segmentů (sudý počet půlsegmentů), do spodní se vejde je 4
-    if ((data->size() / halfSegmentLength) % 2 == 0)
+    if ((data.size() / halfSegmentLength) % 2 == 0)
       segmentCount--;
 
     // Rozdělení na segmenty
@@ -140,7 +163,7 @@ void SignalProcessing::getFFTPlot(QSharedPointer<QCPGraphDataContainer> data, FF
     segments.resize(segmentCount);
     for (int i = 0; i < segments.size(); i++) {
       for (int j = i * halfSegmentLength; j < (i + 2) * halfSegmentLength; j++)
-        segments[i].append(std::complex<double>(data->at(j)->value, 0));
+        segments[i].append(std::complex<double>(data.at(j).value - dc, 0));
     }
 
     double normalization = 2 * halfSegmentLength;
@@ -154,9 +177,13 @@ void SignalProcessing::getFFTPlot(QSharedPointer<QCPGraphDataContainer> data, FF
 
     // Výpočet spektra pro jednotlivé segmenty
     // Funkce calculateSpectrum použije okno a doplní nulami na mocninu dvou
-    for (int i = 0; i < segments.size(); i++) {
-      segments[i] = calculateSpectrum(segments.at(i), window, minNFFT);
-    }
+    // První segment se spočítá samostatně (připraví tabulky okna a FFT), ostatní se s hotovými tabulkami počítají na všech jádrech
+    segments[0] = calculateSpectrum(segments.at(0), window, minNFFT);
+    QVector<std::complex<double>> *segmentData = segments.data();
+    TaskPool::parallelFor(segments.size() - 1, qMax(1, 16384 / (2 * halfSegmentLength)), [&](int from, int to) {
+      for (int i = from + 1; i <= to; i++)
+        segmentData[i] = calculateSpectrum(segmentData[i], window, minNFFT);
+    });
 
     int nfft = segments.at(0).length();
 
@@ -201,59 +228,236 @@ QVector<std::complex<double>> SignalProcessing::calculateSpectrum(QVector<std::c
   return fft(data);
 }
 
-void SignalProcessing::process(QSharedPointer<QCPGraphDataContainer> data) {
-  bool rangefound = false; // Nevyužité, ale je potřeba do funkcí co hledají max/min
-  auto valRange = data->valueRange(rangefound);
+void SignalProcessing::process(ChannelSnapshot data) {
+  TRACE_SCOPE("analysis", "SignalProcessing::process");
+  double values[MeasurementStatistics::measurementCount];
+  int samples = measure(data, values);
+  emit result(values[MeasurementStatistics::period], values[MeasurementStatistics::frequency], values[MeasurementStatistics::amplitude], values[MeasurementStatistics::minimum], values[MeasurementStatistics::maximum], values[MeasurementStatistics::rms], values[MeasurementStatistics::dc],
+              values[MeasurementStatistics::samplingRate], values[MeasurementStatistics::rise], values[MeasurementStatistics::fall], samples);
+}
+
+void SignalProcessing::setStatisticsChannel(int chID) {
+  statisticsChID = chID;
+  resetStatistics();
+}
+
+void SignalProcessing::setHistogramSource(int source) {
+  statistics.setHistogramSource(source);
+  emit statisticsResult(statistics);
+}
+
+void SignalProcessing::resetStatistics() {
+  statistics.reset();
+  statisticsTimer.start();
+  statisticsPending = false;
+  emit statisticsResult(statistics);
+}
+
+void SignalProcessing::accumulate(int chID, QSharedPointer<QCPGraphDataContainer> data) {
+  if (chID != statisticsChID || data->size() < 2)
+    return;
+  double values[MeasurementStatistics::measurementCount];
+  measure(ChannelSnapshot(data), values);
+  statistics.addAcquisition(values, *data);
+
+  // Průběhů může být tisíce za sekundu, výsledek se posílá jen občas a vynechané průběhy dorazí s odloženým posláním
+  if (statisticsTimer.elapsed() >= STATISTICS_UPDATE_INTERVAL) {
+    statisticsTimer.start();
+    statisticsPending = false;
+    emit statisticsResult(statistics);
+  } else if (!statisticsPending) {
+    statisticsPending = true;
+    QMetaObject::invokeMethod(&statisticsFlushTimer, "start", Qt::QueuedConnection);
+  }
+}
+
+void SignalProcessing::flushStatistics() {
+  if (!statisticsPending)
+    return;
+  statisticsPending = false;
+  statisticsTimer.start();
+  emit statisticsResult(statistics);
+}
+
+void SignalProcessing::correlate(ChannelSnapshot first, ChannelSnapshot second) {
+  TRACE_SCOPE("analysis", "SignalProcessing::correlate");
+  if (first.size() < 4 || second.size() < 4) {
+    emit correlationResult(0, 0, 0, 0, 0);
+    return;
+  }
+
+  // Společná rovnoměrná časová osa v překryvu obou kanálů, krok podle hustěji vzorkovaného kanálu
+  double start = qMax(first.front().key, second.front().key);
+  double end = qMin(first.back().key, second.back().key);
+  double step = qMin((first.back().key - first.front().key) / (first.size() - 1), (second.back().key - second.front().key) / (second.size() - 1));
+  if (!(end > start) || !(step > 0)) {
+    emit correlationResult(0, 0, 0, 0, 0);
+    return;
+  }
+  const int maxSamples = 1 << 20;
+  int count = (int)qMin<double>(maxSamples, floor((end - start) / step) + 1);
+  if (count < 4) {
+    emit correlationResult(0, 0, 0, 0, 0);
+    return;
+  }
+  step = (end - start) / (count - 1);
+
+  correlationGrid.resize(count);
+  correlationFirst.resize(count);
+  correlationSecond.resize(count);
+  for (int i = 0; i < count; i++)
+    correlationGrid[i].key = start + i * step;
+  Resampler::resampleOnto(first.constBegin(), first.size(), correlationGrid.constData(), count, Resampling::linear, correlationFirst.data());
+  Resampler::resampleOnto(second.constBegin(), second.size(), correlationGrid.constData(), count, Resampling::linear, correlationSecond.data());
+
+  double dcFirst = 0, dcSecond = 0;
+  for (int i = 0; i < count; i++) {
+    dcFirst += correlationFirst.at(i).value;
+    dcSecond += correlationSecond.at(i).value;
+  }
+  dcFirst /= count;
+  dcSecond /= count;
+
+  // Doplnění nulami na dvojnásobnou délku, aby se korelace nepřekrývala kruhově
+  int nfft = 1;
+  while (nfft < 2 * count)
+    nfft <<= 1;
+  QVector<std::complex<double>> spectrumFirst(nfft), spectrumSecond(nfft);
+  double energyFirst = 0, energySecond = 0;
+  for (int i = 0; i < count; i++) {
+    double a = correlationFirst.at(i).value - dcFirst;
+    double b = correlationSecond.at(i).value - dcSecond;
+    spectrumFirst[i] = a;
+    spectrumSecond[i] = b;
+    energyFirst += a * a;
+    energySecond += b * b;
+  }
+  if (energyFirst <= 0 || energySecond <= 0) {
+    emit correlationResult(0, 0, 0, 0, 0);
+    return;
+  }
+  spectrumFirst = fft(spectrumFirst);
+  spectrumSecond = fft(spectrumSecond);
+
+  // Vzájemné spektrum, jeho nejsilnější složka určuje frekvenci pro výpočet fáze
+  int strongestBin = 1;
+  double strongestPower = -1;
+  for (int k = 0; k < nfft; k++) {
+    spectrumFirst[k] = std::conj(std::conj(spectrumFirst.at(k)) * spectrumSecond.at(k));
+    if (k > 0 && k <= nfft / 2 && std::norm(spectrumFirst.at(k)) > strongestPower) {
+      strongestPower = std::norm(spectrumFirst.at(k));
+      strongestBin = k;
+    }
+  }
+
+  // Zpřesnění frekvence parabolou přes sousední složky (spektrum je díky doplnění nulami hladké)
+  double strongestFreqBin = strongestBin;
+  if (strongestBin < nfft / 2) {
+    double left = std::abs(spectrumFirst.at(strongestBin - 1));
+    double center = std::abs(spectrumFirst.at(strongestBin));
+    double right = std::abs(spectrumFirst.at(strongestBin + 1));
+    double denominator = left - 2 * center + right;
+    if (denominator < 0)
+      strongestFreqBin += qBound(-0.5, 0.5 * (left - right) / denominator, 0.5);
+  }
+
+  // Zpětná transformace (přes komplexně sdružené spektrum), korelace pro posun d je na indexu d, záporné posuny od konce
+  QVector<std::complex<double>> correlation = fft(spectrumFirst);
+  auto valueAtLag = [&](int lag) { return correlation.at(lag >= 0 ? lag : nfft + lag).real() / nfft; };
+  int bestLag = 0;
+  double bestValue = valueAtLag(0);
+  for (int lag = -(count - 1); lag < count; lag++) {
+    double value = valueAtLag(lag);
+    if (value > bestValue) {
+      bestValue = value;
+      bestLag = lag;
+    }
+  }
+
+  // Interpolace maxima parabolou přes sousední posuny
+  double fraction = 0;
+  if (bestLag > -(count - 1) && bestLag < count - 1) {
+    double left = valueAtLag(bestLag - 1);
+    double right = valueAtLag(bestLag + 1);
+    double denominator = left - 2 * bestValue + right;
+    if (denominator < 0)
+      fraction = qBound(-0.5, 0.5 * (left - right) / denominator, 0.5);
+  }
+
+  double delay = (bestLag + fraction) * step;
+  double frequency = strongestFreqBin / (nfft * step);
+  double phase = -360.0 * frequency * delay;
+  phase = fmod(phase, 360.0);
+  if (phase > 180)
+    phase -= 360;
+  else if (phase <= -180)
+    phase += 360;
+
+  emit correlationResult(delay, phase, bestValue / sqrt(energyFirst * energySecond), frequency, count);
+}
+
+int SignalProcessing::measure(ChannelSnapshot data, double values[MeasurementStatistics::measurementCount]) {
+  auto valRange = data.valueRange();
   double max = valRange.upper;
   double min = valRange.lower;
 
   double dc_full = 0;
-  for (QCPGraphDataContainer::iterator it = data->begin(); it != data->end(); it++)
+  for (const QCPGraphData *it = data.constBegin(); it != data.constEnd(); it++)
     dc_full += it->value;
-  dc_full /= data->size();
+  dc_full /= data.size();
 
-  double fs = (data->size() - 1) / (data->at(data->size() - 1)->key - data->at(0)->key);
+  double fs = (data.size() - 1) / (data.back().key - data.front().key);
 
   double freq = getStrongestFreq(data, dc_full, fs);
 
   double period = 1.0 / freq;
 
-  int samples = data->size();
+  int samples = data.size();
 
   // Remove non-integer period part from beginning of signal
-  auto keyRange = data->keyRange(rangefound);
+  auto keyRange = data.keyRange();
   double N_periods = floor(keyRange.size() / period);
   if (!qIsNull(N_periods) && !qIsInf(N_periods))
-    data->removeBefore(data->at(data->size() - 1)->key - N_periods * period);
+    data = data.sliceFrom(data.back().key - N_periods * period);
 
   // Stejnosměrná složka
   double dc = 0;
-  for (QCPGraphDataContainer::iterator it = data->begin(); it != data->end(); it++)
+  for (const QCPGraphData *it = data.constBegin(); it != data.constEnd(); it++)
     dc += it->value;
-  dc /= data->size();
+  dc /= data.size();
 
   // Efektivní hodnota
   double vrms = 0;
-  for (QCPGraphDataContainer::iterator it = data->begin(); it != data->end(); it++)
+  for (const QCPGraphData *it = data.constBegin(); it != data.constEnd(); it++)
     vrms += (it->value * it->value);
-  vrms /= data->size();
+  vrms /= data.size();
   vrms = sqrt(vrms);
 
   // Od teď se počítá jen s posledními dvěma periodami !!!
   if (N_periods > 2 && !qIsInf(N_periods))
-    data->removeBefore(data->at(data->size() - 1)->key - 2.0 * period);
+    data = data.sliceFrom(data.back().key - 2.0 * period);
 
   auto risefall = getRiseFall(data);
 
-  emit result(period, freq, (max - min), min, max, vrms, dc, fs, risefall.first, risefall.second, samples);
+  values[MeasurementStatistics::period] = period;
+  values[MeasurementStatistics::frequency] = freq;
+  values[MeasurementStatistics::amplitude] = max - min;
+  values[MeasurementStatistics::minimum] = min;
+  values[MeasurementStatistics::maximum] = max;
+  values[MeasurementStatistics::rms] = vrms;
+  values[MeasurementStatistics::dc] = dc;
+  values[MeasurementStatistics::samplingRate] = fs;
+  values[MeasurementStatistics::rise] = risefall.first;
+  values[MeasurementStatistics::fall] = risefall.second;
+  return samples;
 }
 
-double SignalProcessing::getStrongestFreq(QSharedPointer<QCPGraphDataContainer> data, double dc, double fs) {
+double SignalProcessing::getStrongestFreq(const ChannelSnapshot &data, double dc, double fs) {
 
   // Prostě udělám FFT (po odečtení DC) a najdu globální maximum
   QVector<std::complex<double>> acValues;
-  for (int i = 0; i < data->size(); i++)
-    acValues.append((data->at(i)->value - dc));
+  for (int i = 0; i < data.size(); i++)
+    acValues.append((data.at(i).value - dc));
 
   int nfft = acValues.size() * 5;
 
@@ -278,7 +482,7 @@ double SignalProcessing::getStrongestFreq(QSharedPointer<QCPGraphDataContainer>
     int aproxIndex = fs / freq;
     int aproxMin = (aproxIndex * 90) / 100;
     int aproxMax = (aproxIndex * 110) / 100;
-    acValues.resize(data->size()); // Odstranění doplněných nul
+    acValues.resize(data.size()); // Odstranění doplněných nul
 
     int N = acValues.size();
 
@@ -304,13 +508,13 @@ double SignalProcessing::getStrongestFreq(QSharedPointer<QCPGraphDataContainer>
   return (freq);
 }
 
-QPair<double, double> SignalProcessing::getRiseFall(QSharedPointer<QCPGraphDataContainer> data) {
+QPair<double, double> SignalProcessing::getRiseFall(const ChannelSnapshot &data) {
   auto risefall = QPair<double, double>(Q_QNAN, Q_QNAN);
 
   // Zde se počítá je s posledními dvěma periodami (aby se zamezil vliv náhodných špiček na min/max)
-  bool rangefound = false; // Nevyužité, ale je potřeba do funkcí co hledají max/min
-  double max = data->valueRange(rangefound).upper;
-  double min = data->valueRange(rangefound).lower;
+  auto valRange = data.valueRange();
+  double max = valRange.upper;
+  double min = valRange.lower;
 
   double top = min + 0.9 * (max - min);    // 90 %
   double bottom = min + 0.1 * (max - min); // 10 %
@@ -320,17 +524,17 @@ QPair<double, double> SignalProcessing::getRiseFall(QSharedPointer<QCPGraphDataC
 
   // postupuje se od konce - platí poslední vzestup/sestup
   // vzestup
-  for (int i = data->size() - 1; i >= 0; i--) {
-    if (data->at(i)->value >= top)
+  for (int i = data.size() - 1; i >= 0; i--) {
+    if (data.at(i).value >= top)
       riseEnd = i; // Je nad 90 %
     else if (riseEnd != -1) {
       // Konec už mám, tohle může být začátek, pokud je pod 10 %
-      if (data->at(i)->value <= bottom) {
+      if (data.at(i).value <= bottom) {
         // Je to začátek (první před koncem co je pod 10 %)
         // Aby to fungovalo i pro málo vzorků, tak to podle začátku a konce
         // nahradím přímkou a spočítám za jak dlouho naroste z min na max
-        QCPGraphData end = *data->at(riseEnd);
-        QCPGraphData begin = *data->at(i);
+        QCPGraphData end = data.at(riseEnd);
+        QCPGraphData begin = data.at(i);
         double slope = (end.value - begin.value) / (end.key - begin.key);
         risefall.first = (max - min) / slope * 0.8;
         // Risetime je definován jako čas mezi 10 % a 90 %, toto je od min do max, tedy 0 - 100 %,
@@ -341,13 +545,13 @@ QPair<double, double> SignalProcessing::getRiseFall(QSharedPointer<QCPGraphDataC
   }
 
   // Falltime, analogicky k předchozímu...
-  for (int i = data->size() - 1; i >= 0; i--) {
-    if (data->at(i)->value <= bottom)
+  for (int i = data.size() - 1; i >= 0; i--) {
+    if (data.at(i).value <= bottom)
       fallEnd = i;
     else if (fallEnd != -1) {
-      if (data->at(i)->value >= top) {
-        QCPGraphData end = *data->at(fallEnd);
-        QCPGraphData begin = *data->at(i);
+      if (data.at(i).value >= top) {
+        QCPGraphData end = data.at(fallEnd);
+        QCPGraphData begin = data.at(i);
         double slope = (end.value - begin.value) / (end.key - begin.key);
         risefall.second = (min - max) / slope * 0.8; // min a max je prohozeno, aby výsledek nebyl záporný
         break;
@@ -22,8 +22,11 @@
 #include <QObject>
 #include <complex>
 #include <QElapsedTimer>
+#include <QTimer>
 
 #include "global.h"
+#include "math/measurementstatistics.h"
+#include "plots/channelsnapshot.h"
 #include "plots/qcustomplot.h"
 
 class SignalProcessing : public QObject {
@@ -37,18 +40,43 @@ class SignalProcessing : public QObject {
   void resizeBlackman(int length);
   void calculateLookupTable(int NxK);
   QVector<double> hamming, hann, blackman;
+  QVector<std::complex<double>> twiddles;
   QVector<std::complex<double>> fft(QVector<std::complex<double>> signal);
-  inline double getStrongestFreq(QSharedPointer<QCPGraphDataContainer> data, double dc, double fs);
-  inline QPair<double, double> getRiseFall(QSharedPointer<QCPGraphDataContainer> data);
+  QVector<QCPGraphData> correlationGrid, correlationFirst, correlationSecond;
+  inline double getStrongestFreq(const ChannelSnapshot &data, double dc, double fs);
+  inline QPair<double, double> getRiseFall(const ChannelSnapshot &data);
+  /// Spočítá všechna měření (z pohledu na data se vybere celý počet period), vrací počet vzorků
+  int measure(ChannelSnapshot data, double values[MeasurementStatistics::measurementCount]);
+
+  int statisticsChID = -1;
+  MeasurementStatistics statistics;
+  QElapsedTimer statisticsTimer;
+  /// Odložené poslání statistiky, aby se zobrazily i poslední průběhy dávky (časovač žije v hlavním vlákně)
+  QTimer statisticsFlushTimer;
+  bool statisticsPending = false;
+  void flushStatistics();
 
  public slots:
-  void getFFTPlot(QSharedPointer<QCPGraphDataContainer> data, FFTType::enumFFTType type, FFTWindow::enumFFTWindow window, bool removeDC, int segmentCount, bool twosided, bool zerocenter, int minNFFT);
+  void getFFTPlot(ChannelSnapshot data, FFTType::enumFFTType type, FFTWindow::enumFFTWindow window, bool removeDC, int segmentCount, bool twosided, bool zerocenter, int minNFFT);
   QVector<std::complex<double> > calculateSpectrum(QVector<std::complex<double>> data, FFTWindow::enumFFTWindow window, int minNFFT);
-  void process(QSharedPointer<QCPGraphDataContainer> data);
+  void process(ChannelSnapshot data);
+
+  /// Kanál, jehož průběhy se započítávají do statistiky (-1 = vypnuto), změna statistiku vynuluje
+  void setStatisticsChannel(int chID);
+  void setHistogramSource(int source);
+  void resetStatistics();
+  /// Nový průběh kanálu (data se nemění, jsou sdílená s grafem)
+  void accumulate(int chID, QSharedPointer<QCPGraphDataContainer> data);
+
+  /// Zpoždění a fáze druhého kanálu proti prvnímu z maxima vzájemné korelace (počítané přes FFT)
+  void correlate(ChannelSnapshot first, ChannelSnapshot second);
 
  signals:
   void fftResult(QSharedPointer<QCPGraphDataContainer> data);
   void result(double period, double freq, double amp, double min, double max, double vrms, double dc, double fs, double rise, double fall, int samples);
+  void statisticsResult(MeasurementStatistics statistics);
+  /// delay > 0: druhý kanál je zpožděný, phase ve stupních na frekvenci frequency, samples = 0 když nelze spočítat
+  void correlationResult(double delay, double phase, double coefficient, double frequency, int samples);
 };
 
 #endif // SIGNALPROCESSING_H
@@ -0,0 +1,201 @@
+//  Copyright (C) 2020-2024  Jiří Maier
+
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "spectrogram.h"
+
+Spectrogram::Spectrogram(QObject *parent) : QObject(parent) { preparePlan(); }
+
+void Spectrogram::preparePlan() {
+  // Okno (stejné vzorce jako v SignalProcessing)
+  window.resize(nfft);
+  windowSum = 0;
+  for (int n = 0; n < nfft; n++) {
+    if (windowType == FFTWindow::hamming)
+      window[n] = 0.54 - 0.46 * cos(2 * M_PI * n / nfft);
+    else if (windowType == FFTWindow::hann)
+      window[n] = 0.5 * (1 - cos(2 * M_PI * n / nfft));
+    else if (windowType == FFTWindow::blackman)
+      window[n] = 0.42 - 0.5 * cos(2 * M_PI * n / nfft) + 0.08 * cos(4 * M_PI * n / nfft);
+    else
+      window[n] = 1;
+    windowSum += window[n];
+  }
+
+  // Bitová reverze indexů
+  int bits = 0;
+  while ((1 << bits) < nfft)
+    bits++;
+  bitReverse.resize(nfft);
+  for (int n = 0; n < nfft; n++) {
+    int reversed = 0;
+    for (int b = 0; b < bits; b++)
+      if (n & (1 << b))
+        reversed |= 1 << (bits - 1 - b);
+    bitReverse[n] = reversed;
+  }
+
+  // exp(-i*2*Pi*k/N)
+  twiddleRe.resize(nfft / 2);
+  twiddleIm.resize(nfft / 2);
+  for (int k = 0; k < nfft / 2; k++) {
+    twiddleRe[k] = cos(2 * M_PI * k / nfft);
+    twiddleIm[k] = -sin(2 * M_PI * k / nfft);
+  }
+
+  bufferRe.resize(nfft);
+  bufferIm.resize(nfft);
+  accumulated.resize(nfft / 2 + 1);
+  clearBuffers();
+}
+
+void Spectrogram::clearBuffers() {
+  pending.clear();
+  rows.clear();
+  accumulated.fill(0);
+  accumulatedFrames = 0;
+  lastPointTime = qQNaN();
+}
+
+void Spectrogram::updateFramesPerRow() {
+  // Při rychlém toku dat se více rámců zprůměruje do jednoho řádku, aby řádků nebylo víc, než graf zobrazí
+  framesPerRow = 1;
+  if (samplingPeriod > 0 && rowPeriod > 0)
+    framesPerRow = qMax(1, (int)round(rowPeriod / (samplingPeriod * hop)));
+}
+
+void Spectrogram::fftInPlace() {
+  // Iterativní radix-2 FFT, vstup už je v bitově reverzním pořadí
+  double *re = bufferRe.data();
+  double *im = bufferIm.data();
+  for (int len = 2; len <= nfft; len <<= 1) {
+    int half = len / 2;
+    int step = nfft / len;
+    for (int i = 0; i < nfft; i += len) {
+      for (int j = 0; j < half; j++) {
+        double wRe = twiddleRe.at(j * step);
+        double wIm = twiddleIm.at(j * step);
+        int a = i + j, b = i + j + half;
+        double tRe = wRe * re[b] - wIm * im[b];
+        double tIm = wRe * im[b] + wIm * re[b];
+        re[b] = re[a] - tRe;
+        im[b] = im[a] - tIm;
+        re[a] += tRe;
+        im[a] += tIm;
+      }
+    }
+  }
+}
+
+void Spectrogram::processPending() {
+  const int binCount = nfft / 2 + 1;
+  int frameStart = 0;
+  while (pending.size() - frameStart >= nfft) {
+    const double *in = pending.constData() + frameStart;
+    for (int n = 0; n < nfft; n++) {
+      bufferRe[bitReverse.at(n)] = in[n] * window.at(n);
+      bufferIm[bitReverse.at(n)] = 0;
+    }
+    fftInPlace();
+    for (int k = 0; k < binCount; k++)
+      accumulated[k] += bufferRe.at(k) * bufferRe.at(k) + bufferIm.at(k) * bufferIm.at(k);
+    accumulatedFrames++;
+    frameStart += hop;
+
+    if (accumulatedFrames >= framesPerRow) {
+      // Normalizace stejná jako u periodogramu v SignalProcessing
+      double normalization = 1.0 / (accumulatedFrames * windowSum * windowSum);
+      int offset = rows.size();
+      rows.resize(offset + binCount);
+      for (int k = 0; k < binCount; k++)
+        rows[offset + k] = 10 * log10(accumulated.at(k) * normalization + 1e-30);
+      accumulated.fill(0);
+      accumulatedFrames = 0;
+    }
+  }
+  if (frameStart > 0)
+    pending.remove(0, frameStart);
+
+  if (!rows.isEmpty()) {
+    emit newRows(rows, binCount, 1.0 / (samplingPeriod * nfft), samplingPeriod * hop * framesPerRow);
+    rows.clear();
+  }
+}
+
+void Spectrogram::setSource(int chID) {
+  sourceChID = chID;
+  samplingPeriod = 0;
+  clearBuffers();
+}
+
+void Spectrogram::setSettings(int nfft, int overlapPercent, FFTWindow::enumFFTWindow fftWindow, double rowPeriod) {
+  nfft = nextPow2(qMax(nfft, 16));
+  overlapPercent = qBound(0, overlapPercent, 95);
+  this->hop = qMax(1, nfft * (100 - overlapPercent) / 100);
+  this->rowPeriod = rowPeriod;
+  if (nfft != this->nfft || fftWindow != windowType) {
+    this->nfft = nfft;
+    windowType = fftWindow;
+    preparePlan();
+  }
+  updateFramesPerRow();
+}
+
+void Spectrogram::reset() { clearBuffers(); }
+
+void Spectrogram::newDataVector(int chID, double timeStep, QSharedPointer<QCPGraphDataContainer> data) {
+  if (chID != sourceChID || timeStep <= 0)
+    return;
+
+  // Změna vzorkovací periody - navazující rámce by neměly smysl
+  if (timeStep != samplingPeriod) {
+    clearBuffers();
+    samplingPeriod = timeStep;
+    updateFramesPerRow();
+  }
+
+  int offset = pending.size();
+  pending.resize(offset + data->size());
+  double *out = pending.data() + offset;
+  for (auto it = data->constBegin(); it != data->constEnd(); it++)
+    *out++ = it->value;
+
+  processPending();
+}
+
+void Spectrogram::newDataPoint(int chID, double time, double value) {
+  if (chID != sourceChID)
+    return;
+
+  if (qIsNaN(lastPointTime) || time <= lastPointTime) {
+    // První bod, nebo čas šel zpět (nový záznam)
+    clearBuffers();
+  } else {
+    double step = time - lastPointTime;
+    if (samplingPeriod <= 0 || step > 2 * samplingPeriod || step < 0.5 * samplingPeriod) {
+      // Vzorkovací perioda se výrazně změnila, začne znovu
+      clearBuffers();
+      samplingPeriod = step;
+      updateFramesPerRow();
+    } else {
+      // Body s časem od "-auto" mají jitter, perioda se jen pomalu dolaďuje
+      samplingPeriod += (step - samplingPeriod) * 0.01;
+    }
+  }
+  lastPointTime = time;
+  pending.append(value);
+
+  if (samplingPeriod > 0 && pending.size() >= nfft)
+    processPending();
+}
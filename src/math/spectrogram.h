@@ -0,0 +1,79 @@
+//  Copyright (C) 2020-2024  Jiří Maier
+
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef SPECTROGRAM_H
+#define SPECTROGRAM_H
+
+#include <QObject>
+#include <QVector>
+#include <QtMath>
+
+#include "global.h"
+#include "plots/qcustomplot.h"
+
+/// Průběžný výpočet STFT pro spektrogram
+/// Data přichází po částech (kanály i body), zpracovávají se rámce o délce nfft posunuté o hop vzorků.
+/// Okno a tabulky FFT (twiddle faktory, bitová reverze) se počítají jen při změně nastavení.
+class Spectrogram : public QObject {
+  Q_OBJECT
+public:
+  explicit Spectrogram(QObject *parent = nullptr);
+
+private:
+  int sourceChID = -1;
+  int nfft = 1024;
+  int hop = 256;
+  FFTWindow::enumFFTWindow windowType = FFTWindow::hann;
+  double rowPeriod = 0;
+
+  // Plán FFT
+  QVector<double> window;
+  double windowSum = 1;
+  QVector<int> bitReverse;
+  QVector<double> twiddleRe, twiddleIm;
+  QVector<double> bufferRe, bufferIm;
+
+  // Vzorky, které ještě nebyly použity v celém rámci
+  QVector<double> pending;
+  double samplingPeriod = 0;
+  double lastPointTime = qQNaN();
+
+  // Rámce sčítané do jednoho řádku
+  QVector<double> accumulated;
+  int accumulatedFrames = 0;
+  int framesPerRow = 1;
+  QVector<double> rows;
+
+  void preparePlan();
+  void clearBuffers();
+  void updateFramesPerRow();
+  void fftInPlace();
+  void processPending();
+
+public slots:
+  /// Nastaví zdrojový kanál, -1 vypne výpočet
+  void setSource(int chID);
+  /// Nastaví délku FFT, překryv rámců (v procentech), okno a časovou délku jednoho řádku
+  void setSettings(int nfft, int overlapPercent, FFTWindow::enumFFTWindow fftWindow, double rowPeriod);
+  void reset();
+  void newDataVector(int chID, double timeStep, QSharedPointer<QCPGraphDataContainer> data);
+  void newDataPoint(int chID, double time, double value);
+
+signals:
+  /// Nové řádky spektrogramu (výkon v dB), binCount hodnot na řádek, řádky za sebou
+  void newRows(QVector<double> rows, int binCount, double binWidth, double rowPeriod);
+};
+
+#endif // SPECTROGRAM_H
@@ -0,0 +1,201 @@
+//  Copyright (C) 2020-2024  Jiří Maier
+
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "taskpool.h"
+#include "metrics.h"
+
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QRunnable>
+#include <QSharedPointer>
+#include <QThread>
+#include <QWaitCondition>
+
+QHash<const QObject *, TaskStrand *> TaskPool::strands;
+QAtomicInt TaskPool::nextConnectionID{0};
+
+namespace {
+class FunctionRunnable : public QRunnable {
+public:
+  explicit FunctionRunnable(std::function<void()> function) : function(std::move(function)) {}
+  void run() override { function(); }
+
+private:
+  std::function<void()> function;
+};
+
+struct ParallelForState {
+  const std::function<void(int, int)> *body;
+  int count, chunkSize, chunks;
+  QAtomicInt next{0};
+  QMutex mutex;
+  QWaitCondition finished;
+  int done = 0;
+
+  /// Zpracovává bloky, dokud nějaké zbývají (bloky si bere i vlákno, které by jinak čekalo)
+  void work() {
+    int processed = 0;
+    for (int chunk = next.fetchAndAddRelaxed(1); chunk < chunks; chunk = next.fetchAndAddRelaxed(1)) {
+      (*body)(chunk * chunkSize, qMin(count, (chunk + 1) * chunkSize));
+      processed++;
+    }
+    if (processed == 0)
+      return;
+    QMutexLocker locker(&mutex);
+    done += processed;
+    if (done == chunks)
+      finished.wakeAll();
+  }
+};
+} // namespace
+
+QThreadPool *TaskPool::pool() {
+  static QThreadPool *threadPool = [] {
+    QThreadPool *newPool = new QThreadPool();
+    newPool->setMaxThreadCount(qMax(2, QThread::idealThreadCount()));
+    newPool->setExpiryTimeout(-1); // Vlákna zůstávají připravená, úloh je hodně a krátkých
+    return newPool;
+  }();
+  return threadPool;
+}
+
+void TaskPool::start(std::function<void()> task, int priority) { pool()->start(new FunctionRunnable(std::move(task)), priority); }
+
+void TaskPool::attach(QObject *worker, Priority priority) {
+  if (!strands.contains(worker))
+    strands.insert(worker, new TaskStrand(priority));
+}
+
+TaskStrand *TaskPool::strandOf(const QObject *worker) { return strands.value(worker, nullptr); }
+
+int TaskPool::droppedTasks() {
+  int count = 0;
+  for (const TaskStrand *strand : qAsConst(strands))
+    count += strand->dropped();
+  return count;
+}
+
+int TaskPool::pendingTasks() {
+  int count = 0;
+  for (TaskStrand *strand : qAsConst(strands))
+    count += strand->pending();
+  return count;
+}
+
+void TaskPool::parallelFor(int count, int minChunk, const std::function<void(int, int)> &body) {
+  if (count <= 0)
+    return;
+  int threads = pool()->maxThreadCount();
+  // Víc bloků než vláken, aby se práce rozdělila rovnoměrně i když některé vlákno začne později
+  int chunks = qBound(1, count / qMax(1, minChunk), threads * 4);
+  if (chunks == 1) {
+    body(0, count);
+    return;
+  }
+
+  auto state = QSharedPointer<ParallelForState>::create();
+  state->body = &body;
+  state->count = count;
+  state->chunkSize = (count + chunks - 1) / chunks;
+  state->chunks = (count + state->chunkSize - 1) / state->chunkSize;
+
+  // Pomocníci, kteří se dostanou ke slovu až po dokončení všech bloků, nic nezpracují (body už nevolají)
+  for (int i = 1; i < qMin(threads, state->chunks); i++)
+    start([state]() { state->work(); }, high);
+  state->work();
+
+  QMutexLocker locker(&state->mutex);
+  while (state->done < state->chunks)
+    state->finished.wait(&state->mutex);
+}
+
+void TaskPool::shutdown() {
+  pool()->waitForDone();
+  qDeleteAll(strands);
+  strands.clear();
+}
+
+void TaskStrand::post(std::function<void()> task) {
+  QMutexLocker locker(&mutex);
+  tasks.enqueue({std::move(task)});
+  schedule();
+}
+
+void TaskStrand::postLatest(int connectionID, qint64 key, std::function<void()> task) {
+  QMutexLocker locker(&mutex);
+  // Starší požadavek ještě nezačal, zahodí se (fronta tak nemůže růst nad počet klíčů)
+  // Nový se zařadí na konec, aby se zachovalo pořadí vůči ostatním úlohám
+  for (int i = 0; i < tasks.size(); i++) {
+    if (tasks.at(i).connectionID == connectionID && tasks.at(i).key == key) {
+      tasks.removeAt(i);
+      droppedCount.fetchAndAddRelaxed(1);
+      Metrics::add(Metrics::workerTasksDropped);
+      break;
+    }
+  }
+  tasks.enqueue({std::move(task), connectionID, key});
+  schedule();
+}
+
+void TaskStrand::postBatched(int connectionID, int maxPending, const std::function<TaskBatch *()> &create, const std::function<void(TaskBatch *)> &append) {
+  QMutexLocker locker(&mutex);
+  // Do dávky se přidává jen dokud je poslední v řadě (a ještě nezačala), jinak by se předběhly novější úlohy
+  if (tasks.isEmpty() || tasks.last().connectionID != connectionID || tasks.last().batch.isNull()) {
+    QSharedPointer<TaskBatch> batch(create());
+    tasks.enqueue({[batch]() { batch->run(); }, connectionID, -1, batch});
+  }
+  TaskBatch *batch = tasks.last().batch.data();
+  if (batch->size() >= maxPending) {
+    // Zahlcení, zahodí se nejstarší čtvrtina dávky
+    int count = qMax(1, maxPending / 4);
+    batch->dropOldest(count);
+    droppedCount.fetchAndAddRelaxed(count);
+    Metrics::add(Metrics::workerTasksDropped, count);
+  }
+  append(batch);
+  schedule();
+}
+
+int TaskStrand::pending() {
+  QMutexLocker locker(&mutex);
+  return tasks.size();
+}
+
+void TaskStrand::schedule() {
+  if (scheduled)
+    return;
+  scheduled = true;
+  TaskPool::start([this]() { runNext(); }, priority);
+}
+
+void TaskStrand::runNext() {
+  // Čekající úlohy se zpracují jedna po druhé bez nového zařazení do fondu, dokud neuplyne časový úsek
+  QElapsedTimer busy;
+  busy.start();
+  QMutexLocker locker(&mutex);
+  do {
+    std::function<void()> task = tasks.dequeue().function;
+    locker.unlock();
+    task();
+    locker.relock();
+  } while (!tasks.isEmpty() && busy.nsecsElapsed() < timeSlice);
+  Metrics::add(Metrics::workerBusyTime, busy.nsecsElapsed());
+
+  // Po vypršení úseku se vlákno uvolní, zbytek řady se zařadí znovu (podle priority mezi ostatní)
+  if (tasks.isEmpty())
+    scheduled = false;
+  else
+    TaskPool::start([this]() { runNext(); }, priority);
+}
@@ -0,0 +1,200 @@
+//  Copyright (C) 2020-2024  Jiří Maier
+
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef TASKPOOL_H
+#define TASKPOOL_H
+
+#include <QAtomicInt>
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QQueue>
+#include <QSharedPointer>
+#include <QThreadPool>
+#include <QVector>
+#include <functional>
+#include <tuple>
+#include <type_traits>
+
+class TaskStrand;
+
+/// Sdílený fond vláken pro výpočty, počet vláken odpovídá počtu jader
+/// Výpočetní objekty (měření, FFT, interpolace, ...) nemají vlastní QThread, každý má řadu úloh (TaskStrand),
+/// jejíž úlohy běží na libovolném volném vlákně fondu. Volné vlákno si vždy vezme čekající úlohu s nejvyšší prioritou,
+/// takže zatížený objekt nezůstane čekat, zatímco jiná vlákna nic nedělají.
+class TaskPool {
+public:
+  enum Priority { low = 0, normal = 1, high = 2 };
+
+  static QThreadPool *pool();
+
+  /// Spustí úlohu na fondu
+  static void start(std::function<void()> task, int priority = normal);
+
+  /// Přiřadí objekt do fondu (místo moveToThread), jeho sloty je pak potřeba připojovat přes TaskPool::connect.
+  /// Volá se jen z hlavního vlákna při spuštění.
+  static void attach(QObject *worker, Priority priority);
+
+  /// Řada úloh objektu přiřazeného funkcí attach
+  static TaskStrand *strandOf(const QObject *worker);
+
+  /// Obdoba QObject::connect s frontovým spojením: argumenty se zkopírují a slot se zařadí do řady objektu.
+  /// Sloty jednoho objektu tak nikdy neběží současně a zachovávají pořadí.
+  template <typename Sender, typename Signal, typename Worker, typename... SlotArgs>
+  static QMetaObject::Connection connect(const Sender *sender, Signal signal, const Worker *worker, void (Worker::*slot)(SlotArgs...));
+
+  /// Jako connect, ale volání se slučují do dávky (jedna úloha řady pro mnoho bodů, jako PlotMailbox::addPoint).
+  /// Dávka má nejvýše maxPending volání, při zahlcení se zahodí nejstarší čtvrtina (počítá se jako zahozené).
+  /// Pořadí vůči ostatním úlohám řady se zachová, po jiné úloze začíná nová dávka.
+  template <typename Sender, typename Signal, typename Worker, typename... SlotArgs>
+  static QMetaObject::Connection connectBatched(const Sender *sender, Signal signal, const Worker *worker, void (Worker::*slot)(SlotArgs...), int maxPending);
+
+  /// Nejvíce čekajících bodů jedné dávky
+  static const int maxBatchedPoints = 1 << 16;
+  /// Nejvíce čekajících celých průběhů jedné dávky (zpracovávají se všechny, dokud výpočet stíhá)
+  static const int maxBatchedFrames = 64;
+
+  /// Jako connect, ale platí jen poslední volání: čeká-li v řadě ještě nezpracované volání tohoto spojení se stejným klíčem,
+  /// nahradí se novým (počítá se jako zahozené). Klíč vrací funkce key z argumentů slotu (např. číslo kanálu),
+  /// záporný klíč znamená, že se volání nenahrazuje, ale přidá do dávky s nejvýše maxBatchedPoints voláními.
+  template <typename Sender, typename Signal, typename Worker, typename... SlotArgs, typename KeyFunction>
+  static QMetaObject::Connection connectLatest(const Sender *sender, Signal signal, const Worker *worker, void (Worker::*slot)(SlotArgs...), KeyFunction key);
+  template <typename Sender, typename Signal, typename Worker, typename... SlotArgs>
+  static QMetaObject::Connection connectLatest(const Sender *sender, Signal signal, const Worker *worker, void (Worker::*slot)(SlotArgs...)) {
+    return connectLatest(sender, signal, worker, slot, [](const std::decay_t<SlotArgs> &...) { return 0; });
+  }
+
+  /// Celkový počet zahozených (nahrazených) úloh všech řad
+  static int droppedTasks();
+
+  /// Počet úloh čekajících ve všech řadách
+  static int pendingTasks();
+
+  /// Rozdělí rozsah 0 až count na bloky (alespoň minChunk prvků) a zpracuje je na všech jádrech.
+  /// Bloky si vlákna berou postupně ze sdíleného počítadla, volající vlákno počítá také, takže to funguje i když je fond plně
+  /// vytížen (i volání z úlohy fondu). Vrátí se až po zpracování celého rozsahu.
+  static void parallelFor(int count, int minChunk, const std::function<void(int begin, int end)> &body);
+
+  /// Počká na dokončení všech úloh a zruší řady, volá se při ukončení programu před smazáním objektů
+  static void shutdown();
+
+private:
+  static QHash<const QObject *, TaskStrand *> strands;
+  static QAtomicInt nextConnectionID;
+};
+
+/// Dávka volání jednoho spojení, zpracuje se jako jedna úloha řady
+class TaskBatch {
+public:
+  virtual ~TaskBatch() = default;
+  virtual int size() const = 0;
+  virtual void dropOldest(int count) = 0;
+  virtual void run() = 0;
+};
+
+/// Řada úloh jednoho objektu: úlohy se provádí postupně na vláknech fondu, nikdy dvě současně
+class TaskStrand {
+public:
+  explicit TaskStrand(int priority) : priority(priority) {}
+  void post(std::function<void()> task);
+  /// Zahodí čekající úlohu se stejným spojením a klíčem a novou zařadí na konec
+  void postLatest(int connectionID, qint64 key, std::function<void()> task);
+  /// Přidá volání do dávky spojení, pokud je poslední úlohou řady, jinak založí novou dávku (create).
+  /// Plná dávka zahodí nejstarší čtvrtinu.
+  void postBatched(int connectionID, int maxPending, const std::function<TaskBatch *()> &create, const std::function<void(TaskBatch *)> &append);
+  int dropped() const { return droppedCount.loadRelaxed(); }
+  int pending();
+
+private:
+  struct Task {
+    std::function<void()> function;
+    int connectionID = -1; ///< -1 = úloha se neslučuje
+    qint64 key = 0;
+    QSharedPointer<TaskBatch> batch; ///< Dávka, do které lze přidávat, dokud úloha čeká na konci řady
+  };
+
+  /// Nejdelší doba [ns], po kterou jedno spuštění runNext zpracovává úlohy řady, než uvolní vlákno ostatním
+  static const qint64 timeSlice = 2000000;
+
+  void schedule();
+  void runNext();
+
+  int priority;
+  QMutex mutex;
+  QQueue<Task> tasks;
+  bool scheduled = false;
+  QAtomicInt droppedCount{0};
+};
+
+template <typename Sender, typename Signal, typename Worker, typename... SlotArgs>
+QMetaObject::Connection TaskPool::connect(const Sender *sender, Signal signal, const Worker *worker, void (Worker::*slot)(SlotArgs...)) {
+  TaskStrand *strand = strandOf(worker);
+  Q_ASSERT(strand);
+  Worker *target = const_cast<Worker *>(worker); // Stejně jako QObject::connect, sloty nejsou const
+  return QObject::connect(sender, signal, [strand, target, slot](SlotArgs... args) { strand->post([=]() { (target->*slot)(args...); }); });
+}
+
+/// Dávka s argumenty volání uloženými přímo (bez samostatné alokace pro každé volání)
+template <typename Worker, typename... SlotArgs>
+class TypedTaskBatch : public TaskBatch {
+public:
+  using Arguments = std::tuple<std::decay_t<SlotArgs>...>;
+  TypedTaskBatch(Worker *target, void (Worker::*slot)(SlotArgs...)) : target(target), slot(slot) {}
+  QVector<Arguments> calls;
+  int size() const override { return calls.size(); }
+  void dropOldest(int count) override { calls.remove(0, qMin(count, calls.size())); }
+  void run() override {
+    for (const Arguments &arguments : qAsConst(calls))
+      std::apply([this](const auto &...args) { (target->*slot)(args...); }, arguments);
+  }
+
+private:
+  Worker *target;
+  void (Worker::*slot)(SlotArgs...);
+};
+
+template <typename Sender, typename Signal, typename Worker, typename... SlotArgs>
+QMetaObject::Connection TaskPool::connectBatched(const Sender *sender, Signal signal, const Worker *worker, void (Worker::*slot)(SlotArgs...), int maxPending) {
+  TaskStrand *strand = strandOf(worker);
+  Q_ASSERT(strand);
+  Worker *target = const_cast<Worker *>(worker);
+  int connectionID = nextConnectionID.fetchAndAddRelaxed(1);
+  using Batch = TypedTaskBatch<Worker, SlotArgs...>;
+  return QObject::connect(sender, signal, [strand, target, slot, connectionID, maxPending](SlotArgs... args) {
+    typename Batch::Arguments call(args...);
+    strand->postBatched(
+        connectionID, maxPending, [&]() -> TaskBatch * { return new Batch(target, slot); }, [&call](TaskBatch *batch) { static_cast<Batch *>(batch)->calls.append(std::move(call)); });
+  });
+}
+
+template <typename Sender, typename Signal, typename Worker, typename... SlotArgs, typename KeyFunction>
+QMetaObject::Connection TaskPool::connectLatest(const Sender *sender, Signal signal, const Worker *worker, void (Worker::*slot)(SlotArgs...), KeyFunction key) {
+  TaskStrand *strand = strandOf(worker);
+  Q_ASSERT(strand);
+  Worker *target = const_cast<Worker *>(worker);
+  int connectionID = nextConnectionID.fetchAndAddRelaxed(1);
+  using Batch = TypedTaskBatch<Worker, SlotArgs...>;
+  return QObject::connect(sender, signal, [strand, target, slot, connectionID, key](SlotArgs... args) {
+    qint64 taskKey = key(args...);
+    if (taskKey < 0) {
+      typename Batch::Arguments call(args...);
+      strand->postBatched(
+          connectionID, maxBatchedPoints, [&]() -> TaskBatch * { return new Batch(target, slot); }, [&call](TaskBatch *batch) { static_cast<Batch *>(batch)->calls.append(std::move(call)); });
+    } else
+      strand->postLatest(connectionID, taskKey, [=]() { (target->*slot)(args...); });
+  });
+}
+
+#endif // TASKPOOL_H
@@ -0,0 +1,238 @@
+//  Copyright (C) 2020-2024  Jiří Maier
+
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "triggerengine.h"
+#include <algorithm>
+#include <cstring>
+
+/// Počet vzorků, po kterých se spouští detektor (menší = menší zpoždění, větší = méně režie)
+static const int detectorBlock = 256;
+/// Horní mez počtu bodů v bufferu
+static const int maxSamples = 1 << 22;
+
+void TriggerEngine::configure(TriggerMode::enumTriggerMode mode, int sourceChID, double level, double width, double frameLength, double preTrigger) {
+  this->mode = mode;
+  this->sourceChID = sourceChID;
+  this->level = level;
+  this->width = width;
+  preTime = frameLength * qBound(0.0, preTrigger, 1.0);
+  postTime = frameLength - preTime;
+  reset();
+}
+
+void TriggerEngine::reset() {
+  state = armed;
+  times.clear();
+  for (int ch = 0; ch < ANALOG_COUNT; ch++)
+    channels[ch].clear();
+  source.clear();
+  usedChannels = 0;
+  start = 0;
+  scanned = 0;
+  hasLastState = false;
+  pulseStart = qQNaN();
+  timeoutFired = false;
+  frames.clear();
+}
+
+bool TriggerEngine::addPoint(double time, const double* values, quint32 present) {
+  if (!times.isEmpty() && time < times.last())
+    reset(); // Čas se vrátil, jde o nové měření
+
+  int index = times.size();
+  times.append(time);
+  for (int ch = 0; ch < ANALOG_COUNT; ch++) {
+    quint32 bit = 1u << ch;
+    if (present & bit) {
+      if (!(usedChannels & bit)) {
+        usedChannels |= bit;
+        channels[ch].fill(qQNaN(), index);
+      }
+      channels[ch].append(values[ch]);
+    } else if (usedChannels & bit) {
+      channels[ch].append(qQNaN());
+    }
+  }
+  if (present & (1u << sourceChID))
+    source.append(values[sourceChID]);
+  else
+    source.append(source.isEmpty() ? qQNaN() : source.last());
+
+  // Dokud zdrojový kanál nemá hodnotu, není co vyhodnocovat
+  if (qIsNaN(source.last())) {
+    scanned = times.size();
+    hasLastState = false;
+  }
+
+  if (state == armed) {
+    int pending = times.size() - scanned;
+    // Blok se zpracuje, když je plný, nebo když čeká déle než setinu průběhu (pomalé signály)
+    if (pending >= detectorBlock || (pending > 0 && time - times.at(scanned) >= 0.01 * (preTime + postTime))) {
+      bool fired = detect(scanned, times.size());
+      scanned = times.size();
+      if (fired)
+        state = triggered;
+    }
+  }
+
+  if (state == triggered) {
+    if (time < triggerTime + postTime) {
+      discardOld(triggerTime - preTime);
+      return false;
+    }
+    buildFrames();
+    // Vzorky během průběhu se už nevyhodnocují (holdoff), detektor začne znovu od aktuálního bodu
+    state = armed;
+    scanned = times.size();
+    hasLastState = false;
+    pulseStart = qQNaN();
+    discardOld(time - preTime);
+    return true;
+  }
+
+  discardOld(times.at(qMin(scanned, times.size() - 1)) - preTime);
+  return false;
+}
+
+QVector<QPair<int, QSharedPointer<QCPGraphDataContainer>>> TriggerEngine::takeFrames() {
+  QVector<QPair<int, QSharedPointer<QCPGraphDataContainer>>> result;
+  result.swap(frames);
+  return result;
+}
+
+double TriggerEngine::crossingTime(int index) const {
+  double t0 = times.at(index - 1), t1 = times.at(index);
+  double v0 = source.at(index - 1), v1 = source.at(index);
+  if (v1 == v0)
+    return t1;
+  return t0 + (level - v0) * (t1 - t0) / (v1 - v0);
+}
+
+bool TriggerEngine::detect(int from, int to) {
+  int count = to - from;
+  above.resize(count);
+  const double* values = source.constData() + from;
+  uchar* isAbove = above.data();
+  const double threshold = level;
+  for (int i = 0; i < count; i++)
+    isAbove[i] = values[i] > threshold;
+
+  if (!hasLastState) {
+    hasLastState = true;
+    lastAbove = isAbove[0];
+    lastTransition = times.at(from);
+    timeoutFired = false;
+  }
+
+  if (mode == TriggerMode::levelHigh || mode == TriggerMode::levelLow) {
+    const uchar* hit = (const uchar*)memchr(isAbove, mode == TriggerMode::levelHigh ? 1 : 0, count);
+    lastAbove = isAbove[count - 1];
+    if (hit == nullptr)
+      return false;
+    triggerTime = times.at(from + (hit - isAbove));
+    return true;
+  }
+
+  // Změny stavu jsou řídké, hledají se přes memchr (pole obsahuje jen 0 a 1)
+  int pos = 0;
+  forever {
+    const uchar* hit = (const uchar*)memchr(isAbove + pos, lastAbove ? 0 : 1, count - pos);
+    int k = hit ? (hit - isAbove) : count;
+    int index = from + k;
+    double time = (k < count) ? (index > start ? crossingTime(index) : times.at(index)) : times.at(to - 1);
+
+    if (mode == TriggerMode::timeout && !timeoutFired && lastTransition + width <= time) {
+      // Signál se nezměnil déle než width
+      timeoutFired = true;
+      triggerTime = lastTransition + width;
+      return true;
+    }
+    if (k == count)
+      return false;
+
+    bool rising = !lastAbove;
+    lastAbove = rising;
+    lastTransition = time;
+    timeoutFired = false;
+    pos = k + 1;
+
+    switch (mode) {
+      case TriggerMode::risingEdge:
+      case TriggerMode::fallingEdge:
+        if (rising == (mode == TriggerMode::risingEdge)) {
+          triggerTime = time;
+          return true;
+        }
+        break;
+      case TriggerMode::pulseLonger:
+      case TriggerMode::pulseShorter:
+        if (rising) {
+          pulseStart = time;
+        } else if (!qIsNaN(pulseStart)) {
+          double pulseWidth = time - pulseStart;
+          if ((mode == TriggerMode::pulseLonger) ? (pulseWidth > width) : (pulseWidth < width)) {
+            triggerTime = time;
+            return true;
+          }
+        }
+        break;
+      default:
+        break;
+    }
+  }
+}
+
+void TriggerEngine::buildFrames() {
+  frames.clear();
+  const double* t = times.constData();
+  int first = std::lower_bound(t + start, t + times.size(), triggerTime - preTime) - t;
+  int last = std::upper_bound(t + first, t + times.size(), triggerTime + postTime) - t;
+  for (int ch = 0; ch < ANALOG_COUNT; ch++) {
+    if (!(usedChannels & (1u << ch)))
+      continue;
+    const double* v = channels[ch].constData();
+    QVector<QCPGraphData> points;
+    points.reserve(last - first);
+    for (int i = first; i < last; i++)
+      if (!qIsNaN(v[i]))
+        points.append(QCPGraphData(t[i] - triggerTime, v[i]));
+    if (points.isEmpty())
+      continue;
+    auto data = QSharedPointer<QCPGraphDataContainer>(new QCPGraphDataContainer());
+    data->set(points, true);
+    frames.append(QPair<int, QSharedPointer<QCPGraphDataContainer>>(ch, data));
+  }
+}
+
+void TriggerEngine::discardOld(double oldestNeeded) {
+  // Jeden vzorek před oldestNeeded zůstává kvůli interpolaci průchodu úrovní
+  int end = times.size();
+  while (start < end - 1 && times.at(start + 1) < oldestNeeded)
+    start++;
+  if (end - start > maxSamples)
+    start = end - maxSamples;
+  scanned = qMax(scanned, start);
+
+  // Posun dat na začátek jen občas, aby to v průměru nic nestálo
+  if (start > 4096 && start > end / 2) {
+    times.remove(0, start);
+    source.remove(0, start);
+    for (int ch = 0; ch < ANALOG_COUNT; ch++)
+      if (usedChannels & (1u << ch))
+        channels[ch].remove(0, start);
+    scanned -= start;
+    start = 0;
+  }
+}
@@ -0,0 +1,85 @@
+//  Copyright (C) 2020-2024  Jiří Maier
+
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef TRIGGERENGINE_H
+#define TRIGGERENGINE_H
+
+#include <QPair>
+#include <QVector>
+#include "global.h"
+#include "plots/qcustomplot.h"
+#include "utils.h"
+
+/// Softwarový trigger nad proudem bodů ($$P), používá ho PlotData.
+/// Body se ukládají do bufferu, ze kterého se průběžně zahazuje vše starší než doba před spuštěním (pre-trigger).
+/// Detektor prochází nové vzorky zdrojového kanálu po blocích: nejdřív se spočítá, kde je signál nad úrovní
+/// (smyčka bez větvení, vektorizuje se), změny stavu se pak hledají přes memchr.
+/// Po spuštění se počká na dobu po spuštění a vrátí se průběhy všech kanálů s časem 0 v okamžiku spuštění.
+class TriggerEngine {
+public:
+  /// width je šířka pulzu nebo timeout (s), frameLength délka průběhu (s), preTrigger podíl průběhu před spuštěním (0 až 1)
+  void configure(TriggerMode::enumTriggerMode mode, int sourceChID, double level, double width, double frameLength, double preTrigger);
+  bool isEnabled() const { return mode != TriggerMode::off; }
+
+  /// Zahodí buffer a znovu čeká na spuštění
+  void reset();
+
+  /// Přidá bod, values je indexováno chID, bit n v present znamená, že kanál n v bodě je.
+  /// Vrací true, pokud je připraven průběh (vyzvednout přes takeFrames)
+  bool addPoint(double time, const double *values, quint32 present);
+
+  /// Průběhy kanálů (chID, data) z posledního spuštění
+  QVector<QPair<int, QSharedPointer<QCPGraphDataContainer>>> takeFrames();
+
+private:
+  enum State { armed, triggered };
+
+  TriggerMode::enumTriggerMode mode = TriggerMode::off;
+  int sourceChID = 0;
+  double level = 0;
+  double width = 0;
+  double preTime = 0, postTime = 0;
+
+  State state = armed;
+  double triggerTime = 0;
+
+  /// Buffer bodů, platná data začínají na indexu start
+  QVector<double> times;
+  QVector<double> channels[ANALOG_COUNT];
+  /// Zdrojový kanál, chybějící hodnoty jsou nahrazeny poslední známou
+  QVector<double> source;
+  quint32 usedChannels = 0;
+  int start = 0;
+  /// První vzorek, který ještě neprošel detektorem
+  int scanned = 0;
+
+  /// Stav detektoru mezi bloky
+  bool hasLastState = false;
+  bool lastAbove = false;
+  double lastTransition = 0;
+  double pulseStart = qQNaN();
+  bool timeoutFired = false;
+
+  QVector<uchar> above;
+  QVector<QPair<int, QSharedPointer<QCPGraphDataContainer>>> frames;
+
+  bool detect(int from, int to);
+  bool detectLevel(int from, int to, bool high);
+  void buildFrames();
+  void discardOld(double oldestNeeded);
+  double crossingTime(int index) const;
+};
+
+#endif // TRIGGERENGINE_H
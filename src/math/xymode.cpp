@@ -19,30 +19,32 @@ XYMode::XYMode(QObject* parent): QObject(parent) {
 
 }
 
-void XYMode::calculateXY(QSharedPointer<QCPGraphDataContainer> in1, QSharedPointer<QCPGraphDataContainer> in2, bool removeDC) {
-  if (in1->size() != in2->size()) {                                                  // Mají kanály stejný počet vzorků? Když ne, budou ustřihnut začátk nebo konec.
-    double mint = MAX(in1->at(0)->key, in2->at(0)->key);                             // Nejnižší společný čas
-    double maxt = MIN(in1->at(in1->size() - 1)->key, in2->at(in2->size() - 1)->key); // Nejvyšší společný čas
-    in1->removeBefore(mint);
-    in2->removeBefore(mint);
-    in1->removeAfter(maxt);
-    in2->removeAfter(maxt);
+void XYMode::calculateXY(ChannelSnapshot in1, ChannelSnapshot in2, bool removeDC, Resampling::enumResampling method) {
+  auto result = QSharedPointer<QCPCurveDataContainer>(new QCPCurveDataContainer());
+  if (in1.isEmpty() || in2.isEmpty()) {
+    emit sendResultXY(result);
+    return;
   }
 
+  // Kanály se zarovnají na společnou časovou osu (i při různé délce nebo vzorkování)
+  QVector<QCPCurveData> points;
+  points.reserve(Resampler::maxOutputCount(in1.size(), in2.size()));
   double dc1 = 0, dc2 = 0;
-
-  if (removeDC) {
-    for (int i = 0; i < in1->size(); i++) {
-      dc1 += in1->at(i)->value;
-      dc2 += in2->at(i)->value;
+  Resampler::merge(in1.constBegin(), in1.size(), in2.constBegin(), in2.size(), method, [&](double time, double x, double y) {
+    points.append(QCPCurveData(time, x, y));
+    dc1 += x;
+    dc2 += y;
+  });
+
+  if (removeDC && !points.isEmpty()) {
+    dc1 /= points.size();
+    dc2 /= points.size();
+    for (QCPCurveData &point : points) {
+      point.key -= dc1;
+      point.value -= dc2;
     }
-    dc1 /= in1->size();
-    dc2 /= in2->size();
   }
 
-  auto result = QSharedPointer<QCPCurveDataContainer>(new QCPCurveDataContainer());
-  for (int i = 0; i < in1->size(); i++) {
-    result->add(QCPCurveData(in1->at(i)->key, in1->at(i)->value - dc1, in2->at(i)->value - dc2));
-  }
+  result->set(points, true);
   emit sendResultXY(result);
 }
@@ -19,6 +19,8 @@
 #include <QObject>
 
 #include "global.h"
+#include "math/resampler.h"
+#include "plots/channelsnapshot.h"
 #include "plots/qcustomplot.h"
 
 class XYMode : public QObject {
@@ -27,7 +29,7 @@ class XYMode : public QObject {
   explicit XYMode(QObject* parent = nullptr);
 
  public slots:
-  void calculateXY(QSharedPointer<QCPGraphDataContainer> in1, QSharedPointer<QCPGraphDataContainer> in2, bool removeDC);
+  void calculateXY(ChannelSnapshot in1, ChannelSnapshot in2, bool removeDC, Resampling::enumResampling method);
 
  signals:
   void sendResultXY(QSharedPointer<QCPCurveDataContainer> result);
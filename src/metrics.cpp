@@ -0,0 +1,53 @@
+//  Copyright (C) 2020-2024  Jiří Maier
+
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "metrics.h"
+
+QAtomicInteger<qint64> Metrics::counters[Metrics::COUNTER_COUNT];
+QAtomicInteger<qint64> Metrics::gauges[Metrics::GAUGE_COUNT];
+QAtomicInteger<qint64> Metrics::channelMemory[Metrics::memoryChannelCount];
+
+const char *Metrics::name(Counter counter) {
+  static const char *names[COUNTER_COUNT] = {"bytes_received", "frames_point", "frames_logic_point", "frames_channel", "frames_logic_channel", "samples_parsed", "parse_errors", "parse_resyncs", "plot_frames_dropped", "plot_points_dropped", "plot_samples_copied", "replots", "replot_time_ns", "worker_busy_time_ns", "worker_tasks_dropped", "logger_samples", "logger_samples_dropped", "logger_bytes"};
+  return names[counter];
+}
+
+const char *Metrics::name(Gauge gauge) {
+  static const char *names[GAUGE_COUNT] = {"parser_buffer_bytes", "plot_mailbox_points", "worker_queue_depth", "last_replot_time_ns", "plot_memory_bytes", "logger_queue_depth", "logger_lag_ns"};
+  return names[gauge];
+}
+
+QByteArray Metrics::channelMemoryName(int index) {
+  QByteArray channel;
+  if (index < ANALOG_COUNT)
+    channel = "ch" + QByteArray::number(index + 1);
+  else if (index < ANALOG_COUNT + MATH_COUNT)
+    channel = "math" + QByteArray::number(index - ANALOG_COUNT + 1);
+  else
+    channel = "logic" + QByteArray::number(index - ANALOG_COUNT - MATH_COUNT + 1);
+  return "channel_memory_bytes{channel=\"" + channel + "\"}";
+}
+
+QByteArray Metrics::report() {
+  QByteArray output;
+  for (int i = 0; i < COUNTER_COUNT; i++)
+    output.append(name((Counter)i)).append(' ').append(QByteArray::number(value((Counter)i))).append('\n');
+  for (int i = 0; i < GAUGE_COUNT; i++)
+    output.append(name((Gauge)i)).append(' ').append(QByteArray::number(value((Gauge)i))).append('\n');
+  for (int i = 0; i < memoryChannelCount; i++)
+    if (channelMemoryValue(i) > 0)
+      output.append(channelMemoryName(i)).append(' ').append(QByteArray::number(channelMemoryValue(i))).append('\n');
+  return output;
+}
@@ -0,0 +1,85 @@
+//  Copyright (C) 2020-2024  Jiří Maier
+
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <QAtomicInteger>
+#include <QByteArray>
+
+#include "global.h"
+
+/// Počítadla a ukazatele stavu zpracování dat (pro dlouhý běh bez dozoru, aby bylo vidět, že program nestíhá)
+/// Zápis je bez zámku (atomické proměnné), volá se z libovolného vlákna. Přehled je ve vývojářských možnostech
+/// a na telnetovém portu (klient pošle "$$?metrics", odpoví se textem "název hodnota" po řádcích).
+class Metrics {
+public:
+  /// Rostoucí počítadla (od spuštění)
+  enum Counter {
+    bytesReceived = 0,
+    pointFrames,        ///< $$P
+    logicPointFrames,   ///< $$L u bodů
+    channelFrames,      ///< $$C
+    logicChannelFrames, ///< $$L u kanálů
+    samplesParsed,
+    parseErrors,
+    resyncs,           ///< Zahození části bufferu po chybě (hledání dalšího $$)
+    plotFramesDropped, ///< Průběhy, které se kvůli zahlcení nezobrazily (nahradil je novější)
+    plotPointsDropped, ///< Body, které se kvůli zahlcení nezobrazily
+    plotSamplesCopied, ///< Vzorky zkopírované grafem před připojením bodu ke sdíleným datům
+    replots,
+    replotTime, ///< ns
+    workerBusyTime, ///< ns, součet přes všechna vlákna výpočtů
+    workerTasksDropped, ///< Nahrazené požadavky na výpočet (platí jen poslední) a volání zahozená z plných dávek
+    loggerSamples,        ///< Vzorky zapsané průběžným logováním na disk
+    loggerSamplesDropped, ///< Vzorky, které se nevešly do fronty logování
+    loggerBytes,
+    COUNTER_COUNT
+  };
+  /// Okamžité hodnoty
+  enum Gauge {
+    parserBufferBytes = 0,
+    plotMailboxPoints, ///< Body čekající na převzetí grafem
+    workerQueueDepth,  ///< Úlohy čekající ve frontách výpočtů
+    lastReplotTime,    ///< ns
+    plotMemoryBytes,
+    loggerQueueDepth, ///< Záznamy čekající na zápis na disk
+    loggerLag,        ///< ns, jak dlouho nejstarší záznam čekal ve frontě logování
+    GAUGE_COUNT
+  };
+  /// Paměť dat jednotlivých kanálů (analogové, matematika, logické skupiny)
+  static const int memoryChannelCount = ANALOG_COUNT + MATH_COUNT + LOGIC_GROUPS;
+
+  static void add(Counter counter, qint64 value = 1) { counters[counter].fetchAndAddRelaxed(value); }
+  static void set(Gauge gauge, qint64 value) { gauges[gauge].storeRelaxed(value); }
+  static void setChannelMemory(int index, qint64 bytes) { channelMemory[index].storeRelaxed(bytes); }
+  static qint64 value(Counter counter) { return counters[counter].loadRelaxed(); }
+  static qint64 value(Gauge gauge) { return gauges[gauge].loadRelaxed(); }
+  static qint64 channelMemoryValue(int index) { return channelMemory[index].loadRelaxed(); }
+
+  static const char *name(Counter counter);
+  static const char *name(Gauge gauge);
+  static QByteArray channelMemoryName(int index);
+
+  /// Všechny hodnoty, řádek "název hodnota"
+  static QByteArray report();
+
+private:
+  static QAtomicInteger<qint64> counters[COUNTER_COUNT];
+  static QAtomicInteger<qint64> gauges[GAUGE_COUNT];
+  static QAtomicInteger<qint64> channelMemory[memoryChannelCount];
+};
+
+#endif // METRICS_H
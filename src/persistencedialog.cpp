@@ -0,0 +1,72 @@
+//  Copyright (C) 2020-2024  Jiří Maier
+
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "persistencedialog.h"
+#include "ui_persistencedialog.h"
+
+PersistenceDialog::PersistenceDialog(QWidget *parent) : QDialog(parent), ui(new Ui::PersistenceDialog) {
+  ui->setupUi(this);
+
+  ui->comboBoxPersistenceCh->blockSignals(true);
+  for (int i = 0; i < ANALOG_COUNT; i++)
+    ui->comboBoxPersistenceCh->addItem(getChName(i));
+  ui->comboBoxPersistenceCh->blockSignals(false);
+
+  setWindowFlags(windowFlags() & ~Qt::WindowContextHelpButtonHint);
+  setWindowFlags(windowFlags() | Qt::WindowMinMaxButtonsHint);
+}
+
+PersistenceDialog::~PersistenceDialog() { delete ui; }
+
+Ui::PersistenceDialog *PersistenceDialog::getUi() const { return ui; }
+
+void PersistenceDialog::setSourceChannel(int chID) {
+  if (chID >= 0 && chID < ANALOG_COUNT)
+    ui->comboBoxPersistenceCh->setCurrentIndex(chID);
+}
+
+void PersistenceDialog::setUnits(UnitOfMeasure timeUnit, UnitOfMeasure valueUnit) {
+  ui->plotPersistence->setXUnit(timeUnit);
+  ui->plotPersistence->setYUnit(valueUnit);
+}
+
+void PersistenceDialog::showEvent(QShowEvent *event) {
+  QDialog::showEvent(event);
+  emit decayChanged(ui->doubleSpinBoxPersistenceDecay->value());
+  emit sourceChanged(ui->comboBoxPersistenceCh->currentIndex());
+}
+
+void PersistenceDialog::hideEvent(QHideEvent *event) {
+  QDialog::hideEvent(event);
+  emit sourceChanged(-1);
+}
+
+void PersistenceDialog::newDensity(QVector<float> density, int columns, int rows, QCPRange keyRange, QCPRange valueRange, float maxValue, int frames) {
+  ui->labelPersistenceFrames->setText(tr("%n waveform(s)", "", frames));
+  ui->plotPersistence->newDensity(density, columns, rows, keyRange, valueRange, maxValue);
+}
+
+void PersistenceDialog::on_comboBoxPersistenceCh_currentIndexChanged(int index) {
+  ui->plotPersistence->clear();
+  if (isVisible())
+    emit sourceChanged(index);
+}
+
+void PersistenceDialog::on_doubleSpinBoxPersistenceDecay_valueChanged(double arg1) { emit decayChanged(arg1); }
+
+void PersistenceDialog::on_pushButtonPersistenceClear_clicked() {
+  ui->plotPersistence->clear();
+  emit resetRequested();
+}
@@ -0,0 +1,64 @@
+//  Copyright (C) 2020-2024  Jiří Maier
+
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef PERSISTENCEDIALOG_H
+#define PERSISTENCEDIALOG_H
+
+#include "global.h"
+#include "plots/qcustomplot.h"
+#include <QDialog>
+
+namespace Ui {
+class PersistenceDialog;
+}
+
+class PersistenceDialog : public QDialog {
+  Q_OBJECT
+
+public:
+  explicit PersistenceDialog(QWidget *parent = nullptr);
+  ~PersistenceDialog();
+
+  Ui::PersistenceDialog *getUi() const;
+
+  /// Vybere zdrojový kanál (použije se při příštím zobrazení)
+  void setSourceChannel(int chID);
+
+  /// Jednotky os podle hlavního grafu
+  void setUnits(UnitOfMeasure timeUnit, UnitOfMeasure valueUnit);
+
+protected:
+  void showEvent(QShowEvent *event) override;
+  void hideEvent(QHideEvent *event) override;
+
+private slots:
+  void on_comboBoxPersistenceCh_currentIndexChanged(int index);
+  void on_doubleSpinBoxPersistenceDecay_valueChanged(double arg1);
+  void on_pushButtonPersistenceClear_clicked();
+
+private:
+  Ui::PersistenceDialog *ui;
+
+public slots:
+  void newDensity(QVector<float> density, int columns, int rows, QCPRange keyRange, QCPRange valueRange, float maxValue, int frames);
+
+signals:
+  /// Výpočet se provádí jen když je okno zobrazeno, jinak je zdroj -1
+  void sourceChanged(int chID);
+  void decayChanged(double halfLife);
+  void resetRequested();
+};
+
+#endif // PERSISTENCEDIALOG_H
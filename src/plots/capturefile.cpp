@@ -0,0 +1,732 @@
+//  Copyright (C) 2020-2024  Jiří Maier
+
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "capturefile.h"
+#include "global.h"
+#include "math/taskpool.h"
+#include "traceevents.h"
+#include <QFile>
+#include <QSysInfo>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+namespace {
+// Struktury souboru, všechna čísla jsou little-endian (popis v documentation/Capture file format.md)
+const char fileMagic[8] = {'D', 'P', 'C', 'A', 'P', 'T', 'U', 'R'};
+const char endMagic[8] = {'D', 'P', 'C', 'A', 'P', 'E', 'N', 'D'};
+const quint32 chunkMagic = 0x4B4E4843; // "CHNK"
+const quint32 formatVersion = 1;
+
+struct FileHeader {
+  char magic[8];
+  quint32 version;
+  quint32 reserved;
+};
+
+struct ChunkHeader {
+  quint32 magic;
+  quint16 stream;
+  quint8 kind;
+  quint8 valueType;
+  quint32 count;
+  quint32 flags;
+  double t0, dt; ///< Bez příznaku rovnoměrných časů jen informativní, časy následují za hlavičkou
+  double multiplier;
+  double min, max;
+  quint32 dataSize; ///< Počet bajtů za hlavičkou (časy, hodnoty, zarovnání na 8)
+  quint32 reserved;
+};
+
+struct StreamEntry {
+  quint32 channel;
+  quint8 kind;
+  quint8 firstBit;
+  quint8 bitCount;
+  quint8 reserved;
+  quint64 samples;
+};
+
+struct ChunkEntry {
+  quint64 offset;
+  quint32 stream;
+  quint32 count;
+  double first, last;
+  double min, max;
+};
+
+struct Footer {
+  quint64 indexOffset;
+  quint32 streamCount;
+  quint32 chunkCount;
+  char magic[8];
+};
+
+static_assert(sizeof(FileHeader) == 16 && sizeof(ChunkHeader) == 64 && sizeof(StreamEntry) == 16 && sizeof(ChunkEntry) == 48 && sizeof(Footer) == 24, "Capture file structures must not be padded");
+
+enum Kind : quint8 { analogKind = 0, logicKind = 1 };
+enum ValueType : quint8 { int8Type = 1, int16Type = 2, int32Type = 3, float32Type = 4, float64Type = 5, logicWordType = 6 };
+const quint32 uniformTimeFlag = 1;
+const quint32 frameStartFlag = 2;
+
+/// Čas i-tého vzorku rovnoměrného bloku, součin se zaokrouhlí zvlášť (bez FMA), aby zápis i čtení daly na všech platformách stejný double
+inline double uniformKey(double t0, double dt, int i) {
+  volatile double offset = i * dt;
+  return t0 + offset;
+}
+
+int valueSize(int type) {
+  switch (type) {
+    case int8Type:
+      return 1;
+    case int16Type:
+      return 2;
+    case int32Type:
+    case float32Type:
+    case logicWordType:
+      return 4;
+    case float64Type:
+      return 8;
+  }
+  return 0;
+}
+
+template <typename T> void appendRaw(QByteArray &bytes, const T &value) { bytes.append(reinterpret_cast<const char *>(&value), sizeof(T)); }
+
+template <typename T> T readRaw(const uchar *data) {
+  T value;
+  memcpy(&value, data, sizeof(T));
+  return value;
+}
+
+template <typename T> QByteArray packValues(const QCPGraphData *data, int count, double multiplier) {
+  QByteArray bytes(count * (int)sizeof(T), Qt::Uninitialized);
+  T *out = reinterpret_cast<T *>(bytes.data());
+  for (int i = 0; i < count; i++) {
+    if constexpr (std::is_integral<T>::value)
+      out[i] = (T)std::llround(data[i].value / multiplier);
+    else
+      out[i] = (T)data[i].value;
+  }
+  return bytes;
+}
+
+/// Zakóduje hodnoty do nejmenšího typu, ve kterém se uloží bez ztráty: celá čísla (i násobky nejmenší nenulové hodnoty, typicky
+/// surová data přenásobená konstantou), float, jinak double
+QByteArray encodeValues(const QCPGraphData *data, int count, quint8 &type, double &multiplier, double &min, double &max) {
+  min = qInf();
+  max = -qInf();
+  double smallest = qInf();
+  bool finite = true, isFloat = true;
+  for (int i = 0; i < count; i++) {
+    double value = data[i].value;
+    if (!std::isfinite(value))
+      finite = false;
+    else {
+      min = qMin(min, value);
+      max = qMax(max, value);
+      if (value != 0)
+        smallest = qMin(smallest, qAbs(value));
+    }
+    if (!std::isnan(value) && (double)(float)value != value)
+      isFloat = false;
+  }
+  if (min > max)
+    min = max = qQNaN();
+
+  multiplier = 1;
+  if (finite) {
+    for (double candidate : {1.0, smallest}) {
+      if (!std::isfinite(candidate))
+        continue;
+      double low = 0, high = 0;
+      bool exact = true;
+      for (int i = 0; i < count && exact; i++) {
+        double raw = std::round(data[i].value / candidate);
+        exact = qAbs(raw) <= std::numeric_limits<qint32>::max() && raw * candidate == data[i].value;
+        low = qMin(low, raw);
+        high = qMax(high, raw);
+      }
+      if (!exact)
+        continue;
+      multiplier = candidate;
+      if (low >= std::numeric_limits<qint8>::min() && high <= std::numeric_limits<qint8>::max()) {
+        type = int8Type;
+        return packValues<qint8>(data, count, multiplier);
+      }
+      if (low >= std::numeric_limits<qint16>::min() && high <= std::numeric_limits<qint16>::max()) {
+        type = int16Type;
+        return packValues<qint16>(data, count, multiplier);
+      }
+      type = int32Type;
+      return packValues<qint32>(data, count, multiplier);
+    }
+  }
+  if (isFloat) {
+    type = float32Type;
+    return packValues<float>(data, count, 1);
+  }
+  type = float64Type;
+  return packValues<double>(data, count, 1);
+}
+
+/// Jdou časy přesně (bit po bitu) spočítat jako uniformKey(t0, dt, i)? t0 a dt se vyplní vždy (dt jako průměrný interval)
+template <typename TimeFunction> bool uniformTimes(TimeFunction time, int count, double &t0, double &dt) {
+  t0 = time(0);
+  dt = count > 1 ? (time(count - 1) - t0) / (count - 1) : 0;
+  auto exact = [&](double step) {
+    if (!(step > 0))
+      return false;
+    for (int i = 1; i < count; i++)
+      if (time(i) != uniformKey(t0, step, i))
+        return false;
+    return true;
+  };
+  if (count < 2 || exact(dt))
+    return true;
+  // Průměrný interval se od kroku, kterým byly časy spočítané, může lišit v posledním bitu
+  double step = time(1) - t0;
+  if (step != dt && exact(step)) {
+    dt = step;
+    return true;
+  }
+  return false;
+}
+
+/// Souhrn logického bloku: min = bity, které byly vždy v 1, max = bity, které byly aspoň jednou v 1
+void logicSummary(const quint32 *words, int count, double &min, double &max) {
+  quint32 always = 0xFFFFFFFF, ever = 0;
+  for (int i = 0; i < count; i++) {
+    always &= words[i];
+    ever |= words[i];
+  }
+  min = always;
+  max = ever;
+}
+
+/// Hodnota v souboru (typ podle hlavičky bloku) převedená na double
+double readValue(const uchar *data, int type, int index) {
+  switch (type) {
+    case int8Type:
+      return readRaw<qint8>(data + index);
+    case int16Type:
+      return readRaw<qint16>(data + 2 * index);
+    case int32Type:
+      return readRaw<qint32>(data + 4 * index);
+    case float32Type:
+      return readRaw<float>(data + 4 * index);
+    case float64Type:
+      return readRaw<double>(data + 8 * index);
+  }
+  return qQNaN();
+}
+} // namespace
+
+qint64 Capture::sampleCount() const {
+  qint64 count = 0;
+  for (const Stream &stream : streams)
+    if (!stream.columns.isEmpty())
+      count += stream.columns.first()->size();
+  return count;
+}
+
+CaptureWriter::CaptureWriter(QIODevice &device) : device(device) {}
+
+bool CaptureWriter::begin() {
+  FileHeader header = {};
+  memcpy(header.magic, fileMagic, sizeof(header.magic));
+  header.version = formatVersion;
+  QByteArray bytes;
+  appendRaw(bytes, header);
+  return writeBytes(bytes);
+}
+
+int CaptureWriter::addStream(int channel, bool logic, int firstBit, int bitCount) {
+  streams.append(StreamInfo{channel, logic, firstBit, bitCount});
+  return streams.size() - 1;
+}
+
+template <typename TimeFunction> bool CaptureWriter::writeChunk(int stream, TimeFunction time, int count, const QByteArray &values, int valueType, double multiplier, double min, double max, bool frameStart) {
+  ChunkHeader header = {};
+  header.magic = chunkMagic;
+  header.stream = stream;
+  header.kind = streams.at(stream).logic ? logicKind : analogKind;
+  header.valueType = valueType;
+  header.count = count;
+  bool uniform = uniformTimes(time, count, header.t0, header.dt);
+  header.flags = (uniform ? uniformTimeFlag : 0) | (frameStart ? frameStartFlag : 0);
+  header.multiplier = multiplier;
+  header.min = min;
+  header.max = max;
+  int timeBytes = uniform ? 0 : count * (int)sizeof(double);
+  int padding = (8 - (timeBytes + values.size()) % 8) % 8;
+  header.dataSize = timeBytes + values.size() + padding;
+
+  QByteArray bytes;
+  bytes.reserve(sizeof(header) + header.dataSize);
+  appendRaw(bytes, header);
+  if (!uniform)
+    for (int i = 0; i < count; i++)
+      appendRaw(bytes, time(i));
+  bytes.append(values);
+  bytes.append(padding, '\0');
+
+  chunks.append(ChunkInfo{position, stream, count, time(0), time(count - 1), min, max});
+  streams[stream].samples += count;
+  return writeBytes(bytes);
+}
+
+bool CaptureWriter::writeAnalog(int stream, const QCPGraphData *data, int count, bool frameStart) {
+  for (int offset = 0; offset < count; offset += CAPTURE_CHUNK_SAMPLES) {
+    int length = qMin(count - offset, CAPTURE_CHUNK_SAMPLES);
+    quint8 type;
+    double multiplier, min, max;
+    QByteArray values = encodeValues(data + offset, length, type, multiplier, min, max);
+    const QCPGraphData *chunk = data + offset;
+    if (!writeChunk(stream, [chunk](int i) { return chunk[i].key; }, length, values, type, multiplier, min, max, frameStart && offset == 0))
+      return false;
+  }
+  return ok;
+}
+
+bool CaptureWriter::writeLogic(int stream, const QVector<const QCPGraphData *> &bits, int count) {
+  for (int offset = 0; offset < count; offset += CAPTURE_CHUNK_SAMPLES) {
+    int length = qMin(count - offset, CAPTURE_CHUNK_SAMPLES);
+    QByteArray words(length * (int)sizeof(quint32), Qt::Uninitialized);
+    quint32 *out = reinterpret_cast<quint32 *>(words.data());
+    for (int i = 0; i < length; i++) {
+      quint32 word = 0;
+      for (int bit = 0; bit < bits.size(); bit++)
+        if (((int)round(bits.at(bit)[offset + i].value)) % 3)
+          word |= (quint32)1 << bit;
+      out[i] = word;
+    }
+    double min, max;
+    logicSummary(out, length, min, max);
+    const QCPGraphData *chunk = bits.first() + offset;
+    if (!writeChunk(stream, [chunk](int i) { return chunk[i].key; }, length, words, logicWordType, 1, min, max))
+      return false;
+  }
+  return ok;
+}
+
+bool CaptureWriter::writeLogicWords(int stream, const double *times, const quint32 *words, int count, bool frameStart) {
+  for (int offset = 0; offset < count; offset += CAPTURE_CHUNK_SAMPLES) {
+    int length = qMin(count - offset, CAPTURE_CHUNK_SAMPLES);
+    QByteArray values(reinterpret_cast<const char *>(words + offset), length * (int)sizeof(quint32));
+    double min, max;
+    logicSummary(words + offset, length, min, max);
+    const double *chunk = times + offset;
+    if (!writeChunk(stream, [chunk](int i) { return chunk[i]; }, length, values, logicWordType, 1, min, max, frameStart && offset == 0))
+      return false;
+  }
+  return ok;
+}
+
+bool CaptureWriter::finish() {
+  QByteArray bytes;
+  bytes.reserve(streams.size() * sizeof(StreamEntry) + chunks.size() * sizeof(ChunkEntry) + sizeof(Footer));
+  for (const StreamInfo &stream : qAsConst(streams)) {
+    StreamEntry entry = {};
+    entry.channel = stream.channel;
+    entry.kind = stream.logic ? logicKind : analogKind;
+    entry.firstBit = stream.firstBit;
+    entry.bitCount = stream.bitCount;
+    entry.samples = stream.samples;
+    appendRaw(bytes, entry);
+  }
+  for (const ChunkInfo &chunk : qAsConst(chunks)) {
+    ChunkEntry entry = {};
+    entry.offset = chunk.offset;
+    entry.stream = chunk.stream;
+    entry.count = chunk.count;
+    entry.first = chunk.first;
+    entry.last = chunk.last;
+    entry.min = chunk.min;
+    entry.max = chunk.max;
+    appendRaw(bytes, entry);
+  }
+  Footer footer = {};
+  footer.indexOffset = position;
+  footer.streamCount = streams.size();
+  footer.chunkCount = chunks.size();
+  memcpy(footer.magic, endMagic, sizeof(footer.magic));
+  appendRaw(bytes, footer);
+  return writeBytes(bytes);
+}
+
+bool CaptureWriter::writeBytes(const QByteArray &bytes) {
+  if (!ok)
+    return false;
+  if (device.write(bytes) != bytes.size())
+    ok = false;
+  else
+    position += bytes.size();
+  return ok;
+}
+
+bool CaptureFile::write(QIODevice &device, const Capture &capture, QString &error, const QAtomicInt *canceled, const std::function<void(qint64)> &progress) {
+  if (QSysInfo::ByteOrder != QSysInfo::LittleEndian) {
+    error = tr("Capture files are supported only on little-endian systems");
+    return false;
+  }
+  CaptureWriter writer(device);
+  writer.begin();
+  qint64 done = 0;
+
+  // Po každém bloku se kontroluje zrušení a hlásí průběh
+  auto endOfChunk = [&](int count) {
+    done += count;
+    if (progress)
+      progress(done);
+    return writer.isOk() && !(canceled && canceled->loadRelaxed());
+  };
+
+  for (const Capture::Stream &stream : capture.streams) {
+    if (stream.columns.isEmpty())
+      continue;
+    if (!stream.logic) {
+      ChannelSnapshot data(stream.columns.first());
+      if (data.isEmpty())
+        continue;
+      int id = writer.addStream(stream.channel, false);
+      for (int offset = 0; offset < data.size(); offset += CAPTURE_CHUNK_SAMPLES) {
+        int length = qMin(data.size() - offset, CAPTURE_CHUNK_SAMPLES);
+        writer.writeAnalog(id, data.constBegin() + offset, length);
+        if (!endOfChunk(length))
+          break;
+      }
+      continue;
+    }
+
+    // Bity se zabalí do slov, jen když mají všechny stejné časy, jinak se uloží každý jako samostatný stream
+    QVector<ChannelSnapshot> bits;
+    for (const auto &column : stream.columns)
+      bits.append(ChannelSnapshot(column));
+    bool sameTimes = true;
+    for (int bit = 1; bit < bits.size() && sameTimes; bit++) {
+      sameTimes = bits.at(bit).size() == bits.first().size();
+      for (int i = 0; i < bits.first().size() && sameTimes; i++)
+        sameTimes = bits.at(bit).at(i).key == bits.first().at(i).key;
+    }
+    QVector<QPair<int, int>> parts; // První bit a počet bitů
+    if (sameTimes)
+      parts.append(QPair<int, int>(0, bits.size()));
+    else
+      for (int bit = 0; bit < bits.size(); bit++)
+        parts.append(QPair<int, int>(bit, 1));
+
+    for (const auto &part : parts) {
+      int samples = bits.at(part.first).size();
+      if (samples == 0)
+        continue;
+      int id = writer.addStream(stream.channel, true, stream.firstBit + part.first, part.second);
+      for (int offset = 0; offset < samples; offset += CAPTURE_CHUNK_SAMPLES) {
+        int length = qMin(samples - offset, CAPTURE_CHUNK_SAMPLES);
+        QVector<const QCPGraphData *> pointers;
+        for (int bit = part.first; bit < part.first + part.second; bit++)
+          pointers.append(bits.at(bit).constBegin() + offset);
+        writer.writeLogic(id, pointers, length);
+        // Průběh se počítá v řádcích skupiny, samostatné bity se dělí počtem bitů
+        if (!endOfChunk(sameTimes ? length : length / bits.size()))
+          break;
+      }
+    }
+  }
+  if (canceled && canceled->loadRelaxed())
+    return false;
+  if (!writer.isOk() || !writer.finish()) {
+    error = device.errorString();
+    return false;
+  }
+  return true;
+}
+
+bool CaptureFile::read(const QString &fileName, Capture &capture, QString &error) {
+  if (QSysInfo::ByteOrder != QSysInfo::LittleEndian) {
+    error = tr("Capture files are supported only on little-endian systems");
+    return false;
+  }
+  QFile file(fileName);
+  if (!file.open(QIODevice::ReadOnly)) {
+    error = file.errorString();
+    return false;
+  }
+  qint64 size = file.size();
+  if (size < (qint64)(sizeof(FileHeader) + sizeof(Footer))) {
+    error = tr("Not a capture file");
+    return false;
+  }
+
+  // Namapovaný soubor se nečte předem, systém načítá stránky až při dekódování bloků
+  const uchar *data = file.map(0, size);
+  QByteArray contents;
+  if (!data) {
+    contents = file.readAll();
+    if (contents.size() != size) {
+      error = file.errorString();
+      return false;
+    }
+    data = reinterpret_cast<const uchar *>(contents.constData());
+  }
+
+  FileHeader header = readRaw<FileHeader>(data);
+  Footer footer = readRaw<Footer>(data + size - sizeof(Footer));
+  if (memcmp(header.magic, fileMagic, sizeof(fileMagic)) || memcmp(footer.magic, endMagic, sizeof(endMagic))) {
+    error = tr("Not a capture file or the file is incomplete");
+    return false;
+  }
+  if (header.version > formatVersion) {
+    error = tr("Capture file was created by a newer version");
+    return false;
+  }
+  qint64 indexSize = (qint64)footer.streamCount * sizeof(StreamEntry) + (qint64)footer.chunkCount * sizeof(ChunkEntry);
+  if (footer.indexOffset < sizeof(FileHeader) || (qint64)footer.indexOffset + indexSize + (qint64)sizeof(Footer) != size) {
+    error = tr("Capture file is damaged");
+    return false;
+  }
+
+  // Rejstřík: streamy a bloky, výstupní kontejnery se připraví předem, bloky se pak zapisují rovnou na své místo
+  const uchar *index = data + footer.indexOffset;
+  QVector<StreamEntry> streams(footer.streamCount);
+  QVector<QVector<QCPGraphData *>> outputs(footer.streamCount);
+  capture.streams.clear();
+  for (int i = 0; i < streams.size(); i++) {
+    StreamEntry entry = readRaw<StreamEntry>(index + i * sizeof(StreamEntry));
+    bool valid = entry.kind == analogKind ? entry.channel < ANALOG_COUNT + MATH_COUNT : (entry.kind == logicKind && entry.channel < LOGIC_GROUPS && entry.bitCount >= 1 && entry.firstBit + entry.bitCount <= LOGIC_BITS);
+    if (!valid || entry.samples > (quint64)std::numeric_limits<int>::max()) {
+      error = tr("Capture file is damaged");
+      return false;
+    }
+    streams[i] = entry;
+    Capture::Stream stream;
+    stream.channel = entry.channel;
+    stream.logic = entry.kind == logicKind;
+    stream.firstBit = stream.logic ? entry.firstBit : 0;
+    for (int bit = 0; bit < (stream.logic ? entry.bitCount : 1); bit++) {
+      auto column = QSharedPointer<QCPGraphDataContainer>(new QCPGraphDataContainer());
+      column->set(QVector<QCPGraphData>(entry.samples), true);
+      outputs[i].append(column->isEmpty() ? nullptr : &*column->begin());
+      stream.columns.append(column);
+    }
+    capture.streams.append(stream);
+  }
+
+  QVector<ChunkEntry> chunks(footer.chunkCount);
+  QVector<qint64> starts(footer.chunkCount);
+  QVector<quint64> filled(footer.streamCount, 0);
+  for (int i = 0; i < chunks.size(); i++) {
+    ChunkEntry entry = readRaw<ChunkEntry>(index + streams.size() * sizeof(StreamEntry) + i * sizeof(ChunkEntry));
+    if (entry.stream >= (quint32)streams.size() || entry.offset < sizeof(FileHeader) || entry.offset + sizeof(ChunkHeader) > footer.indexOffset || filled.at(entry.stream) + entry.count > streams.at(entry.stream).samples) {
+      error = tr("Capture file is damaged");
+      return false;
+    }
+    chunks[i] = entry;
+    starts[i] = filled.at(entry.stream);
+    filled[entry.stream] += entry.count;
+    // Záznam z průběžného logování může obsahovat průběhy ($$C, $$L) s vlastní časovou osou, zůstanou v pořadí zápisu
+    if (readRaw<ChunkHeader>(data + entry.offset).flags & frameStartFlag)
+      capture.streams[entry.stream].frameStarts.append((int)starts.at(i));
+  }
+  for (int i = 0; i < streams.size(); i++)
+    if (filled.at(i) != streams.at(i).samples) {
+      error = tr("Capture file is damaged");
+      return false;
+    }
+
+  // Bloky jsou nezávislé, dekódují se na všech jádrech
+  QAtomicInt damaged(0);
+  TaskPool::parallelFor(chunks.size(), 1, [&](int begin, int end) {
+    for (int i = begin; i < end; i++) {
+      const ChunkEntry &entry = chunks.at(i);
+      ChunkHeader chunk = readRaw<ChunkHeader>(data + entry.offset);
+      bool uniform = chunk.flags & uniformTimeFlag;
+      bool logic = streams.at(entry.stream).kind == logicKind;
+      qint64 needed = (uniform ? 0 : (qint64)chunk.count * sizeof(double)) + (qint64)chunk.count * valueSize(chunk.valueType);
+      if (chunk.magic != chunkMagic || chunk.stream != entry.stream || chunk.count != entry.count || valueSize(chunk.valueType) == 0 || (logic != (chunk.valueType == logicWordType)) || chunk.dataSize < needed ||
+          entry.offset + sizeof(ChunkHeader) + chunk.dataSize > footer.indexOffset) {
+        damaged.storeRelaxed(1);
+        continue;
+      }
+      const uchar *times = data + entry.offset + sizeof(ChunkHeader);
+      const uchar *values = times + (uniform ? 0 : chunk.count * sizeof(double));
+      const QVector<QCPGraphData *> &columns = outputs.at(entry.stream);
+      for (int sample = 0; sample < (int)chunk.count; sample++) {
+        double key = uniform ? uniformKey(chunk.t0, chunk.dt, sample) : readRaw<double>(times + sample * sizeof(double));
+        if (!logic) {
+          QCPGraphData &out = columns.first()[starts.at(i) + sample];
+          out.key = key;
+          out.value = readValue(values, chunk.valueType, sample) * chunk.multiplier;
+          continue;
+        }
+        // Logické kanály jsou v grafu posunuté o 3 na bit (stejně jako v PlotData)
+        quint32 word = readRaw<quint32>(values + sample * sizeof(quint32));
+        int firstBit = streams.at(entry.stream).firstBit;
+        for (int bit = 0; bit < columns.size(); bit++) {
+          QCPGraphData &out = columns.at(bit)[starts.at(i) + sample];
+          out.key = key;
+          out.value = ((word >> bit) & 1) + (firstBit + bit) * 3;
+        }
+      }
+    }
+  });
+  if (damaged.loadRelaxed()) {
+    capture.streams.clear();
+    error = tr("Capture file is damaged");
+    return false;
+  }
+  return true;
+}
+
+double CaptureFile::uniformInterval(const ChannelSnapshot &channel, double tolerance) {
+  if (channel.size() < 2)
+    return 0;
+  double interval = (channel.back().key - channel.front().key) / (channel.size() - 1);
+  if (!(interval > 0))
+    return 0;
+  for (int i = 1; i < channel.size(); i++)
+    if (qAbs(channel.at(i).key - channel.at(i - 1).key - interval) > tolerance * interval)
+      return 0;
+  return interval;
+}
+
+bool CaptureFile::writeWav(QIODevice &device, const ChannelSnapshot &channel, QString &error) {
+  // Mírný jitter časů nevadí, zvuk se přehraje se středním vzorkovacím kmitočtem
+  double interval = uniformInterval(channel, 0.01);
+  if (interval == 0) {
+    error = tr("Channel is not sampled uniformly");
+    return false;
+  }
+  double sampleRate = std::round(1 / interval);
+  if (sampleRate < 1 || sampleRate > std::numeric_limits<quint32>::max() / sizeof(float)) {
+    error = tr("Sample rate is out of range for WAV");
+    return false;
+  }
+  qint64 dataBytes = (qint64)channel.size() * sizeof(float);
+  if (dataBytes > std::numeric_limits<quint32>::max() - 58) {
+    error = tr("Channel is too long for WAV");
+    return false;
+  }
+
+  double peak = 0;
+  for (const QCPGraphData *it = channel.constBegin(); it != channel.constEnd(); it++)
+    if (std::isfinite(it->value))
+      peak = qMax(peak, qAbs(it->value));
+  double scale = peak > 0 ? 1 / peak : 1;
+
+  // RIFF s formátem IEEE float (3), u něj je povinný blok fact
+  QByteArray header;
+  header.append("RIFF");
+  appendRaw<quint32>(header, 4 + (8 + 18) + (8 + 4) + 8 + dataBytes);
+  header.append("WAVE");
+  header.append("fmt ");
+  appendRaw<quint32>(header, 18);
+  appendRaw<quint16>(header, 3);
+  appendRaw<quint16>(header, 1);
+  appendRaw<quint32>(header, sampleRate);
+  appendRaw<quint32>(header, sampleRate * sizeof(float));
+  appendRaw<quint16>(header, sizeof(float));
+  appendRaw<quint16>(header, 32);
+  appendRaw<quint16>(header, 0);
+  header.append("fact");
+  appendRaw<quint32>(header, 4);
+  appendRaw<quint32>(header, channel.size());
+  header.append("data");
+  appendRaw<quint32>(header, dataBytes);
+  if (device.write(header) != header.size()) {
+    error = device.errorString();
+    return false;
+  }
+
+  QVector<float> block;
+  for (int offset = 0; offset < channel.size(); offset += CAPTURE_CHUNK_SAMPLES) {
+    int length = qMin(channel.size() - offset, CAPTURE_CHUNK_SAMPLES);
+    block.resize(length);
+    for (int i = 0; i < length; i++) {
+      double value = channel.at(offset + i).value;
+      block[i] = std::isfinite(value) ? value * scale : 0;
+    }
+    qint64 bytes = length * sizeof(float);
+    if (device.write(reinterpret_cast<const char *>(block.constData()), bytes) != bytes) {
+      error = device.errorString();
+      return false;
+    }
+  }
+  return true;
+}
+
+CaptureFile *CaptureFile::save(Capture capture, QString fileName) {
+  CaptureFile *job = new CaptureFile();
+  job->task = [job, capture, fileName]() {
+    TRACE_SCOPE("export", "Capture save");
+    qint64 total = qMax(capture.sampleCount(), (qint64)1);
+    int lastPercent = -1;
+    QFile file(fileName);
+    if (!file.open(QFile::WriteOnly | QFile::Truncate)) {
+      job->error = file.errorString();
+      return false;
+    }
+    bool ok = write(file, capture, job->error, &job->canceled, [&](qint64 done) {
+      int percent = done * 100 / total;
+      if (percent != lastPercent) {
+        lastPercent = percent;
+        emit job->progress(percent);
+      }
+    });
+    file.close();
+    if (!ok)
+      file.remove();
+    return ok;
+  };
+  return job;
+}
+
+CaptureFile *CaptureFile::saveWav(QSharedPointer<const QCPGraphDataContainer> channel, QString fileName) {
+  CaptureFile *job = new CaptureFile();
+  job->task = [job, channel, fileName]() {
+    TRACE_SCOPE("export", "WAV save");
+    QFile file(fileName);
+    if (!file.open(QFile::WriteOnly | QFile::Truncate)) {
+      job->error = file.errorString();
+      return false;
+    }
+    bool ok = writeWav(file, ChannelSnapshot(channel), job->error);
+    file.close();
+    if (!ok)
+      file.remove();
+    return ok;
+  };
+  return job;
+}
+
+CaptureFile *CaptureFile::open(QString fileName) {
+  CaptureFile *job = new CaptureFile();
+  job->task = [job, fileName]() {
+    TRACE_SCOPE("export", "Capture open");
+    return read(fileName, job->capture, job->error);
+  };
+  return job;
+}
+
+void CaptureFile::start() {
+  TaskPool::start(
+      [this]() {
+        bool ok = task();
+        emit finished(ok);
+        deleteLater();
+      },
+      TaskPool::low);
+}
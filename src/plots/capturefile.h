@@ -0,0 +1,139 @@
+//  Copyright (C) 2020-2024  Jiří Maier
+
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef CAPTUREFILE_H
+#define CAPTUREFILE_H
+
+#include <QAtomicInt>
+#include <QObject>
+#include <functional>
+
+#include "plots/channelsnapshot.h"
+
+/// Nejvyšší počet vzorků v jednom bloku souboru záznamu
+#define CAPTURE_CHUNK_SAMPLES 65536
+
+/// Záznam kanálů hlavního grafu pro uložení do binárního souboru nebo načtený ze souboru
+struct Capture {
+  struct Stream {
+    int channel = 0;   ///< Číslo kanálu (analogový, matematický), u logiky číslo skupiny
+    bool logic = false;
+    int firstBit = 0;  ///< Logika: bit skupiny, kterému odpovídá první sloupec
+    /// Analogový kanál má jeden sloupec, logika jeden sloupec na bit (všechny se stejnými časy)
+    QVector<QSharedPointer<QCPGraphDataContainer>> columns;
+    /// Průběhy ($$C, $$L) zapsané logováním: index prvního vzorku každého průběhu, každý má vlastní časovou osu.
+    /// Prázdné u souvislého záznamu.
+    QVector<int> frameStarts;
+  };
+  QVector<Stream> streams;
+
+  qint64 sampleCount() const;
+};
+
+/// Zápis binárního záznamu po blocích (formát je popsaný v documentation/Capture file format.md)
+/// Každý blok nese nejvýše CAPTURE_CHUNK_SAMPLES vzorků jednoho streamu: hodnoty v nejmenším bezeztrátovém typu (s násobitelem),
+/// časy jako t0 a dt, pokud jsou rovnoměrné, a min/max. Rejstřík bloků se zapíše na konec souboru ve finish().
+class CaptureWriter {
+public:
+  explicit CaptureWriter(QIODevice &device);
+
+  /// Zapíše hlavičku souboru, volá se před prvním blokem
+  bool begin();
+  /// Přidá stream, vrátí jeho číslo pro zápis bloků
+  int addStream(int channel, bool logic, int firstBit = 0, int bitCount = 1);
+  /// Zapíše vzorky analogového streamu (rozdělí je na bloky), frameStart označí začátek nového průběhu s vlastní časovou osou
+  bool writeAnalog(int stream, const QCPGraphData *data, int count, bool frameStart = false);
+  /// Zapíše vzorky logického streamu, bits ukazují na data jednotlivých bitů se stejnými časy
+  bool writeLogic(int stream, const QVector<const QCPGraphData *> &bits, int count);
+  /// Zapíše logický stream ve tvaru slov (bit 0 slova = první bit streamu)
+  bool writeLogicWords(int stream, const double *times, const quint32 *words, int count, bool frameStart = false);
+  /// Změní počet bitů logického streamu (zapisuje se až do rejstříku), když není předem známý
+  void setBitCount(int stream, int bitCount) { streams[stream].bitCount = bitCount; }
+  /// Zapíše rejstřík a zakončení, bez něj soubor nejde otevřít
+  bool finish();
+
+  qint64 bytesWritten() const { return position; }
+  bool isOk() const { return ok; }
+
+private:
+  struct StreamInfo {
+    int channel;
+    bool logic;
+    int firstBit, bitCount;
+    qint64 samples = 0;
+  };
+  struct ChunkInfo {
+    qint64 offset;
+    int stream, count;
+    double first, last, min, max;
+  };
+
+  /// time(i) vrací čas i-tého vzorku bloku
+  template <typename TimeFunction> bool writeChunk(int stream, TimeFunction time, int count, const QByteArray &values, int valueType, double multiplier, double min, double max, bool frameStart = false);
+  bool writeBytes(const QByteArray &bytes);
+
+  QIODevice &device;
+  QVector<StreamInfo> streams;
+  QVector<ChunkInfo> chunks;
+  qint64 position = 0;
+  bool ok = true;
+};
+
+/// Uložení a otevření binárního záznamu a export do WAV na vlákně fondu
+/// Otevření namapuje soubor do paměti a bloky dekóduje paralelně přímo do kontejnerů grafů.
+/// Objekt se po skončení sám smaže, výsledek a chyba jsou dostupné ve slotu připojeném na finished.
+class CaptureFile : public QObject {
+  Q_OBJECT
+public:
+  /// Uloží záznam (kontejnery se jen čtou, graf je nesmí měnit, viz MyMainPlot::shareChannelData)
+  static CaptureFile *save(Capture capture, QString fileName);
+  /// Uloží rovnoměrně vzorkovaný kanál jako zvuk (mono, 32 bit float, hodnoty normalizované na rozsah ±1)
+  static CaptureFile *saveWav(QSharedPointer<const QCPGraphDataContainer> channel, QString fileName);
+  /// Načte záznam, data jsou po dokončení v result()
+  static CaptureFile *open(QString fileName);
+
+  /// Spustí připravenou úlohu (až po připojení signálů)
+  void start();
+
+  const Capture &result() const { return capture; }
+  QString errorString() const { return error; }
+
+  /// Synchronní varianty (z libovolného vlákna), při chybě vrátí false a popis v error
+  static bool write(QIODevice &device, const Capture &capture, QString &error, const QAtomicInt *canceled = nullptr, const std::function<void(qint64 samplesDone)> &progress = nullptr);
+  static bool read(const QString &fileName, Capture &capture, QString &error);
+  static bool writeWav(QIODevice &device, const ChannelSnapshot &channel, QString &error);
+
+  /// Interval vzorkování, pokud se žádný interval neliší od průměrného o víc než tolerance (poměrná), jinak 0
+  static double uniformInterval(const ChannelSnapshot &channel, double tolerance);
+
+public slots:
+  /// Zastaví ukládání, rozepsaný soubor se smaže
+  void cancel() { canceled.storeRelaxed(1); }
+
+signals:
+  void progress(int percent);
+  void finished(bool ok);
+
+private:
+  CaptureFile() {}
+
+  /// Běží na fondu, po dokončení se pošle finished a objekt se smaže
+  std::function<bool()> task;
+  Capture capture;
+  QString error;
+  QAtomicInt canceled{0};
+};
+
+#endif // CAPTUREFILE_H
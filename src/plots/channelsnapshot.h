@@ -0,0 +1,69 @@
+//  Copyright (C) 2020-2024  Jiří Maier
+
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef CHANNELSNAPSHOT_H
+#define CHANNELSNAPSHOT_H
+
+#include <algorithm>
+
+#include "plots/qcustomplot.h"
+
+/// Neměnný pohled na data kanálu pro výpočty v jiných vláknech
+/// Drží sdílený ukazatel na kontejner grafu (nic se nekopíruje) a rozsah indexů. Vzorky v rozsahu pohledu graf už nemění
+/// (nanejvýš připojí body za ně do rezervy kontejneru, jinak si udělá vlastní kopii, viz MyMainPlot::detachData).
+/// Výřez podle času je binární vyhledávání, data zůstávají sdílená.
+class ChannelSnapshot {
+public:
+  ChannelSnapshot() {}
+  explicit ChannelSnapshot(QSharedPointer<const QCPGraphDataContainer> container) : container(container) {
+    if (container && !container->isEmpty()) {
+      first = &*container->constBegin();
+      last = first + container->size();
+    }
+  }
+
+  int size() const { return last - first; }
+  bool isEmpty() const { return first == last; }
+  const QCPGraphData *constBegin() const { return first; }
+  const QCPGraphData *constEnd() const { return last; }
+  const QCPGraphData &at(int index) const { return first[index]; }
+  const QCPGraphData &front() const { return *first; }
+  const QCPGraphData &back() const { return *(last - 1); }
+
+  /// Vzorky s časem od from do to (včetně), stejně jako removeBefore(from) a removeAfter(to) na kopii
+  ChannelSnapshot slice(double from, double to) const {
+    ChannelSnapshot result(*this);
+    result.first = std::lower_bound(first, last, from, [](const QCPGraphData &data, double key) { return data.key < key; });
+    result.last = std::upper_bound(result.first, last, to, [](double key, const QCPGraphData &data) { return key < data.key; });
+    return result;
+  }
+  /// Vzorky s časem od from
+  ChannelSnapshot sliceFrom(double from) const { return slice(from, qInf()); }
+
+  QCPRange keyRange() const { return isEmpty() ? QCPRange() : QCPRange(front().key, back().key); }
+  QCPRange valueRange() const {
+    if (isEmpty())
+      return QCPRange();
+    auto minmax = std::minmax_element(first, last, [](const QCPGraphData &a, const QCPGraphData &b) { return a.value < b.value; });
+    return QCPRange(minmax.first->value, minmax.second->value);
+  }
+
+private:
+  QSharedPointer<const QCPGraphDataContainer> container;
+  const QCPGraphData *first = nullptr;
+  const QCPGraphData *last = nullptr;
+};
+
+#endif // CHANNELSNAPSHOT_H
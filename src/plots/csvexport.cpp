@@ -0,0 +1,221 @@
+//  Copyright (C) 2020-2024  Jiří Maier
+
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "csvexport.h"
+#include "math/taskpool.h"
+#include "traceevents.h"
+#include <QBuffer>
+#include <QDebug>
+#include <QFile>
+#include <charconv>
+#include <cmath>
+
+/// Velikost bloku zapisovaného najednou do souboru
+#define CSV_CHUNK_SIZE (1 << 20)
+
+char *CsvFormat::write(char *out, double value) const {
+  int digits = qBound(0, precision, 20);
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+  auto result = std::to_chars(out, out + maxNumberLength, value, std::chars_format::fixed, digits);
+  char *end = (result.ec == std::errc()) ? result.ptr : out;
+#else
+  // Starší standardní knihovny neumí std::to_chars pro double
+  char *end = out + qMax(0, qsnprintf(out, maxNumberLength, "%.*f", digits, value));
+#endif
+  if (decimal != '.')
+    for (char *c = out; c != end; c++)
+      if (*c == '.') {
+        *c = decimal;
+        break;
+      }
+  return end;
+}
+
+namespace {
+/// Buffer výstupu, po naplnění bloku se zapíše do zařízení
+class CsvWriter {
+public:
+  CsvWriter(QIODevice &device, const CsvFormat &format) : device(device), format(format) {
+    // Plnost se kontroluje před každou hodnotou, za blokem musí zbýt místo na čas, hodnotu a oddělovače
+    buffer.resize(CSV_CHUNK_SIZE + 4 * CsvFormat::maxNumberLength);
+    position = buffer.data();
+  }
+
+  void number(double value) { position = format.write(position, value); }
+  void character(char c) { *position++ = c; }
+  void text(const QByteArray &text) {
+    // Záhlaví, může být delší než místo pro číslo
+    if (flush() && device.write(text) != text.size())
+      ok = false;
+  }
+
+  /// Zapíše buffer do zařízení, když je blok plný (nebo vždy, když force)
+  bool flush(bool force = true) {
+    qint64 length = position - buffer.data();
+    if (!force && length < CSV_CHUNK_SIZE)
+      return true;
+    position = buffer.data();
+    if (length && device.write(buffer.constData(), length) != length)
+      ok = false;
+    return ok;
+  }
+  bool isFull() const { return position - buffer.constData() >= CSV_CHUNK_SIZE; }
+
+private:
+  QIODevice &device;
+  const CsvFormat &format;
+  QByteArray buffer;
+  char *position;
+  bool ok = true;
+};
+} // namespace
+
+bool CsvTable::isEmpty() const {
+  if (curve)
+    return curve->isEmpty();
+  for (const Column &column : columns)
+    if (!column.data.isEmpty())
+      return false;
+  return true;
+}
+
+qint64 CsvTable::sampleCount() const {
+  if (curve)
+    return curve->size();
+  qint64 count = 0;
+  for (const Column &column : columns)
+    count += column.data.size();
+  return count;
+}
+
+bool CsvExport::write(QIODevice &device, const CsvTable &table, const CsvFormat &format, const QAtomicInt *canceled, const std::function<void(qint64)> &progress) {
+  CsvWriter writer(device, format);
+  qint64 done = 0;
+
+  // Po každém bloku se kontroluje zrušení a hlásí průběh
+  auto endOfChunk = [&]() {
+    if (!writer.isFull())
+      return true;
+    if (!writer.flush())
+      return false;
+    if (canceled && canceled->loadRelaxed())
+      return false;
+    if (progress)
+      progress(done);
+    return true;
+  };
+
+  if (table.curve) {
+    writer.text(QString("X%1Y\n").arg(format.separator).toUtf8());
+    for (auto it = table.curve->constBegin(); it != table.curve->constEnd(); it++) {
+      writer.number(it->key);
+      writer.character(format.separator);
+      writer.number(it->value);
+      writer.character('\n');
+      done++;
+      if (!endOfChunk())
+        return false;
+    }
+    return writer.flush();
+  }
+
+  QByteArray header = table.keyName.toUtf8();
+  for (const CsvTable::Column &column : table.columns) {
+    header.append(format.separator);
+    header.append(column.name.toUtf8());
+  }
+  header.append('\n');
+  writer.text(header);
+
+  // Spojení seřazených sloupců: čas řádku je nejmenší čas mezi aktuálními pozicemi sloupců, sloupce s tímto časem
+  // zapíší hodnotu a posunou se dál. Každý sloupec se tak projde jen jednou.
+  int columnCount = table.columns.size();
+  QVector<const QCPGraphData *> positions(columnCount), ends(columnCount);
+  for (int i = 0; i < columnCount; i++) {
+    positions[i] = table.columns.at(i).data.constBegin();
+    ends[i] = table.columns.at(i).data.constEnd();
+  }
+  forever {
+    const QCPGraphData *first = nullptr;
+    for (int i = 0; i < columnCount; i++)
+      if (positions.at(i) != ends.at(i) && (!first || positions.at(i)->key < first->key))
+        first = positions.at(i);
+    if (!first)
+      break;
+    double key = first->key;
+    writer.number(key);
+    for (int i = 0; i < columnCount; i++) {
+      // Řádek s mnoha sloupci se nemusí vejít do rezervy bufferu za blokem
+      if (!writer.flush(false))
+        return false;
+      writer.character(format.separator);
+      if (positions.at(i) != ends.at(i) && positions.at(i)->key == key) {
+        if (table.columns.at(i).logic)
+          writer.character(((int)round(positions.at(i)->value) % 3) ? '1' : '0');
+        else
+          writer.number(positions.at(i)->value);
+        positions[i]++;
+        done++;
+      }
+    }
+    writer.character('\n');
+    if (!endOfChunk())
+      return false;
+  }
+  return writer.flush();
+}
+
+void CsvExport::start(QString fileName) {
+  TaskPool::start(
+      [this, fileName]() {
+        TRACE_SCOPE("export", "CSV export");
+        qint64 total = qMax(table.sampleCount(), (qint64)1);
+        int lastPercent = -1;
+        auto reportProgress = [&](qint64 done) {
+          int percent = done * 100 / total;
+          if (percent != lastPercent) {
+            lastPercent = percent;
+            emit progress(percent);
+          }
+        };
+
+        bool ok;
+        QByteArray data;
+        if (fileName.isEmpty()) {
+          QBuffer buffer(&data);
+          buffer.open(QIODevice::WriteOnly);
+          ok = write(buffer, table, format, &canceled, reportProgress);
+          if (!ok)
+            data.clear();
+        } else {
+          QFile file(fileName);
+          if (file.open(QFile::WriteOnly | QFile::Truncate)) {
+            ok = write(file, table, format, &canceled, reportProgress);
+            file.close();
+            if (!ok) {
+              if (!canceled.loadRelaxed())
+                qCritical() << "Cannot write to file" << fileName;
+              file.remove();
+            }
+          } else {
+            qCritical() << "Cannot write to file" << fileName;
+            ok = false;
+          }
+        }
+        emit finished(ok, data);
+        deleteLater();
+      },
+      TaskPool::low);
+}
@@ -0,0 +1,87 @@
+//  Copyright (C) 2020-2024  Jiří Maier
+
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef CSVEXPORT_H
+#define CSVEXPORT_H
+
+#include <QAtomicInt>
+#include <QObject>
+#include <functional>
+
+#include "plots/channelsnapshot.h"
+
+/// Data k exportu do tabulky, připravená v hlavním vlákně (sdílená nebo zkopírovaná data, graf je pak může měnit)
+struct CsvTable {
+  struct Column {
+    QString name;
+    ChannelSnapshot data; ///< Seřazené podle času
+    bool logic = false;   ///< Logický kanál, hodnota (posunutá o 3 * bit) se zapíše jako 0 nebo 1
+  };
+
+  /// Název prvního sloupce (čas, frekvence)
+  QString keyName;
+  /// Sloupce se spojí podle času, řádek je pro každý čas, který má aspoň jeden sloupec, ostatní buňky zůstanou prázdné
+  QVector<Column> columns;
+  /// Křivka XY, když je nastavená, exportují se místo sloupců dvojice X, Y v pořadí křivky
+  QSharedPointer<const QCPCurveDataContainer> curve;
+
+  bool isEmpty() const;
+  /// Celkový počet hodnot (pro průběh exportu)
+  qint64 sampleCount() const;
+};
+
+struct CsvFormat {
+  char separator = ',';
+  char decimal = '.';
+  int precision = 5;
+
+  /// Místo pro jedno číslo, v pevném formátu může mít double přes 300 číslic
+  static const int maxNumberLength = 400;
+  /// Zapíše číslo s pevným počtem desetinných míst (std::to_chars, bez QString), vrátí konec zapsaného textu
+  char *write(char *out, double value) const;
+};
+
+/// Export tabulky do CSV na vlákně fondu
+/// Sloupce se spojují jedním průchodem přes seřazené časy (O(N·C)), čísla se formátují přímo do bufferu (std::to_chars),
+/// který se po blocích zapisuje do souboru, celý výstup tedy nikdy není v paměti.
+/// Objekt se po skončení sám smaže, signály přichází do hlavního vlákna frontou.
+class CsvExport : public QObject {
+  Q_OBJECT
+public:
+  CsvExport(CsvTable table, CsvFormat format) : table(table), format(format) {}
+
+  /// Spustí export do souboru, při prázdném názvu do paměti (výsledek je v signálu finished)
+  void start(QString fileName);
+
+  /// Zapíše tabulku do zařízení (z libovolného vlákna), vrátí false při chybě zápisu nebo zrušení.
+  /// progress dostává počet zapsaných hodnot, volá se po každém bloku.
+  static bool write(QIODevice &device, const CsvTable &table, const CsvFormat &format, const QAtomicInt *canceled = nullptr, const std::function<void(qint64 samplesDone)> &progress = nullptr);
+
+private:
+  CsvTable table;
+  CsvFormat format;
+  QAtomicInt canceled{0};
+
+public slots:
+  /// Zastaví export, rozepsaný soubor se smaže
+  void cancel() { canceled.storeRelaxed(1); }
+
+signals:
+  void progress(int percent);
+  /// ok je false při chybě nebo zrušení, data obsahují výstup při exportu do paměti
+  void finished(bool ok, QByteArray data);
+};
+
+#endif // CSVEXPORT_H
@@ -18,6 +18,7 @@
 
 #include <QObject>
 
+#include "csvexport.h"
 #include "myplot.h"
 
 class MyFFTPlot : public MyPlot {
@@ -25,8 +26,8 @@ class MyFFTPlot : public MyPlot {
  public:
   explicit MyFFTPlot(QWidget* parent = nullptr);
 
-  /// Exportuje oba kanály (nebo jeden, když nejsou oba využité)
-  QByteArray exportCSV(char separator, char decimal, int precision);
+  /// Tabulka k exportu obou kanálů (nebo jednoho, když nejsou oba využité)
+  CsvTable exportTable();
 
   /// Vrátí rozsah vzorků v daném kanálu, které jsou ve viditelném rozsahu osy X
   QPair<unsigned int, unsigned int> getVisibleSamplesRange(int chID);
@@ -43,7 +44,6 @@ class MyFFTPlot : public MyPlot {
   int currentTracerIndex = -1;
   int chSourceChannel[2];
   QColor chSourceColor[2];
-  QPair<QVector<double>, QVector<double> > getDataVector(int chID);
   bool holdmax[2] = {false, false};
   bool firstAutoset = true;
   bool outputPeakValue;
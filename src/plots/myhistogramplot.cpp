@@ -0,0 +1,82 @@
+//  Copyright (C) 2020-2024  Jiří Maier
+
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "myhistogramplot.h"
+
+MyHistogramPlot::MyHistogramPlot(QWidget *parent) : MyPlot(parent) {
+  bars = new QCPBars(xAxis, yAxis);
+  bars->setWidthType(QCPBars::wtPlotCoords);
+  bars->setPen(Qt::NoPen);
+  bars->setBrush(QColor(42, 130, 218));
+
+  xAxis->setSubTicks(false);
+  yAxis->setSubTicks(false);
+  setYUnit(QString(""));
+  setGridHintX(-3);
+  setGridHintY(-3);
+
+  this->setInteraction(QCP::iRangeDrag, true);
+  this->setInteraction(QCP::iRangeZoom, true);
+}
+
+void MyHistogramPlot::setHistogram(const QVector<quint64> &bins, double lower, double binWidth) {
+  if (bins.isEmpty() || binWidth <= 0) {
+    clear();
+    return;
+  }
+
+  // Z histogramu se zobrazí jen rozsah, kde jsou nějaké hodnoty
+  int first = 0, last = bins.size() - 1;
+  while (first < last && bins.at(first) == 0)
+    first++;
+  while (last > first && bins.at(last) == 0)
+    last--;
+
+  QVector<double> keys, values;
+  keys.reserve(last - first + 1);
+  values.reserve(last - first + 1);
+  quint64 maxCount = 1;
+  for (int i = first; i <= last; i++) {
+    keys.append(lower + (i + 0.5) * binWidth);
+    values.append(bins.at(i));
+    maxCount = qMax(maxCount, bins.at(i));
+  }
+  bars->setWidth(binWidth);
+  bars->setData(keys, values, true);
+
+  QCPRange keyRange(lower + first * binWidth, lower + (last + 1) * binWidth);
+  QCPRange valueRange(0, maxCount * 1.05);
+  setMaxZoomX(keyRange, true);
+  setMaxZoomY(valueRange, true);
+  replot(rpQueuedReplot);
+}
+
+void MyHistogramPlot::clear() {
+  bars->data()->clear();
+  replot(rpQueuedReplot);
+}
+
+void MyHistogramPlot::setTheme(QColor fnt, QColor bck, int chClrThemeId) {
+  MyPlot::setTheme(fnt, bck, chClrThemeId);
+  bars->setBrush(chClrThemeId == 2 ? QColor(42, 130, 218).lighter() : QColor(42, 130, 218));
+}
+
+void MyHistogramPlot::mouseMoved(QMouseEvent *event) {
+  Q_UNUSED(event);
+  if (tracer->visible())
+    hideTracer();
+}
+
+void MyHistogramPlot::mousePressed(QMouseEvent *event) { Q_UNUSED(event); }
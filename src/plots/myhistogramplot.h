@@ -0,0 +1,44 @@
+//  Copyright (C) 2020-2024  Jiří Maier
+
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef MYHISTOGRAMPLOT_H
+#define MYHISTOGRAMPLOT_H
+
+#include "myplot.h"
+#include <QObject>
+
+class MyHistogramPlot : public MyPlot {
+  Q_OBJECT
+public:
+  explicit MyHistogramPlot(QWidget *parent = nullptr);
+
+  void setTheme(QColor fnt, QColor bck, int chClrThemeId) override;
+
+private:
+  QCPBars *bars;
+
+public slots:
+  /// Zobrazí koše histogramu (první koš začíná na lower)
+  void setHistogram(const QVector<quint64> &bins, double lower, double binWidth);
+
+  /// Vymaže graf
+  void clear();
+
+private slots:
+  void mouseMoved(QMouseEvent *event);
+  void mousePressed(QMouseEvent *event);
+};
+
+#endif // MYHISTOGRAMPLOT_H
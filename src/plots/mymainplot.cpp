@@ -14,6 +14,8 @@
 //  along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include "mymainplot.h"
+#include "metrics.h"
+#include "traceevents.h"
 
 MyMainPlot::MyMainPlot(QWidget *parent) : MyPlot(parent) {
   xAxis->setSubTicks(false);
@@ -60,6 +62,25 @@ MyMainPlot::MyMainPlot(QWidget *parent) : MyPlot(parent) {
   initTriggerLine();
 
   dataToBeInterpolated.resize(ANALOG_COUNT + MATH_COUNT);
+  sharedData.fill(nullptr, graphCount());
+  appendBuffers.fill(nullptr, graphCount());
+  appendCapacities.fill(0, graphCount());
+  dataVersions.fill(0, graphCount());
+  connect(this, &QCustomPlot::beforeReplot, this, [this]() {
+    replotDuration.start();
+    replotStart = LatencyTrace::now();
+  });
+  // Data předaná se značkou LatencyTrace jsou po překreslení na obrazovce
+  connect(this, &QCustomPlot::afterReplot, this, [this]() {
+    qint64 duration = replotDuration.nsecsElapsed();
+    Metrics::add(Metrics::replots);
+    Metrics::add(Metrics::replotTime, duration);
+    Metrics::set(Metrics::lastReplotTime, duration);
+    TRACE_COMPLETE("gui", "MyMainPlot::replot", replotStart, replotStart + duration);
+    for (auto &stamp : pendingLatency)
+      LatencyTrace::finish(stamp);
+    pendingLatency.clear();
+  });
 
   // Propojení musí být až po skončení inicializace!
   connect(this->yAxis, SIGNAL(rangeChanged(QCPRange)), this, SLOT(verticalAxisRangeChanged()));
@@ -74,6 +95,43 @@ MyMainPlot::MyMainPlot(QWidget *parent) : MyPlot(parent) {
 
 MyMainPlot::~MyMainPlot() {}
 
+QSharedPointer<QCPGraphDataContainer> MyMainPlot::shareChannelData(int chID) {
+  // Výpočet čte celý kontejner (i jeho velikost), do rezervy se už připojovat nesmí
+  sharedData[chID] = graph(chID)->data().data();
+  appendBuffers[chID] = nullptr;
+  return graph(chID)->data();
+}
+
+ChannelSnapshot MyMainPlot::getSnapshot(int chID) {
+  sharedData[chID] = graph(chID)->data().data();
+  return ChannelSnapshot(graph(chID)->data());
+}
+
+void MyMainPlot::detachData(int chID, double key) {
+  // Kopie jen když kontejner mezitím nebyl nahrazen novými daty (režim kanálů data vždy nahrazuje)
+  const QCPGraphDataContainer *data = graph(chID)->data().data();
+  if (sharedData.at(chID) != data)
+    return;
+  // Připojení bodu na konec do rezervy nepřesune ani nepřepíše vzorky, na které ukazují pohledy (ChannelSnapshot),
+  // bod se starším časem by ale kontejner vložil doprostřed
+  if (appendBuffers.at(chID) == data && data->size() < appendCapacities.at(chID) && (data->isEmpty() || key >= (data->constEnd() - 1)->key))
+    return;
+
+  // Nový kontejner s rezervou úměrnou velikosti, v režimu bodů se tak kopíruje jen jednou za mnoho bodů (amortizovaně O(1) na bod)
+  int size = data->size();
+  QVector<QCPGraphData> copy;
+  copy.reserve(size + qMax(size / 2, 1024));
+  for (auto it = data->constBegin(); it != data->constEnd(); ++it)
+    copy.append(*it);
+  auto container = QSharedPointer<QCPGraphDataContainer>(new QCPGraphDataContainer());
+  container->set(copy, true); // Sdílí buffer i s kapacitou, po zániku copy ho kontejner vlastní sám
+  appendBuffers[chID] = container.data();
+  appendCapacities[chID] = copy.capacity();
+  graph(chID)->setData(container);
+  sharedData[chID] = nullptr;
+  Metrics::add(Metrics::plotSamplesCopied, size);
+}
+
 void MyMainPlot::initZeroLines() {
   QPen zeroPen;
   zeroPen.setWidth(1);
@@ -243,18 +301,14 @@ void MyMainPlot::togglePause() {
     resume();
 }
 
-QPair<QVector<double>, QVector<double>> MyMainPlot::getDataVector(int chID, bool onlyInView) {
-  QVector<double> keys, values;
-  for (QCPGraphDataContainer::iterator it = graph(chID)->data()->begin(); it != graph(chID)->data()->end(); it++) {
-    if (!onlyInView || (it->key >= this->xAxis->range().lower && it->key <= this->xAxis->range().upper)) {
-      keys.append(it->key);
-      if (IS_LOGIC_CH(chID))
-        values.append((int)round(it->value) % 3);
-      else
-        values.append(it->value);
-    }
-  }
-  return QPair<QVector<double>, QVector<double>>(keys, values);
+CsvTable::Column MyMainPlot::exportColumn(int chID, bool onlyInView) {
+  CsvTable::Column column;
+  column.name = getChName(chID);
+  column.data = getSnapshot(chID);
+  if (onlyInView)
+    column.data = column.data.slice(xAxis->range().lower, xAxis->range().upper);
+  column.logic = IS_LOGIC_CH(chID);
+  return column;
 }
 
 void MyMainPlot::updateTracerText(int index) {
@@ -331,6 +385,8 @@ void MyMainPlot::setLogicColor(int group, QColor color, int themeIndex) {
         this->graph(getLogicChannelID(group, bit))->setBrush(color);
       }
     }
+    for (auto label : qAsConst(decoderLabels[group]))
+      label->setColor(color);
     this->replot(QCustomPlot::RefreshPriority::rpQueuedReplot);
   }
 }
@@ -339,6 +395,8 @@ void MyMainPlot::setLogicVisibility(int group, bool visible) {
   logicSettings[group].visible = visible;
   for (int bit = 0; bit < LOGIC_BITS; bit++)
     this->graph(getLogicChannelID(group, bit))->setVisible(visible);
+  for (auto label : qAsConst(decoderLabels[group]))
+    label->setVisible(visible);
   this->replot(QCustomPlot::RefreshPriority::rpQueuedReplot);
 }
 
@@ -443,6 +501,7 @@ void MyMainPlot::setChInterpolate(int chID, bool enabled) {
   channelSettings[chID].interpolate = enabled;
   graph(INTERPOLATION_CHID(chID))->setVisible(enabled && channelSettings.at(chID).visible);
   setChStyle(chID, channelSettings.at(chID).style); // Updatuje styl čáry
+  newData = true; // Aby se spustila interpolace
 }
 
 void MyMainPlot::setChVisible(int chID, bool visible) {
@@ -459,8 +518,10 @@ void MyMainPlot::resume() {
   plottingStatus = PlotStatus::run;
   emit showPlotStatus(plottingStatus);
   for (int i = 0; i < ALL_COUNT; i++) {
-    if (!pauseBuffer.at(i).data()->isEmpty())
+    if (!pauseBuffer.at(i).data()->isEmpty()) {
       graph(i)->setData(pauseBuffer.at(i));
+      dataVersions[i]++;
+    }
   }
   pauseBuffer.clear();
   newData = true;
@@ -471,9 +532,16 @@ void MyMainPlot::update() {
     newData = false;
     updateMinMaxTimes();
     redraw();
+    emit dataUpdated();
   }
 }
 
+void MyMainPlot::traceLatency(const LatencyTrace::Stamp &stamp) {
+  // Při pozastaveném grafu se nepřekresluje, značek se nahromadí jen omezeně
+  if (stamp.isValid() && pendingLatency.size() < 256)
+    pendingLatency.append(stamp);
+}
+
 void MyMainPlot::redraw() {
   emit requestCursorUpdate();
 
@@ -500,7 +568,9 @@ void MyMainPlot::clearLogicGroup(int number, int fromBit) {
 }
 
 void MyMainPlot::clearCh(int chID) {
-  this->graph(chID)->data().data()->clear(); // Odstraní kanál
+  // Nový prázdný kontejner místo mazání, starý může ještě číst výpočet
+  this->graph(chID)->setData(QSharedPointer<QCPGraphDataContainer>(new QCPGraphDataContainer)); // Odstraní kanál
+  dataVersions[chID]++;
   if (chID < ANALOG_COUNT + MATH_COUNT)
     this->graph(INTERPOLATION_CHID(chID))->data().data()->clear(); // Odstraní graf interpolace
   if (plottingStatus == PlotStatus::pause)
@@ -509,12 +579,51 @@ void MyMainPlot::clearCh(int chID) {
   newData = true;                  // Aby se překreslil graf
 }
 
+void MyMainPlot::clearDecoderLabels(int group) {
+  for (auto label : qAsConst(decoderLabels[group]))
+    removeItem(label);
+  decoderLabels[group].clear();
+}
+
+void MyMainPlot::newDecodedWords(int group, QVector<DecodedWord> words, bool clear) {
+  if (clear)
+    clearDecoderLabels(group);
+  // Popisků může být hodně, staré se zahodí (celý seznam je v tabulce dekodéru)
+  const int maxLabels = 256;
+  if (words.size() > maxLabels)
+    words.remove(0, words.size() - maxLabels);
+  int overflow = decoderLabels[group].size() + words.size() - maxLabels;
+  if (overflow > 0) {
+    for (int i = 0; i < overflow; i++)
+      removeItem(decoderLabels[group].at(i));
+    decoderLabels[group].remove(0, overflow);
+  }
+
+  // Nad nejvyšší použitý bit skupiny
+  double y = 3 * qMax(getLogicBitsUsed(group), 1) - 1;
+  for (const auto &word : qAsConst(words)) {
+    auto label = new QCPItemText(this);
+    label->position->setAxes(xAxis, logicGroupAxis.at(group));
+    label->position->setCoords((word.start + word.end) / 2, y);
+    label->setPositionAlignment(Qt::AlignBottom | Qt::AlignHCenter);
+    label->setText(word.text());
+    label->setColor(getLogicColor(group));
+    label->setBrush(triggerLabel->brush());
+    label->setPadding(QMargins(2, 0, 2, 0));
+    label->setVisible(logicSettings.at(group).visible);
+    decoderLabels[group].append(label);
+  }
+  this->replot(QCustomPlot::RefreshPriority::rpQueuedReplot);
+}
+
 void MyMainPlot::resetChannels() {
   for (int i = 0; i < ALL_COUNT; i++) {
     clearCh(i);
     if (plottingStatus == PlotStatus::pause)
       pauseBuffer.at(i)->clear();
   }
+  for (int i = 0; i < LOGIC_GROUPS; i++)
+    clearDecoderLabels(i);
   setTriggerLineChannel(0);
   setTriggerLineValue(0);
   updateMinMaxTimes();
@@ -538,19 +647,24 @@ void MyMainPlot::newDataVector(int chID, QSharedPointer<QCPGraphDataContainer> d
       // odkud si je odebere interpolátor
       if (channelSettings.at(chID).interpolate) {
         dataToBeInterpolated[chID] = data;
+        newData = true; // Aby se spustila interpolace
         return;
       }
     }
     this->graph(chID)->setData(data);
+    dataVersions[chID]++;
     newData = true;
   }
   setLastDataTypeWasPoint(false);
 }
 
 void MyMainPlot::newInterpolatedVector(int chID, QSharedPointer<QCPGraphDataContainer> dataOriginal, QSharedPointer<QCPGraphDataContainer> dataInterpolated, bool dataIsFromInterpolationBuffer) {
-  if (dataIsFromInterpolationBuffer)
+  if (dataIsFromInterpolationBuffer) {
     this->graph(chID)->setData(dataOriginal);
+    dataVersions[chID]++;
+  }
   this->graph(INTERPOLATION_CHID(chID))->setData(dataInterpolated);
+  dataVersions[INTERPOLATION_CHID(chID)]++;
   newData = true;
   setLastDataTypeWasPoint(false);
 }
@@ -610,6 +724,9 @@ void MyMainPlot::setTheme(QColor fnt, QColor bck, int chClrThemeId) {
     item->setBrush(b);
     item->setColor(fnt);
   }
+  for (int i = 0; i < LOGIC_GROUPS; i++)
+    for (auto item : qAsConst(decoderLabels[i]))
+      item->setBrush(triggerLabel->brush());
 
   QVector<QCPItemLine *> lines;
   lines << triggerLine;
@@ -625,10 +742,12 @@ void MyMainPlot::setTheme(QColor fnt, QColor bck, int chClrThemeId) {
 void MyMainPlot::newDataPoint(int chID, double time, double value, bool append) {
   if (plottingStatus != PlotStatus::pause) {
     if (!append) {
-      this->graph(chID)->data()->clear();
+      this->graph(chID)->setData(QSharedPointer<QCPGraphDataContainer>(new QCPGraphDataContainer));
       this->graph(INTERPOLATION_CHID(chID))->data()->clear();
-    }
+    } else
+      detachData(chID, time);
     this->graph(chID)->addData(time, value);
+    dataVersions[chID]++;
     newData = true;
   } else {
     if (!append)
@@ -648,84 +767,77 @@ void MyMainPlot::newDataPoint(int chID, double time, double value, bool append)
   setLastDataTypeWasPoint(true);
 }
 
-QByteArray MyMainPlot::exportChannelCSV(char separator, char decimal, int chID, int precision, bool onlyInView) {
-  if (graph(chID)->data()->isEmpty())
-    return "";
-  QByteArray output = (QString("time%1%2\n").arg(separator).arg(getChName(chID))).toUtf8();
-  for (QCPGraphDataContainer::iterator it = graph(chID)->data()->begin(); it != graph(chID)->data()->end(); it++) {
-    if (!onlyInView || (it->key >= this->xAxis->range().lower && it->key <= this->xAxis->range().upper)) {
-      output.append(QString::number(it->key, 'f', precision).replace('.', decimal).toUtf8());
-      output.append(separator);
-      output.append(QString::number(it->value, 'f', precision).replace('.', decimal).toUtf8());
-      output.append('\n');
-    }
-  }
-  return output;
+CsvTable MyMainPlot::exportChannelTable(int chID, bool onlyInView) {
+  CsvTable table;
+  table.keyName = tr("time");
+  table.columns.append(exportColumn(chID, onlyInView));
+  return table;
 }
 
-QByteArray MyMainPlot::exportLogicCSV(char separator, char decimal, int group, int precision, bool onlyInView) {
-  int bits = getLogicBitsUsed(group);
-  if (bits == 0)
-    return "";
+CsvTable MyMainPlot::exportLogicTable(int group, bool onlyInView) {
+  CsvTable table;
+  table.keyName = tr("time");
+  for (int bit = 0; bit < getLogicBitsUsed(group); bit++) {
+    table.columns.append(exportColumn(getLogicChannelID(group, bit), onlyInView));
+    table.columns.last().name = QString("bit %1").arg(bit);
+  }
+  return table;
+}
 
-  QByteArray output = tr("time").toUtf8();
+CsvTable MyMainPlot::exportAllTable(bool onlyInView, bool includeHidden) {
+  CsvTable table;
+  table.keyName = tr("time");
+  for (int i = 0; i < ALL_COUNT; i++)
+    if (!graph(i)->data()->isEmpty() && (graph(i)->visible() || includeHidden))
+      table.columns.append(exportColumn(i, onlyInView));
+  return table;
+}
 
-  for (int i = 0; i < bits; i++) {
-    output.append(separator);
-    output.append(QString("bit %1").arg(i).toUtf8());
+Capture MyMainPlot::exportCapture() {
+  Capture capture;
+  for (int i = 0; i < ANALOG_COUNT + MATH_COUNT; i++) {
+    if (graph(i)->data()->isEmpty())
+      continue;
+    Capture::Stream stream;
+    stream.channel = i;
+    stream.columns.append(shareChannelData(i));
+    capture.streams.append(stream);
   }
-  output.append('\n');
-  for (int i = 0; i < graph(getLogicChannelID(group, 0))->dataCount(); i++) {
-    double time = graph(getLogicChannelID(group, 0))->data()->at(i)->key;
-    if (!onlyInView || (time >= this->xAxis->range().lower && time <= this->xAxis->range().upper)) {
-      output.append(QString::number(time, 'f', precision).toUtf8());
-      for (int bit = 0; bit < bits; bit++) {
-        output.append(separator);
-        int chID = getLogicChannelID(group, bit);
-        output.append(QString((((int)round(graph(chID)->data()->at(i)->value)) % 3) ? "1" : "0").replace('.', decimal).toUtf8());
-      }
-      output.append('\n');
-    }
+  for (int group = 0; group < LOGIC_GROUPS; group++) {
+    int bits = getLogicBitsUsed(group);
+    if (bits == 0)
+      continue;
+    Capture::Stream stream;
+    stream.channel = group;
+    stream.logic = true;
+    for (int bit = 0; bit < bits; bit++)
+      stream.columns.append(shareChannelData(getLogicChannelID(group, bit)));
+    capture.streams.append(stream);
   }
-  return output;
+  return capture;
 }
 
-QByteArray MyMainPlot::exportAllCSV(char separator, char decimal, int precision, bool onlyInView, bool includeHidden) {
-  QByteArray output = "";
-  QVector<QPair<QVector<double>, QVector<double>>> channels;
-  bool firstNonEmpty = true;
-  for (int i = 0; i < ALL_COUNT; i++) {
-    if (!graph(i)->data()->isEmpty() && (graph(i)->visible() || includeHidden)) {
-      if (firstNonEmpty) {
-        firstNonEmpty = false;
-        output.append(tr("time").toUtf8());
+void MyMainPlot::showCapture(const Capture &capture) {
+  if (plottingStatus == PlotStatus::run)
+    pause();
+  resetChannels();
+  for (const Capture::Stream &stream : capture.streams) {
+    for (int i = 0; i < stream.columns.size(); i++) {
+      int chID = stream.logic ? getLogicChannelID(stream.channel, stream.firstBit + i) : stream.channel;
+      QSharedPointer<QCPGraphDataContainer> column = stream.columns.at(i);
+      if (!stream.frameStarts.isEmpty()) {
+        // Zalogované průběhy mají každý vlastní časovou osu, zobrazí se poslední (jako při příjmu)
+        QVector<QCPGraphData> samples(column->size() - stream.frameStarts.last());
+        std::copy(column->constBegin() + stream.frameStarts.last(), column->constEnd(), samples.begin());
+        column = QSharedPointer<QCPGraphDataContainer>(new QCPGraphDataContainer());
+        column->set(samples, true);
       }
-      channels.append(getDataVector(i, onlyInView));
-      output.append(separator);
-      output.append(getChName(i).toUtf8());
+      graph(chID)->setData(column);
+      dataVersions[chID]++;
     }
   }
-  QList<double> times;
-  for (QVector<QPair<QVector<double>, QVector<double>>>::iterator it = channels.begin(); it != channels.end(); it++)
-    foreach (double time, it->first)
-      if (!times.contains(time))
-        times.append(time);
-  std::sort(times.begin(), times.end());
-
-  foreach (double time, times) {
-    output.append('\n');
-    output.append(QString::number(time, 'f', precision).replace('.', decimal).toUtf8());
-    for (QVector<QPair<QVector<double>, QVector<double>>>::iterator it = channels.begin(); it != channels.end(); it++) {
-      output.append(separator);
-      if (!it->first.isEmpty())
-        if (it->first.first() == time) {
-          output.append(QString::number(it->second.first(), 'f', precision).replace('.', decimal).toUtf8());
-          it->first.pop_front();
-          it->second.pop_front();
-        }
-    }
-  }
-  return output;
+  newData = true;
+  setLastDataTypeWasPoint(false);
 }
 
 void MyMainPlot::mouseMoved(QMouseEvent *event) {
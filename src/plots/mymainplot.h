@@ -16,9 +16,15 @@
 #ifndef MYMAINPLOT_H
 #define MYMAINPLOT_H
 
+#include <QElapsedTimer>
 #include <QTimer>
 
+#include "communication/latencytrace.h"
 #include "communication/plotdata.h"
+#include "math/protocoldecoder.h"
+#include "channelsnapshot.h"
+#include "capturefile.h"
+#include "csvexport.h"
 #include "myplot.h"
 
 class MyMainPlot : public MyPlot {
@@ -124,14 +130,22 @@ public:
   /// Je zobrazený/skrytý?
   bool isLogicVisible(int group) { return logicSettings.at(group).visible; }
 
-  /// Exportuje jeden analogový kanál
-  QByteArray exportChannelCSV(char separator, char decimal, int chID, int precision, bool onlyInView);
+  /// Tabulka k exportu jednoho analogového kanálu
+  CsvTable exportChannelTable(int chID, bool onlyInView);
 
-  /// Exportuje skupinu logických kanálů
-  QByteArray exportLogicCSV(char separator, char decimal, int group, int precision, bool onlyInView);
+  /// Tabulka k exportu skupiny logických kanálů
+  CsvTable exportLogicTable(int group, bool onlyInView);
 
-  /// Exportuje vše (včetně logických)
-  QByteArray exportAllCSV(char separator, char decimal, int precision, bool onlyInView, bool includeHidden);
+  /// Tabulka k exportu všeho (včetně logických)
+  CsvTable exportAllTable(bool onlyInView, bool includeHidden);
+
+  /// Všechny kanály s daty pro uložení do binárního záznamu (data se sdílí, nekopírují)
+  Capture exportCapture();
+
+  /// Zobrazí otevřený záznam místo aktuálních dat, graf se pozastaví, aby je nepřepsala nově přijatá data
+  void showCapture(const Capture &capture);
+
+  bool isPaused() const { return plottingStatus == PlotStatus::pause; }
 
   /// Vrátí osu hodnot zadaného kanálu
   QCPAxis *getAnalogAxis(int chID) const { return analogAxis.at(chID); }
@@ -139,6 +153,19 @@ public:
   /// Fronta kanálů pro interpolování
   QVector<QSharedPointer<QCPGraphDataContainer>> dataToBeInterpolated;
 
+  /// Kontejner dat grafu sdílený s výpočty (jen pro čtení), graf ho od teď nemění, před změnou si udělá kopii
+  QSharedPointer<QCPGraphDataContainer> shareChannelData(int chID);
+
+  /// Neměnný pohled na data kanálu bez kopírování
+  /// Pohled drží jen dosavadní vzorky, takže nové body se smí připojovat do rezervy kontejneru (viz detachData).
+  ChannelSnapshot getSnapshot(int chID);
+
+  /// Verze dat kanálu, zvýší se při každé změně dat (podle ní se rozhoduje, zda přepočítat analýzy)
+  quint64 getDataVersion(int chID) const { return dataVersions.at(chID); }
+
+  /// Data se značkou byla předána grafu, po nejbližším překreslení se zapíše zpoždění vykreslení
+  void traceLatency(const LatencyTrace::Stamp &stamp);
+
   /// Nastaví OpenGL a překreslí graf
   void setOpenGL(bool enable) {
     QCustomPlot::setOpenGl(enable);
@@ -161,6 +188,19 @@ public:
 private:
   void redraw();
 
+  /// Kontejnery, které drží i výpočty (podle grafu), data v nich se nesmí měnit
+  QVector<const QCPGraphDataContainer *> sharedData;
+  /// Kontejnery vytvořené v detachData s rezervou na konci a jejich kapacita, body se do rezervy připojují i při sdílení pohledem
+  QVector<const QCPGraphDataContainer *> appendBuffers;
+  QVector<int> appendCapacities;
+  QVector<quint64> dataVersions;
+  /// Před připojením bodu s časem key: když data sdílí výpočty, přesune je do nového kontejneru (jen pokud bod nejde do rezervy)
+  void detachData(int chID, double key);
+
+  QVector<LatencyTrace::Stamp> pendingLatency;
+  QElapsedTimer replotDuration;
+  qint64 replotStart = 0; ///< Čas LatencyTrace pro záznam TraceEvents
+
   QTimer plotUpdateTimer;
 
   void resume();
@@ -170,7 +210,7 @@ private:
   void updateMinMaxTimes();
   void reOffsetAndRescaleCH(int chID);
   void reOffsetAndRescaleLogic(int chID);
-  QPair<QVector<double>, QVector<double>> getDataVector(int chID, bool onlyInView = false);
+  CsvTable::Column exportColumn(int chID, bool onlyInView);
   void updateTracerText(int index);
   int currentTracerIndex = -1;
 
@@ -197,6 +237,8 @@ private:
   QCPGraph *triggerLineCh;
   bool triggerLineEnabled = false;
   QCPItemText *triggerLabel;
+  QVector<QCPItemText *> decoderLabels[LOGIC_GROUPS];
+  void clearDecoderLabels(int group);
   enum Mode { free, growing, rolling, empty, free_locked } mode = empty;
   double lastSignalEnd = 0;
   void updateRollingState(double xMax);
@@ -228,6 +270,9 @@ public slots:
   /// Vymaže kanál
   void clearCh(int chID);
 
+  /// Přidá popisky dekódovaných slov nad logickou skupinu
+  void newDecodedWords(int group, QVector<DecodedWord> words, bool clear);
+
   /// Přidá bod do kanálu
   void newDataPoint(int chID, double time, double value, bool append);
 
@@ -252,6 +297,9 @@ signals:
   /// Změnil se stav (běží/pauza)
   void showPlotStatus(PlotStatus::enumPlotStatus type);
 
+  /// Data některého kanálu se změnila (nejvýše jednou za překreslení)
+  void dataUpdated();
+
   /// Změna dat, přepočítat polohu kurzorů
   void requestCursorUpdate();
 
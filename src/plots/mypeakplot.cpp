@@ -37,51 +37,19 @@ MyPeakPlot::MyPeakPlot(QWidget *parent) : MyPlot(parent) {
   this->setInteraction(QCP::iRangeZoom, true);
 }
 
-QPair<QVector<double>, QVector<double>> MyPeakPlot::getDataVector(int chID) {
-  QVector<double> keys, values;
-  for (QCPGraphDataContainer::iterator it = graph(chID)->data()->begin(); it != graph(chID)->data()->end(); it++) {
-    keys.append(it->key);
-    values.append(it->value);
-  }
-  return QPair<QVector<double>, QVector<double>>(keys, values);
-}
-
-QByteArray MyPeakPlot::exportCSV(char separator, char decimal, int precision) {
-  QByteArray output = "";
-  QVector<QPair<QVector<double>, QVector<double>>> channels;
-  bool firstNonEmpty = true;
+CsvTable MyPeakPlot::exportTable() {
+  // Data se kopírují, graf do nich dál přidává
+  CsvTable table;
+  table.keyName = tr("time");
   for (int i = 0; i < graphCount(); i++) {
     if (!graph(i)->data()->isEmpty()) {
-      if (firstNonEmpty) {
-        firstNonEmpty = false;
-        output.append(tr("time").toUtf8());
-      }
-      channels.append(getDataVector(i));
-      output.append(separator);
-      output.append(getChName(chSourceChannel[i]).toUtf8());
-    }
-  }
-  QList<double> times;
-  for (QVector<QPair<QVector<double>, QVector<double>>>::iterator it = channels.begin(); it != channels.end(); it++)
-    foreach (double time, it->first)
-      if (!times.contains(time))
-        times.append(time);
-  std::sort(times.begin(), times.end());
-
-  foreach (double time, times) {
-    output.append('\n');
-    output.append(QString::number(time, 'f', precision).replace('.', decimal).toUtf8());
-    for (QVector<QPair<QVector<double>, QVector<double>>>::iterator it = channels.begin(); it != channels.end(); it++) {
-      output.append(separator);
-      if (!it->first.isEmpty())
-        if (it->first.first() == time) {
-          output.append(QString::number(it->second.first(), 'f', precision).replace('.', decimal).toUtf8());
-          it->first.pop_front();
-          it->second.pop_front();
-        }
+      CsvTable::Column column;
+      column.name = getChName(chSourceChannel[i]);
+      column.data = ChannelSnapshot(QSharedPointer<const QCPGraphDataContainer>(new QCPGraphDataContainer(*graph(i)->data())));
+      table.columns.append(column);
     }
   }
-  return output;
+  return table;
 }
 
 QPair<unsigned int, unsigned int> MyPeakPlot::getVisibleSamplesRange(int chID) {
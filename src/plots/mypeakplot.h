@@ -16,6 +16,7 @@
 #ifndef MYPEAKPLOT_H
 #define MYPEAKPLOT_H
 
+#include "csvexport.h"
 #include "myplot.h"
 #include <QObject>
 
@@ -25,8 +26,8 @@ public:
   explicit MyPeakPlot(QWidget *parent = nullptr);
   void setUptimeTimer(QElapsedTimer *timer) { uptime = timer; }
 
-  /// Exportuje oba kanály (nebo jeden, když nejsou oba využité)
-  QByteArray exportCSV(char separator, char decimal, int precision);
+  /// Tabulka k exportu obou kanálů (nebo jednoho, když nejsou oba využité)
+  CsvTable exportTable();
 
   /// Vrátí rozsah vzorků v daném kanálu, které jsou ve viditelném rozsahu osy X
   QPair<unsigned int, unsigned int> getVisibleSamplesRange(int chID);
@@ -44,7 +45,6 @@ private:
   int currentTracerIndex = -1;
   int chSourceChannel[2];
   QColor chSourceColor[2];
-  QPair<QVector<double>, QVector<double>> getDataVector(int chID);
   QCPItemText *infoText;
   QElapsedTimer *uptime;
   double timeLength = 100;
@@ -0,0 +1,98 @@
+//  Copyright (C) 2020-2024  Jiří Maier
+
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "mypersistenceplot.h"
+
+MyPersistencePlot::MyPersistencePlot(QWidget *parent) : MyPlot(parent) {
+  map = new QCPColorMap(xAxis, yAxis);
+  map->setInterpolate(false);
+  map->setTightBoundary(true);
+  colorScale = new QCPColorScale(this);
+  plotLayout()->addElement(0, 1, colorScale);
+  colorScale->setType(QCPAxis::atRight);
+  map->setColorScale(colorScale);
+
+  // Prázdná místa jsou průhledná, aby bylo vidět pozadí podle tématu
+  QCPColorGradient gradient(QCPColorGradient::gpJet);
+  gradient.setColorStopAt(0, Qt::transparent);
+  colorScale->setGradient(gradient);
+  colorScale->setDataRange(QCPRange(0, 1));
+  colorScale->axis()->setLabel(tr("log hits"));
+
+  QCPMarginGroup *marginGroup = new QCPMarginGroup(this);
+  axisRect()->setMarginGroup(QCP::msBottom | QCP::msTop, marginGroup);
+  colorScale->setMarginGroup(QCP::msBottom | QCP::msTop, marginGroup);
+
+  xAxis->setSubTicks(false);
+  yAxis->setSubTicks(false);
+  setGridHintX(-3);
+  setGridHintY(-3);
+
+  this->setInteraction(QCP::iRangeDrag, true);
+  this->setInteraction(QCP::iRangeZoom, true);
+}
+
+void MyPersistencePlot::newDensity(QVector<float> density, int columns, int rows, QCPRange keyRange, QCPRange valueRange, float maxValue) {
+  if (columns <= 0 || rows <= 0 || density.size() < columns * rows || keyRange.size() <= 0 || valueRange.size() <= 0) {
+    clear();
+    return;
+  }
+
+  QCPColorMapData *data = map->data();
+  if (data->keySize() != columns || data->valueSize() != rows)
+    data->setSize(columns, rows);
+  // Buňky pole jsou intervaly, mapa pracuje se středy buněk
+  double halfColumn = 0.5 * keyRange.size() / columns;
+  double halfRow = 0.5 * valueRange.size() / rows;
+  data->setRange(QCPRange(keyRange.lower + halfColumn, keyRange.upper - halfColumn), QCPRange(valueRange.lower + halfRow, valueRange.upper - halfRow));
+
+  const float *cell = density.constData();
+  for (int column = 0; column < columns; column++)
+    for (int row = 0; row < rows; row++, cell++)
+      data->setCell(column, row, *cell > 0 ? log10(1 + *cell) : 0);
+  colorScale->setDataRange(QCPRange(0, qMax(1.0, log10(1 + maxValue))));
+
+  // Při změně rozsahu (nový zdroj nebo vzorkování) se přizpůsobí zoom
+  if (keyRange != lastKeyRange || valueRange != lastValueRange) {
+    lastKeyRange = keyRange;
+    lastValueRange = valueRange;
+    setMaxZoomX(keyRange, true);
+    setMaxZoomY(valueRange, true);
+  }
+
+  replot(rpQueuedReplot);
+}
+
+void MyPersistencePlot::clear() {
+  map->data()->fill(0);
+  replot(rpQueuedReplot);
+}
+
+void MyPersistencePlot::setTheme(QColor fnt, QColor bck, int chClrThemeId) {
+  MyPlot::setTheme(fnt, bck, chClrThemeId);
+  colorScale->axis()->setBasePen(fnt);
+  colorScale->axis()->setLabelColor(fnt);
+  colorScale->axis()->setTickLabelColor(fnt);
+  colorScale->axis()->setTickPen(fnt);
+  colorScale->axis()->setSubTickPen(fnt);
+}
+
+void MyPersistencePlot::mouseMoved(QMouseEvent *event) {
+  Q_UNUSED(event);
+  if (tracer->visible())
+    hideTracer();
+}
+
+void MyPersistencePlot::mousePressed(QMouseEvent *event) { Q_UNUSED(event); }
@@ -0,0 +1,46 @@
+//  Copyright (C) 2020-2024  Jiří Maier
+
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef MYPERSISTENCEPLOT_H
+#define MYPERSISTENCEPLOT_H
+
+#include "myplot.h"
+#include <QObject>
+
+class MyPersistencePlot : public MyPlot {
+  Q_OBJECT
+public:
+  explicit MyPersistencePlot(QWidget *parent = nullptr);
+
+  void setTheme(QColor fnt, QColor bck, int chClrThemeId) override;
+
+private:
+  QCPColorMap *map;
+  QCPColorScale *colorScale;
+  QCPRange lastKeyRange, lastValueRange;
+
+public slots:
+  /// Zobrazí pole zásahů spočítané ve vlákně Persistence (barva odpovídá logaritmu počtu zásahů)
+  void newDensity(QVector<float> density, int columns, int rows, QCPRange keyRange, QCPRange valueRange, float maxValue);
+
+  /// Vymaže graf
+  void clear();
+
+private slots:
+  void mouseMoved(QMouseEvent *event);
+  void mousePressed(QMouseEvent *event);
+};
+
+#endif // MYPERSISTENCEPLOT_H
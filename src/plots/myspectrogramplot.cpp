@@ -0,0 +1,156 @@
+//  Copyright (C) 2020-2024  Jiří Maier
+
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "myspectrogramplot.h"
+
+MySpectrogramMap::MySpectrogramMap(QCPAxis *keyAxis, QCPAxis *valueAxis) : QCPColorMap(keyAxis, valueAxis) {
+  setInterpolate(false);
+  setTightBoundary(false);
+  // Vlastní data jsou v kruhovém zásobníku, mapa drží jen rozsahy os
+  data()->setSize(2, 2);
+}
+
+void MySpectrogramMap::resetRing(int rowCount, int binCount) {
+  ringRows = rowCount;
+  ringBins = binCount;
+  writeRow = 0;
+  // Prázdné řádky mají nejnižší barvu (výpočet dává minimálně -300 dB)
+  ringValues.fill(-1000, rowCount * binCount);
+  ringImage = QImage(QSize(binCount, rowCount), QImage::Format_ARGB32_Premultiplied);
+  mMapImageInvalidated = true;
+}
+
+void MySpectrogramMap::colorizeRow(int row) {
+  // Řádky obrázku jsou odspodu, stejně jako v QCPColorMap::updateMapImage
+  QRgb *pixels = reinterpret_cast<QRgb *>(ringImage.scanLine(ringRows - 1 - row));
+  mGradient.colorize(ringValues.constData() + row * ringBins, mDataRange, pixels, ringBins, 1, mDataScaleType == QCPAxis::stLogarithmic);
+}
+
+void MySpectrogramMap::addRow(const double *values) {
+  if (ringRows == 0)
+    return;
+  std::copy(values, values + ringBins, ringValues.begin() + writeRow * ringBins);
+  // Když se stejně bude přebarvovat celý obrázek, není třeba barvit řádek zvlášť
+  if (!mMapImageInvalidated)
+    colorizeRow(writeRow);
+  writeRow = (writeRow + 1) % ringRows;
+}
+
+void MySpectrogramMap::updateMapImage() {
+  for (int row = 0; row < ringRows; row++)
+    colorizeRow(row);
+  mMapImageInvalidated = false;
+}
+
+void MySpectrogramMap::draw(QCPPainter *painter) {
+  if (ringRows == 0 || ringBins == 0 || !mKeyAxis || !mValueAxis)
+    return;
+  if (mMapImageInvalidated)
+    updateMapImage();
+  applyDefaultAntialiasingHint(painter);
+
+  // Klíčová osa (čas) je svislá, nejnovější řádek (čas 0) je nahoře
+  QRectF imageRect = QRectF(coordsToPixels(mMapData->keyRange().lower, mMapData->valueRange().lower), coordsToPixels(mMapData->keyRange().upper, mMapData->valueRange().upper)).normalized();
+  double halfCellHeight = ringRows > 1 ? 0.5 * imageRect.height() / (ringRows - 1) : 0;
+  double halfCellWidth = ringBins > 1 ? 0.5 * imageRect.width() / (ringBins - 1) : 0;
+  imageRect.adjust(-halfCellWidth, -halfCellHeight, halfCellWidth, halfCellHeight);
+
+  const bool smoothBackup = painter->renderHints().testFlag(QPainter::SmoothPixmapTransform);
+  painter->setRenderHint(QPainter::SmoothPixmapTransform, false);
+
+  // Řádky zapsané od posledního přetočení zásobníku jsou v obrázku nahoře (řádky 0 až writeRow-1 jsou uloženy odspodu)
+  double topHeight = imageRect.height() * writeRow / ringRows;
+  if (writeRow > 0)
+    painter->drawImage(QRectF(imageRect.left(), imageRect.top(), imageRect.width(), topHeight), ringImage, QRectF(0, ringRows - writeRow, ringBins, writeRow));
+  if (writeRow < ringRows)
+    painter->drawImage(QRectF(imageRect.left(), imageRect.top() + topHeight, imageRect.width(), imageRect.height() - topHeight), ringImage, QRectF(0, 0, ringBins, ringRows - writeRow));
+
+  painter->setRenderHint(QPainter::SmoothPixmapTransform, smoothBackup);
+}
+
+MySpectrogramPlot::MySpectrogramPlot(QWidget *parent) : MyPlot(parent) {
+  map = new MySpectrogramMap(yAxis, xAxis);
+  colorScale = new QCPColorScale(this);
+  plotLayout()->addElement(0, 1, colorScale);
+  colorScale->setType(QCPAxis::atRight);
+  map->setColorScale(colorScale);
+  colorScale->setGradient(QCPColorGradient::gpJet);
+  colorScale->setDataRange(QCPRange(-120, 0));
+  colorScale->axis()->setLabel("dB");
+
+  QCPMarginGroup *marginGroup = new QCPMarginGroup(this);
+  axisRect()->setMarginGroup(QCP::msBottom | QCP::msTop, marginGroup);
+  colorScale->setMarginGroup(QCP::msBottom | QCP::msTop, marginGroup);
+
+  xAxis->setSubTicks(false);
+  yAxis->setSubTicks(false);
+  setXUnit(QString("-Hz"));
+  setYUnit(QString("time"));
+  setMaxZoomX(QCPRange(0, 1), true);
+  setMaxZoomY(QCPRange(-1, 0), true);
+  setGridHintX(-3);
+  setGridHintY(-3);
+
+  this->setInteraction(QCP::iRangeDrag, true);
+  this->setInteraction(QCP::iRangeZoom, true);
+}
+
+void MySpectrogramPlot::newRows(QVector<double> rows, int binCount, double binWidth, double rowPeriod) {
+  if (binCount <= 0)
+    return;
+
+  // Při změně osy frekvence nebo času se začne znovu, malé změny (perioda dolaďovaná z bodů) se ignorují
+  if (binCount != map->binCount() || qAbs(binWidth - lastBinWidth) > 0.01 * binWidth || qAbs(rowPeriod - lastRowPeriod) > 0.01 * rowPeriod) {
+    lastBinWidth = binWidth;
+    lastRowPeriod = rowPeriod;
+    map->resetRing(rowCount, binCount);
+    map->data()->setRange(QCPRange(-(rowCount - 1) * rowPeriod, 0), QCPRange(0, (binCount - 1) * binWidth));
+    setMaxZoomX(map->data()->valueRange(), true);
+    setMaxZoomY(map->data()->keyRange(), true);
+  }
+
+  for (int offset = 0; offset + binCount <= rows.size(); offset += binCount)
+    map->addRow(rows.constData() + offset);
+
+  replot(rpQueuedReplot);
+}
+
+void MySpectrogramPlot::clear() {
+  map->resetRing(rowCount, map->binCount());
+  replot(rpQueuedReplot);
+}
+
+void MySpectrogramPlot::setDBRange(double min, double max) {
+  if (max > min)
+    colorScale->setDataRange(QCPRange(min, max));
+  replot(rpQueuedReplot);
+}
+
+void MySpectrogramPlot::setTheme(QColor fnt, QColor bck, int chClrThemeId) {
+  MyPlot::setTheme(fnt, bck, chClrThemeId);
+  colorScale->axis()->setBasePen(fnt);
+  colorScale->axis()->setLabelColor(fnt);
+  colorScale->axis()->setTickLabelColor(fnt);
+  colorScale->axis()->setTickPen(fnt);
+  colorScale->axis()->setSubTickPen(fnt);
+}
+
+void MySpectrogramPlot::mouseMoved(QMouseEvent *event) {
+  Q_UNUSED(event);
+  if (tracer->visible())
+    hideTracer();
+}
+
+void MySpectrogramPlot::mousePressed(QMouseEvent *event) { Q_UNUSED(event); }
@@ -0,0 +1,78 @@
+//  Copyright (C) 2020-2024  Jiří Maier
+
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef MYSPECTROGRAMPLOT_H
+#define MYSPECTROGRAMPLOT_H
+
+#include "myplot.h"
+#include <QObject>
+
+/// Barevná mapa s kruhovým zásobníkem řádků
+/// Nový řádek se obarví jen jednou (do jednoho řádku obrázku), při vykreslení se obrázek poskládá ze dvou částí tak,
+/// aby nejnovější řádek byl nahoře. Celý obrázek se přebarvuje jen při změně rozsahu nebo gradientu.
+class MySpectrogramMap : public QCPColorMap {
+public:
+  explicit MySpectrogramMap(QCPAxis *keyAxis, QCPAxis *valueAxis);
+
+  void resetRing(int rowCount, int binCount);
+  void addRow(const double *values);
+  int rowCount() const { return ringRows; }
+  int binCount() const { return ringBins; }
+
+protected:
+  void updateMapImage() override;
+  void draw(QCPPainter *painter) override;
+
+private:
+  QVector<double> ringValues;
+  QImage ringImage;
+  int ringRows = 0;
+  int ringBins = 0;
+  int writeRow = 0;
+  void colorizeRow(int row);
+};
+
+class MySpectrogramPlot : public MyPlot {
+  Q_OBJECT
+public:
+  explicit MySpectrogramPlot(QWidget *parent = nullptr);
+
+  int getRowCount() const { return rowCount; }
+
+  void setTheme(QColor fnt, QColor bck, int chClrThemeId) override;
+
+private:
+  MySpectrogramMap *map;
+  QCPColorScale *colorScale;
+  int rowCount = 300;
+  double lastBinWidth = 0;
+  double lastRowPeriod = 0;
+
+public slots:
+  /// Přidá řádky spočítané ve vlákně Spectrogram
+  void newRows(QVector<double> rows, int binCount, double binWidth, double rowPeriod);
+
+  /// Vymaže graf
+  void clear();
+
+  /// Nastaví rozsah barevné škály v dB
+  void setDBRange(double min, double max);
+
+private slots:
+  void mouseMoved(QMouseEvent *event);
+  void mousePressed(QMouseEvent *event);
+};
+
+#endif // MYSPECTROGRAMPLOT_H
@@ -78,17 +78,11 @@ void MyXYPlot::setTheme(QColor fnt, QColor bck, int chClrThemeId) {
   this->replot(QCustomPlot::RefreshPriority::rpQueuedReplot);
 }
 
-QByteArray MyXYPlot::exportCSV(char separator, char decimal, int precision) {
-  if (graphXY->data()->isEmpty())
-    return "";
-  QByteArray output = (QString("X%1Y\n").arg(separator)).toUtf8();
-  for (QCPCurveDataContainer::iterator it = graphXY->data()->begin(); it != graphXY->data()->end(); it++) {
-    output.append(QString::number(it->key, 'f', precision).replace('.', decimal).toUtf8());
-    output.append(separator);
-    output.append(QString::number(it->value, 'f', precision).replace('.', decimal).toUtf8());
-    output.append('\n');
-  }
-  return output;
+CsvTable MyXYPlot::exportTable() {
+  // Kopie, clear() maže data grafu na místě
+  CsvTable table;
+  table.curve = QSharedPointer<const QCPCurveDataContainer>(new QCPCurveDataContainer(*graphXY->data()));
+  return table;
 }
 
 void MyXYPlot::updateTracerText() {
@@ -16,6 +16,7 @@
 #ifndef MYXYPLOT_H
 #define MYXYPLOT_H
 
+#include "csvexport.h"
 #include "myplot.h"
 
 class MyXYPlot : public MyPlot {
@@ -23,7 +24,7 @@ class MyXYPlot : public MyPlot {
 public:
   explicit MyXYPlot(QWidget *parent = nullptr);
   ~MyXYPlot();
-  QByteArray exportCSV(char separator, char decimal, int precision);
+  CsvTable exportTable();
   QCPCurve *graphXY;
   UnitOfMeasure tUnit = UnitOfMeasure("s");
 
@@ -0,0 +1,131 @@
+//  Copyright (C) 2020-2024  Jiří Maier
+
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "plotmailbox.h"
+#include "plots/mymainplot.h"
+#include "metrics.h"
+#include "traceevents.h"
+#include "utils.h"
+
+PlotMailbox::PlotMailbox(MyMainPlot *plot, QObject *parent) : QObject(parent), plot(plot) {}
+
+int PlotMailbox::takeDropped() {
+  QMutexLocker locker(&mutex);
+  int result = dropped;
+  dropped = 0;
+  return result;
+}
+
+void PlotMailbox::scheduleDelivery() {
+  if (deliveryScheduled)
+    return;
+  deliveryScheduled = true;
+  QMetaObject::invokeMethod(this, "deliver", Qt::QueuedConnection);
+}
+
+LatencyTrace::Stamp PlotMailbox::processedStamp() {
+  LatencyTrace::Stamp stamp = LatencyTrace::current();
+  LatencyTrace::mark(LatencyTrace::processing, stamp);
+  return stamp;
+}
+
+void PlotMailbox::addPoint(int chID, const PendingPoint &point, const LatencyTrace::Stamp &stamp) {
+  PendingChannel &channel = pending[chID];
+  if (!channel.stamp.isValid())
+    channel.stamp = stamp;
+  if (!point.append && !point.fromVector) {
+    // Bod bez připojení kanál maže, vše starší je zbytečné
+    channel.frame.clear();
+    channel.points.clear();
+    channel.stamp = stamp;
+  } else if (channel.points.size() >= maxPendingPoints) {
+    // Zahlcení, zahodí se nejstarší čtvrtina dávky
+    int count = maxPendingPoints / 4;
+    channel.points.remove(0, count);
+    dropped += count;
+    Metrics::add(Metrics::plotPointsDropped, count);
+  }
+  channel.points.append(point);
+  scheduleDelivery();
+}
+
+void PlotMailbox::postVector(int chID, QSharedPointer<QCPGraphDataContainer> data, bool ignorePause) {
+  LatencyTrace::Stamp stamp = processedStamp();
+  QMutexLocker locker(&mutex);
+  if (data->size() == 1) {
+    addPoint(chID, {data->at(0)->key, data->at(0)->value, true, true}, stamp);
+    return;
+  }
+  // Průběh nahrazuje celý kanál, předchozí nepřevzatý průběh ani body už se nezobrazí
+  PendingChannel &channel = pending[chID];
+  if (!channel.frame.isNull()) {
+    dropped++;
+    Metrics::add(Metrics::plotFramesDropped);
+  }
+  channel.frame = data;
+  channel.ignorePause = ignorePause;
+  channel.points.clear();
+  channel.stamp = stamp;
+  scheduleDelivery();
+}
+
+void PlotMailbox::postPoint(int chID, double time, double value, bool append) {
+  LatencyTrace::Stamp stamp = processedStamp();
+  QMutexLocker locker(&mutex);
+  addPoint(chID, {time, value, append, false}, stamp);
+}
+
+void PlotMailbox::postClearLogicGroup(int group, int fromBit) {
+  QMutexLocker locker(&mutex);
+  // Mazání se provede před ostatními daty, starší data mazaných kanálů se proto zahodí
+  for (int bit = fromBit; bit < LOGIC_BITS; bit++)
+    pending.remove(getLogicChannelID(group, bit));
+  pendingLogicClears.append(QPair<int, int>(group, fromBit));
+  scheduleDelivery();
+}
+
+void PlotMailbox::deliver() {
+  TRACE_SCOPE("gui", "PlotMailbox::deliver");
+  mutex.lock();
+  QMap<int, PendingChannel> channels;
+  channels.swap(pending);
+  QVector<QPair<int, int>> clears;
+  clears.swap(pendingLogicClears);
+  deliveryScheduled = false;
+  mutex.unlock();
+
+  int points = 0;
+  for (const PendingChannel &channel : qAsConst(channels))
+    points += channel.points.size();
+  Metrics::set(Metrics::plotMailboxPoints, points);
+
+  for (const auto &clear : clears)
+    plot->clearLogicGroup(clear.first, clear.second);
+
+  for (auto it = channels.begin(); it != channels.end(); it++) {
+    LatencyTrace::mark(LatencyTrace::guiQueue, it->stamp);
+    if (!it->frame.isNull())
+      plot->newDataVector(it.key(), it->frame, it->ignorePause);
+    for (const PendingPoint &point : it->points) {
+      if (point.fromVector) {
+        auto single = QSharedPointer<QCPGraphDataContainer>(new QCPGraphDataContainer);
+        single->add(QCPGraphData(point.time, point.value));
+        plot->newDataVector(it.key(), single);
+      } else
+        plot->newDataPoint(it.key(), point.time, point.value, point.append);
+    }
+    plot->traceLatency(it->stamp);
+  }
+}
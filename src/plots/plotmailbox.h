@@ -0,0 +1,81 @@
+//  Copyright (C) 2020-2024  Jiří Maier
+
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef PLOTMAILBOX_H
+#define PLOTMAILBOX_H
+
+#include <QMap>
+#include <QMutex>
+#include <QObject>
+
+#include "communication/latencytrace.h"
+#include "global.h"
+#include "plots/qcustomplot.h"
+
+class MyMainPlot;
+
+/// Omezená schránka mezi zdroji dat (PlotData, Averager, PlotMath) a grafem v GUI vlákně
+/// Místo jedné události ve frontě za každý průběh nebo bod se data odkládají sem a graf si je převezme najednou
+/// jednou událostí. Průběh kanálu platí jen poslední (starší, který graf ještě nepřevzal, se zahodí), body se slučují
+/// do dávky, jejíž velikost je omezená (při zahlcení se zahodí nejstarší). Zpoždění zobrazení tak zůstává omezené,
+/// i když je GUI pomalejší než příjem dat.
+class PlotMailbox : public QObject {
+  Q_OBJECT
+public:
+  explicit PlotMailbox(MyMainPlot *plot, QObject *parent = nullptr);
+
+  /// Nejvíce bodů jednoho kanálu čekajících na převzetí
+  static const int maxPendingPoints = 1 << 16;
+
+  /// Počet zahozených průběhů a bodů od posledního volání (volá se z GUI vlákna)
+  int takeDropped();
+
+private:
+  struct PendingPoint {
+    double time, value;
+    bool append;
+    bool fromVector; ///< Jednobodový průběh, o připojení se rozhoduje až podle stavu grafu (jako newDataVector)
+  };
+  struct PendingChannel {
+    QSharedPointer<QCPGraphDataContainer> frame;
+    bool ignorePause = false;
+    QVector<PendingPoint> points;
+    LatencyTrace::Stamp stamp; ///< Průběhu, u bodů nejstaršího z dávky
+  };
+
+  MyMainPlot *plot;
+  QMutex mutex;
+  QMap<int, PendingChannel> pending;
+  QVector<QPair<int, int>> pendingLogicClears;
+  bool deliveryScheduled = false;
+  int dropped = 0;
+
+  /// Volá se se zamčeným mutexem
+  void scheduleDelivery();
+  void addPoint(int chID, const PendingPoint &point, const LatencyTrace::Stamp &stamp);
+  /// Značka právě zpracovávaných dat (z vlákna parseru), úsek zpracování končí vložením do schránky
+  static LatencyTrace::Stamp processedStamp();
+
+private slots:
+  void deliver();
+
+public slots:
+  /// Bezpečné volat z libovolného vlákna (spojení přímé, ne přes frontu)
+  void postVector(int chID, QSharedPointer<QCPGraphDataContainer> data, bool ignorePause = false);
+  void postPoint(int chID, double time, double value, bool append);
+  void postClearLogicGroup(int group, int fromBit);
+};
+
+#endif // PLOTMAILBOX_H
@@ -0,0 +1,149 @@
+//  Copyright (C) 2020-2024  Jiří Maier
+
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "protocoldecoderdialog.h"
+#include "defaultpathmanager.h"
+#include "ui_protocoldecoderdialog.h"
+
+#define DECODER_MAX_ROWS 10000
+#define DECODER_MAX_WORDS 1000000
+
+ProtocolDecoderDialog::ProtocolDecoderDialog(QWidget *parent) : QDialog(parent), ui(new Ui::ProtocolDecoderDialog) {
+  ui->setupUi(this);
+  ui->comboBoxDecoderGroup->setCurrentIndex(LOGIC_GROUPS - 1);
+  on_comboBoxDecoderProtocol_currentIndexChanged(ui->comboBoxDecoderProtocol->currentIndex());
+
+  // Změna kteréhokoli nastavení znovu spustí dekódování
+  for (auto spinBox : findChildren<QSpinBox *>())
+    connect(spinBox, QOverload<int>::of(&QSpinBox::valueChanged), this, &ProtocolDecoderDialog::sendSettings);
+  for (auto checkBox : findChildren<QCheckBox *>())
+    connect(checkBox, &QCheckBox::toggled, this, &ProtocolDecoderDialog::sendSettings);
+  connect(ui->comboBoxUartParity, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &ProtocolDecoderDialog::sendSettings);
+  connect(ui->comboBoxSpiMode, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &ProtocolDecoderDialog::sendSettings);
+
+  setWindowFlags(windowFlags() & ~Qt::WindowContextHelpButtonHint);
+  setWindowFlags(windowFlags() | Qt::WindowMinMaxButtonsHint);
+}
+
+ProtocolDecoderDialog::~ProtocolDecoderDialog() { delete ui; }
+
+Ui::ProtocolDecoderDialog *ProtocolDecoderDialog::getUi() const { return ui; }
+
+void ProtocolDecoderDialog::sendSettings() {
+  DecoderSettings settings;
+  settings.protocol = (DecoderProtocol::enumDecoderProtocol)ui->comboBoxDecoderProtocol->currentIndex();
+  settings.group = ui->comboBoxDecoderGroup->currentIndex();
+  settings.uartBit = ui->spinBoxUartBit->value();
+  settings.baud = ui->spinBoxUartBaud->value();
+  settings.dataBits = ui->spinBoxUartDataBits->value();
+  settings.parity = ui->comboBoxUartParity->currentIndex();
+  settings.uartInverted = ui->checkBoxUartInverted->isChecked();
+  settings.clkBit = ui->spinBoxSpiClk->value();
+  settings.mosiBit = ui->spinBoxSpiMosi->value();
+  settings.misoBit = ui->spinBoxSpiMiso->value();
+  settings.csBit = ui->spinBoxSpiCs->value();
+  settings.spiMode = ui->comboBoxSpiMode->currentIndex();
+  settings.lsbFirst = ui->checkBoxSpiLsbFirst->isChecked();
+  settings.sclBit = ui->spinBoxI2cScl->value();
+  settings.sdaBit = ui->spinBoxI2cSda->value();
+
+  clearWords();
+  emit settingsChanged(settings);
+}
+
+void ProtocolDecoderDialog::clearWords() {
+  words.clear();
+  ui->tableWidgetDecoder->setRowCount(0);
+}
+
+void ProtocolDecoderDialog::addWords(int group, QVector<DecodedWord> newWords, bool clear) {
+  if (group != ui->comboBoxDecoderGroup->currentIndex())
+    return;
+  if (clear)
+    clearWords();
+  if (newWords.isEmpty())
+    return;
+
+  if (words.size() + newWords.size() > DECODER_MAX_WORDS)
+    words.remove(0, qMin(words.size(), words.size() + newWords.size() - DECODER_MAX_WORDS));
+  words.append(newWords);
+
+  // V tabulce jen posledních DECODER_MAX_ROWS slov (vkládání řádků je pomalé)
+  auto table = ui->tableWidgetDecoder;
+  int first = qMax(0, newWords.size() - DECODER_MAX_ROWS);
+  int overflow = table->rowCount() + (newWords.size() - first) - DECODER_MAX_ROWS;
+  for (int i = 0; i < overflow; i++)
+    table->removeRow(0);
+  table->setUpdatesEnabled(false);
+  int row = table->rowCount();
+  table->setRowCount(row + newWords.size() - first);
+  for (int i = first; i < newWords.size(); i++, row++) {
+    const DecodedWord &word = newWords.at(i);
+    table->setItem(row, 0, new QTableWidgetItem(floatToNiceString(word.start, 6, false, false) + "s"));
+    table->setItem(row, 1, new QTableWidgetItem(word.text()));
+    table->setItem(row, 2, new QTableWidgetItem(word.info()));
+  }
+  table->setUpdatesEnabled(true);
+  table->scrollToBottom();
+}
+
+void ProtocolDecoderDialog::on_comboBoxDecoderGroup_currentIndexChanged(int index) {
+  Q_UNUSED(index);
+  sendSettings();
+}
+
+void ProtocolDecoderDialog::on_comboBoxDecoderProtocol_currentIndexChanged(int index) {
+  ui->frameUart->setVisible(index == DecoderProtocol::uart);
+  ui->frameSpi->setVisible(index == DecoderProtocol::spi);
+  ui->frameI2c->setVisible(index == DecoderProtocol::i2c);
+  sendSettings();
+}
+
+void ProtocolDecoderDialog::on_pushButtonDecoderClear_clicked() {
+  clearWords();
+  emit resetRequested();
+}
+
+void ProtocolDecoderDialog::on_pushButtonDecoderExport_clicked() {
+  if (words.isEmpty()) {
+    QMessageBox msgBox(this);
+    msgBox.setText(tr("No data to export"));
+    msgBox.setIcon(QMessageBox::Warning);
+    msgBox.exec();
+    return;
+  }
+  QString fileName = DefaultPathManager::getInstance().requestSaveFile(this, tr("Export decoded data"), "path_export", "decoded.csv", tr("Comma separated values (*.csv)"));
+  if (fileName.isEmpty())
+    return;
+
+  QByteArray data = tr("start,end,value,info\n").toUtf8();
+  for (const auto &word : qAsConst(words)) {
+    data.append(QString::number(word.start, 'g', 12).toUtf8());
+    data.append(',');
+    data.append(QString::number(word.end, 'g', 12).toUtf8());
+    data.append(',');
+    data.append(word.text().toUtf8());
+    data.append(',');
+    data.append(word.info().replace(',', ';').toUtf8());
+    data.append('\n');
+  }
+  QFile file(fileName);
+  if (file.open(QFile::WriteOnly | QFile::Truncate)) {
+    file.write(data);
+    file.close();
+  } else {
+    qCritical() << "Cannot write to file" << fileName;
+  }
+}
@@ -0,0 +1,58 @@
+//  Copyright (C) 2020-2024  Jiří Maier
+
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef PROTOCOLDECODERDIALOG_H
+#define PROTOCOLDECODERDIALOG_H
+
+#include "global.h"
+#include "math/protocoldecoder.h"
+#include <QDialog>
+
+namespace Ui {
+class ProtocolDecoderDialog;
+}
+
+class ProtocolDecoderDialog : public QDialog {
+  Q_OBJECT
+
+public:
+  explicit ProtocolDecoderDialog(QWidget *parent = nullptr);
+  ~ProtocolDecoderDialog();
+
+  Ui::ProtocolDecoderDialog *getUi() const;
+
+private slots:
+  void on_comboBoxDecoderGroup_currentIndexChanged(int index);
+  void on_comboBoxDecoderProtocol_currentIndexChanged(int index);
+  void on_pushButtonDecoderClear_clicked();
+  void on_pushButtonDecoderExport_clicked();
+
+private:
+  Ui::ProtocolDecoderDialog *ui;
+  /// Všechna dekódovaná slova (pro export), tabulka drží jen posledních maxRows
+  QVector<DecodedWord> words;
+  void clearWords();
+  void sendSettings();
+
+public slots:
+  /// Přidá dekódovaná slova do tabulky
+  void addWords(int group, QVector<DecodedWord> newWords, bool clear);
+
+signals:
+  void settingsChanged(DecoderSettings settings);
+  void resetRequested();
+};
+
+#endif // PROTOCOLDECODERDIALOG_H
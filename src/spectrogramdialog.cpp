@@ -0,0 +1,90 @@
+//  Copyright (C) 2020-2024  Jiří Maier
+
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "spectrogramdialog.h"
+#include "ui_spectrogramdialog.h"
+
+SpectrogramDialog::SpectrogramDialog(QWidget *parent) : QDialog(parent), ui(new Ui::SpectrogramDialog) {
+  ui->setupUi(this);
+
+  ui->comboBoxSpectrogramCh->blockSignals(true);
+  for (int i = 0; i < ANALOG_COUNT; i++)
+    ui->comboBoxSpectrogramCh->addItem(getChName(i));
+  ui->comboBoxSpectrogramCh->blockSignals(false);
+
+  setWindowFlags(windowFlags() & ~Qt::WindowContextHelpButtonHint);
+  setWindowFlags(windowFlags() | Qt::WindowMinMaxButtonsHint);
+}
+
+SpectrogramDialog::~SpectrogramDialog() { delete ui; }
+
+Ui::SpectrogramDialog *SpectrogramDialog::getUi() const { return ui; }
+
+void SpectrogramDialog::setSourceChannel(int chID) {
+  if (chID >= 0 && chID < ANALOG_COUNT)
+    ui->comboBoxSpectrogramCh->setCurrentIndex(chID);
+}
+
+void SpectrogramDialog::showEvent(QShowEvent *event) {
+  QDialog::showEvent(event);
+  sendSettings();
+  emit sourceChanged(ui->comboBoxSpectrogramCh->currentIndex());
+}
+
+void SpectrogramDialog::hideEvent(QHideEvent *event) {
+  QDialog::hideEvent(event);
+  emit sourceChanged(-1);
+}
+
+void SpectrogramDialog::sendSettings() {
+  int nfft = ui->comboBoxSpectrogramNFFT->currentText().toInt();
+  double rowPeriod = ui->doubleSpinBoxSpectrogramSpan->value() / ui->plotSpectrogram->getRowCount();
+  emit settingsChanged(nfft, ui->spinBoxSpectrogramOverlap->value(), (FFTWindow::enumFFTWindow)ui->comboBoxSpectrogramWindow->currentIndex(), rowPeriod);
+}
+
+void SpectrogramDialog::on_comboBoxSpectrogramCh_currentIndexChanged(int index) {
+  ui->plotSpectrogram->clear();
+  if (isVisible())
+    emit sourceChanged(index);
+}
+
+void SpectrogramDialog::on_comboBoxSpectrogramNFFT_currentIndexChanged(int index) {
+  Q_UNUSED(index);
+  sendSettings();
+}
+
+void SpectrogramDialog::on_comboBoxSpectrogramWindow_currentIndexChanged(int index) {
+  Q_UNUSED(index);
+  sendSettings();
+}
+
+void SpectrogramDialog::on_spinBoxSpectrogramOverlap_valueChanged(int arg1) {
+  Q_UNUSED(arg1);
+  sendSettings();
+}
+
+void SpectrogramDialog::on_doubleSpinBoxSpectrogramSpan_valueChanged(double arg1) {
+  Q_UNUSED(arg1);
+  sendSettings();
+}
+
+void SpectrogramDialog::on_doubleSpinBoxSpectrogramMin_valueChanged(double arg1) { ui->plotSpectrogram->setDBRange(arg1, ui->doubleSpinBoxSpectrogramMax->value()); }
+
+void SpectrogramDialog::on_doubleSpinBoxSpectrogramMax_valueChanged(double arg1) { ui->plotSpectrogram->setDBRange(ui->doubleSpinBoxSpectrogramMin->value(), arg1); }
+
+void SpectrogramDialog::on_pushButtonSpectrogramClear_clicked() {
+  ui->plotSpectrogram->clear();
+  emit resetRequested();
+}
@@ -0,0 +1,63 @@
+//  Copyright (C) 2020-2024  Jiří Maier
+
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef SPECTROGRAMDIALOG_H
+#define SPECTROGRAMDIALOG_H
+
+#include "global.h"
+#include <QDialog>
+
+namespace Ui {
+class SpectrogramDialog;
+}
+
+class SpectrogramDialog : public QDialog {
+  Q_OBJECT
+
+public:
+  explicit SpectrogramDialog(QWidget *parent = nullptr);
+  ~SpectrogramDialog();
+
+  Ui::SpectrogramDialog *getUi() const;
+
+  /// Vybere zdrojový kanál (použije se při příštím zobrazení)
+  void setSourceChannel(int chID);
+
+protected:
+  void showEvent(QShowEvent *event) override;
+  void hideEvent(QHideEvent *event) override;
+
+private slots:
+  void on_comboBoxSpectrogramCh_currentIndexChanged(int index);
+  void on_comboBoxSpectrogramNFFT_currentIndexChanged(int index);
+  void on_comboBoxSpectrogramWindow_currentIndexChanged(int index);
+  void on_spinBoxSpectrogramOverlap_valueChanged(int arg1);
+  void on_doubleSpinBoxSpectrogramSpan_valueChanged(double arg1);
+  void on_doubleSpinBoxSpectrogramMin_valueChanged(double arg1);
+  void on_doubleSpinBoxSpectrogramMax_valueChanged(double arg1);
+  void on_pushButtonSpectrogramClear_clicked();
+
+private:
+  Ui::SpectrogramDialog *ui;
+  void sendSettings();
+
+signals:
+  /// Výpočet se provádí jen když je okno zobrazeno, jinak je zdroj -1
+  void sourceChanged(int chID);
+  void settingsChanged(int nfft, int overlapPercent, FFTWindow::enumFFTWindow window, double rowPeriod);
+  void resetRequested();
+};
+
+#endif // SPECTROGRAMDIALOG_H
@@ -0,0 +1,114 @@
+//  Copyright (C) 2020-2024  Jiří Maier
+
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "statisticsdialog.h"
+#include "ui_statisticsdialog.h"
+
+StatisticsDialog::StatisticsDialog(QWidget *parent) : QDialog(parent), ui(new Ui::StatisticsDialog) {
+  ui->setupUi(this);
+
+  ui->comboBoxStatisticsCh->blockSignals(true);
+  for (int i = 0; i < ANALOG_COUNT; i++)
+    ui->comboBoxStatisticsCh->addItem(getChName(i));
+  ui->comboBoxStatisticsCh->blockSignals(false);
+
+  setWindowFlags(windowFlags() & ~Qt::WindowContextHelpButtonHint);
+  setWindowFlags(windowFlags() | Qt::WindowMinMaxButtonsHint);
+}
+
+StatisticsDialog::~StatisticsDialog() { delete ui; }
+
+Ui::StatisticsDialog *StatisticsDialog::getUi() const { return ui; }
+
+void StatisticsDialog::setSourceChannel(int chID) {
+  if (chID >= 0 && chID < ANALOG_COUNT)
+    ui->comboBoxStatisticsCh->setCurrentIndex(chID);
+}
+
+int StatisticsDialog::getSourceChannel() const { return isVisible() ? ui->comboBoxStatisticsCh->currentIndex() : -1; }
+
+void StatisticsDialog::setUnits(UnitOfMeasure timeUnit, UnitOfMeasure valueUnit) {
+  this->timeUnit = timeUnit;
+  this->valueUnit = valueUnit;
+}
+
+void StatisticsDialog::showEvent(QShowEvent *event) {
+  QDialog::showEvent(event);
+  emit histogramSourceChanged(ui->comboBoxStatisticsHistogram->currentIndex());
+  emit sourceChanged(ui->comboBoxStatisticsCh->currentIndex());
+}
+
+void StatisticsDialog::hideEvent(QHideEvent *event) {
+  QDialog::hideEvent(event);
+  emit sourceChanged(-1);
+}
+
+UnitOfMeasure StatisticsDialog::unitOf(int measurement) {
+  switch (measurement) {
+    case MeasurementStatistics::period:
+    case MeasurementStatistics::rise:
+    case MeasurementStatistics::fall: return timeUnit;
+    case MeasurementStatistics::frequency:
+    case MeasurementStatistics::samplingRate: return timeUnit.reciprocal();
+    default: return valueUnit;
+  }
+}
+
+void StatisticsDialog::newStatistics(MeasurementStatistics statistics) {
+  ui->labelStatisticsCount->setText(tr("%n acquisition(s)", "", statistics.getAcquisitions()));
+  for (int i = 0; i < MeasurementStatistics::measurementCount; i++) {
+    const RunningStatistic &stat = statistics.getStatistic(i);
+    UnitOfMeasure unit = unitOf(i);
+    QStringList cells;
+    if (stat.count == 0)
+      cells << "---" << "---" << "---" << "---";
+    else
+      cells << floatToNiceString(stat.mean, 4, false, false, false, unit) << floatToNiceString(stat.stdDev(), 4, false, false, false, unit) << floatToNiceString(stat.min, 4, false, false, false, unit)
+            << floatToNiceString(stat.max, 4, false, false, false, unit);
+    for (int column = 0; column < cells.size(); column++) {
+      auto item = ui->tableWidgetStatistics->item(i, column);
+      if (!item) {
+        item = new QTableWidgetItem();
+        ui->tableWidgetStatistics->setItem(i, column, item);
+      }
+      item->setText(cells.at(column));
+    }
+  }
+
+  const FixedBinHistogram &histogram = statistics.getHistogram();
+  if (histogram.getCount() == 0) {
+    ui->plotHistogram->clear();
+    return;
+  }
+  int source = statistics.getHistogramSource();
+  ui->plotHistogram->setXUnit(source == 0 ? valueUnit : unitOf(source - 1));
+  ui->plotHistogram->setHistogram(histogram.getBins(), histogram.getLower(), histogram.getBinWidth());
+}
+
+void StatisticsDialog::on_comboBoxStatisticsCh_currentIndexChanged(int index) {
+  ui->plotHistogram->clear();
+  if (isVisible())
+    emit sourceChanged(index);
+}
+
+void StatisticsDialog::on_comboBoxStatisticsHistogram_currentIndexChanged(int index) {
+  ui->plotHistogram->clear();
+  emit histogramSourceChanged(index);
+}
+
+void StatisticsDialog::on_pushButtonStatisticsReset_clicked() {
+  ui->plotHistogram->clear();
+  emit resetRequested();
+}
@@ -0,0 +1,69 @@
+//  Copyright (C) 2020-2024  Jiří Maier
+
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef STATISTICSDIALOG_H
+#define STATISTICSDIALOG_H
+
+#include "global.h"
+#include "math/measurementstatistics.h"
+#include <QDialog>
+
+namespace Ui {
+class StatisticsDialog;
+}
+
+class StatisticsDialog : public QDialog {
+  Q_OBJECT
+
+public:
+  explicit StatisticsDialog(QWidget *parent = nullptr);
+  ~StatisticsDialog();
+
+  Ui::StatisticsDialog *getUi() const;
+
+  /// Vybere zdrojový kanál (použije se při příštím zobrazení)
+  void setSourceChannel(int chID);
+
+  /// Kanál, ze kterého se sbírá statistika, -1 když je okno skryté
+  int getSourceChannel() const;
+
+  /// Jednotky času a hodnot kanálu (pro výpis)
+  void setUnits(UnitOfMeasure timeUnit, UnitOfMeasure valueUnit);
+
+protected:
+  void showEvent(QShowEvent *event) override;
+  void hideEvent(QHideEvent *event) override;
+
+private slots:
+  void on_comboBoxStatisticsCh_currentIndexChanged(int index);
+  void on_comboBoxStatisticsHistogram_currentIndexChanged(int index);
+  void on_pushButtonStatisticsReset_clicked();
+
+private:
+  Ui::StatisticsDialog *ui;
+  UnitOfMeasure timeUnit, valueUnit;
+  UnitOfMeasure unitOf(int measurement);
+
+public slots:
+  void newStatistics(MeasurementStatistics statistics);
+
+signals:
+  /// Statistika se sbírá jen když je okno zobrazeno, jinak je zdroj -1
+  void sourceChanged(int chID);
+  void histogramSourceChanged(int source);
+  void resetRequested();
+};
+
+#endif // STATISTICSDIALOG_H
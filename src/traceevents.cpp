@@ -0,0 +1,103 @@
+//  Copyright (C) 2020-2024  Jiří Maier
+
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "traceevents.h"
+#include <QCoreApplication>
+#include <QMutex>
+#include <QThread>
+#include <QVector>
+
+QAtomicInt TraceEvents::enabled{0};
+
+namespace {
+struct Event {
+  const char *category, *name;
+  qint64 start, end;
+  int thread;
+};
+
+QMutex eventsMutex;
+QVector<Event> events;
+int nextEvent = 0;
+bool wrapped = false;
+QVector<QByteArray> threadNames;
+
+/// Pořadové číslo vlákna (tid v záznamu), jméno se zapamatuje při první události
+int threadIndex() {
+  thread_local int index = -1;
+  if (index < 0) {
+    QThread *thread = QThread::currentThread();
+    QByteArray name = thread->objectName().toUtf8();
+    if (QCoreApplication::instance() && thread == QCoreApplication::instance()->thread())
+      name = "GUI";
+    QMutexLocker locker(&eventsMutex);
+    index = threadNames.size();
+    threadNames.append(name.isEmpty() ? "Worker " + QByteArray::number(index) : name);
+  }
+  return index;
+}
+
+void appendEscaped(QByteArray &output, const char *text) {
+  for (const char *c = text; *c; c++) {
+    if (*c == '"' || *c == '\\')
+      output.append('\\');
+    output.append(*c);
+  }
+}
+} // namespace
+
+void TraceEvents::record(const char *category, const char *name, qint64 start, qint64 end) {
+  int thread = threadIndex();
+  QMutexLocker locker(&eventsMutex);
+  if (!isEnabled())
+    return;
+  if (events.size() < capacity)
+    events.append({category, name, start, end, thread});
+  else
+    events[nextEvent] = {category, name, start, end, thread};
+  nextEvent = (nextEvent + 1) % capacity;
+  if (nextEvent == 0)
+    wrapped = true;
+}
+
+QByteArray TraceEvents::toJson() {
+  QMutexLocker locker(&eventsMutex);
+  QByteArray output = "{\"traceEvents\":[\n";
+  for (int i = 0; i < threadNames.size(); i++)
+    output.append("{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" + QByteArray::number(i) + ",\"args\":{\"name\":\"" + threadNames.at(i) + "\"}},\n");
+  // Od nejstarší události
+  int first = wrapped ? nextEvent : 0;
+  for (int i = 0; i < events.size(); i++) {
+    const Event &event = events.at((first + i) % events.size());
+    output.append("{\"ph\":\"X\",\"cat\":\"");
+    appendEscaped(output, event.category);
+    output.append("\",\"name\":\"");
+    appendEscaped(output, event.name);
+    output.append("\",\"pid\":1,\"tid\":" + QByteArray::number(event.thread));
+    output.append(",\"ts\":" + QByteArray::number(event.start / 1000.0, 'f', 3));
+    output.append(",\"dur\":" + QByteArray::number((event.end - event.start) / 1000.0, 'f', 3) + "},\n");
+  }
+  if (output.endsWith(",\n"))
+    output.chop(2);
+  output.append("\n],\"displayTimeUnit\":\"ms\"}\n");
+  return output;
+}
+
+void TraceEvents::clear() {
+  QMutexLocker locker(&eventsMutex);
+  events.clear();
+  nextEvent = 0;
+  wrapped = false;
+}
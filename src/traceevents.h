@@ -0,0 +1,74 @@
+//  Copyright (C) 2020-2024  Jiří Maier
+
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef TRACEEVENTS_H
+#define TRACEEVENTS_H
+
+#include <QAtomicInt>
+#include <QByteArray>
+
+#include "communication/latencytrace.h"
+
+/// Záznam událostí s trváním (čtení, parser, PlotData, výpočty, překreslení) do kruhového bufferu v paměti
+/// Uloží se jako JSON pro chrome://tracing nebo Perfetto. Události se zapisují makrem TRACE_SCOPE, které je bez
+/// DATAPLOTTER_TRACING prázdné, a za běhu se zaznamenávají jen po zapnutí (jinak stojí jedno čtení příznaku).
+/// Jméno a kategorie musí být řetězcové konstanty (ukládá se jen ukazatel).
+class TraceEvents {
+public:
+  /// Počet uchovaných událostí, starší se přepisují
+  static const int capacity = 1 << 16;
+
+  static void setEnabled(bool enable) { enabled.storeRelaxed(enable); }
+  static bool isEnabled() { return enabled.loadRelaxed(); }
+
+  /// Zapíše událost, časy jsou z LatencyTrace::now (ns)
+  static void record(const char *category, const char *name, qint64 start, qint64 end);
+  /// Zaznamenané události ve formátu Chrome trace event (JSON)
+  static QByteArray toJson();
+  static void clear();
+
+  /// Událost trvající od vytvoření do zániku objektu
+  class Scope {
+  public:
+    Scope(const char *category, const char *name) : category(category), name(name), start(isEnabled() ? LatencyTrace::now() : 0) {}
+    ~Scope() {
+      if (start)
+        record(category, name, start, LatencyTrace::now());
+    }
+
+  private:
+    const char *category, *name;
+    qint64 start;
+  };
+
+private:
+  static QAtomicInt enabled;
+};
+
+#ifdef DATAPLOTTER_TRACING
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(category, name) TraceEvents::Scope TRACE_CONCAT(traceScope, __LINE__)(category, name)
+#define TRACE_COMPLETE(category, name, start, end) \
+  do {                                             \
+    if (TraceEvents::isEnabled())                  \
+      TraceEvents::record(category, name, start, end); \
+  } while (0)
+#else
+#define TRACE_SCOPE(category, name) ((void)0)
+#define TRACE_COMPLETE(category, name, start, end) ((void)0)
+#endif
+
+#endif // TRACEEVENTS_H
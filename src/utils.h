@@ -46,7 +46,35 @@ enum enumOutputLevel { device = 0, error = 1, warning = 2, info = 3 };
 }
 
 namespace MathOperations {
-enum enumMathOperations { add = 0, subtract = 1, multiply = 2, divide = 3 };
+enum enumMathOperations { add = 0, subtract = 1, multiply = 2, divide = 3, minimum = 4, maximum = 5, integral = 6, derivative = 7, absolute = 8, expression = 9 };
+}
+
+namespace FilterType {
+enum enumFilterType { none = 0, lowPass = 1, highPass = 2, bandPass = 3, notch = 4, firLowPass = 5, median = 6 };
+}
+
+namespace TriggerMode {
+enum enumTriggerMode { off = 0, risingEdge = 1, fallingEdge = 2, levelHigh = 3, levelLow = 4, pulseLonger = 5, pulseShorter = 6, timeout = 7 };
+}
+
+namespace DecoderProtocol {
+enum enumDecoderProtocol { off = 0, uart = 1, spi = 2, i2c = 3 };
+}
+
+namespace Resampling {
+enum enumResampling { linear = 0, bandLimited = 1 };
+}
+
+namespace LogFormat {
+enum enumLogFormat { binary = 0, csv = 1 };
+}
+
+namespace LogSync {
+enum enumLogSync { never = 0, onClose = 1, everySecond = 2 };
+}
+
+namespace AveragerMode {
+enum enumAveragerMode { mean = 0, exponential = 1, peakMax = 2, peakMin = 3, highResolution = 4 };
 }
 
 namespace DataLineType {